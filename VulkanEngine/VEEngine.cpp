@@ -52,9 +52,11 @@ namespace ve
 		createRenderer(); //create a renderer
 		createSceneManager(); //create a scene manager
 		createWindow(); //create a window
-		m_pWindow->initWindow(800, 600); //initialize the window
+		m_pWindow->initWindow(m_windowExtent.width, m_windowExtent.height); //initialize the window
 
-		m_threadPool = new ThreadPool(0); //worker threads
+		m_jobSystem = new VEJobSystem(0); //worker threads
+		m_pFrameArena = new VEFrameArena(); //per frame memory of the render loop
+		m_pFrameStats = new VEFrameStats(); //time statistics of the render loop
 
 		std::vector<const char *> instanceExtensions = getRequiredInstanceExtensions();
 		std::vector<const char *> validationLayers = getValidationLayers();
@@ -84,7 +86,10 @@ namespace ve
 		*/
 	void VEEngine::createWindow()
 	{
-		m_pWindow = new VEWindowGLFW();
+		if (m_headless)
+			m_pWindow = new VEWindowHeadless(m_headlessFrames, m_headlessDuration);
+		else
+			m_pWindow = new VEWindowGLFW();
 	}
 
 	/**
@@ -101,9 +106,18 @@ namespace ve
 		case veRendererType::VE_RENDERER_TYPE_FORWARD:
 			m_pRenderer = new VERendererForward();
 			break;
+		case veRendererType::VE_RENDERER_TYPE_FORWARD_INDIRECT:
+			m_pRenderer = new VERendererForward(true);
+			break;
+		case veRendererType::VE_RENDERER_TYPE_FORWARD_CLUSTERED:
+			m_pRenderer = new VERendererForward(false, true);
+			break;
 		case veRendererType::VE_RENDERER_TYPE_DEFERRED:
 			m_pRenderer = new VERendererDeferred();
 			break;
+		case veRendererType::VE_RENDERER_TYPE_DEFERRED_TILED:
+			m_pRenderer = new VERendererDeferred(true);
+			break;
 		case veRendererType::VE_RENDERER_TYPE_RAYTRACING_NV:
 			m_pRenderer = new VERendererRayTracingNV();
 			break;
@@ -139,8 +153,7 @@ namespace ve
 		*/
 	void VEEngine::closeEngine()
 	{
-		//m_threadPool->shutdown();
-		delete m_threadPool;
+		delete m_jobSystem;
 
 		clearEventListenerList();
 		m_eventlist.clear();
@@ -155,10 +168,17 @@ namespace ve
 		m_pRenderer->closeRenderer();
 		m_pWindow->closeWindow();
 
+		delete m_pFrameArena;
+
+		if (!m_frameStatsFile.empty())
+			m_pFrameStats->exportStats(m_frameStatsFile);
+		delete m_pFrameStats;
+
 		if (m_debug)
 			vhDebugDestroyReportCallbackEXT(m_instance, callback, nullptr);
 
-		vkDestroySurfaceKHR(m_instance, m_pRenderer->m_surface, nullptr);
+		if (m_pRenderer->m_surface != VK_NULL_HANDLE)
+			vkDestroySurfaceKHR(m_instance, m_pRenderer->m_surface, nullptr);
 		vkDestroyInstance(m_instance, nullptr);
 	}
 
@@ -368,33 +388,11 @@ namespace ve
 		*/
 	void VEEngine::callListeners(double dt, veEvent event, std::vector<VEEventListener *> *list)
 	{
-		static std::vector<std::future<void>> futures;
 		event.dt = dt;
 
 		const uint32_t granularity = 200;
-		if (m_threadPool->threadCount() > 1 && list->size() > granularity)
-		{
-			uint32_t numThreads = std::min((int)(list->size() / granularity), (int)m_threadPool->threadCount());
-			uint32_t numListenerPerThread = (uint32_t)list->size() / numThreads;
-			futures.resize(numThreads);
-
-			uint32_t startIdx, endIdx;
-			for (uint32_t k = 0; k < numThreads; k++)
-			{
-				startIdx = k * numListenerPerThread;
-				endIdx = k == numThreads - 1 ? (uint32_t)list->size() - 1 : (k + 1) * numListenerPerThread - 1;
-
-				auto future = m_threadPool->add(&VEEngine::callListeners2, this, dt, event, list, startIdx, endIdx);
-				futures[k] = std::move(future);
-			}
-			for (uint32_t i = 0; i < futures.size(); i++)
-				futures[i].get();
-		}
-		else
-		{
-			if (list->size() > 0)
-				callListeners2(dt, event, list, 0, (uint32_t)list->size() - 1);
-		}
+		m_jobSystem->parallelFor((uint32_t)list->size(), granularity, [&](uint32_t begin, uint32_t end)
+			{ callListeners2(dt, event, list, begin, end - 1); });
 	}
 
 	/**
@@ -467,30 +465,26 @@ namespace ve
 		* \brief Go through the event list, and call all listeners for it.
 		*
 		* Go through all events in the event list and pass them to the event listeners. Continuous events are kept,
-		* all other events are deleted from the list at the end.
+		* all other events are deleted from the list at the end. The list is changed in place, so it keeps its
+		* capacity and no memory is allocated in a normal frame.
 		*
 		* \param[in] dt The delta time that has passed since the last loop.
 		*
 		*/
 	void VEEngine::processEvents(double dt)
 	{
-		std::vector<veEvent> keepEvents; //Keep these events in the list
-		for (auto event : m_eventlist)
-		{
-			if (event.lifeTime == veEvent::VE_EVENT_LIFETIME_CONTINUOUS)
-			{
-				keepEvents.push_back(event);
-			}
-		}
-
-		for (auto event : m_eventlist)
+		size_t numEvents = m_eventlist.size(); //listeners may add events to the list
+		for (size_t i = 0; i < numEvents; i++)
 		{
+			veEvent event = m_eventlist[i];
 			if (event.notBeforeTime <= m_loopCount)
 			{
 				callListeners(dt, event);
 			}
 		}
-		m_eventlist = keepEvents;
+
+		std::erase_if(m_eventlist, [](const veEvent &event)
+			{ return event.lifeTime != veEvent::VE_EVENT_LIFETIME_CONTINUOUS; });
 	}
 
 	/**
@@ -573,16 +567,23 @@ namespace ve
 
 		while ( !m_end_running) {
 			m_dt = vh::vhTimeDuration( t_prev );
-			m_AvgFrameTime = vh::vhAverage( (float)m_dt, m_AvgFrameTime );
+			if (m_loopCount > 1)				//the first frame has no predecessor
+				m_pFrameStats->record(VE_FRAME_PHASE_FRAME, (float)m_dt);
 			t_prev = vh::vhTimeNow();
 
+			m_pFrameArena->reset();				//all per frame memory of the last frame is free again
+			m_pRenderer->getMaterialTable()->nextFrame();	//material slots released some frames ago can be reused
+			uint64_t numAllocations = veGetNumAllocations();
+			m_allocationsPerFrame = numAllocations - m_lastNumAllocations;
+			m_lastNumAllocations = numAllocations;
+
 			//----------------------------------------------------------------------------------
 			//process frame begin
 
 			t_now = vh::vhTimeNow();
 			veEvent event(veEvent::VE_EVENT_FRAME_STARTED );	//notify all listeners that a new frame starts
 			callListeners(m_dt, event);
-			m_AvgStartedTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgStartedTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_STARTED, vh::vhTimeDuration(t_now));
 
 			//----------------------------------------------------------------------------------
 			//get and process window events
@@ -597,42 +598,50 @@ namespace ve
 			
 			t_now = vh::vhTimeNow();
 			processEvents(m_dt);				//process all current events, including pressed keys
-			m_AvgEventTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgEventTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_EVENTS, vh::vhTimeDuration(t_now));
 
 			//----------------------------------------------------------------------------------
 			//acquire the next frame before changing GPU buffers
 
 			m_pRenderer->acquireFrame();
 
+			//----------------------------------------------------------------------------------
+			//upload asynchronously loaded models and put them into the scene graph
+
+			getSceneManagerPointer()->updateModelLoads();
+
+			//submit all mesh and texture uploads of this frame in one batch
+			vh::vhUploadSubmit(m_pRenderer->getUploadRing());
+
 			//----------------------------------------------------------------------------------
 			//update world matrices and send them to the GPU
 
 			t_now = vh::vhTimeNow();
 			getSceneManagerPointer()->updateSceneNodes(getEnginePointer()->getRenderer()->getImageIndex());	//update scene node UBOs
-			m_AvgUpdateTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgUpdateTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_UPDATE, vh::vhTimeDuration(t_now));
 
 			//----------------------------------------------------------------------------------
 			//submit the cmd buffer to the GPU
 
 			t_now = vh::vhTimeNow();
 			m_pRenderer->drawFrame();			//draw the next frame
-			m_AvgDrawTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgDrawTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_DRAW, vh::vhTimeDuration(t_now));
 
 			//----------------------------------------------------------------------------------
 			//Overlay
 
 			t_now = vh::vhTimeNow();
 			m_pRenderer->prepareOverlay();
-			m_AvgPrepOvlTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgPrepOvlTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_PREP_OVERLAY, vh::vhTimeDuration(t_now));
 
 			t_now = vh::vhTimeNow();
 			event.type = veEvent::VE_EVENT_DRAW_OVERLAY;		//notify all listeners that they can draw an overlay now
 			callListeners(m_dt, event);
-			m_AvgEndedTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgEndedTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_OVERLAY_EVENTS, vh::vhTimeDuration(t_now));
 
 			t_now = vh::vhTimeNow();
 			m_pRenderer->drawOverlay();			//draw overlay in the subrenderer
-			m_AvgDrawOvlTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgDrawOvlTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_DRAW_OVERLAY, vh::vhTimeDuration(t_now));
 
 			//----------------------------------------------------------------------------------
 			//Frame ended
@@ -640,14 +649,14 @@ namespace ve
 			t_now = vh::vhTimeNow();
 			event.type = veEvent::VE_EVENT_FRAME_ENDED;	//notify all listeners that the frame ended, e.g. fill cmd buffers for overlay
 			callListeners(m_dt, event);
-			m_AvgEndedTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgEndedTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_ENDED, vh::vhTimeDuration(t_now));
 
 			//----------------------------------------------------------------------------------
 			//present the finished frame
 
 			t_now = vh::vhTimeNow();
 			m_pRenderer->presentFrame();		//present the next frame
-			m_AvgPresentTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgPresentTime);
+			m_pFrameStats->record(VE_FRAME_PHASE_PRESENT, vh::vhTimeDuration(t_now));
 
 			m_loopCount++;
 		}
@@ -677,10 +686,10 @@ namespace ve
 		//camera can only do yaw (parent y-axis) and pitch (local x-axis) rotations
 		VkExtent2D extent = getWindowPointer()->getExtent();
 		VECameraProjective *camera = (VECameraProjective *)getSceneManagerPointer()->createCamera("StandardCamera", VECamera::VE_CAMERA_TYPE_PROJECTIVE, cameraParent);
-		camera->m_nearPlane = 0.1f;
-		camera->m_farPlane = 500.1f;
-		camera->m_aspectRatio = extent.width / (float)extent.height;
-		camera->m_fov = 45.0f;
+		camera->setNearPlane(0.1f);
+		camera->setFarPlane(500.1f);
+		camera->setAspectRatio(extent.width / (float)extent.height);
+		camera->setFov(45.0f);
 		camera->lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		getSceneManagerPointer()->setCamera(camera);
 
@@ -60,25 +60,23 @@ namespace ve
 		double m_dt = 0.0; ///<Delta time since the last loop
 		double m_time = 0.0; ///<Absolute game time since start of the render loop
 		uint32_t m_loopCount = 0; ///<Counts up the render loop
-		ThreadPool *m_threadPool; ///<thread pool for parallel processing
+		VEJobSystem *m_jobSystem; ///<job system for parallel processing
+		VEFrameArena *m_pFrameArena = nullptr; ///<Memory for data that lives for one frame only
+		uint64_t m_lastNumAllocations = 0; ///<Number of heap allocations at the start of the last frame
+		uint64_t m_allocationsPerFrame = 0; ///<Number of heap allocations in the last frame, debug builds only
 
 		//time statistics
-		float m_AvgUpdateTime = 0.0f; ///<Average time for OBO updates (s)
-		float m_AvgFrameTime = 0.0f; ///<Average time per frame (s)
-		float m_MaxFrameTime = 0.0f; ///<Average time per frame (s)
-		float m_AcceptableLevel1 = 1.0f; ///<percentage of frames with time < 33 ms (30 fps)
-		float m_AcceptableLevel2 = 1.0f; ///<percentage of frames with time < 16 ms (60 fps)
-		float m_AvgDrawTime = 0.0f; ///<Average time for baking cmd buffers and calling commit (s)
-		float m_AvgStartedTime = 0.0f; ///<Average time for processing frame started event
-		float m_AvgEventTime = 0.0f; ///<Average time for processing windows events
-		float m_AvgEndedTime = 0.0f; ///<Average time for processing frame ended event
-		float m_AvgPresentTime = 0.0f; ///<Average time for presenting the frame
-		float m_AvgPrepOvlTime = 0.0f; ///<Average prepare overlay time
-		float m_AvgDrawOvlTime = 0.0f; ///<Average draw overlay time
+		VEFrameStats *m_pFrameStats = nullptr; ///<Time distributions of the phases of the render loop
+		std::string m_frameStatsFile; ///<File the time statistics are written to when the engine closes, empty for none
 
 		bool m_framebufferResized = false; ///<Flag indicating whether the window size has changed.
 		bool m_end_running = false; ///<Flag indicating that the engine should leave the render loop
 		bool m_debug = true; ///<Flag indicating whether debugging is enabled or not
+		bool m_packedVertices = false; ///<Flag indicating whether meshes are stored as vhVertexPacked
+		bool m_headless = false; ///<Flag indicating whether to render into offscreen images without a display
+		VkExtent2D m_windowExtent = { 800, 600 }; ///<Size of the window or the offscreen images
+		uint32_t m_headlessFrames = 0; ///<Number of frames to render headless, 0 for no limit
+		double m_headlessDuration = 0.0; ///<Time to render headless (s), 0 for no limit
 
 		virtual std::vector<const char *>
 			getRequiredInstanceExtensions(); //Return a list of required Vulkan instance extensions
@@ -139,99 +137,98 @@ namespace ve
 		uint32_t getLoopCount(); //Return the number of the current render loop
 
 		//-----------------------------------------------------------------------------------------------
-		//thread pool
+		//job system
 
 		///\returns the max number of threads that anybody may start during the render loop
 		uint32_t getMaxThreads()
 		{
-			return (uint32_t)m_threadPool->threadCount();
+			return m_jobSystem->getThreadCount();
 		};
 
-		///\returns a pointer to the threadpool
-		ThreadPool *getThreadPool()
+		///\returns a pointer to the job system
+		VEJobSystem *getJobSystem()
 		{
-			return m_threadPool;
+			return m_jobSystem;
 		};
 
-		//-----------------------------------------------------------------------------------------------
-		//time statistics
-
-		///\returns the average frame time (s)
-		float getAvgFrameTime()
-		{
-			return m_AvgFrameTime;
-		};
-
-		///\returns the maximal frame time (s)
-		float getMaxFrameTime()
+		///\returns a pointer to the frame arena
+		VEFrameArena *getFrameArena()
 		{
-			return m_MaxFrameTime;
+			return m_pFrameArena;
 		};
 
-		///\returns the percentage of frames with frame time < 33 ms (s)
-		float getAcceptableLevel1()
+		///\returns the number of heap allocations in the last frame (debug builds only), the AllocationTest expects 0 in a steady scene
+		uint64_t getAllocationsPerFrame()
 		{
-			return m_AcceptableLevel1;
+			return m_allocationsPerFrame;
 		};
 
-		///\returns the percentage of frames with frame time < 16 ms (s)
-		float getAcceptableLevel2()
-		{
-			return m_AcceptableLevel2;
-		};
-
-		///\returns the average update time (s)
-		float getAvgUpdateTime()
-		{
-			return m_AvgUpdateTime;
-		};
-
-		///\returns the average started time (s)
-		float getAvgStartedTime()
-		{
-			return m_AvgStartedTime;
-		};
+		//-----------------------------------------------------------------------------------------------
+		//time statistics
 
-		///\returns the average event time (s)
-		float getAvgEventTime()
+		///\returns the time statistics of the render loop
+		VEFrameStats *getFrameStats()
 		{
-			return m_AvgEventTime;
+			return m_pFrameStats;
 		};
 
-		///\returns the average event time (s)
-		float getAvgDrawTime()
+		/**
+			* \brief Write the time statistics to a file when the engine closes
+			* \param[in] filename JSON file, or CSV if the name ends with .csv, empty for no file
+			*/
+		void setFrameStatsFile(std::string filename)
 		{
-			return m_AvgDrawTime;
+			m_frameStatsFile = filename;
 		};
 
-		///\returns the average ended time (s)
-		float getAvgEndedTime()
+		bool isRayTracing()
 		{
-			return m_AvgEndedTime;
-		};
+			return m_rendererType == VE_RENDERER_TYPE_RAYTRACING_NV ||
+				m_rendererType == VE_RENDERER_TYPE_RAYTRACING_KHR;
+		}
 
-		///\returns the average present time (s)
-		float getAvgPresentTime()
+		/**
+			* \brief Store meshes in the compact vertex format vhVertexPacked
+			*
+			* Must be called before initEngine(). Ray tracing reads the vertex buffers as vhVertex, so
+			* the setting is ignored for the ray tracing renderers.
+			*
+			* \param[in] packed If true, meshes are stored as vhVertexPacked
+			*/
+		void setPackedVertices(bool packed)
 		{
-			return m_AvgPresentTime;
-		};
+			m_packedVertices = packed;
+		}
 
-		///\returns the average prep overlay time (s)
-		float getAvgPrepOvlTime()
+		///\returns true if meshes are stored as vhVertexPacked
+		bool usePackedVertices()
 		{
-			return m_AvgPrepOvlTime;
-		};
+			return m_packedVertices && !isRayTracing();
+		}
 
-		///\returns the average draw overlay time (s)
-		float getAvgDrawOvlTime()
+		/**
+			* \brief Render into offscreen images instead of a window, e.g. for benchmarking without a display
+			*
+			* Must be called before initEngine(). There is no input and no overlay, the render loop
+			* ends after the given number of frames or the given time, whatever comes first.
+			*
+			* \param[in] width Width of the offscreen images
+			* \param[in] height Height of the offscreen images
+			* \param[in] numFrames Number of frames to render, 0 for no limit
+			* \param[in] duration Time to render (s), 0 for no limit
+			*/
+		void setHeadless(uint32_t width, uint32_t height, uint32_t numFrames, double duration = 0.0)
 		{
-			return m_AvgDrawOvlTime;
-		};
+			m_headless = true;
+			m_windowExtent = { width, height };
+			m_headlessFrames = numFrames;
+			m_headlessDuration = duration;
+		}
 
-		bool isRayTracing()
+		///\returns true if the engine renders into offscreen images
+		bool isHeadless()
 		{
-			return m_rendererType == VE_RENDERER_TYPE_RAYTRACING_NV ||
-				m_rendererType == VE_RENDERER_TYPE_RAYTRACING_KHR;
+			return m_headless;
 		}
 	};
 
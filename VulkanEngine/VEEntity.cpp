@@ -21,9 +21,17 @@ namespace ve
 
 	VESceneNode::VESceneNode(std::string name, glm::mat4 transf)
 		: VENamedClass(name),
-		m_parent(nullptr),
-		m_transform(transf)
+		m_parent(nullptr)
 	{
+		m_transformIdx = getSceneManagerPointer()->getTransformHierarchy()->allocate(this, transf);
+	}
+
+	/**
+		* \brief Destructor of the scene node class, frees the entry in the transform hierarchy.
+		*/
+	VESceneNode::~VESceneNode()
+	{
+		getSceneManagerPointer()->getTransformHierarchy()->release(m_transformIdx);
 	}
 
 	/**
@@ -33,7 +41,7 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		return m_transform;
+		return getSceneManagerPointer()->getTransformHierarchy()->getLocal(m_transformIdx);
 	}
 
 	/**
@@ -48,7 +56,7 @@ namespace ve
 
 	glm::mat4 VESceneNode::getRotation2()
 	{
-		auto transform = m_transform;
+		auto transform = getSceneManagerPointer()->getTransformHierarchy()->getLocal(m_transformIdx);
 		transform[3].x = 0.0;
 		transform[3].y = 0.0;
 		transform[3].z = 0.0;
@@ -63,7 +71,7 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		m_transform = trans;
+		getSceneManagerPointer()->getTransformHierarchy()->setLocal(m_transformIdx, trans); //also marks it dirty
 	}
 
 	/**
@@ -73,7 +81,10 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		m_transform[3] = glm::vec4(pos.x, pos.y, pos.z, 1.0f);
+		VETransformHierarchy *pTransforms = getSceneManagerPointer()->getTransformHierarchy();
+		glm::mat4 transform = pTransforms->getLocal(m_transformIdx);
+		transform[3] = glm::vec4(pos.x, pos.y, pos.z, 1.0f);
+		pTransforms->setLocal(m_transformIdx, transform);
 	};
 
 	/**
@@ -86,7 +97,8 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		return glm::vec3(m_transform[3].x, m_transform[3].y, m_transform[3].z);
+		glm::mat4 transform = getSceneManagerPointer()->getTransformHierarchy()->getLocal(m_transformIdx);
+		return glm::vec3(transform[3].x, transform[3].y, transform[3].z);
 	};
 
 	/**
@@ -96,7 +108,7 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		glm::vec4 x = m_transform[0];
+		glm::vec4 x = getSceneManagerPointer()->getTransformHierarchy()->getLocal(m_transformIdx)[0];
 		return glm::vec3(x.x, x.y, x.z);
 	}
 
@@ -107,7 +119,7 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		glm::vec4 y = m_transform[1];
+		glm::vec4 y = getSceneManagerPointer()->getTransformHierarchy()->getLocal(m_transformIdx)[1];
 		return glm::vec3(y.x, y.y, y.z);
 	}
 
@@ -118,7 +130,7 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		glm::vec4 z = m_transform[2];
+		glm::vec4 z = getSceneManagerPointer()->getTransformHierarchy()->getLocal(m_transformIdx)[2];
 		return glm::vec3(z.x, z.y, z.z);
 	}
 
@@ -135,7 +147,8 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		m_transform = trans * m_transform;
+		VETransformHierarchy *pTransforms = getSceneManagerPointer()->getTransformHierarchy();
+		pTransforms->setLocal(m_transformIdx, trans * pTransforms->getLocal(m_transformIdx));
 	};
 
 	/**
@@ -161,11 +174,12 @@ namespace ve
 		*/
 	glm::mat4 VESceneNode::getWorldTransform2()
 	{
+		glm::mat4 transform = getSceneManagerPointer()->getTransformHierarchy()->getLocal(m_transformIdx);
 		if (m_parent != nullptr)
-			return m_parent->getWorldTransform() * m_transform;
+			return m_parent->getWorldTransform() * transform;
 
 		if (this == getRoot())
-			return m_transform;
+			return transform;
 
 		return glm::mat4(0.0f);
 	};
@@ -202,6 +216,16 @@ namespace ve
 		return glm::mat4(0.0f);
 	};
 
+	/**
+		* \returns true if the world matrix changed in the last update of the transform hierarchy, or if the node is not in it
+		*/
+	bool VESceneNode::isWorldChanged()
+	{
+		if (m_transformIdx == VE_TRANSFORM_NONE)
+			return true;
+		return getSceneManagerPointer()->getTransformHierarchy()->isChanged(m_transformIdx);
+	};
+
 	/**
 		*
 		* \brief lookAt function for a left handed frame of reference
@@ -215,7 +239,8 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		m_transform[3] = glm::vec4(eye.x, eye.y, eye.z, 1.0f);
+		glm::mat4 transform = glm::mat4(1.0f);
+		transform[3] = glm::vec4(eye.x, eye.y, eye.z, 1.0f);
 		glm::vec3 z = glm::normalize(point - eye);
 		up = glm::normalize(up);
 		float corr = glm::dot(z, up); //if z, up are lined up (corr=1 or corr=-1), decorrelate them
@@ -225,11 +250,25 @@ namespace ve
 			up = glm::normalize(glm::vec3(sc, sc, sc));
 		}
 
-		m_transform[2] = glm::vec4(z.x, z.y, z.z, 0.0f);
+		transform[2] = glm::vec4(z.x, z.y, z.z, 0.0f);
 		glm::vec3 x = glm::normalize(glm::cross(up, z));
-		m_transform[0] = glm::vec4(x.x, x.y, x.z, 0.0f);
+		transform[0] = glm::vec4(x.x, x.y, x.z, 0.0f);
 		glm::vec3 y = glm::normalize(glm::cross(z, x));
-		m_transform[1] = glm::vec4(y.x, y.y, y.z, 0.0f);
+		transform[1] = glm::vec4(y.x, y.y, y.z, 0.0f);
+		getSceneManagerPointer()->getTransformHierarchy()->setLocal(m_transformIdx, transform);
+	}
+
+	/**
+		*
+		* \brief Mark this node as changed.
+		*
+		* The node gets a new world matrix and UBO in the next update, and so do all its children.
+		* Transform setters call this automatically, call it yourself after changing public members directly.
+		*
+		*/
+	void VESceneNode::setDirty()
+	{
+		getSceneManagerPointer()->getTransformHierarchy()->setDirty(m_transformIdx);
 	}
 
 	/**
@@ -249,6 +288,8 @@ namespace ve
 				pObject->m_parent->removeChild(pObject);
 			pObject->m_parent = this;
 			m_children.push_back(pObject);
+			pObject->setDirty(); //new parent means new world matrix
+			getSceneManagerPointer()->getTransformHierarchy()->setStructureChanged();
 			getEnginePointer()->getRenderer()->updateCmdBuffers();
 		}
 	}
@@ -272,6 +313,7 @@ namespace ve
 				m_children[i] = last;
 				m_children.pop_back(); //child is not destroyed
 				pNode->m_parent = nullptr;
+				getSceneManagerPointer()->getTransformHierarchy()->setStructureChanged();
 				getEnginePointer()->getRenderer()->updateCmdBuffers();
 				return;
 			}
@@ -458,6 +500,7 @@ namespace ve
 		std::lock_guard<std::mutex> lock(m_mutex);
 
 		m_param = param;
+		setDirty();
 	}
 
 	/**
@@ -486,7 +529,9 @@ namespace ve
 		}
 
 		ubo.param = m_param;
-		ubo.iparam[0] = m_resourceIdx; //make sure the shader uses the right maps in the array of maps
+		ubo.iparam[0] = m_resourceIdx; //make sure the shader uses the right maps in the material table
+		if (m_pMesh != nullptr)
+			ubo.dequantize = m_pMesh->m_dequantize; //decodes the positions of packed vertices
 		if (m_pMaterial != nullptr)
 		{
 			ubo.color = m_pMaterial->color;
@@ -581,6 +626,65 @@ namespace ve
 		}
 	}
 
+	/**
+		*
+		* \brief Get the bounding sphere of the entity in world space
+		*
+		* The mesh bounding sphere is transformed with the world matrix of the last update.
+		* Invisible entities get a negative infinite radius, so they are never in a frustum. Cloth gets an infinite
+		* radius, so it is always in the frustum, since its bounding sphere is only recomputed on request.
+		*
+		* \returns the center in xyz and the radius in w
+		*
+		*/
+	glm::vec4 VEEntity::getWorldBoundingSphere()
+	{
+		if (!m_visible)
+			return glm::vec4(0.0f, 0.0f, 0.0f, -std::numeric_limits<float>::infinity());
+
+		if (m_pMesh == nullptr || m_entityType == VE_ENTITY_TYPE_CLOTH)
+			return glm::vec4(0.0f, 0.0f, 0.0f, std::numeric_limits<float>::infinity());
+
+		glm::mat4 W = getSceneManagerPointer()->getTransformHierarchy()->getWorld(m_transformIdx);
+		glm::vec4 center = W * glm::vec4(m_pMesh->m_boundingSphereCenter, 1.0f);
+		float scale = std::max(std::max(glm::dot(glm::vec3(W[0]), glm::vec3(W[0])), //largest axis scaling
+			glm::dot(glm::vec3(W[1]), glm::vec3(W[1]))),
+			glm::dot(glm::vec3(W[2]), glm::vec3(W[2])));
+		return glm::vec4(glm::vec3(center), m_pMesh->m_boundingSphereRadius * sqrt(scale));
+	}
+
+	/**
+		*
+		* \brief Test whether the entity can be seen by a camera
+		*
+		* \param[in] planes The frustum planes in world space, as returned by VECamera::getFrustumPlanes()
+		* \returns true if the world bounding sphere is at least partially inside the frustum
+		*
+		*/
+	bool VEEntity::isInFrustum(veFrameVector<glm::vec4> &planes)
+	{
+		return isSphereInFrustum(getWorldBoundingSphere(), planes);
+	}
+
+	/**
+		*
+		* \brief Test a sphere against frustum planes
+		*
+		* \param[in] sphere Center in xyz and radius in w, in world space
+		* \param[in] planes The frustum planes in world space, as returned by VECamera::getFrustumPlanes()
+		* \returns true if the sphere is at least partially inside the frustum
+		*
+		*/
+	bool VEEntity::isSphereInFrustum(const glm::vec4 &sphere, veFrameVector<glm::vec4> &planes)
+	{
+		for (auto &plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+				return false; //completely outside of this plane
+		}
+		return true;
+	}
+
 	//-------------------------------------------------------------------------------------------------
 	//camera
 
@@ -695,6 +799,33 @@ namespace ve
 		*radius = sqrt(maxsq);
 	}
 
+	/**
+	* \brief Get the frustum planes of this camera
+	*
+	* The planes are extracted from the view and projection matrices of the last update.
+	* Each plane is stored as (normal, distance) with the normal pointing into the frustum.
+	*
+	* \param[out] planes The 6 planes in world space: left, right, bottom, top, near, far
+	*
+	*/
+	void VECamera::getFrustumPlanes(veFrameVector<glm::vec4> &planes)
+	{
+		glm::mat4 M = glm::transpose(m_ubo.proj * m_ubo.view); //rows of the view projection matrix
+
+		planes.reserve(planes.size() + 6);
+		planes.push_back(M[3] + M[0]);
+		planes.push_back(M[3] - M[0]);
+		planes.push_back(M[3] + M[1]);
+		planes.push_back(M[3] - M[1]);
+		planes.push_back(M[2]); //depth range is 0 to 1
+		planes.push_back(M[3] - M[2]);
+
+		for (size_t i = planes.size() - 6; i < planes.size(); i++)
+		{ //normalize, so that the plane equation yields distances
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+		}
+	}
+
 	//-------------------------------------------------------------------------------------------------
 	//camera projective
 
@@ -943,7 +1074,8 @@ namespace ve
 	* \brief Update the UBO of this light.
 	*
 	* This function updates the UBO of this light, but also calls updates on the shadow
-	* cameras of this light.
+	* cameras of this light. Besides moving, a light is updated when the camera changes,
+	* since its shadow cameras follow the camera, or when the renderer must render its shadow maps.
 	*
 	* \param[in] worldMatrix The new world matrix of this light
 	*
@@ -974,13 +1106,14 @@ namespace ve
 
 		VECamera *pCam = getSceneManagerPointer()->getCamera();
 
-		if (!getEnginePointer()->isRayTracing())
+		if (!getEnginePointer()->isRayTracing() && getEnginePointer()->getRenderer()->hasShadowMaps(this))
 		{
 			updateShadowCameras(pCam, imageIndex); //copy shadow cam UBOs to GPU
 			for (uint32_t i = 0; i < m_shadowCameras.size(); i++)
 			{ //copy shadow cam UBOs to light UBO
 				m_ubo.shadowCameras[i] = m_shadowCameras[i]->m_ubo;
 			}
+			getEnginePointer()->getRenderer()->updateShadowTiles(this); //the renderer might keep older shadow maps
 		}
 
 		VESceneObject::updateUBO((void *)&m_ubo, (uint32_t)sizeof(veUBOPerLight_t), imageIndex);
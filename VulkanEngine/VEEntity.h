@@ -20,7 +20,8 @@ namespace ve
 		* VESceneNode represents any object that can be used by the scene manager to be put into the scene.
 		* This includes objects, cameras, lights, sky boxes or terrains.
 		* Scene nodes have a local to parent transform. This is a 4x4 matrix translating position and orientation
-		* from the local (object) space to the parent space.
+		* from the local (object) space to the parent space. The transforms are not stored in the node, but
+		* in the VETransformHierarchy of the scene manager, the node only holds the index of its entry.
 		* Scene nodes can have a parent. If so the local transform is relative to the parent transform. This
 		* relation is stored in the parent and children pointers.
 		* Since there is a parent-child relationship, scene nodes build up trees of nodes.
@@ -32,6 +33,7 @@ namespace ve
 	class VESceneNode : public VENamedClass
 	{
 		friend VESceneManager;
+		friend VETransformHierarchy;
 
 	public:
 		///Object type, can be just a scene node, or an object that additionally needs a UBO buffer
@@ -42,8 +44,7 @@ namespace ve
 		};
 
 	protected:
-		glm::mat4 m_transform = glm::mat4(
-			1.0); ///<Transform from local to parent space, the engine uses Y-UP, Left-handed
+		uint32_t m_transformIdx = VE_TRANSFORM_NONE; ///<Index of the transform from local to parent space in the transform hierarchy, the engine uses Y-UP, Left-handed
 		VkBuffer m_transformBuffer = VK_NULL_HANDLE; ///<Vulkan transform buffer handle
 		VmaAllocation m_transformBufferAllocation = nullptr; ///<VMA allocation info
 
@@ -54,8 +55,8 @@ namespace ve
 		//constructor
 		VESceneNode(std::string name, glm::mat4 transf = glm::mat4(1.0f));
 
-		///Destructor of the scene node class.
-		virtual ~VESceneNode() {};
+		//destructor
+		virtual ~VESceneNode();
 
 		//--------------------------------------------------------------------------------------
 		glm::mat4 getWorldTransform2(); //Compute the world matrix
@@ -117,7 +118,9 @@ namespace ve
 		void multiplyTransform(glm::mat4 trans); //Multiply the transform, e.g. translate, scale, rotate
 		glm::mat4 getWorldTransform(); //Compute the world matrix
 		glm::mat4 getWorldRotation(); //Compute the world matrix, only rotations
+		bool isWorldChanged(); //Check whether the world matrix changed in the last hierarchy update
 		void lookAt(glm::vec3 eye, glm::vec3 point, glm::vec3 up); //LookAt function for left handed system
+		void setDirty(); //Mark this node as changed, so it is updated in the next frame
 
 		//--------------------------------------------------------------------------------------
 		//manage tree, will make cmd buffers to be rerecorded since the tree is changed
@@ -229,14 +232,14 @@ namespace ve
 			glm::mat4 modelInvTrans; ///<Inverse transpose
 			glm::vec4 color; ///<Uniform color if needed by shader
 			glm::vec4 param; ///<Texture scaling and animation: 0,1..scale 2,3...offset
-			glm::ivec4 iparam; ///<iparam[0] is the resource idx, iparam[1] shows if normal map exists
-			glm::vec4 a; ///<paddding to ensure that struct has size 256
+			glm::ivec4 iparam; ///<iparam[0] is the material table slot, iparam[1] shows if normal map exists
+			glm::vec4 dequantize; ///<Offset (xyz) and scale (w) of packed vertex positions, also pads the struct to 256 bytes
 		};
 
 	protected:
 		veEntityType m_entityType = VE_ENTITY_TYPE_NORMAL; ///<Entity type
 		glm::vec4 m_param = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f); ///<Free parameter, e.g. for texture animation
-		uint32_t m_resourceIdx = 0; ///<Idx into subrenderer list of resources
+		uint32_t m_resourceIdx = 0; ///<Slot of the entity maps in the material table
 
 		VEEntity(std::string name, veEntityType type, VEMesh *pMesh, VEMaterial *pMat, glm::mat4 transf);
 
@@ -282,15 +285,16 @@ namespace ve
 
 		void setParam(glm::vec4 param); //set the free parameter
 		/**
-			* \brief set the index into the subrenderer resource list
+			* \brief set the slot of the entity maps in the material table
 			* \param[in] idx The new index
 			*/
 		void setResourceIdx(uint32_t idx)
 		{
 			m_resourceIdx = idx;
+			setDirty();
 		};
 
-		///\returns the index into the list of resources for this entity, held by the subrenderer
+		///\returns the slot of the entity maps in the material table
 		uint32_t getResourceIdx()
 		{
 			return m_resourceIdx;
@@ -300,6 +304,10 @@ namespace ve
 
 		virtual void
 			getBoundingSphere(glm::vec3 *center, float *radius); //return center and radius for a bounding sphere
+
+		glm::vec4 getWorldBoundingSphere(); //world space center and radius of the bounding sphere
+		bool isInFrustum(veFrameVector<glm::vec4> &planes); //test world space bounding sphere against frustum planes
+		static bool isSphereInFrustum(const glm::vec4 &sphere, veFrameVector<glm::vec4> &planes); //test a world space sphere against frustum planes
 	};
 
 	//--------------------------------------------------------------------------------------------------
@@ -341,7 +349,8 @@ namespace ve
 			glm::mat4 viewInverse; ///<Camera view inverse matrix (for ray tracing)
 			glm::mat4 projInverse; ///<Camera projection inverse matrix (for ray tracing)
 			glm::vec4 param; ///<param[0]: near plane param[1]: far plane distances - 2 and 3 are shadow depth fractions
-			glm::vec4 a, b, c, d, e, f, g; ///<paddding to ensure that struct has size multiple of 256
+			glm::vec4 tile; ///<Shadow cameras in a light UBO: offset and size of the shadow map in the shadow atlas, in texture coordinates
+			glm::vec4 b, c, d, e, f, g; ///<paddding to ensure that struct has size multiple of 256
 		};
 
 		struct veUBOPerCamera_t m_ubo; ///<The UBO that is copied to the GPU
@@ -376,6 +385,26 @@ namespace ve
 		///Set the camera extent, this is a pure virtual function for the base class
 		virtual void setExtent(VkExtent2D extent) = 0;
 
+		/**
+			* \brief Set the distance of the near plane
+			* \param[in] nearPlane The new distance
+			*/
+		void setNearPlane(float nearPlane)
+		{
+			m_nearPlane = nearPlane;
+			setDirty(); //new projection matrix
+		};
+
+		/**
+			* \brief Set the distance of the far plane
+			* \param[in] farPlane The new distance
+			*/
+		void setFarPlane(float farPlane)
+		{
+			m_farPlane = farPlane;
+			setDirty(); //new projection matrix
+		};
+
 		//-------------------------------------------------------------------------------------
 		//UBO
 
@@ -398,6 +427,8 @@ namespace ve
 			getBoundingSphere(glm::vec3 *center, float *radius); //return center and radius for a bounding sphere
 			///\returns list of frustum points in world space - pure virtual for the camera base class
 		virtual void getFrustumPoints(std::vector<glm::vec4> &points, float z0 = 0.0f, float z1 = 1.0f) = 0;
+
+		void getFrustumPlanes(veFrameVector<glm::vec4> &planes); //return the 6 frustum planes in world space
 	};
 
 	class VEPointLight;
@@ -451,6 +482,27 @@ namespace ve
 		virtual void setExtent(VkExtent2D e)
 		{
 			m_aspectRatio = (float)e.width / (float)e.height;
+			setDirty(); //new projection matrix
+		};
+
+		/**
+			* \brief Set the ratio between width and height
+			* \param[in] aspectRatio The new ratio
+			*/
+		void setAspectRatio(float aspectRatio)
+		{
+			m_aspectRatio = aspectRatio;
+			setDirty(); //new projection matrix
+		};
+
+		/**
+			* \brief Set the vertical field of view
+			* \param[in] fov The new field of view in degrees
+			*/
+		void setFov(float fov)
+		{
+			m_fov = fov;
+			setDirty(); //new projection matrix
 		};
 
 		//-------------------------------------------------------------------------------------
@@ -514,6 +566,7 @@ namespace ve
 		{
 			m_width = (float)e.width;
 			m_height = (float)e.height;
+			setDirty(); //new projection matrix
 		};
 
 		//-------------------------------------------------------------------------------------
@@ -581,6 +634,7 @@ namespace ve
 		struct veUBOPerLight_t m_ubo; ///<The UBO that is copied to the GPU
 		std::vector<VECamera *> m_shadowCameras; ///<Up to 6 shadow cameras for this light
 		bool m_switchedOn = true; ///<If false, then the colors are all zero
+		bool m_castShadows = true; ///<If false, the clustered forward renderer shades the light without shadow maps
 
 		glm::vec4 m_col_ambient = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); ///<Ambient color
 		glm::vec4 m_col_diffuse = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); ///<Diffuse color
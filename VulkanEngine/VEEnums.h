@@ -10,6 +10,9 @@ namespace ve
 		VE_RENDERER_TYPE_RAYTRACING_NV = 2,
 		VE_RENDERER_TYPE_RAYTRACING_KHR = 3,
 		VE_RENDERER_TYPE_HYBRID = 4,
+		VE_RENDERER_TYPE_FORWARD_INDIRECT = 5,
+		VE_RENDERER_TYPE_FORWARD_CLUSTERED = 6,
+		VE_RENDERER_TYPE_DEFERRED_TILED = 7,
 	};
 
 	/**
@@ -46,5 +49,23 @@ namespace ve
 		VE_SUBRENDERER_TYPE_CLOTH	///<Use a Diffuse texture to draw a cloth (two sided)
 	};
 
+	/**
+		* \brief enums the phases of the render loop whose times are measured
+		*/
+	enum veFramePhase
+	{
+		VE_FRAME_PHASE_FRAME, ///<The whole frame
+		VE_FRAME_PHASE_STARTED, ///<Frame started event
+		VE_FRAME_PHASE_EVENTS, ///<Window events and the event queue
+		VE_FRAME_PHASE_UPDATE, ///<Scene node updates
+		VE_FRAME_PHASE_DRAW, ///<Recording and submitting the cmd buffers
+		VE_FRAME_PHASE_PREP_OVERLAY, ///<Preparing the overlay
+		VE_FRAME_PHASE_OVERLAY_EVENTS, ///<Draw overlay event
+		VE_FRAME_PHASE_DRAW_OVERLAY, ///<Drawing the overlay
+		VE_FRAME_PHASE_ENDED, ///<Frame ended event
+		VE_FRAME_PHASE_PRESENT, ///<Presenting the frame
+		VE_FRAME_PHASE_LAST ///<Number of phases
+	};
+
 } // namespace ve
 #endif
\ No newline at end of file
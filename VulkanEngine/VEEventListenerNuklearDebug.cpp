@@ -28,52 +28,52 @@ namespace ve
 			nk_layout_row_dynamic(ctx, 30, 1);
 			nk_label(ctx, "LOOP", NK_TEXT_LEFT);
 
-			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, " Max Frametime (ms): %4.1f", getEnginePointer()->getMaxFrameTime() * 1000.0f);
-			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
-
-			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, " 30 FPS percentage: %4.1f", getEnginePointer()->getAcceptableLevel1() * 100.0f);
-			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
+			VEFrameStats *pStats = getEnginePointer()->getFrameStats();
 
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, " 60 FPS percentage: %4.1f", getEnginePointer()->getAcceptableLevel2() * 100.0f);
+			sprintf(outbuffer, " 30 FPS percentage: %4.1f", pStats->getFractionBelow(VE_FRAME_PHASE_FRAME, 1.0f / 30.0f) * 100.0f);
 			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
 
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, " Avg Frametime (ms): %4.1f", getEnginePointer()->getAvgFrameTime() * 1000.0f);
+			sprintf(outbuffer, " 60 FPS percentage: %4.1f", pStats->getFractionBelow(VE_FRAME_PHASE_FRAME, 1.0f / 60.0f) * 100.0f);
 			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
 
+			//p50, p99 and max of the last frames, spikes do not show in averages
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Started (ms): %4.1f", getEnginePointer()->getAvgStartedTime() * 1000.0f);
-			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
+			nk_label(ctx, " Time (ms): p50 / p99 / max", NK_TEXT_LEFT);
 
-			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Events(ms): %4.1f", getEnginePointer()->getAvgEventTime() * 1000.0f);
-			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
+			for (uint32_t i = 0; i < VE_FRAME_PHASE_LAST; i++)
+			{
+				veFrameStat_t stat = pStats->getWindowStats((veFramePhase)i);
+				nk_layout_row_dynamic(ctx, 30, 1);
+				sprintf(outbuffer, "  %s: %4.1f / %4.1f / %4.1f", VEFrameStats::getPhaseName((veFramePhase)i),
+					stat.p50 * 1000.0f, stat.p99 * 1000.0f, stat.max * 1000.0f);
+				nk_label(ctx, outbuffer, NK_TEXT_LEFT);
+			}
 
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Updates (ms): %4.1f", getEnginePointer()->getAvgUpdateTime() * 1000.0f);
+			sprintf(outbuffer, "  Allocs/frame: %llu", (unsigned long long)getEnginePointer()->getAllocationsPerFrame());
 			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
 
+			//----------------------------------------------------------
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Draw (ms): %4.1f", getEnginePointer()->getAvgDrawTime() * 1000.0f);
-			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
+			nk_label(ctx, "SCENE", NK_TEXT_LEFT);
 
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Prep Ovl (ms): %4.1f", getEnginePointer()->getAvgPrepOvlTime() * 1000.0f);
+			sprintf(outbuffer, "  Nodes updated: %u", getSceneManagerPointer()->getNumNodesUpdated());
 			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
 
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Ended (ms): %4.1f", getEnginePointer()->getAvgEndedTime() * 1000.0f);
+			sprintf(outbuffer, "  UBO upload (KB): %4.1f", getSceneManagerPointer()->getNumBytesUploaded() / 1024.0f);
 			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
 
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Draw Ovl (ms): %4.1f", getEnginePointer()->getAvgDrawOvlTime() * 1000.0f);
+			sprintf(outbuffer, "  Shadow maps rendered/cached: %u/%u", getEnginePointer()->getRenderer()->m_numShadowMapsRendered,
+				getEnginePointer()->getRenderer()->m_numShadowMapsCached);
 			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
 
 			nk_layout_row_dynamic(ctx, 30, 1);
-			sprintf(outbuffer, "  Present (ms): %4.1f", getEnginePointer()->getAvgPresentTime() * 1000.0f);
+			sprintf(outbuffer, "  Shadow draw calls: %u", getEnginePointer()->getRenderer()->m_numShadowDrawCalls);
 			nk_label(ctx, outbuffer, NK_TEXT_LEFT);
 
 			//----------------------------------------------------------
@@ -0,0 +1,206 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VEInclude.h"
+
+//debug builds count all heap allocations, so that allocations in the render loop can be found
+#if !defined(NDEBUG) && !defined(VE_NO_ALLOCATION_COUNTER)
+#define VE_COUNT_ALLOCATIONS
+#endif
+
+#ifdef VE_COUNT_ALLOCATIONS
+
+static std::atomic<uint64_t> g_veNumAllocations = 0; ///<Number of calls to operator new
+
+//all other forms of new and delete, e.g. new[], call one of these
+
+static void *veAllocate(size_t size)
+{
+	g_veNumAllocations.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size > 0 ? size : 1);
+}
+
+static void *veAllocateAligned(size_t size, std::align_val_t alignment)
+{
+	g_veNumAllocations.fetch_add(1, std::memory_order_relaxed);
+	size_t align = (size_t)alignment;
+	size = (std::max(size, (size_t)1) + align - 1) & ~(align - 1); //aligned_alloc needs a multiple of the alignment
+#ifdef _MSC_VER
+	return _aligned_malloc(size, align);
+#else
+	return std::aligned_alloc(align, size);
+#endif
+}
+
+static void veFreeAligned(void *p)
+{
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+void *operator new(size_t size)
+{
+	void *p = veAllocate(size);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	return veAllocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+	void *p = veAllocateAligned(size, alignment);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return veAllocateAligned(size, alignment);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+	veFreeAligned(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+	veFreeAligned(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+	veFreeAligned(p);
+}
+
+#endif
+
+namespace ve
+{
+	VEFrameArena *g_pVEFrameArenaSingleton = nullptr; ///<Singleton pointer to the frame arena
+
+	/**
+		*
+		* \returns the number of heap allocations since the program started
+		*
+		* Only debug builds count the allocations, otherwise 0 is returned.
+		*
+		*/
+	uint64_t veGetNumAllocations()
+	{
+#ifdef VE_COUNT_ALLOCATIONS
+		return g_veNumAllocations.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+
+	/**
+		*
+		* \brief Constructor, allocates the block and makes this the frame arena of the engine
+		*
+		* \param[in] capacity Initial size of the block, it grows if a frame needs more
+		*
+		*/
+	VEFrameArena::VEFrameArena(size_t capacity)
+	{
+		m_capacity = capacity;
+		m_pMemory = (unsigned char *)malloc(m_capacity);
+		m_overflow.reserve(64);
+		g_pVEFrameArenaSingleton = this;
+	}
+
+	/**
+		* \brief Destructor, frees the block
+		*/
+	VEFrameArena::~VEFrameArena()
+	{
+		reset();
+		free(m_pMemory);
+		if (g_pVEFrameArenaSingleton == this)
+			g_pVEFrameArenaSingleton = nullptr;
+	}
+
+	/**
+		*
+		* \brief Allocate memory that is valid until the next reset
+		*
+		* Thread safe. If the block is full, the memory is taken from the heap.
+		*
+		* \param[in] size Number of bytes
+		* \param[in] alignment Alignment of the memory, must be a power of 2
+		* \returns a pointer to the memory
+		*
+		*/
+	void *VEFrameArena::allocate(size_t size, size_t alignment)
+	{
+		size_t worst = size + alignment - 1; //enough for any alignment of the start
+		size_t offset = m_offset.fetch_add(worst, std::memory_order_relaxed);
+		if (offset + worst <= m_capacity)
+		{
+			uintptr_t start = ((uintptr_t)(m_pMemory + offset) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			return (void *)start;
+		}
+
+		//the block is full, take the memory from the heap until the next reset
+		void *p = malloc(worst);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_overflow.push_back(p);
+		return (void *)(((uintptr_t)p + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+
+	/**
+		*
+		* \brief Start a new frame
+		*
+		* All memory of the last frame is freed. If the last frame needed more than the block, then
+		* the block is enlarged. Must not be called while any thread still uses memory of the last frame.
+		*
+		*/
+	void VEFrameArena::reset()
+	{
+		m_peak = m_offset.exchange(0);
+
+		if (m_overflow.size() > 0)
+		{
+			for (auto p : m_overflow)
+			{
+				free(p);
+			}
+			m_overflow.clear();
+
+			m_capacity = std::max(2 * m_capacity, m_peak);
+			free(m_pMemory);
+			m_pMemory = (unsigned char *)malloc(m_capacity);
+		}
+	}
+
+} // namespace ve
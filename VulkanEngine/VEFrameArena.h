@@ -0,0 +1,122 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#ifndef VEFRAMEARENA_H
+#define VEFRAMEARENA_H
+
+#ifndef getFrameArenaPointer
+#define getFrameArenaPointer() g_pVEFrameArenaSingleton
+#endif
+
+namespace ve
+{
+	class VEFrameArena;
+
+	extern VEFrameArena *g_pVEFrameArenaSingleton; ///<Pointer to the frame arena of the engine
+
+	uint64_t veGetNumAllocations(); //number of heap allocations so far, 0 if they are not counted
+
+	/**
+		*
+		* \brief A linear allocator for data that lives for one frame only
+		*
+		* Memory is taken from one large block by atomically advancing an offset, so any thread of the render loop
+		* can allocate without locking. Nothing is freed individually, instead the engine resets the arena at the
+		* start of each frame. If the block is too small, the memory is taken from the heap and the block is
+		* enlarged at the next reset, so after a few frames all allocations fit into the block.
+		*
+		* Do not use the arena in background jobs, or for data that must survive the frame.
+		*
+		*/
+	class VEFrameArena
+	{
+	protected:
+		unsigned char *m_pMemory = nullptr; ///<The block
+		size_t m_capacity = 0; ///<Size of the block
+		std::atomic<size_t> m_offset = 0; ///<Start of the free part of the block
+		size_t m_peak = 0; ///<Max memory used in one frame since the last reset
+		std::mutex m_mutex; ///<Protects the overflow list
+		std::vector<void *> m_overflow; ///<Heap allocations of this frame that did not fit into the block
+
+	public:
+		VEFrameArena(size_t capacity = 1 << 20); //allocate the block
+		~VEFrameArena(); //free the block
+
+		void *allocate(size_t size, size_t alignment); //allocate memory for this frame
+		void reset(); //start a new frame, all memory is freed
+
+		///\returns the number of bytes allocated in the last frame
+		size_t getPeak()
+		{
+			return m_peak;
+		};
+
+		///\returns the size of the block
+		size_t getCapacity()
+		{
+			return m_capacity;
+		};
+	};
+
+	/**
+		*
+		* \brief STL allocator taking its memory from the frame arena
+		*
+		* Containers using it must be destroyed before the frame ends. Freeing does nothing,
+		* so containers should reserve their size up front instead of growing step by step.
+		*
+		*/
+	template<typename T>
+	class VEFrameAllocator
+	{
+	public:
+		using value_type = T;
+
+		VEFrameArena *m_pArena; ///<The arena to allocate from
+
+		///Constructor, uses the frame arena of the engine
+		VEFrameAllocator()
+			: m_pArena(getFrameArenaPointer()) {};
+
+		///Constructor
+		VEFrameAllocator(VEFrameArena *pArena)
+			: m_pArena(pArena) {};
+
+		///Conversion from an allocator of another type
+		template<typename U>
+		VEFrameAllocator(const VEFrameAllocator<U> &other)
+			: m_pArena(other.m_pArena) {};
+
+		///Allocate memory for n objects
+		T *allocate(size_t n)
+		{
+			return (T *)m_pArena->allocate(n * sizeof(T), alignof(T));
+		};
+
+		///Memory is freed when the arena is reset
+		void deallocate(T *, size_t) {};
+
+		template<typename U>
+		bool operator==(const VEFrameAllocator<U> &other) const
+		{
+			return m_pArena == other.m_pArena;
+		};
+
+		template<typename U>
+		bool operator!=(const VEFrameAllocator<U> &other) const
+		{
+			return m_pArena != other.m_pArena;
+		};
+	};
+
+	///A vector whose memory lives until the end of the frame
+	template<typename T>
+	using veFrameVector = std::vector<T, VEFrameAllocator<T>>;
+
+} // namespace ve
+
+#endif
@@ -0,0 +1,285 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VEInclude.h"
+
+namespace ve
+{
+	/**
+		* \brief Constructor, clears all samples
+		*/
+	VEFrameStats::VEFrameStats()
+	{
+		reset();
+	}
+
+	/**
+		*
+		* \brief Clear all samples, e.g. after loading a level
+		*
+		* Must not be called while the render loop records times.
+		*
+		*/
+	void VEFrameStats::reset()
+	{
+		for (auto &phase : m_phases)
+		{
+			for (auto &t : phase.window)
+				t.store(0.0f, std::memory_order_relaxed);
+			for (auto &n : phase.histogram)
+				n.store(0, std::memory_order_relaxed);
+			phase.count.store(0, std::memory_order_relaxed);
+			phase.sum.store(0.0, std::memory_order_relaxed);
+			phase.max.store(0.0f, std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	/**
+		* \param[in] t A time (s)
+		* \returns the histogram bucket of the time, bucket i holds times from 2^(i/8) to 2^((i+1)/8) us
+		*/
+	uint32_t VEFrameStats::getBucket(float t)
+	{
+		float us = t * 1.0e6f;
+		if (us <= 1.0f)
+			return 0;
+		uint32_t bucket = (uint32_t)(std::log2(us) * VE_FRAME_STATS_BUCKETS_PER_OCTAVE);
+		return std::min(bucket, VE_FRAME_STATS_BUCKETS - 1);
+	}
+
+	/**
+		* \param[in] bucket A histogram bucket
+		* \returns the time in the middle of the bucket (s)
+		*/
+	float VEFrameStats::getBucketTime(uint32_t bucket)
+	{
+		return 1.0e-6f * std::exp2((bucket + 0.5f) / VE_FRAME_STATS_BUCKETS_PER_OCTAVE);
+	}
+
+	/**
+		*
+		* \brief Record the time of a phase
+		*
+		* Called by the render loop only, other threads may read concurrently.
+		*
+		* \param[in] phase The phase
+		* \param[in] t The time the phase took (s)
+		*
+		*/
+	void VEFrameStats::record(veFramePhase phase, float t)
+	{
+		vePhaseSamples_t &samples = m_phases[phase];
+		uint64_t count = samples.count.load(std::memory_order_relaxed);
+
+		samples.window[count % VE_FRAME_STATS_WINDOW].store(t, std::memory_order_relaxed);
+		samples.histogram[getBucket(t)].fetch_add(1, std::memory_order_relaxed);
+		samples.sum.store(samples.sum.load(std::memory_order_relaxed) + t, std::memory_order_relaxed); //single writer
+		if (t > samples.max.load(std::memory_order_relaxed))
+			samples.max.store(t, std::memory_order_relaxed);
+		samples.count.store(count + 1, std::memory_order_release);
+	}
+
+	/**
+		*
+		* \brief Compute the distribution of a phase over the last VE_FRAME_STATS_WINDOW frames
+		*
+		* The window is copied to the stack and sorted, so this does not allocate.
+		*
+		* \param[in] phase The phase
+		* \returns the exact percentiles of the window, mean and max are also taken from the window
+		*
+		*/
+	veFrameStat_t VEFrameStats::getWindowStats(veFramePhase phase)
+	{
+		vePhaseSamples_t &samples = m_phases[phase];
+		uint32_t num = (uint32_t)std::min(samples.count.load(std::memory_order_acquire), (uint64_t)VE_FRAME_STATS_WINDOW);
+
+		veFrameStat_t stat;
+		if (num == 0)
+			return stat;
+
+		std::array<float, VE_FRAME_STATS_WINDOW> times;
+		double sum = 0.0;
+		for (uint32_t i = 0; i < num; i++)
+		{
+			times[i] = samples.window[i].load(std::memory_order_relaxed);
+			sum += times[i];
+		}
+		std::sort(times.begin(), times.begin() + num);
+
+		auto percentile = [&](float p) { //nearest rank
+			uint32_t rank = (uint32_t)std::ceil(p * num);
+			return times[std::max(rank, 1u) - 1];
+		};
+
+		stat.count = num;
+		stat.mean = (float)(sum / num);
+		stat.p50 = percentile(0.50f);
+		stat.p95 = percentile(0.95f);
+		stat.p99 = percentile(0.99f);
+		stat.max = times[num - 1];
+		return stat;
+	}
+
+	/**
+		*
+		* \brief Compute the distribution of a phase since the start or the last reset
+		*
+		* \param[in] phase The phase
+		* \returns the percentiles of the histogram, mean and max are exact
+		*
+		*/
+	veFrameStat_t VEFrameStats::getRunStats(veFramePhase phase)
+	{
+		vePhaseSamples_t &samples = m_phases[phase];
+
+		veFrameStat_t stat;
+		stat.count = samples.count.load(std::memory_order_acquire);
+		if (stat.count == 0)
+			return stat;
+		stat.mean = (float)(samples.sum.load(std::memory_order_relaxed) / stat.count);
+		stat.max = samples.max.load(std::memory_order_relaxed);
+
+		std::array<uint64_t, VE_FRAME_STATS_BUCKETS> histogram;
+		uint64_t total = 0;
+		for (uint32_t i = 0; i < VE_FRAME_STATS_BUCKETS; i++)
+		{
+			histogram[i] = samples.histogram[i].load(std::memory_order_relaxed);
+			total += histogram[i];
+		}
+
+		auto percentile = [&](float p) {
+			uint64_t rank = std::max((uint64_t)std::ceil(p * total), (uint64_t)1);
+			uint64_t below = 0;
+			for (uint32_t i = 0; i < VE_FRAME_STATS_BUCKETS; i++)
+			{
+				below += histogram[i];
+				if (below >= rank)
+					return std::min(getBucketTime(i), stat.max);
+			}
+			return stat.max;
+		};
+
+		stat.p50 = percentile(0.50f);
+		stat.p95 = percentile(0.95f);
+		stat.p99 = percentile(0.99f);
+		return stat;
+	}
+
+	/**
+		*
+		* \brief Compute the fraction of the last frames in which a phase took less than a given time
+		*
+		* \param[in] phase The phase
+		* \param[in] t The time (s), e.g. 1/60 for the fraction of frames reaching 60 FPS
+		* \returns the fraction between 0 and 1, 1 if nothing was recorded yet
+		*
+		*/
+	float VEFrameStats::getFractionBelow(veFramePhase phase, float t)
+	{
+		vePhaseSamples_t &samples = m_phases[phase];
+		uint32_t num = (uint32_t)std::min(samples.count.load(std::memory_order_acquire), (uint64_t)VE_FRAME_STATS_WINDOW);
+		if (num == 0)
+			return 1.0f;
+
+		uint32_t below = 0;
+		for (uint32_t i = 0; i < num; i++)
+		{
+			if (samples.window[i].load(std::memory_order_relaxed) < t)
+				below++;
+		}
+		return (float)below / num;
+	}
+
+	/**
+		* \param[in] phase The phase
+		* \returns the name of the phase, as used in the exported files
+		*/
+	const char *VEFrameStats::getPhaseName(veFramePhase phase)
+	{
+		static const char *names[VE_FRAME_PHASE_LAST] = {
+			"frame", "started", "events", "update", "draw",
+			"prep_overlay", "overlay_events", "draw_overlay", "ended", "present" };
+		return phase < VE_FRAME_PHASE_LAST ? names[phase] : "unknown";
+	}
+
+	/**
+		*
+		* \brief Write the statistics of all phases to a file
+		*
+		* If the file name ends with .csv, a CSV table with one row per phase and scope (window or run) is written.
+		* Otherwise a JSON object is written, which also holds the non empty histogram buckets of each phase.
+		* All times are in ms.
+		*
+		* \param[in] filename Name of the file, is overwritten
+		* \returns true if the file was written
+		*
+		*/
+	bool VEFrameStats::exportStats(const std::string &filename)
+	{
+		std::ofstream file(filename, std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		bool csv = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0;
+		file.setf(std::ios::fixed);
+		file.precision(4);
+
+		auto writeStat = [&](const char *name, const char *scope, veFrameStat_t &stat) {
+			if (csv)
+			{
+				file << name << "," << scope << "," << stat.count << "," << stat.mean * 1000.0f << ","
+					<< stat.p50 * 1000.0f << "," << stat.p95 * 1000.0f << "," << stat.p99 * 1000.0f << ","
+					<< stat.max * 1000.0f << "\n";
+				return;
+			}
+			file << "\t\t\t\"" << scope << "\": { \"count\": " << stat.count << ", \"mean\": " << stat.mean * 1000.0f
+				<< ", \"p50\": " << stat.p50 * 1000.0f << ", \"p95\": " << stat.p95 * 1000.0f << ", \"p99\": "
+				<< stat.p99 * 1000.0f << ", \"max\": " << stat.max * 1000.0f << " },\n";
+		};
+
+		if (csv)
+			file << "phase,scope,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+		else
+			file << "{\n\t\"window\": " << VE_FRAME_STATS_WINDOW << ",\n\t\"phases\": {\n";
+
+		for (uint32_t i = 0; i < VE_FRAME_PHASE_LAST; i++)
+		{
+			veFramePhase phase = (veFramePhase)i;
+			const char *name = getPhaseName(phase);
+			veFrameStat_t window = getWindowStats(phase);
+			veFrameStat_t run = getRunStats(phase);
+
+			if (!csv)
+				file << "\t\t\"" << name << "\": {\n";
+			writeStat(name, "window", window);
+			writeStat(name, "run", run);
+			if (csv)
+				continue;
+
+			//histogram as pairs of bucket time and count
+			file << "\t\t\t\"histogram\": [";
+			bool first = true;
+			for (uint32_t b = 0; b < VE_FRAME_STATS_BUCKETS; b++)
+			{
+				uint64_t n = m_phases[i].histogram[b].load(std::memory_order_relaxed);
+				if (n == 0)
+					continue;
+				file << (first ? " " : ", ") << "[" << getBucketTime(b) * 1000.0f << ", " << n << "]";
+				first = false;
+			}
+			file << " ]\n\t\t}" << (i + 1 < VE_FRAME_PHASE_LAST ? "," : "") << "\n";
+		}
+
+		if (!csv)
+			file << "\t}\n}\n";
+
+		return file.good();
+	}
+
+} // namespace ve
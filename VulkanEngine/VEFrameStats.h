@@ -0,0 +1,76 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#ifndef VEFRAMESTATS_H
+#define VEFRAMESTATS_H
+
+namespace ve
+{
+	const uint32_t VE_FRAME_STATS_WINDOW = 1024; ///<Number of recent frames the window percentiles are computed from
+	const uint32_t VE_FRAME_STATS_BUCKETS_PER_OCTAVE = 8; ///<Histogram buckets per doubling of the time
+	const uint32_t VE_FRAME_STATS_BUCKETS = 24 * VE_FRAME_STATS_BUCKETS_PER_OCTAVE; ///<Histogram buckets, covering 1 us to 16 s
+
+	///Distribution of the times of a phase (s)
+	struct veFrameStat_t
+	{
+		uint64_t count = 0; ///<Number of samples
+		float mean = 0.0f; ///<Mean time
+		float p50 = 0.0f; ///<Median time
+		float p95 = 0.0f; ///<95th percentile
+		float p99 = 0.0f; ///<99th percentile
+		float max = 0.0f; ///<Longest time
+	};
+
+	/**
+		*
+		* \brief Time statistics of the phases of the render loop
+		*
+		* For each phase, the times of the last VE_FRAME_STATS_WINDOW frames are kept in a ring, and all times since
+		* the start are counted in a histogram with logarithmic buckets. Percentiles of the window are exact, percentiles
+		* of the whole run are accurate to about 9%. Unlike averages, the percentiles and the max show rare spikes.
+		*
+		* Only the render loop records times. Everything is stored in atomics, so any thread can read the
+		* statistics without locking and without stalling the loop. Recording does not allocate.
+		*
+		*/
+	class VEFrameStats
+	{
+	protected:
+		///Samples of one phase
+		struct vePhaseSamples_t
+		{
+			std::array<std::atomic<float>, VE_FRAME_STATS_WINDOW> window; ///<Ring of the latest times
+			std::array<std::atomic<uint64_t>, VE_FRAME_STATS_BUCKETS> histogram; ///<Number of times in each bucket
+			std::atomic<uint64_t> count; ///<Number of recorded times
+			std::atomic<double> sum; ///<Sum of all times
+			std::atomic<float> max; ///<Longest time
+		};
+
+		std::array<vePhaseSamples_t, VE_FRAME_PHASE_LAST> m_phases; ///<Samples of all phases
+
+		static uint32_t getBucket(float t); //histogram bucket of a time
+		static float getBucketTime(uint32_t bucket); //representative time of a bucket
+
+	public:
+		VEFrameStats(); //clear all samples
+		~VEFrameStats() {};
+
+		void record(veFramePhase phase, float t); //record the time of a phase, render loop only
+		void reset(); //clear all samples
+
+		veFrameStat_t getWindowStats(veFramePhase phase); //distribution over the last frames
+		veFrameStat_t getRunStats(veFramePhase phase); //distribution since the start
+		float getFractionBelow(veFramePhase phase, float t); //fraction of the last frames faster than t
+
+		static const char *getPhaseName(veFramePhase phase); //name of a phase for printing
+
+		bool exportStats(const std::string &filename); //write JSON, or CSV if the file ends with .csv
+	};
+
+} // namespace ve
+
+#endif
@@ -11,6 +11,12 @@
 #include "VEEnums.h"
 
 #include "VHHelper.h"
+#include "VEJobSystem.h"
+#include "VETransformHierarchy.h"
+#include "VEFrameArena.h"
+#include "VEFrameStats.h"
+#include "VESlotMap.h"
+#include "VEMaterialTable.h"
 
 #include "VENamedClass.h"
 #include "VEEventListener.h"
@@ -19,6 +25,7 @@
 #include "VEEventListenerNuklearDebug.h"
 #include "VEWindow.h"
 #include "VEWindowGLFW.h"
+#include "VEWindowHeadless.h"
 #include "VEEngine.h"
 #include "VEMaterial.h"
 #include "VEEntity.h"
@@ -0,0 +1,206 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VEJobSystem.h"
+
+namespace ve
+{
+	thread_local VEJobSystem *VEJobSystem::t_pJobSystem = nullptr;
+	thread_local uint32_t VEJobSystem::t_threadIndex = 0;
+
+	/**
+		*
+		* \brief Constructor, starts the worker threads
+		*
+		* \param[in] threadCount Number of worker threads, if 0 then one for each hardware thread
+		*
+		*/
+	VEJobSystem::VEJobSystem(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+		m_threadCount = threadCount;
+		m_queues.resize(threadCount);
+		for (auto &pQueue : m_queues)
+		{
+			pQueue = std::make_unique<veWorkerQueue_t>();
+		}
+
+		m_threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			m_threads.emplace_back(&VEJobSystem::workerThread, this, i);
+		}
+	}
+
+	/**
+		* \brief Destructor, lets the workers finish their current task and joins them
+		*
+		* Tasks that have not been started yet are discarded.
+		*/
+	VEJobSystem::~VEJobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_terminate = true;
+			m_wakeUp.notify_all();
+		}
+		for (auto &thread : m_threads)
+		{
+			if (thread.joinable())
+				thread.join();
+		}
+	}
+
+	/**
+		*
+		* \brief Main function of the worker threads
+		*
+		* Runs tasks until the job system is destroyed, and sleeps while there are none.
+		*
+		* \param[in] threadIndex Index of this worker thread
+		*
+		*/
+	void VEJobSystem::workerThread(uint32_t threadIndex)
+	{
+		t_pJobSystem = this;
+		t_threadIndex = threadIndex;
+
+		VETask task;
+		while (!m_terminate)
+		{
+			if (pop(task, true))
+			{
+				task();
+				task = VETask();
+				continue;
+			}
+
+			//announce going to sleep before checking for tasks, so that push() either sees the sleeper or the sleeper sees the task
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_numSleeping.fetch_add(1);
+			m_wakeUp.wait(lock, [this]()
+				{ return m_terminate || m_numQueued.load() > 0; });
+			m_numSleeping.fetch_sub(1);
+		}
+	}
+
+	/**
+		*
+		* \returns the index of the calling thread
+		*
+		* Worker threads of this job system get 0 to getThreadCount()-1, all other threads getThreadCount().
+		*
+		*/
+	uint32_t VEJobSystem::getThreadIndex()
+	{
+		return t_pJobSystem == this ? t_threadIndex : getThreadCount();
+	}
+
+	/**
+		*
+		* \brief Push a task into a worker deque
+		*
+		* A worker pushes into its own deque, other threads distribute their tasks round robin.
+		*
+		* \param[in] task The task
+		*
+		*/
+	void VEJobSystem::push(VETask &&task)
+	{
+		uint32_t idx = getThreadIndex();
+		if (idx == getThreadCount())
+			idx = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % getThreadCount();
+
+		{
+			std::lock_guard<std::mutex> lock(m_queues[idx]->mutex);
+			m_queues[idx]->tasks.pushBack(std::move(task));
+		}
+		m_numQueued.fetch_add(1);
+		if (m_numSleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_wakeUp.notify_one();
+		}
+	}
+
+	/**
+		*
+		* \brief Take a task
+		*
+		* First from the back of the own deque, then from the front of the other deques, and then from the background queue.
+		*
+		* \param[out] task The task
+		* \param[in] background If true, background jobs are taken too
+		* \returns true if a task was found
+		*
+		*/
+	bool VEJobSystem::pop(VETask &task, bool background)
+	{
+		if (m_numQueued.load() == 0)
+			return false;
+
+		uint32_t numQueues = getThreadCount();
+		uint32_t self = getThreadIndex();
+		if (self < numQueues)
+		{
+			veWorkerQueue_t &queue = *m_queues[self];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				queue.tasks.popBack(task);
+				m_numQueued.fetch_sub(1);
+				return true;
+			}
+		}
+
+		for (uint32_t i = 1; i <= numQueues; i++)
+		{ //steal, starting with the neighbour
+			veWorkerQueue_t &queue = *m_queues[(self + i) % numQueues];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				queue.tasks.popFront(task);
+				m_numQueued.fetch_sub(1);
+				return true;
+			}
+		}
+
+		if (background)
+		{
+			std::lock_guard<std::mutex> lock(m_backgroundQueue.mutex);
+			if (!m_backgroundQueue.tasks.empty())
+			{
+				m_backgroundQueue.tasks.popFront(task);
+				m_numQueued.fetch_sub(1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+		*
+		* \brief Run one task from the worker deques
+		*
+		* Called by threads waiting for a task group. Background jobs are not run here.
+		*
+		* \returns true if a task was run
+		*
+		*/
+	bool VEJobSystem::runOne()
+	{
+		VETask task;
+		if (!pop(task, false))
+			return false;
+
+		task();
+		return true;
+	}
+
+} // namespace ve
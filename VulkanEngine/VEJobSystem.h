@@ -0,0 +1,421 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#ifndef VEJOBSYSTEM_H
+#define VEJOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ve
+{
+	const size_t VE_TASK_STORAGE_SIZE = 56; ///<Callables up to this size are stored inside the task, larger ones on the heap
+
+	/**
+		*
+		* \brief A callable with small buffer storage
+		*
+		* Lambdas capturing a few pointers and indices are stored inside the task, so
+		* creating a task does not allocate memory. Tasks can be moved, but not copied.
+		*
+		*/
+	class VETask
+	{
+	protected:
+		alignas(std::max_align_t) unsigned char m_storage[VE_TASK_STORAGE_SIZE]; ///<The callable, or a pointer to it if it is too large
+		void (*m_invoke)(void *pStorage) = nullptr; ///<Calls the callable
+		void (*m_relocate)(void *pDst, void *pSrc) = nullptr; ///<Moves the callable into other storage and destroys the source
+		void (*m_destroy)(void *pStorage) = nullptr; ///<Destroys the callable
+		std::atomic<uint32_t> *m_pPending = nullptr; ///<Counter of the task group, decreased when the task is done
+
+		///Callables that fit into the storage
+		template<typename F>
+		struct veInline_t
+		{
+			static void invoke(void *pStorage)
+			{
+				(*(F *)pStorage)();
+			}
+			static void relocate(void *pDst, void *pSrc)
+			{
+				new (pDst) F(std::move(*(F *)pSrc));
+				((F *)pSrc)->~F();
+			}
+			static void destroy(void *pStorage)
+			{
+				((F *)pStorage)->~F();
+			}
+		};
+
+		///Callables on the heap, the storage holds the pointer
+		template<typename F>
+		struct veHeap_t
+		{
+			static void invoke(void *pStorage)
+			{
+				(**(F **)pStorage)();
+			}
+			static void relocate(void *pDst, void *pSrc)
+			{
+				*(F **)pDst = *(F **)pSrc;
+			}
+			static void destroy(void *pStorage)
+			{
+				delete *(F **)pStorage;
+			}
+		};
+
+		void reset()
+		{
+			if (m_destroy != nullptr)
+				m_destroy(m_storage);
+			m_invoke = nullptr;
+			m_relocate = nullptr;
+			m_destroy = nullptr;
+			m_pPending = nullptr;
+		}
+
+	public:
+		///Constructor of an empty task
+		VETask() {};
+
+		/**
+			* \brief Constructor
+			* \param[in] func The callable to be run
+			* \param[in] pPending If not nullptr, this counter is decreased after the callable has run
+			*/
+		template<typename Func, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Func>, VETask>>>
+		VETask(Func &&func, std::atomic<uint32_t> *pPending = nullptr)
+			: m_pPending(pPending)
+		{
+			using F = std::decay_t<Func>;
+			if constexpr (sizeof(F) <= VE_TASK_STORAGE_SIZE && alignof(F) <= alignof(std::max_align_t) &&
+				std::is_nothrow_move_constructible_v<F>)
+			{
+				new (m_storage) F(std::forward<Func>(func));
+				m_invoke = &veInline_t<F>::invoke;
+				m_relocate = &veInline_t<F>::relocate;
+				m_destroy = &veInline_t<F>::destroy;
+			}
+			else
+			{
+				*(F **)m_storage = new F(std::forward<Func>(func));
+				m_invoke = &veHeap_t<F>::invoke;
+				m_relocate = &veHeap_t<F>::relocate;
+				m_destroy = &veHeap_t<F>::destroy;
+			}
+		}
+
+		///Move constructor
+		VETask(VETask &&other) noexcept
+		{
+			*this = std::move(other);
+		}
+
+		///Move operator
+		VETask &operator=(VETask &&other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				if (other.m_relocate != nullptr)
+					other.m_relocate(m_storage, other.m_storage);
+				m_invoke = other.m_invoke;
+				m_relocate = other.m_relocate;
+				m_destroy = other.m_destroy;
+				m_pPending = other.m_pPending;
+				other.m_invoke = nullptr;
+				other.m_relocate = nullptr;
+				other.m_destroy = nullptr;
+				other.m_pPending = nullptr;
+			}
+			return *this;
+		}
+
+		VETask(const VETask &) = delete;
+		VETask &operator=(const VETask &) = delete;
+
+		///Destructor
+		~VETask()
+		{
+			reset();
+		}
+
+		///Run the callable, then signal the task group
+		void operator()()
+		{
+			m_invoke(m_storage);
+			if (m_pPending != nullptr)
+				m_pPending->fetch_sub(1, std::memory_order_acq_rel);
+		}
+	};
+
+	const size_t VE_TASK_QUEUE_SIZE = 64; ///<Initial capacity of a task queue
+
+	/**
+		*
+		* \brief A double ended queue of tasks in a ring buffer
+		*
+		* Unlike std::deque, which allocates and frees blocks while tasks are taken from its front,
+		* the ring only allocates when it is full. It grows then and never shrinks, so in a steady frame
+		* pushing and popping tasks does not allocate. Not thread safe, the job system locks it.
+		*
+		*/
+	class VETaskQueue
+	{
+	protected:
+		std::vector<VETask> m_tasks; ///<The ring buffer
+		size_t m_first = 0; ///<Index of the task at the front
+		size_t m_size = 0; ///<Number of tasks in the ring
+
+		///Double the capacity, the tasks are moved to the start of the new ring
+		void grow()
+		{
+			std::vector<VETask> tasks(std::max(2 * m_tasks.size(), VE_TASK_QUEUE_SIZE));
+			for (size_t i = 0; i < m_size; i++)
+				tasks[i] = std::move(m_tasks[(m_first + i) % m_tasks.size()]);
+			m_tasks.swap(tasks);
+			m_first = 0;
+		}
+
+	public:
+		///Constructor
+		VETaskQueue()
+			: m_tasks(VE_TASK_QUEUE_SIZE) {};
+
+		///\returns true if there is no task
+		bool empty()
+		{
+			return m_size == 0;
+		};
+
+		///Add a task at the back
+		void pushBack(VETask &&task)
+		{
+			if (m_size == m_tasks.size())
+				grow();
+			m_tasks[(m_first + m_size) % m_tasks.size()] = std::move(task);
+			m_size++;
+		}
+
+		///Take the task at the back, the queue must not be empty
+		void popBack(VETask &task)
+		{
+			m_size--;
+			task = std::move(m_tasks[(m_first + m_size) % m_tasks.size()]);
+		}
+
+		///Take the task at the front, the queue must not be empty
+		void popFront(VETask &task)
+		{
+			task = std::move(m_tasks[m_first]);
+			m_first = (m_first + 1) % m_tasks.size();
+			m_size--;
+		}
+	};
+
+	class VETaskGroup;
+
+	/**
+		*
+		* \brief A work stealing job system
+		*
+		* Each worker thread owns a deque of tasks. A worker takes tasks from the back of its own deque,
+		* and if it is empty, steals from the front of the other deques. Tasks of task groups and parallelFor()
+		* go into these deques, and a thread waiting for them helps running tasks instead of blocking.
+		* Background jobs started by add() go into a separate queue that is only served by idle workers,
+		* so a waiting thread never picks up a long running job like decoding a model.
+		*
+		* Worker threads are numbered 0 to getThreadCount()-1, all other threads get the index getThreadCount().
+		* This index can be used for per-thread resources like command pools.
+		*
+		*/
+	class VEJobSystem
+	{
+		friend VETaskGroup;
+
+	protected:
+		///The deque of one worker thread
+		struct veWorkerQueue_t
+		{
+			std::mutex mutex; ///<Protects the deque, held only for pushing and popping
+			VETaskQueue tasks; ///<The owner works at the back, thieves steal from the front
+		};
+
+		uint32_t m_threadCount = 0; ///<Number of worker threads
+		std::vector<std::thread> m_threads; ///<The worker threads
+		std::vector<std::unique_ptr<veWorkerQueue_t>> m_queues; ///<One deque for each worker thread
+		veWorkerQueue_t m_backgroundQueue; ///<Jobs started by add()
+		std::atomic<uint32_t> m_nextQueue = 0; ///<Round robin index for tasks that are pushed by other threads
+		std::atomic<uint32_t> m_numQueued = 0; ///<Number of tasks in all queues
+		std::atomic<uint32_t> m_numSleeping = 0; ///<Number of workers that wait for tasks
+		std::atomic<bool> m_terminate = false; ///<Tell the workers to end
+		std::mutex m_sleepMutex; ///<Mutex for the condition variable
+		std::condition_variable m_wakeUp; ///<Wakes up sleeping workers
+
+		static thread_local VEJobSystem *t_pJobSystem; ///<Job system of the current worker thread
+		static thread_local uint32_t t_threadIndex; ///<Index of the current worker thread
+
+		void workerThread(uint32_t threadIndex); //main function of the worker threads
+		void push(VETask &&task); //push a task into a worker deque
+		bool pop(VETask &task, bool background); //take a task from the own deque, other deques, or the background queue
+		bool runOne(); //run one task from the deques, if there is one
+
+	public:
+		VEJobSystem(uint32_t threadCount = 0); //start the worker threads
+		~VEJobSystem(); //end the worker threads
+
+		VEJobSystem(const VEJobSystem &) = delete;
+		VEJobSystem &operator=(const VEJobSystem &) = delete;
+
+		///\returns the number of worker threads
+		uint32_t getThreadCount()
+		{
+			return m_threadCount;
+		};
+
+		uint32_t getThreadIndex(); //index of the calling thread
+
+		/**
+			*
+			* \brief Start a background job
+			*
+			* The job is run by an idle worker thread. Use this for long running jobs, the result can be waited for with the future.
+			* The job and its future are allocated on the heap, so the render loop uses VETaskGroup instead.
+			*
+			* \param[in] func The function to be called
+			* \param[in] args The arguments of the function, they are copied
+			* \returns a future for the result of the function
+			*
+			*/
+		template<typename Func, typename... Args>
+		auto add(Func &&func, Args &&... args) -> std::future<std::invoke_result_t<std::decay_t<Func>, std::decay_t<Args>...>>
+		{
+			using R = std::invoke_result_t<std::decay_t<Func>, std::decay_t<Args>...>;
+			std::packaged_task<R()> task(
+				[func = std::forward<Func>(func), ... args = std::forward<Args>(args)]() mutable -> R
+				{
+					return std::invoke(func, args...);
+				});
+			std::future<R> future = task.get_future();
+			{
+				std::lock_guard<std::mutex> lock(m_backgroundQueue.mutex);
+				m_backgroundQueue.tasks.pushBack(VETask(std::move(task)));
+			}
+			m_numQueued.fetch_add(1);
+			if (m_numSleeping.load() > 0)
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+				m_wakeUp.notify_one();
+			}
+			return future;
+		}
+
+		template<typename Func>
+		void parallelFor(uint32_t count, uint32_t granularity, Func &&func);
+	};
+
+	/**
+		*
+		* \brief A group of tasks that can be waited for
+		*
+		* While waiting, the calling thread runs tasks of the job system, so task groups can be nested.
+		* The group must be waited for before it is destroyed.
+		*
+		*/
+	class VETaskGroup
+	{
+	protected:
+		VEJobSystem *m_pJobSystem; ///<The job system running the tasks
+		std::atomic<uint32_t> m_pending = 0; ///<Number of tasks that are not done yet
+
+	public:
+		///Constructor
+		VETaskGroup(VEJobSystem *pJobSystem)
+			: m_pJobSystem(pJobSystem) {};
+
+		///Destructor, waits for the tasks
+		~VETaskGroup()
+		{
+			wait();
+		}
+
+		/**
+			* \brief Run a task as part of this group
+			* \param[in] func The callable, it should capture references or pointers only, so it fits into the task storage
+			*/
+		template<typename Func>
+		void run(Func &&func)
+		{
+			m_pending.fetch_add(1, std::memory_order_relaxed);
+			m_pJobSystem->push(VETask(std::forward<Func>(func), &m_pending));
+		}
+
+		///Wait until all tasks of the group are done, run other tasks meanwhile
+		void wait()
+		{
+			while (m_pending.load(std::memory_order_acquire) > 0)
+			{
+				if (!m_pJobSystem->runOne())
+					std::this_thread::yield();
+			}
+		}
+	};
+
+	/**
+		*
+		* \brief Call a function on ranges of indices in parallel
+		*
+		* The range [0, count) is split into at most getThreadCount()+1 chunks of at least granularity indices.
+		* The calling thread runs the first chunk itself and helps with the others until all are done.
+		*
+		* \param[in] count Number of indices
+		* \param[in] granularity Minimum number of indices per chunk
+		* \param[in] func Called as func(begin, end) for each chunk
+		*
+		*/
+	template<typename Func>
+	void VEJobSystem::parallelFor(uint32_t count, uint32_t granularity, Func &&func)
+	{
+		if (count == 0)
+			return;
+
+		uint32_t numChunks = std::max(std::min(count / std::max(granularity, 1u), getThreadCount() + 1), 1u);
+		if (numChunks == 1)
+		{
+			func(0u, count);
+			return;
+		}
+
+		uint32_t chunkSize = count / numChunks;
+		VETaskGroup group(this);
+		for (uint32_t k = 1; k < numChunks; k++)
+		{
+			uint32_t begin = k * chunkSize;
+			uint32_t end = k == numChunks - 1 ? count : begin + chunkSize;
+			group.run([&func, begin, end]()
+				{ func(begin, end); });
+		}
+		func(0u, chunkSize);
+		group.wait();
+	}
+
+} // namespace ve
+
+#endif
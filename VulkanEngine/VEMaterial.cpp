@@ -29,10 +29,66 @@ namespace ve
 		std::vector<vh::vhVertex> vertices; //vertex array
 		std::vector<uint32_t> indices; //index array
 
-		//copy the mesh vertex data
-		m_vertexCount = paiMesh->mNumVertices;
-		m_boundingSphereRadius = 0.0f;
-		m_boundingSphereCenter = glm::vec3(0.0f, 0.0f, 0.0f);
+		copyAiMesh(paiMesh, vertices, indices);
+		createBuffers(vertices, indices);
+	}
+
+	/**
+		*
+		* \brief VEMesh constructor from a vertex and an index list
+		*
+		* \param[in] name The name of the mesh.
+		* \param[in] vertices A list of vertices to be used
+		* \param[in] indices A list of indices to be used
+		*
+		*/
+
+	VEMesh::VEMesh(std::string name, std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices)
+		: VENamedClass(name)
+	{
+		createBuffers(vertices, indices);
+	}
+
+	/**
+		*
+		* \brief VEMesh constructor from vertex and index arrays with a known bounding sphere
+		*
+		* Used for meshes of cooked models, whose arrays can point right into a cache file.
+		* The arrays are copied into the upload ring, so they can be released after the call.
+		*
+		* \param[in] name The name of the mesh.
+		* \param[in] pVertices Pointer to the vertices
+		* \param[in] vertexCount Number of vertices
+		* \param[in] pIndices Pointer to the indices
+		* \param[in] indexCount Number of indices
+		* \param[in] indexType VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32
+		* \param[in] boundingSphereCenter Center of the bounding sphere in local space
+		* \param[in] boundingSphereRadius Radius of the bounding sphere in local space
+		*
+		*/
+
+	VEMesh::VEMesh(std::string name, const vh::vhVertex *pVertices, uint32_t vertexCount, const void *pIndices, uint32_t indexCount, VkIndexType indexType, glm::vec3 boundingSphereCenter, float boundingSphereRadius)
+		: VENamedClass(name)
+	{
+		m_boundingSphereCenter = boundingSphereCenter;
+		m_boundingSphereRadius = boundingSphereRadius;
+		createBuffers(pVertices, vertexCount, pIndices, indexCount, indexType);
+	}
+
+	/**
+		*
+		* \brief Copy the vertices and indices of an Assimp aiMesh
+		*
+		* Does not create any Vulkan object, so it can be called from any thread.
+		*
+		* \param[in] paiMesh Pointer to the Assimp aiMesh.
+		* \param[out] vertices The vertices of the mesh
+		* \param[out] indices The indices of the mesh faces
+		*
+		*/
+	void VEMesh::copyAiMesh(const aiMesh *paiMesh, std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices)
+	{
+		vertices.reserve(paiMesh->mNumVertices);
 		for (uint32_t i = 0; i < paiMesh->mNumVertices; i++)
 		{
 			vh::vhVertex vertex;
@@ -40,11 +96,6 @@ namespace ve
 			vertex.pos.y = paiMesh->mVertices[i].y;
 			vertex.pos.z = paiMesh->mVertices[i].z;
 
-			m_boundingSphereRadius = std::max(
-				std::max(std::max(vertex.pos.x * vertex.pos.x, vertex.pos.y * vertex.pos.y),
-					vertex.pos.z * vertex.pos.z),
-				m_boundingSphereRadius);
-
 			if (paiMesh->HasNormals())
 			{ //copy normals
 				vertex.normal.x = paiMesh->mNormals[i].x;
@@ -67,75 +118,103 @@ namespace ve
 
 			vertices.push_back(vertex);
 		}
-		m_boundingSphereRadius = sqrt(m_boundingSphereRadius);
 
 		//got through the aiMesh faces, and copy the indices
-		m_indexCount = 0;
 		for (uint32_t i = 0; i < paiMesh->mNumFaces; i++)
 		{
 			for (uint32_t j = 0; j < paiMesh->mFaces[i].mNumIndices; j++)
 			{
 				indices.push_back(paiMesh->mFaces[i].mIndices[j]);
-				m_indexCount++;
 			}
 		}
+	}
 
-		//create the vertex buffer
-		VECHECKRESULT(vh::vhBufCreateVertexBuffer(getEnginePointer()->getRenderer()->getDevice(),
-			getEnginePointer()->getRenderer()->getVmaAllocator(),
-			getEnginePointer()->getRenderer()->getGraphicsQueue(),
-			getEnginePointer()->getRenderer()->getCommandPool(),
-			vertices, &m_vertexBuffer, &m_vertexBufferAllocation));
-
-		//create the index buffer
-		VECHECKRESULT(vh::vhBufCreateIndexBuffer(getEnginePointer()->getRenderer()->getDevice(),
-			getEnginePointer()->getRenderer()->getVmaAllocator(),
-			getEnginePointer()->getRenderer()->getGraphicsQueue(),
-			getEnginePointer()->getRenderer()->getCommandPool(),
-			indices, &m_indexBuffer, &m_indexBufferAllocation));
+	/**
+		*
+		* \brief Compute the bounding sphere of a vertex array
+		*
+		* The sphere is centered at the origin of the local space and contains all vertices.
+		*
+		* \param[in] pVertices Pointer to the vertices
+		* \param[in] vertexCount Number of vertices
+		* \param[out] center Center of the sphere
+		* \param[out] radius Radius of the sphere
+		*
+		*/
+	void VEMesh::computeBoundingSphere(const vh::vhVertex *pVertices, uint32_t vertexCount, glm::vec3 &center, float &radius)
+	{
+		radius = 0.0f;
+		center = glm::vec3(0.0f, 0.0f, 0.0f);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{ //find max over all vertices
+			radius = std::max(glm::dot(pVertices[i].pos, pVertices[i].pos), radius);
+		}
+		radius = sqrt(radius);
 	}
 
 	/**
 		*
-		* \brief VEMesh constructor from a vertex and an index list
+		* \brief Compute the bounding sphere and create the vertex and index buffers
 		*
-		* \param[in] name The name of the mesh.
 		* \param[in] vertices A list of vertices to be used
 		* \param[in] indices A list of indices to be used
 		*
 		*/
+	void VEMesh::createBuffers(std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices)
+	{
+		computeBoundingSphere(vertices.data(), (uint32_t)vertices.size(), m_boundingSphereCenter, m_boundingSphereRadius);
+		createBuffers(vertices.data(), (uint32_t)vertices.size(), indices.data(), (uint32_t)indices.size(), VK_INDEX_TYPE_UINT32);
+	}
 
-	VEMesh::VEMesh(std::string name, std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices)
-		: VENamedClass(name)
+	/**
+		*
+		* \brief Create the vertex and index buffers from arrays
+		*
+		* Ray tracing reads the index buffers as 32 bit indices, so 16 bit indices are widened when ray tracing.
+		*
+		* \param[in] pVertices Pointer to the vertices
+		* \param[in] vertexCount Number of vertices
+		* \param[in] pIndices Pointer to the indices
+		* \param[in] indexCount Number of indices
+		* \param[in] indexType VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32
+		*
+		*/
+	void VEMesh::createBuffers(const vh::vhVertex *pVertices, uint32_t vertexCount, const void *pIndices, uint32_t indexCount, VkIndexType indexType)
 	{
-		//copy the mesh vertex data
-		m_vertexCount = (uint32_t)vertices.size();
-		m_boundingSphereRadius = 0.0f;
-		m_boundingSphereCenter = glm::vec3(0.0f, 0.0f, 0.0f);
-		for (uint32_t i = 0; i < vertices.size(); i++)
-		{ //find max over all vertices
-			m_boundingSphereRadius = std::max(
-				std::max(std::max(vertices[i].pos.x * vertices[i].pos.x, vertices[i].pos.y * vertices[i].pos.y),
-					vertices[i].pos.z * vertices[i].pos.z),
-				m_boundingSphereRadius);
-		}
-		m_boundingSphereRadius = sqrt(m_boundingSphereRadius);
+		m_vertexCount = vertexCount;
+		m_indexCount = indexCount;
+		m_indexType = indexType;
 
-		m_indexCount = (uint32_t)indices.size();
+		std::vector<uint32_t> indices32;
+		if (indexType == VK_INDEX_TYPE_UINT16 && getEnginePointer()->isRayTracing())
+		{
+			const uint16_t *pIndices16 = (const uint16_t *)pIndices;
+			indices32.assign(pIndices16, pIndices16 + indexCount);
+			pIndices = indices32.data();
+			m_indexType = VK_INDEX_TYPE_UINT32;
+		}
 
-		//create the vertex buffer
-		VECHECKRESULT(vh::vhBufCreateVertexBuffer(getEnginePointer()->getRenderer()->getDevice(),
-			getEnginePointer()->getRenderer()->getVmaAllocator(),
-			getEnginePointer()->getRenderer()->getGraphicsQueue(),
-			getEnginePointer()->getRenderer()->getCommandPool(),
-			vertices, &m_vertexBuffer, &m_vertexBufferAllocation));
+		//create the vertex buffer, the data is uploaded with the next batch of the upload ring
+		m_packed = getEnginePointer()->usePackedVertices();
+		if (m_packed)
+		{
+			std::vector<vh::vhVertexPacked> packed;
+			vh::vhMeshPackVertices(pVertices, vertexCount, packed, m_dequantize);
+			VECHECKRESULT(vh::vhBufCreateVertexBuffer(getEnginePointer()->getRenderer()->getVmaAllocator(),
+				getEnginePointer()->getRenderer()->getUploadRing(),
+				packed.data(), vertexCount, &m_vertexBuffer, &m_vertexBufferAllocation));
+		}
+		else
+		{
+			VECHECKRESULT(vh::vhBufCreateVertexBuffer(getEnginePointer()->getRenderer()->getVmaAllocator(),
+				getEnginePointer()->getRenderer()->getUploadRing(),
+				pVertices, vertexCount, &m_vertexBuffer, &m_vertexBufferAllocation));
+		}
 
 		//create the index buffer
-		VECHECKRESULT(vh::vhBufCreateIndexBuffer(getEnginePointer()->getRenderer()->getDevice(),
-			getEnginePointer()->getRenderer()->getVmaAllocator(),
-			getEnginePointer()->getRenderer()->getGraphicsQueue(),
-			getEnginePointer()->getRenderer()->getCommandPool(),
-			indices, &m_indexBuffer, &m_indexBufferAllocation));
+		VECHECKRESULT(vh::vhBufCreateIndexBuffer(getEnginePointer()->getRenderer()->getVmaAllocator(),
+			getEnginePointer()->getRenderer()->getUploadRing(),
+			pIndices, indexCount, m_indexType, &m_indexBuffer, &m_indexBufferAllocation));
 	}
 
 	/**
@@ -143,6 +222,7 @@ namespace ve
 		*/
 	VEMesh::~VEMesh()
 	{
+		vh::vhUploadFinish(getEnginePointer()->getRenderer()->getUploadRing()); //the buffers might still be upload targets
 		vmaDestroyBuffer(getEnginePointer()->getRenderer()->getVmaAllocator(), m_indexBuffer, m_indexBufferAllocation);
 		vmaDestroyBuffer(getEnginePointer()->getRenderer()->getVmaAllocator(), m_vertexBuffer, m_vertexBufferAllocation);
 	}
@@ -168,7 +248,8 @@ namespace ve
 		* \brief VETexture constructor from a list of textures.
 		*
 		* Create a VETexture from a list of textures. The textures must lie in the same directory and are stored in a texture array.
-		* This can be used also as a 2D texture or a cube map.
+		* This can be used also as a 2D texture or a cube map. A single KTX or DDS file is loaded with gli,
+		* keeping its mip levels and compressed format.
 		*
 		* \param[in] name The name of the mesh.
 		* \param[in] basedir Name of the directory the files are in.
@@ -187,55 +268,124 @@ namespace ve
 		if (texNames.size() == 0)
 			return;
 
-		VECHECKRESULT(vh::vhBufCreateTextureImage(getEnginePointer()->getRenderer()->getDevice(),
-			getEnginePointer()->getRenderer()->getVmaAllocator(),
-			getEnginePointer()->getRenderer()->getGraphicsQueue(),
-			getEnginePointer()->getRenderer()->getCommandPool(),
-			basedir, texNames, flags, &m_image, &m_deviceAllocation, &m_extent));
+		if (texNames.size() == 1 && vh::vhBufIsTextureFile(texNames[0]))
+		{
+			gli::texture texture;
+			VECHECKRESULT(vh::vhBufLoadTextureData(basedir, texNames[0], texture));
+			createImage(texture, flags, viewType);
+			return;
+		}
+
+		std::vector<vh::vhImageData> images;
+		VECHECKRESULT(vh::vhBufLoadImageData(basedir, texNames, images));
+		VECHECKRESULT(vh::vhBufCreateTextureImage(getEnginePointer()->getRenderer()->getVmaAllocator(),
+			getEnginePointer()->getRenderer()->getUploadRing(),
+			images, flags, &m_image, &m_deviceAllocation, &m_extent, &m_mipLevels));
 
 		m_format = VK_FORMAT_R8G8B8A8_UNORM;
 		VECHECKRESULT(vh::vhBufCreateImageView(getEnginePointer()->getRenderer()->getDevice(), m_image,
 			m_format, viewType,
 			(uint32_t)texNames.size(), VK_IMAGE_ASPECT_COLOR_BIT,
-			&m_imageInfo.imageView));
+			&m_imageInfo.imageView, m_mipLevels));
 
-		VECHECKRESULT(
-			vh::vhBufCreateTextureSampler(getEnginePointer()->getRenderer()->getDevice(), &m_imageInfo.sampler));
+		VECHECKRESULT(vh::vhBufCreateTextureSampler(getEnginePointer()->getRenderer()->getDevice(), &m_imageInfo.sampler,
+			m_mipLevels, getEnginePointer()->getRenderer()->getDeviceLimits().maxSamplerAnisotropy));
 	}
 
 	/**
 		*
-		* \brief VETexture constructor from a GLI cube map file.
+		* \brief VETexture constructor from a list of decoded images.
 		*
-		* Create a VETexture from a GLI cubemap file. This has been loaded using GLI from a ktx or dds file.
+		* Create a VETexture from images that have already been decoded, e.g. by a loader thread.
+		* The images are stored in a texture array.
 		*
-		* \param[in] name The name of the mesh.
-		* \param[in] texCube The GLI cubemap structure
-		* \param[in] flags Create flags for the images (e.g. Cube compatible or array)
-		* \param[in] viewType Type for the image views
+		* \param[in] name The name of the texture.
+		* \param[in] images List of decoded images, see vh::vhBufLoadImageData().
+		* \param[in] flags Vulkan flags for creating the textures.
+		* \param[in] viewType Vulkan view tape for the image view.
 		*
 		*/
-		/*VETexture::VETexture(std::string name, gli::texture_cube &texCube,
-				VkImageCreateFlags flags, VkImageViewType viewType) : VENamedClass(name) {
+	VETexture::VETexture(std::string name,
+		std::vector<vh::vhImageData> &images,
+		VkImageCreateFlags flags,
+		VkImageViewType viewType)
+		: VENamedClass(name)
+	{
+		if (images.size() == 0)
+			return;
 
-				VECHECKRESULT(vh::vhBufCreateTexturecubeImage(getEnginePointer()->getRenderer()->getDevice(), getEnginePointer()->getRenderer()->getVmaAllocator(),
-					getEnginePointer()->getRenderer()->getGraphicsQueue(), getEnginePointer()->getRenderer()->getCommandPool(),
-									texCube, &m_image, &m_deviceAllocation, &m_format));
+		VECHECKRESULT(vh::vhBufCreateTextureImage(getEnginePointer()->getRenderer()->getVmaAllocator(),
+			getEnginePointer()->getRenderer()->getUploadRing(),
+			images, flags, &m_image, &m_deviceAllocation, &m_extent, &m_mipLevels));
 
-				m_extent.width = texCube.extent().x;
-				m_extent.height = texCube.extent().y;
+		m_format = VK_FORMAT_R8G8B8A8_UNORM;
+		VECHECKRESULT(vh::vhBufCreateImageView(getEnginePointer()->getRenderer()->getDevice(), m_image,
+			m_format, viewType,
+			(uint32_t)images.size(), VK_IMAGE_ASPECT_COLOR_BIT,
+			&m_imageInfo.imageView, m_mipLevels));
 
-				VECHECKRESULT(vh::vhBufCreateImageView(getEnginePointer()->getRenderer()->getDevice(), m_image,
-									m_format, VK_IMAGE_VIEW_TYPE_CUBE, 6, VK_IMAGE_ASPECT_COLOR_BIT, &m_imageInfo.imageView));
+		VECHECKRESULT(vh::vhBufCreateTextureSampler(getEnginePointer()->getRenderer()->getDevice(), &m_imageInfo.sampler,
+			m_mipLevels, getEnginePointer()->getRenderer()->getDeviceLimits().maxSamplerAnisotropy));
+	}
 
-				VECHECKRESULT(vh::vhBufCreateTextureSampler(getEnginePointer()->getRenderer()->getDevice(), &m_imageInfo.sampler));
-			}*/
+	/**
+		*
+		* \brief VETexture constructor from a KTX or DDS texture.
+		*
+		* Create a VETexture from a texture that has been loaded with gli, e.g. by vh::vhBufLoadTextureData().
+		* All mip levels are taken from the texture. Block compressed formats are uploaded as they are if the
+		* device supports them, otherwise they are transcoded to RGBA8.
+		*
+		* \param[in] name The name of the texture.
+		* \param[in] texture The gli texture, can be 2D, a 2D array or a cube map.
+		* \param[in] flags Vulkan flags for creating the textures.
+		* \param[in] viewType Vulkan view tape for the image view, cube maps always get a cube view.
+		*
+		*/
+	VETexture::VETexture(std::string name,
+		gli::texture &texture,
+		VkImageCreateFlags flags,
+		VkImageViewType viewType)
+		: VENamedClass(name)
+	{
+		createImage(texture, flags, viewType);
+	}
 
-			/**
-				* \brief VETexture destructor - destroy the sampler, image view and image
-				*/
+	/**
+		*
+		* \brief Create the image, image view and sampler from a gli texture
+		*
+		* \param[in] texture The gli texture.
+		* \param[in] flags Vulkan flags for creating the textures.
+		* \param[in] viewType Vulkan view tape for the image view.
+		*
+		*/
+	void VETexture::createImage(gli::texture &texture, VkImageCreateFlags flags, VkImageViewType viewType)
+	{
+		VECHECKRESULT(vh::vhBufCreateTextureImage(getEnginePointer()->getRenderer()->getVmaAllocator(),
+			getEnginePointer()->getRenderer()->getUploadRing(),
+			texture, flags, &m_image, &m_deviceAllocation, &m_extent, &m_mipLevels, &m_format));
+
+		if (texture.target() == gli::TARGET_CUBE)
+			viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+		else if (texture.target() == gli::TARGET_CUBE_ARRAY)
+			viewType = VK_IMAGE_VIEW_TYPE_CUBE_ARRAY;
+
+		VECHECKRESULT(vh::vhBufCreateImageView(getEnginePointer()->getRenderer()->getDevice(), m_image,
+			m_format, viewType,
+			(uint32_t)(texture.layers() * texture.faces()), VK_IMAGE_ASPECT_COLOR_BIT,
+			&m_imageInfo.imageView, m_mipLevels));
+
+		VECHECKRESULT(vh::vhBufCreateTextureSampler(getEnginePointer()->getRenderer()->getDevice(), &m_imageInfo.sampler,
+			m_mipLevels, getEnginePointer()->getRenderer()->getDeviceLimits().maxSamplerAnisotropy));
+	}
+
+	/**
+		* \brief VETexture destructor - destroy the sampler, image view and image
+		*/
 	VETexture::~VETexture()
 	{
+		vh::vhUploadFinish(getEnginePointer()->getRenderer()->getUploadRing()); //the image might still be an upload target
 		if (m_imageInfo.sampler != VK_NULL_HANDLE)
 			vkDestroySampler(getEnginePointer()->getRenderer()->getDevice(), m_imageInfo.sampler, nullptr);
 		if (m_imageInfo.imageView != VK_NULL_HANDLE)
@@ -342,6 +492,9 @@ namespace ve
 			if (distance > sphereRadius)
 				sphereRadius = distance;
 		}
+
+		m_boundingSphereCenter = centre;
+		m_boundingSphereRadius = sphereRadius;
 	}
 
 	/// <summary>
@@ -30,15 +30,22 @@ namespace ve
 		VmaAllocation m_deviceAllocation = nullptr; ///<VMA allocation info
 		VkExtent2D m_extent = { 0, 0 }; ///<map extent
 		VkFormat m_format; ///<texture format
+		uint32_t m_mipLevels = 1; ///<number of mip levels
 
-		//VETexture(std::string name, gli::texture_cube &texCube, VkImageCreateFlags flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_CUBE);
 		VETexture(std::string name, std::string &basedir, std::vector<std::string> texNames, VkImageCreateFlags flags = 0, VkImageViewType viewtype = VK_IMAGE_VIEW_TYPE_2D);
 
+		VETexture(std::string name, std::vector<vh::vhImageData> &images, VkImageCreateFlags flags = 0, VkImageViewType viewtype = VK_IMAGE_VIEW_TYPE_2D);
+
+		VETexture(std::string name, gli::texture &texture, VkImageCreateFlags flags = 0, VkImageViewType viewtype = VK_IMAGE_VIEW_TYPE_2D);
+
 		///Empty constructor
 		VETexture(std::string name)
 			: VENamedClass(name) {};
 
 		~VETexture();
+
+	protected:
+		void createImage(gli::texture &texture, VkImageCreateFlags flags, VkImageViewType viewType); //create image, view and sampler from a KTX or DDS texture
 	};
 
 	/**
@@ -84,13 +91,21 @@ namespace ve
 	{
 	protected:
 		VEMesh(std::string name);		
+
+		void createBuffers(std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices);
+
+		void createBuffers(const vh::vhVertex *pVertices, uint32_t vertexCount, const void *pIndices, uint32_t indexCount, VkIndexType indexType);
+
 	public:
 		uint32_t m_vertexCount = 0; ///<Number of vertices in the vertex buffer
 		uint32_t m_indexCount = 0; ///<Number of indices in the index buffer
+		VkIndexType m_indexType = VK_INDEX_TYPE_UINT32; ///<Type of the indices in the index buffer
 		VkBuffer m_vertexBuffer = VK_NULL_HANDLE; ///<Vulkan vertex buffer handle
 		VmaAllocation m_vertexBufferAllocation = nullptr; ///<VMA allocation info
 		VkBuffer m_indexBuffer = VK_NULL_HANDLE; ///<Vulkan index buffer handle
 		VmaAllocation m_indexBufferAllocation = nullptr; ///<VMA allocation info
+		bool m_packed = false; ///<true if the vertex buffer holds vhVertexPacked instead of vhVertex
+		glm::vec4 m_dequantize = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); ///<Offset (xyz) and scale (w) of packed positions
 		glm::vec3 m_boundingSphereCenter = glm::vec3(0.0f, 0.0f, 0.0f); ///<center of bounding sphere in local space
 		float m_boundingSphereRadius = 1.0; ///<Radius of bounding sphere in local space
 
@@ -98,7 +113,13 @@ namespace ve
 
 		VEMesh(std::string name, std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices);
 
+		VEMesh(std::string name, const vh::vhVertex *pVertices, uint32_t vertexCount, const void *pIndices, uint32_t indexCount, VkIndexType indexType, glm::vec3 boundingSphereCenter, float boundingSphereRadius);
+
 		virtual ~VEMesh();
+
+		static void copyAiMesh(const aiMesh *paiMesh, std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices);
+
+		static void computeBoundingSphere(const vh::vhVertex *pVertices, uint32_t vertexCount, glm::vec3 &center, float &radius);
 	};
 
 	//--------------------------------Begin-Cloth-Simulation-Stuff----------------------------------
@@ -0,0 +1,172 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VEInclude.h"
+
+namespace ve
+{
+	/**
+		*
+		* \brief Constructor, creates the table set
+		*
+		* The set has its own pool, since sets that are updated after binding must come from a pool created for this.
+		*
+		* \param[in] device Logical Vulkan device, must have the descriptor indexing features enabled
+		* \param[in] stageFlags The shader stages that read the maps
+		* \param[in] framesInFlight Number of frames after which the GPU does not use a released slot anymore
+		*
+		*/
+	VEMaterialTable::VEMaterialTable(VkDevice device, VkShaderStageFlags stageFlags, uint32_t framesInFlight)
+	{
+		m_device = device;
+		m_framesInFlight = framesInFlight;
+
+		VECHECKRESULT(vh::vhRenderCreateDescriptorPool(m_device,
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
+			{ VE_MATERIAL_MAPS * VE_MAX_MATERIALS },
+			&m_descriptorPool,
+			VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT));
+
+		//binding 0...diffuse maps
+		//binding 1...normal maps
+		VECHECKRESULT(vh::vhRenderCreateDescriptorSetLayout(m_device,
+			{ VE_MAX_MATERIALS, VE_MAX_MATERIALS },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
+			{ stageFlags, stageFlags },
+			&m_descriptorSetLayout,
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT));
+
+		std::vector<VkDescriptorSet> sets;
+		VECHECKRESULT(vh::vhRenderCreateDescriptorSets(m_device, 1, m_descriptorSetLayout, m_descriptorPool, sets));
+		m_descriptorSet = sets[0];
+
+		m_slots.resize(VE_MAX_MATERIALS);
+		m_freeSlots.reserve(VE_MAX_MATERIALS);
+		for (uint32_t i = VE_MAX_MATERIALS; i > 0; i--)
+		{
+			m_freeSlots.push_back(i - 1); //slot 0 is taken first
+		}
+	}
+
+	/**
+		* \brief Destructor, destroys the table set
+		*/
+	VEMaterialTable::~VEMaterialTable()
+	{
+		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+	}
+
+	/**
+		*
+		* \brief Get the slot of a material
+		*
+		* If an entity already uses the same maps, then its slot is shared. Otherwise a free slot is written.
+		* Since free slots are not used by any pending command buffer, this never waits for the GPU.
+		* The table cannot grow, since the shaders declare VE_MAX_MATERIALS slots. If all slots are used,
+		* a std::runtime_error is thrown. Thread safe.
+		*
+		* \param[in] maps The 1..VE_MATERIAL_MAPS maps of the material, e.g. {diffuse map} or {diffuse map, normal map}
+		* \returns the index of the slot, to be stored in the entity UBO
+		*
+		*/
+	uint32_t VEMaterialTable::acquire(std::vector<VkDescriptorImageInfo> &maps)
+	{
+		uint32_t numMaps = std::min((uint32_t)maps.size(), VE_MATERIAL_MAPS);
+		veMaterialKey_t key = {};
+		for (uint32_t i = 0; i < numMaps; i++)
+		{
+			key[2 * i] = (uint64_t)maps[i].imageView;
+			key[2 * i + 1] = (uint64_t)maps[i].sampler;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_materials.find(key);
+		if (it != m_materials.end())
+		{ //another entity uses the same maps
+			m_slots[it->second].refCount++;
+			return it->second;
+		}
+
+		if (m_freeSlots.empty())
+		{ //slots released in the last frames become free later
+			throw std::runtime_error("Error: More than " + std::to_string(VE_MAX_MATERIALS) + " materials are used!");
+		}
+
+		uint32_t idx = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		m_slots[idx].key = key;
+		m_slots[idx].refCount = 1;
+		m_materials[key] = idx;
+		m_numMaterials++;
+
+		VkWriteDescriptorSet descriptorWrites[VE_MATERIAL_MAPS] = {};
+		uint32_t numWrites = 0;
+		for (uint32_t i = 0; i < numMaps; i++)
+		{
+			if (maps[i].imageLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+				continue; //partially bound, the shader does not read this map
+
+			VkWriteDescriptorSet &dW = descriptorWrites[numWrites++];
+			dW.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			dW.dstSet = m_descriptorSet;
+			dW.dstBinding = i;
+			dW.dstArrayElement = idx;
+			dW.descriptorCount = 1;
+			dW.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			dW.pImageInfo = &maps[i];
+		}
+		vkUpdateDescriptorSets(m_device, numWrites, descriptorWrites, 0, nullptr);
+
+		return idx;
+	}
+
+	/**
+		*
+		* \brief Release the slot of a material
+		*
+		* If no other entity uses the material, the slot is retired. Command buffers in flight might still read it,
+		* so it becomes free only after m_framesInFlight frames. Thread safe.
+		*
+		* \param[in] idx Index of the slot
+		*
+		*/
+	void VEMaterialTable::release(uint32_t idx)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		veMaterialSlot_t &slot = m_slots[idx];
+		if (slot.refCount == 0 || --slot.refCount > 0)
+			return;
+
+		m_materials.erase(slot.key); //the maps might be destroyed, do not share this slot anymore
+		m_retiredSlots.push_back({ idx, m_frame });
+		m_numMaterials--;
+	}
+
+	/**
+		*
+		* \brief Start a new frame
+		*
+		* Called once per frame. Slots that were released long enough ago become free again.
+		*
+		*/
+	void VEMaterialTable::nextFrame()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_frame++;
+		while (!m_retiredSlots.empty() && m_retiredSlots.front().second + m_framesInFlight <= m_frame)
+		{
+			m_freeSlots.push_back(m_retiredSlots.front().first);
+			m_retiredSlots.pop_front();
+		}
+	}
+
+} // namespace ve
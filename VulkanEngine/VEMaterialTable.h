@@ -0,0 +1,85 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#ifndef VEMATERIALTABLE_H
+#define VEMATERIALTABLE_H
+
+namespace ve
+{
+	const uint32_t VE_MAX_MATERIALS = 4096; ///<Number of material slots, must match MAXMATERIALS in the shaders
+	const uint32_t VE_MATERIAL_MAPS = 2; ///<Maps of a material, 0 is the diffuse map, 1 the normal map
+
+	/**
+		*
+		* \brief Bindless table of the texture maps of all materials
+		*
+		* The table is one descriptor set holding one array of combined image samplers for each map type.
+		* A material is a slot in these arrays, and entities store the index of their slot in their UBO,
+		* so shaders pick their maps with this index. The set is bound once per draw and never changes,
+		* entities being added or removed only write the descriptors of unused slots.
+		*
+		* The set is created with update after bind and partially bound descriptors. So slots can be written
+		* while command buffers using the set are pending, as long as these command buffers do not use the slots.
+		* Entities with the same maps share a slot. When the last entity releases a slot, the slot might still be
+		* used by command buffers that are in flight, so it is written again only after some frames.
+		*
+		*/
+	class VEMaterialTable
+	{
+	protected:
+		typedef std::array<uint64_t, 2 * VE_MATERIAL_MAPS> veMaterialKey_t; ///<Image views and samplers of the maps of a material
+
+		///A slot in the table
+		struct veMaterialSlot_t
+		{
+			veMaterialKey_t key = {}; ///<Maps of the material in this slot
+			uint32_t refCount = 0; ///<Number of entities using the material, 0 if the slot is free or retired
+		};
+
+		VkDevice m_device = VK_NULL_HANDLE; ///<Logical Vulkan device
+		VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE; ///<Pool of the table set, allows update after bind
+		VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE; ///<Layout of the table set
+		VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE; ///<The table set
+		std::vector<veMaterialSlot_t> m_slots; ///<All slots of the table
+		std::vector<uint32_t> m_freeSlots; ///<Slots that can be written, used as a stack
+		std::deque<std::pair<uint32_t, uint64_t>> m_retiredSlots; ///<Released slots and their release frames in the order of release
+		std::map<veMaterialKey_t, uint32_t> m_materials; ///<Slot of each material that is used by entities
+		uint32_t m_numMaterials = 0; ///<Number of slots used by entities
+		uint32_t m_framesInFlight = 0; ///<Frames until the GPU is done with a released slot
+		uint64_t m_frame = 0; ///<Number of the current frame
+		std::mutex m_mutex; ///<Protects the slots
+
+	public:
+		VEMaterialTable(VkDevice device, VkShaderStageFlags stageFlags, uint32_t framesInFlight); //create the table set
+		~VEMaterialTable(); //destroy the table set
+
+		uint32_t acquire(std::vector<VkDescriptorImageInfo> &maps); //get the slot of a material
+		void release(uint32_t idx); //release the slot of a material
+		void nextFrame(); //start a new frame, old released slots become free
+
+		///\returns the layout of the table set
+		VkDescriptorSetLayout getDescriptorSetLayout()
+		{
+			return m_descriptorSetLayout;
+		};
+
+		///\returns the table set
+		VkDescriptorSet getDescriptorSet()
+		{
+			return m_descriptorSet;
+		};
+
+		///\returns the number of slots that are used by entities
+		uint32_t getNumberMaterials()
+		{
+			return m_numMaterials;
+		};
+	};
+
+} // namespace ve
+
+#endif
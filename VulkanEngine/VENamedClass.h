@@ -10,6 +10,8 @@
 
 namespace ve
 {
+	class VESceneManager;
+
 	/**
 		*
 		* \brief Base class of all classes that need a name.
@@ -19,8 +21,11 @@ namespace ve
 		*/
 	class VENamedClass
 	{
+		friend VESceneManager;
+
 	protected:
 		std::string m_name; ///<Name of this instance
+		VEHandle m_handle = VE_NULL_HANDLE; ///<Handle in the scene manager, if it is stored there
 
 	public:
 		///Constructor
@@ -33,6 +38,12 @@ namespace ve
 		~VENamedClass() {};
 
 		std::string getName(); //get the name
+
+		///\returns the handle of this instance in the scene manager, or VE_NULL_HANDLE if it is not stored there
+		VEHandle getHandle()
+		{
+			return m_handle;
+		};
 	};
 
 } // namespace ve
@@ -69,6 +69,168 @@ namespace ve
 		return nullptr;
 	}
 
+	/**
+		*
+		* \brief Cull all entities against the camera and all shadow cameras
+		*
+		* Command buffers are recorded only with the entities that are visible. If the camera or the entities move,
+		* other entities might become visible, and the command buffer must be recorded again. This function
+		* compares the current culling result with the one used for recording the command buffer of this image.
+		* The result is kept for each camera and subrenderer, so that only the command buffers of changed
+		* subrenderers have to be recorded again, see isVisibilityChanged().
+		*
+		* Culling is incremental: a camera whose frustum did not change only culls the entities that moved in this frame.
+		* Most shadow cameras do not move, so the scene is not culled once for each shadow camera in every frame.
+		*
+		* \param[in] imageIndex Index of the swapchain image that is currently used
+		* \returns true if the command buffer of this image must be recorded again
+		*
+		*/
+	bool VERenderer::updateVisibility(uint32_t imageIndex)
+	{
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		if (pCamera == nullptr)
+			return false;
+
+		veFrameVector<VECamera *> cameras;
+		cameras.reserve(1 + 6 * getSceneManagerPointer()->getLights().size());
+		cameras.push_back(pCamera);
+		for (auto pLight : getSceneManagerPointer()->getLights())
+		{
+			if (hasShadowMaps(pLight))
+				cameras.insert(cameras.end(), pLight->m_shadowCameras.begin(), pLight->m_shadowCameras.end());
+		}
+
+		if (m_visibility.size() <= imageIndex)
+			m_visibility.resize(imageIndex + 1);
+
+		//compare with the visibility of the last recording and overwrite it in place
+		//if the number of cameras changed, then the lists do not belong to the same cameras anymore
+		std::vector<std::vector<bool>> &visibility = m_visibility[imageIndex];
+		size_t numLists = cameras.size() * m_subrenderers.size();
+		bool changed = visibility.size() != numLists;
+		visibility.resize(numLists);
+		m_visibilityChanged.assign(numLists, changed ? 1 : 0);
+		m_cameraVisibility.resize(cameras.size());
+
+		size_t list = 0;
+		veFrameVector<glm::vec4> planes;
+		for (uint32_t c = 0; c < cameras.size(); c++)
+		{
+			planes.clear();
+			cameras[c]->getFrustumPlanes(planes);
+
+			veCameraVisibility_t &current = m_cameraVisibility[c];
+			bool moved = current.pCamera != cameras[c] || current.planes.size() != planes.size() ||
+				!std::equal(planes.begin(), planes.end(), current.planes.begin());
+			if (moved)
+			{ //the whole scene must be culled again
+				current.pCamera = cameras[c];
+				current.planes.assign(planes.begin(), planes.end());
+			}
+			current.versions.resize(m_subrenderers.size(), UINT64_MAX);
+			current.lists.resize(m_subrenderers.size());
+
+			for (uint32_t k = 0; k < m_subrenderers.size(); k++)
+			{
+				std::vector<VEEntity *> &entities = m_subrenderers[k]->getEntities();
+				std::vector<bool> &currentList = current.lists[k];
+				bool cullAll = moved || current.versions[k] != m_subrenderers[k]->getVersion() ||
+					currentList.size() != entities.size(); //entities were added or removed
+				current.versions[k] = m_subrenderers[k]->getVersion();
+				currentList.resize(entities.size());
+				for (uint32_t i = 0; i < entities.size(); i++)
+				{
+					if (cullAll || entities[i]->isWorldChanged())
+						currentList[i] = entities[i]->isInFrustum(planes);
+				}
+
+				if (visibility[list] != currentList)
+				{ //copying keeps the capacity, so this does not allocate once the lists have their size
+					visibility[list] = currentList;
+					m_visibilityChanged[list] = 1;
+					changed = true;
+				}
+				list++;
+			}
+		}
+		return changed;
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	//swapchain
+
+	/**
+		*
+		* \brief Create the swapchain
+		*
+		* Without a window surface, VE_OFFSCREEN_IMAGES images of the window extent are created instead.
+		* The image views are created too, the renderers destroy them.
+		*
+		*/
+	void VERenderer::createSwapchain()
+	{
+		if (isHeadless())
+		{
+			vh::vhSwapCreateOffscreenImages(m_physicalDevice, m_device, m_vmaAllocator, getWindowPointer()->getExtent(),
+				VE_OFFSCREEN_IMAGES, m_swapChainImages, m_offscreenAllocations, m_swapChainImageViews,
+				&m_swapChainImageFormat, &m_swapChainExtent);
+			return;
+		}
+
+		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device, getWindowPointer()->getExtent(),
+			&m_swapChain, m_swapChainImages, m_swapChainImageViews,
+			&m_swapChainImageFormat, &m_swapChainExtent);
+	}
+
+	/**
+		* \brief Destroy the swapchain or the offscreen images, their image views must have been destroyed
+		*/
+	void VERenderer::destroySwapchain()
+	{
+		if (isHeadless())
+		{
+			vh::vhSwapDestroyOffscreenImages(m_vmaAllocator, m_swapChainImages, m_offscreenAllocations);
+			return;
+		}
+
+		vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
+		m_swapChain = VK_NULL_HANDLE;
+	}
+
+	/**
+		*
+		* \brief Acquire the next swapchain image and store its index in m_imageIndex
+		*
+		* \param[in] imageAvailable Semaphore that is signaled when the image can be drawn into
+		* \returns the result of vkAcquireNextImageKHR(), offscreen images are never out of date
+		*
+		*/
+	VkResult VERenderer::acquireNextImage(VkSemaphore imageAvailable)
+	{
+		if (isHeadless())
+			return vh::vhSwapAcquireOffscreenImage(m_graphicsQueue, (uint32_t)m_swapChainImages.size(), imageAvailable, &m_imageIndex);
+
+		return vkAcquireNextImageKHR(m_device, m_swapChain, std::numeric_limits<uint64_t>::max(),
+			imageAvailable, VK_NULL_HANDLE, &m_imageIndex);
+	}
+
+	/**
+		*
+		* \brief Present the current swapchain image
+		*
+		* \param[in] renderFinished Semaphore that is signaled when the image is finished
+		* \returns the result of vkQueuePresentKHR(), offscreen images are not presented
+		*
+		*/
+	VkResult VERenderer::presentImage(VkSemaphore renderFinished)
+	{
+		if (isHeadless())
+			return vh::vhSwapPresentOffscreenImage(m_graphicsQueue, renderFinished);
+
+		return vh::vhRenderPresentResult(m_presentQueue, m_swapChain, m_imageIndex, renderFinished);
+	}
+
 	/**
 		* \brief Destroy all subrenderers
 		*/
@@ -157,6 +319,7 @@ namespace ve
 			if (m_subrenderers[i]->getType() == type)
 			{
 				m_subrenderers[i]->addEntity(pEntity);
+				m_subrenderers[i]->setChanged(); //its command buffers do not draw the new entity yet
 				return;
 			}
 		}
@@ -176,6 +339,7 @@ namespace ve
 	{
 		if (pEntity->m_pSubrenderer != nullptr)
 		{
+			pEntity->m_pSubrenderer->setChanged(); //its command buffers still draw the entity
 			pEntity->m_pSubrenderer->removeEntity(pEntity);
 		}
 	}
@@ -8,6 +8,9 @@
 #ifndef VERENDERER_H
 #define VERENDERER_H
 
+const VkDeviceSize VE_UPLOAD_RING_SIZE = 64 * 1024 * 1024; ///<Size of the staging ring for mesh and texture uploads
+const uint32_t VE_OFFSCREEN_IMAGES = 3; ///<Number of images replacing the swapchain without a window, more than frames in flight
+
 namespace ve
 {
 	class VEEngine;
@@ -22,6 +25,9 @@ namespace ve
 		* rendering process. However, it does not directly call vkDraw(...). Instead for this it creates and uses
 		* a list of VESubrender classes that are responsible for handling different entity types.
 		*
+		* If the window has no surface, e.g. VEWindowHeadless, then the renderer draws into offscreen images instead
+		* of a swapchain. Renderers use createSwapchain(), acquireNextImage() and presentImage() to handle both cases.
+		*
 		*/
 	class VERenderer
 	{
@@ -33,23 +39,28 @@ namespace ve
 		///\brief One secondary command buffer and the pool that it came from
 		struct secondaryCmdBuf_t
 		{
-			VkCommandBuffer buffer; ///<Vulkan cmd buffer handle
-			VkCommandPool pool; ///<Vulkan cmd buffer pool handle
+			VkCommandBuffer buffer = VK_NULL_HANDLE; ///<Vulkan cmd buffer handle
+			VkCommandPool pool = VK_NULL_HANDLE; ///<Vulkan cmd buffer pool handle
+			uint32_t numDraws = 0; ///<Number of draw calls recorded into the buffer
 			secondaryCmdBuf_t &operator=(const secondaryCmdBuf_t &right)
 			{ ///<copy operator
 				buffer = right.buffer;
 				pool = right.pool;
+				numDraws = right.numDraws;
 				return *this;
 			};
 		};
 
-		///\brief Shadow and light command buffers for one particular light
+		///\brief Shadow and light command buffers of one particular light for one swap chain image
 		struct secondaryBufferLists_t
 		{
-			std::vector<secondaryCmdBuf_t> shadowBuffers = {}; ///<list of secondary command buffers for the shadow pass
-			std::vector<secondaryCmdBuf_t> lightBuffers = {}; ///<list of secondary command buffers for the light pass
-			std::vector<std::future<secondaryCmdBuf_t>> shadowBufferFutures = {}; ///<futures to wait for if the buffers have been created in parallel
-			std::vector<std::future<secondaryCmdBuf_t>> lightBufferFutures = {}; ///<futures to wait for
+			std::vector<secondaryCmdBuf_t> shadowBuffers = {}; ///<secondary command buffers for the shadow pass, one for each shadow cascade and subrenderer
+			std::vector<secondaryCmdBuf_t> lightBuffers = {}; ///<secondary command buffers for the light pass, one for each subrenderer
+			std::vector<uint64_t> shadowVersions = {}; ///<version of the subrenderer that each shadow buffer was recorded with
+			std::vector<uint64_t> lightVersions = {}; ///<version of the subrenderer that each light buffer was recorded with
+			uint32_t numPass = 0; ///<number of the light pass that the buffers were recorded for
+			uint64_t shadowAtlasVersion = 0; ///<layout of the shadow atlas that the shadow buffers were recorded with
+			VECamera *pCamera = nullptr; ///<camera that the light buffers were recorded with
 		};
 
 		///\brief Shadow and light command buffers for one particular light
@@ -69,14 +80,16 @@ namespace ve
 		VkQueue m_presentQueue; ///<Vulkan present queue
 		VmaAllocator m_vmaAllocator; ///<VMA allocator
 		VkCommandPool m_commandPool; ///<Command pool of this thread
+		vh::vhUploadRing m_uploadRing; ///<Staging ring for filling vertex buffers, index buffers and textures
 
 		//surface
-		VkSurfaceKHR m_surface; ///<Vulkan KHR surface
+		VkSurfaceKHR m_surface = VK_NULL_HANDLE; ///<Vulkan KHR surface, VK_NULL_HANDLE if rendering offscreen
 		VkSurfaceCapabilitiesKHR m_surfaceCapabilities; ///<Surface capabilities
 		VkSurfaceFormatKHR m_surfaceFormat; ///<Surface format
 
 		//swapchain
-		VkSwapchainKHR m_swapChain; ///<Vulkan KHR swapchain
+		VkSwapchainKHR m_swapChain = VK_NULL_HANDLE; ///<Vulkan KHR swapchain
+		std::vector<VmaAllocation> m_offscreenAllocations; ///<Memory of the images replacing the swapchain if rendering offscreen
 		std::vector<VkFramebuffer> m_swapChainFramebuffers; ///<Framebuffers for light pass
 		std::vector<VkImage> m_swapChainImages; ///<A list of the swap chain images
 		VkFormat m_swapChainImageFormat; ///<Swap chain image format
@@ -86,6 +99,8 @@ namespace ve
 
 		VkDescriptorPool m_descriptorPool; ///<Descriptor pool for creating descriptor sets
 		VkDescriptorSetLayout m_descriptorSetLayoutPerObject; ///<Descriptor set layout for each scene object
+		VkDescriptorSetLayout m_descriptorSetLayoutPerObjectStorage = VK_NULL_HANDLE; ///<Descriptor set layout for indexing all entity UBOs of a memory block, for instanced and indirect drawing
+		VEMaterialTable *m_pMaterialTable = nullptr; ///<Bindless table of the maps of all entities
 
 		//subrenderers
 		std::vector<VESubrender *> m_subrenderers; ///<Subrenderers for lit objects
@@ -94,6 +109,19 @@ namespace ve
 		VESubrender *m_subrenderRT = nullptr; ///<Pointer to the raytracing subrenderer
 		VESubrender *m_subrenderComposer = nullptr; ///<Pointer to the composer subrenderer (Deferred rendering)
 
+		///Current culling result of one camera, entities are only culled again if they or the camera moved
+		struct veCameraVisibility_t
+		{
+			VECamera *pCamera = nullptr; ///<Camera the result belongs to
+			std::vector<glm::vec4> planes; ///<Frustum planes the result was computed with
+			std::vector<uint64_t> versions; ///<Version of each subrenderer the result was computed with
+			std::vector<std::vector<bool>> lists; ///<Visibility of the entities of each subrenderer
+		};
+
+		std::vector<veCameraVisibility_t> m_cameraVisibility; ///<current culling result of the camera and all shadow cameras
+		std::vector<std::vector<std::vector<bool>>> m_visibility; ///<culling results that the command buffers of each image were recorded with, one list for each camera and subrenderer
+		std::vector<uint8_t> m_visibilityChanged; ///<1 for each camera and subrenderer whose culling result changed in the last call to updateVisibility()
+
 		///Initialize the base class
 		virtual void initRenderer() {};
 
@@ -127,12 +155,33 @@ namespace ve
 		///Recreate the swap chain
 		virtual void recreateSwapchain() {};
 
+		void createSwapchain(); //create the swapchain, or the offscreen images
+		void destroySwapchain(); //destroy the swapchain, or the offscreen images
+		VkResult acquireNextImage(VkSemaphore imageAvailable); //get the index of the next image
+		VkResult presentImage(VkSemaphore renderFinished); //present the current image
+
+		virtual bool updateVisibility(uint32_t imageIndex); //cull all entities, return true if the result changed
+
+		/**
+			* \param[in] camera Index of the camera, 0 is the scene camera, then come the shadow cameras of all lights with shadow maps
+			* \param[in] subrenderer Index of the subrenderer
+			* \returns true if the last call to updateVisibility() found that the visible entities changed
+			*/
+		bool isVisibilityChanged(uint32_t camera, uint32_t subrenderer)
+		{
+			size_t idx = (size_t)camera * m_subrenderers.size() + subrenderer;
+			return idx < m_visibilityChanged.size() && m_visibilityChanged[idx] != 0;
+		};
+
 	public:
 		float m_AvgCmdShadowTime = 0.0f; ///<Average time for recording shadow maps
 		float m_AvgCmdLightTime = 0.0f; ///<Average time for recording light pass
 		float m_AvgCmdGBufferTime = 0.0f; ///<Average time for recording light pass
 		float m_AvgRecordTimeOffscreen = 0.0f; ///<Average recording time of one offscreen command buffer
 		float m_AvgRecordTimeOnscreen = 0.0f; ///<Average recording time of one onscreen command buffer
+		uint32_t m_numShadowMapsRendered = 0; ///<Number of shadow maps rendered in the last frame
+		uint32_t m_numShadowMapsCached = 0; ///<Number of shadow maps kept from earlier frames in the last frame
+		uint32_t m_numShadowDrawCalls = 0; ///<Number of draw calls of the shadow passes in the last frame
 		///Constructor
 		VERenderer();
 
@@ -142,6 +191,27 @@ namespace ve
 		///this function is calledby the scene manager if the tree changed
 		virtual void updateCmdBuffers() {};
 
+		///called if the UBO entry of a scene object moved, so command buffers binding it are outdated
+		virtual void invalidateCmdBuffers(VESceneObject *pObject)
+		{
+			updateCmdBuffers();
+		};
+
+		///\returns true if shadow maps are rendered for the light, so its shadow cameras must be updated
+		virtual bool hasShadowMaps(VELight *pLight)
+		{
+			return true;
+		};
+
+		///Called for each light with shadow maps after its shadow cameras have been copied into its UBO
+		virtual void updateShadowTiles(VELight *pLight) {};
+
+		///\returns true if the light must be updated in this frame although it did not move, e.g. to render its shadow maps
+		virtual bool needsLightUpdate(VELight *pLight)
+		{
+			return false;
+		};
+
 		///\returns the VMA allocator
 		virtual VmaAllocator getVmaAllocator()
 		{
@@ -154,6 +224,12 @@ namespace ve
 			return m_physicalDevice;
 		};
 
+		///\returns the limits of the physical device
+		virtual VkPhysicalDeviceLimits &getDeviceLimits()
+		{
+			return m_deviceLimits;
+		};
+
 		///\returns the Vulkan logical device
 		virtual VkDevice getDevice()
 		{
@@ -166,18 +242,36 @@ namespace ve
 			return m_descriptorSetLayoutPerObject;
 		};
 
+		///\returns the layout for accessing a whole entity memory block as storage buffer, VK_NULL_HANDLE if not needed
+		virtual VkDescriptorSetLayout getDescriptorSetLayoutPerObjectStorage()
+		{
+			return m_descriptorSetLayoutPerObjectStorage;
+		};
+
 		///\returns the descriptor pool of the per frame descriptors
 		virtual VkDescriptorPool getDescriptorPool()
 		{
 			return m_descriptorPool;
 		};
 
+		///\returns the bindless table of the maps of all entities
+		virtual VEMaterialTable *getMaterialTable()
+		{
+			return m_pMaterialTable;
+		};
+
 		///\returns the KHR surface that connects the window to Vulkan
 		virtual VkSurfaceKHR getSurface()
 		{
 			return m_surface;
 		};
 
+		///\returns true if the renderer draws into offscreen images, since there is no window surface
+		bool isHeadless()
+		{
+			return m_surface == VK_NULL_HANDLE;
+		};
+
 		///\returns the Vulkan graphics queue
 		virtual VkQueue getGraphicsQueue()
 		{
@@ -190,6 +284,12 @@ namespace ve
 			return m_commandPool;
 		};
 		
+		///\returns the staging ring that uploads mesh and texture data in batches
+		virtual vh::vhUploadRing *getUploadRing()
+		{
+			return &m_uploadRing;
+		};
+
 		///\returns pointer to the swap chain framebuffer vector
 		virtual std::vector<VkFramebuffer> &getSwapChainFrameBuffers()
 		{
@@ -12,8 +12,13 @@ const uint32_t SHADOW_MAP_DIM = 4096;
 
 namespace ve
 {
-	VERendererDeferred::VERendererDeferred()
-		: VERenderer()
+	/**
+	 * \brief Constructor of the deferred renderer
+	 * \param[in] tiled If true, lights without shadow maps are shaded by a tiled compute shader in one pass
+	 */
+	VERendererDeferred::VERendererDeferred(bool tiled)
+		: VERenderer(),
+		m_tiled(tiled)
 	{
 	}
 
@@ -57,10 +62,7 @@ namespace ve
 		vh::vhMemCreateVMAAllocator(getEnginePointer()->getInstance(),
 			m_physicalDevice, m_device, m_vmaAllocator);
 
-		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device,
-			getWindowPointer()->getExtent(), &m_swapChain,
-			m_swapChainImages, m_swapChainImageViews,
-			&m_swapChainImageFormat, &m_swapChainExtent);
+		createSwapchain();
 
 		//------------------------------------------------------------------------------------------------------------
 
@@ -68,10 +70,13 @@ namespace ve
 		vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface,
 			&m_commandPool);
 
+		vh::vhUploadInit(m_physicalDevice, m_device, m_surface, m_vmaAllocator, m_graphicsQueue,
+			VE_UPLOAD_RING_SIZE, &m_uploadRing); //staging ring for meshes and textures
+
 		m_commandPools.resize(getEnginePointer()
-			->getThreadPool()
-			->threadCount()); // each thread in the thread pool
-// gets its own command pool
+			->getJobSystem()
+			->getThreadCount() + 1); // each worker thread gets its own command pool,
+// the last one is for the main thread
 		for (uint32_t i = 0; i < m_commandPools.size(); i++)
 		{
 			vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface,
@@ -96,8 +101,6 @@ namespace ve
 			m_secondaryBuffersOnscreen[i] = {}; // will be created later
 		}
 
-		m_secondaryBuffersOnscreenFutures.resize(m_swapChainImages.size());
-
 		//------------------------------------------------------------------------------------------------------------
 		// create resources for onscreen pass
 		m_depthMap = new VETexture("DepthMap");
@@ -105,7 +108,8 @@ namespace ve
 		m_depthMap->m_extent = m_swapChainExtent;
 
 		// onscreen render pass
-		vh::vhRenderCreateRenderPassOffscreen(m_device, m_depthMap->m_format, &m_renderPassOffscreen);
+		vh::vhRenderCreateRenderPassOffscreen(m_device, VE_GBUFFER_NORMAL_FORMAT, VE_GBUFFER_ALBEDO_FORMAT,
+			m_depthMap->m_format, &m_renderPassOffscreen);
 		vh::vhRenderCreateRenderPass(m_device, m_swapChainImageFormat, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_CLEAR, &m_renderPassOnscreenClear);
 		vh::vhRenderCreateRenderPass(m_device, m_swapChainImageFormat, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_LOAD, &m_renderPassOnscreenLoad);
 
@@ -126,68 +130,7 @@ namespace ve
 
 		//------------------------------------------------------------------------------------------------------------
 		// create resources for offscreen pass
-		std::vector<VkImageView> offscreenPostionMaps;
-		std::vector<VkImageView> offscreenNormalMaps;
-		std::vector<VkImageView> offscreenAlbedoMaps;
-		std::vector<VkImageView> offscreenDepthMaps;
-
-		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++)
-		{
-			VETexture *depthMap = new VETexture("DepthMap");
-			depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
-			depthMap->m_extent = m_swapChainExtent;
-
-			VETexture *positionMap = new VETexture("Position");
-			positionMap->m_format = VK_FORMAT_R16G16B16A16_SFLOAT;
-			positionMap->m_extent = m_swapChainExtent;
-
-			VETexture *normalMap = new VETexture("Normal");
-			normalMap->m_format = VK_FORMAT_R16G16B16A16_SFLOAT;
-			normalMap->m_extent = m_swapChainExtent;
-
-			VETexture *albedoMap = new VETexture("Albedo");
-			albedoMap->m_format = VK_FORMAT_R8G8B8A8_UNORM;
-			albedoMap->m_extent = m_swapChainExtent;
-
-			// buffers for offscreen pass
-			vh::vhBufCreateOffscreenResources(
-				m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
-				positionMap->m_extent, positionMap->m_format, &positionMap->m_image,
-				&positionMap->m_deviceAllocation, &positionMap->m_imageInfo.imageView);
-			vh::vhBufCreateOffscreenResources(
-				m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
-				normalMap->m_extent, normalMap->m_format, &normalMap->m_image,
-				&normalMap->m_deviceAllocation, &normalMap->m_imageInfo.imageView);
-			vh::vhBufCreateOffscreenResources(
-				m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
-				albedoMap->m_extent, albedoMap->m_format, &albedoMap->m_image,
-				&albedoMap->m_deviceAllocation, &albedoMap->m_imageInfo.imageView);
-
-			// depth map for offscreen pass
-			vh::vhBufCreateDepthResources(
-				m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
-				depthMap->m_extent, depthMap->m_format, &depthMap->m_image,
-				&depthMap->m_deviceAllocation, &depthMap->m_imageInfo.imageView);
-
-			vh::vhBufCreateTextureSampler(m_device, &positionMap->m_imageInfo.sampler);
-			vh::vhBufCreateTextureSampler(m_device, &normalMap->m_imageInfo.sampler);
-			vh::vhBufCreateTextureSampler(m_device, &albedoMap->m_imageInfo.sampler);
-
-			offscreenPostionMaps.push_back(positionMap->m_imageInfo.imageView);
-			offscreenNormalMaps.push_back(normalMap->m_imageInfo.imageView);
-			offscreenAlbedoMaps.push_back(albedoMap->m_imageInfo.imageView);
-			offscreenDepthMaps.push_back(depthMap->m_imageInfo.imageView);
-
-			m_positionMaps.push_back(positionMap);
-			m_normalMaps.push_back(normalMap);
-			m_albedoMaps.push_back(albedoMap);
-			m_depthMaps.push_back(depthMap);
-		}
-
-		vh::vhBufCreateFramebuffersOffscreen(
-			m_device, offscreenPostionMaps, offscreenNormalMaps, offscreenAlbedoMaps,
-			offscreenDepthMaps, m_renderPassOffscreen, m_swapChainExtent,
-			m_offscreenFramebuffers);
+		createGBuffer();
 
 		//------------------------------------------------------------------------------------------------------------
 		// create resources for shadow pass
@@ -242,8 +185,13 @@ namespace ve
 		uint32_t maxobjects = 10000;
 		vh::vhRenderCreateDescriptorPool(m_device,
 			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
-			 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-			{ maxobjects, maxobjects }, &m_descriptorPool);
+			 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			 VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			 VK_DESCRIPTOR_TYPE_STORAGE_IMAGE },
+			{ maxobjects, maxobjects, maxobjects, maxobjects }, &m_descriptorPool);
+
+		//maps of all entities, slots are freed when no frame in flight can use them anymore
+		m_pMaterialTable = new VEMaterialTable(m_device, VK_SHADER_STAGE_FRAGMENT_BIT, getSwapChainNumber() + 1);
 
 		// Shadow Pass:
 		//
@@ -263,12 +211,17 @@ namespace ve
 		// set 0...cam UBO
 		// set 1...light UBO
 		// set 2...shadow maps
-		// set 3...position, normal, albedo map
+		// set 3...depth, normal, albedo map
+		//
+		// Tiled Lighting:
+		//
+		// set 0...cam UBO
+		// set 1...depth, normal, albedo map, lighting image, lights
 
 		// camera, light, UBO layout
 		vh::vhRenderCreateDescriptorSetLayout(
 			m_device, { 1 }, { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
-			{ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT },
+			{ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT },
 			&m_descriptorSetLayoutPerObject);
 
 		// set 2, binding 0 : shadow map + sampler
@@ -318,21 +271,40 @@ namespace ve
 				{ imageViews }, // textureImageViews
 				{ samplers } // samplers
 			);
+		}
 
-			vh::vhRenderUpdateDescriptorSet(
-				m_device, m_descriptorSetsOffscreen[i],
+		updateOffscreenDescriptorSets();
+
+		//------------------------------------------------------------------------------------------------------------
+		// create resources for tiled lighting
+
+		if (m_tiled)
+		{
+			// depth, normal, albedo map, lighting image, lights
+			vh::vhRenderCreateDescriptorSetLayout(
+				m_device, { 1, 1, 1, 1, 1 },
 				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 				 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-				 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER }, // Descriptor Types
-				{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE }, // UBOs
-				{ 0 }, // UBO sizes
-				{ {m_positionMaps[i]->m_imageInfo.imageView},
-				 {m_normalMaps[i]->m_imageInfo.imageView},
-				 {m_albedoMaps[i]->m_imageInfo.imageView} }, // textureImageViews
-				{ {m_positionMaps[i]->m_imageInfo.sampler},
-				 {m_normalMaps[i]->m_imageInfo.sampler},
-				 {m_albedoMaps[i]->m_imageInfo.sampler} } // samplers
-			);
+				 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				 VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				 VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+				{ VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT,
+				 VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT },
+				&m_descriptorSetLayoutTiled);
+
+			// lighting image, sampled by the first onscreen pass
+			vh::vhRenderCreateDescriptorSetLayout(
+				m_device, { 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
+				{ VK_SHADER_STAGE_FRAGMENT_BIT }, &m_descriptorSetLayoutResolve);
+
+			vh::vhPipeCreateGraphicsPipelineLayout(m_device,
+				{ m_descriptorSetLayoutPerObject, m_descriptorSetLayoutTiled },
+				{}, &m_pipelineLayoutTiled);
+
+			vh::vhPipeCreateComputePipeline(m_device, "../../media/shader/Deferred/Tiled/comp.spv",
+				m_pipelineLayoutTiled, &m_pipelineTiled);
+
+			createTiledResources();
 		}
 
 		//------------------------------------------------------------------------------------------------------------
@@ -352,7 +324,8 @@ namespace ve
 		addSubrenderer(new VESubrenderDF_DN(*this));
 		addSubrenderer(new VESubrenderDF_Shadow(*this));
 		addSubrenderer(new VESubrenderDF_Skyplane(*this));
-		addSubrenderer(new VESubrender_Nuklear(*this));
+		if (!isHeadless()) //the overlay needs a GLFW window
+			addSubrenderer(new VESubrender_Nuklear(*this));
 		addSubrenderer(new VESubrenderDF_Composer(*this));
 	}
 
@@ -380,7 +353,7 @@ namespace ve
 			vkDestroyImageView(m_device, imageView, nullptr);
 		}
 
-		vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
+		destroySwapchain();
 	}
 
 	/**
@@ -402,23 +375,8 @@ namespace ve
 			}
 		}
 
-		// destroy offscreen maps
-		for (auto pPositionMap : m_positionMaps)
-		{
-			delete pPositionMap;
-		}
-		for (auto pNormalMap : m_normalMaps)
-		{
-			delete pNormalMap;
-		}
-		for (auto pAlbedoMap : m_albedoMaps)
-		{
-			delete pAlbedoMap;
-		}
-		for (auto pDepthMap : m_depthMaps)
-		{
-			delete pDepthMap;
-		}
+		destroyGBuffer();
+
 		// destroy shadow maps
 		for (auto pShadowMapList : m_shadowMaps)
 		{
@@ -430,7 +388,18 @@ namespace ve
 
 		vkDestroyRenderPass(m_device, m_renderPassShadow, nullptr);
 
+		if (m_tiled)
+		{
+			destroyTiledResources();
+			vkDestroyPipeline(m_device, m_pipelineTiled, nullptr);
+			vkDestroyPipelineLayout(m_device, m_pipelineLayoutTiled, nullptr);
+			vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutTiled, nullptr);
+			vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutResolve, nullptr);
+		}
+
 		// destroy per frame resources
+		delete m_pMaterialTable;
+		m_pMaterialTable = nullptr;
 		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
 		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutPerObject,
 			nullptr);
@@ -451,6 +420,7 @@ namespace ve
 		for (auto pool : m_commandPools)
 			vkDestroyCommandPool(m_device, pool, nullptr);
 
+		vh::vhUploadDeinit(&m_uploadRing);
 		vmaDestroyAllocator(m_vmaAllocator);
 
 		vkDestroyDevice(m_device, nullptr);
@@ -465,10 +435,7 @@ namespace ve
 
 		cleanupSwapChain();
 
-		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device,
-			getWindowPointer()->getExtent(), &m_swapChain,
-			m_swapChainImages, m_swapChainImageViews,
-			&m_swapChainImageFormat, &m_swapChainExtent);
+		createSwapchain();
 
 		//------------------------------------------------------------------------------------------------------------
 		// create resources for onscreen pass
@@ -476,8 +443,8 @@ namespace ve
 		m_depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
 		m_depthMap->m_extent = m_swapChainExtent;
 
-		vh::vhRenderCreateRenderPassOffscreen(m_device, m_depthMap->m_format,
-			&m_renderPassOffscreen);
+		vh::vhRenderCreateRenderPassOffscreen(m_device, VE_GBUFFER_NORMAL_FORMAT, VE_GBUFFER_ALBEDO_FORMAT,
+			m_depthMap->m_format, &m_renderPassOffscreen);
 		vh::vhRenderCreateRenderPass(m_device, m_swapChainImageFormat, 
 			m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_CLEAR,
 			&m_renderPassOnscreenClear);
@@ -500,9 +467,76 @@ namespace ve
 			m_swapChainFramebuffers);
 
 		//------------------------------------------------------------------------------------------------------------
-		// create resources for offscreen pass
+		// create resources for offscreen pass, the old maps do not fit the new extent
+		destroyGBuffer();
+		createGBuffer();
+
+		updateOffscreenDescriptorSets();
+
+		if (m_tiled)
+		{ // the lighting images have the extent of the swapchain
+			destroyTiledResources();
+			createTiledResources();
+		}
 
-		std::vector<VkImageView> offscreenPostionMaps;
+		for (auto pSub : m_subrenderers)
+			pSub->recreateResources();
+		m_subrenderComposer->recreateResources();
+
+		deleteCmdBuffers();
+	}
+
+	/**
+	 * \brief Create the semaphores and fences for syncing command buffers and
+	 * swapchain
+	 */
+	void VERendererDeferred::createSyncObjects()
+	{
+		m_imageAvailableSemaphores.resize(
+			MAX_FRAMES_IN_FLIGHT); // for wait for the next swap chain image
+		m_offscreenSemaphores.resize(
+			MAX_FRAMES_IN_FLIGHT); // for wait for render finished
+		m_renderFinishedSemaphores.resize(
+			MAX_FRAMES_IN_FLIGHT); // for wait for render finished
+		m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT); // for wait for at least one
+		// image in the swap chain
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		m_overlaySemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
+				&m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
+					&m_offscreenSemaphores[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
+					&m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
+					&m_overlaySemaphores[i]) != VK_SUCCESS ||
+				vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]) !=
+				VK_SUCCESS)
+			{
+				assert(false);
+				exit(1);
+			}
+		}
+	}
+
+	/**
+	 *
+	 * \brief Create the G-buffer of each swapchain image and the offscreen framebuffers
+	 *
+	 * There is no position map, the composer reconstructs positions from the depth map.
+	 *
+	 */
+	void VERendererDeferred::createGBuffer()
+	{
 		std::vector<VkImageView> offscreenNormalMaps;
 		std::vector<VkImageView> offscreenAlbedoMaps;
 		std::vector<VkImageView> offscreenDepthMaps;
@@ -513,23 +547,15 @@ namespace ve
 			depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
 			depthMap->m_extent = m_swapChainExtent;
 
-			VETexture *positionMap = new VETexture("Position");
-			positionMap->m_format = VK_FORMAT_R16G16B16A16_SFLOAT;
-			positionMap->m_extent = m_swapChainExtent;
-
 			VETexture *normalMap = new VETexture("Normal");
-			normalMap->m_format = VK_FORMAT_R16G16B16A16_SFLOAT;
+			normalMap->m_format = VE_GBUFFER_NORMAL_FORMAT;
 			normalMap->m_extent = m_swapChainExtent;
 
 			VETexture *albedoMap = new VETexture("Albedo");
-			albedoMap->m_format = VK_FORMAT_R8G8B8A8_UNORM;
+			albedoMap->m_format = VE_GBUFFER_ALBEDO_FORMAT;
 			albedoMap->m_extent = m_swapChainExtent;
 
 			// buffers for offscreen pass
-			vh::vhBufCreateOffscreenResources(
-				m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
-				positionMap->m_extent, positionMap->m_format, &positionMap->m_image,
-				&positionMap->m_deviceAllocation, &positionMap->m_imageInfo.imageView);
 			vh::vhBufCreateOffscreenResources(
 				m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
 				normalMap->m_extent, normalMap->m_format, &normalMap->m_image,
@@ -539,79 +565,290 @@ namespace ve
 				albedoMap->m_extent, albedoMap->m_format, &albedoMap->m_image,
 				&albedoMap->m_deviceAllocation, &albedoMap->m_imageInfo.imageView);
 
-			// depth map for offscreen pass
+			// depth map for offscreen pass, also sampled for reconstructing positions
 			vh::vhBufCreateDepthResources(
 				m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
 				depthMap->m_extent, depthMap->m_format, &depthMap->m_image,
 				&depthMap->m_deviceAllocation, &depthMap->m_imageInfo.imageView);
 
-			vh::vhBufCreateTextureSampler(m_device, &positionMap->m_imageInfo.sampler);
 			vh::vhBufCreateTextureSampler(m_device, &normalMap->m_imageInfo.sampler);
 			vh::vhBufCreateTextureSampler(m_device, &albedoMap->m_imageInfo.sampler);
+			vh::vhBufCreateTextureSampler(m_device, &depthMap->m_imageInfo.sampler);
 
-			offscreenPostionMaps.push_back(positionMap->m_imageInfo.imageView);
 			offscreenNormalMaps.push_back(normalMap->m_imageInfo.imageView);
 			offscreenAlbedoMaps.push_back(albedoMap->m_imageInfo.imageView);
 			offscreenDepthMaps.push_back(depthMap->m_imageInfo.imageView);
 
-			m_depthMaps.push_back(depthMap);
-			m_positionMaps.push_back(positionMap);
 			m_normalMaps.push_back(normalMap);
 			m_albedoMaps.push_back(albedoMap);
+			m_depthMaps.push_back(depthMap);
 		}
 
 		vh::vhBufCreateFramebuffersOffscreen(
-			m_device, offscreenPostionMaps, offscreenNormalMaps, offscreenAlbedoMaps,
+			m_device, offscreenNormalMaps, offscreenAlbedoMaps,
 			offscreenDepthMaps, m_renderPassOffscreen, m_swapChainExtent,
 			m_offscreenFramebuffers);
+	}
 
-		for (auto pSub : m_subrenderers)
-			pSub->recreateResources();
-		m_subrenderComposer->recreateResources();
+	/**
+	 * \brief Destroy the maps of the G-buffer, the framebuffers are destroyed with the swapchain
+	 */
+	void VERendererDeferred::destroyGBuffer()
+	{
+		for (uint32_t i = 0; i < m_depthMaps.size(); i++)
+		{
+			delete m_normalMaps[i];
+			delete m_albedoMaps[i];
+			delete m_depthMaps[i];
+		}
+		m_normalMaps.clear();
+		m_albedoMaps.clear();
+		m_depthMaps.clear();
+	}
 
-		deleteCmdBuffers();
+	/**
+	 * \brief Point the offscreen descriptor sets to the depth, normal and albedo maps of the G-buffer
+	 */
+	void VERendererDeferred::updateOffscreenDescriptorSets()
+	{
+		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++)
+		{
+			vh::vhRenderUpdateDescriptorSet(
+				m_device, m_descriptorSetsOffscreen[i],
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER }, // Descriptor Types
+				{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE }, // UBOs
+				{ 0 }, // UBO sizes
+				{ {m_depthMaps[i]->m_imageInfo.imageView},
+				 {m_normalMaps[i]->m_imageInfo.imageView},
+				 {m_albedoMaps[i]->m_imageInfo.imageView} }, // textureImageViews
+				{ {m_depthMaps[i]->m_imageInfo.sampler},
+				 {m_normalMaps[i]->m_imageInfo.sampler},
+				 {m_albedoMaps[i]->m_imageInfo.sampler} } // samplers
+			);
+		}
 	}
 
+	//--------------------------------------------------------------------------------------------
+	// tiled lighting
+
 	/**
-	 * \brief Create the semaphores and fences for syncing command buffers and
-	 * swapchain
+	 *
+	 * \brief Create the lighting images and light buffers of all swapchain images
+	 *
+	 * The descriptor sets are created once, and then only updated, since they also point to the G-buffer.
+	 *
 	 */
-	void VERendererDeferred::createSyncObjects()
+	void VERendererDeferred::createTiledResources()
 	{
-		m_imageAvailableSemaphores.resize(
-			MAX_FRAMES_IN_FLIGHT); // for wait for the next swap chain image
-		m_offscreenSemaphores.resize(
-			MAX_FRAMES_IN_FLIGHT); // for wait for render finished
-		m_renderFinishedSemaphores.resize(
-			MAX_FRAMES_IN_FLIGHT); // for wait for render finished
-		m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT); // for wait for at least one
-		// image in the swap chain
+		VkDeviceSize sizeLights = sizeof(glm::uvec4) + VE_MAX_TILED_LIGHTS * sizeof(veTileLight_t);
 
-		VkSemaphoreCreateInfo semaphoreInfo = {};
-		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		m_tileResources.resize(m_swapChainImages.size());
+		for (uint32_t i = 0; i < m_tileResources.size(); i++)
+		{
+			veTileResources_t &res = m_tileResources[i];
 
-		VkFenceCreateInfo fenceInfo = {};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			VECHECKRESULT(vh::vhBufCreateBuffer(m_vmaAllocator, sizeLights,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+				&res.lights, &res.lightsAllocation));
 
-		m_overlaySemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			res.pLighting = new VETexture("TiledLighting");
+			res.pLighting->m_format = VK_FORMAT_R16G16B16A16_SFLOAT;
+			res.pLighting->m_extent = m_swapChainExtent;
+			VECHECKRESULT(vh::vhBufCreateStorageImage(m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
+				res.pLighting->m_extent, res.pLighting->m_format, &res.pLighting->m_image,
+				&res.pLighting->m_deviceAllocation, &res.pLighting->m_imageInfo.imageView));
+			VECHECKRESULT(vh::vhBufCreateTextureSampler(m_device, &res.pLighting->m_imageInfo.sampler));
+
+			if (res.descriptorSet == VK_NULL_HANDLE)
+			{
+				std::vector<VkDescriptorSet> sets;
+				VECHECKRESULT(vh::vhRenderCreateDescriptorSets(m_device, 1, m_descriptorSetLayoutTiled,
+					m_descriptorPool, sets));
+				res.descriptorSet = sets[0];
+				VECHECKRESULT(vh::vhRenderCreateDescriptorSets(m_device, 1, m_descriptorSetLayoutResolve,
+					m_descriptorPool, sets));
+				res.descriptorSetResolve = sets[0];
+			}
+
+			VECHECKRESULT(vh::vhRenderUpdateDescriptorSet(m_device, res.descriptorSet,
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				 VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				 VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+				{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, res.lights },
+				{ 0, 0, 0, 0, sizeLights },
+				{ {m_depthMaps[i]->m_imageInfo.imageView},
+				 {m_normalMaps[i]->m_imageInfo.imageView},
+				 {m_albedoMaps[i]->m_imageInfo.imageView},
+				 {res.pLighting->m_imageInfo.imageView},
+				 {VK_NULL_HANDLE} },
+				{ {m_depthMaps[i]->m_imageInfo.sampler},
+				 {m_normalMaps[i]->m_imageInfo.sampler},
+				 {m_albedoMaps[i]->m_imageInfo.sampler},
+				 {VK_NULL_HANDLE},
+				 {VK_NULL_HANDLE} }));
+
+			VECHECKRESULT(vh::vhRenderUpdateDescriptorSet(m_device, res.descriptorSetResolve,
+				{ VK_NULL_HANDLE }, { 0 },
+				{ {res.pLighting->m_imageInfo.imageView} },
+				{ {res.pLighting->m_imageInfo.sampler} }));
+		}
+	}
+
+	/**
+	 * \brief Destroy the lighting images and light buffers of all swapchain images, but keep the descriptor sets
+	 */
+	void VERendererDeferred::destroyTiledResources()
+	{
+		for (auto &res : m_tileResources)
 		{
-			if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
-				&m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
-				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
-					&m_offscreenSemaphores[i]) != VK_SUCCESS ||
-				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
-					&m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr,
-					&m_overlaySemaphores[i]) != VK_SUCCESS ||
-				vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]) !=
-				VK_SUCCESS)
+			if (res.lights != VK_NULL_HANDLE)
+				vmaDestroyBuffer(m_vmaAllocator, res.lights, res.lightsAllocation);
+			res.lights = VK_NULL_HANDLE;
+
+			delete res.pLighting;
+			res.pLighting = nullptr;
+		}
+	}
+
+	/**
+	 *
+	 * \brief Find the lights that have their own shadow and composition passes
+	 *
+	 * Without tiling these are all lights. In tiled mode only lights with shadow maps have their own passes,
+	 * all other lights are shaded by the tiled compute shader.
+	 *
+	 * \returns true if the lights changed, so all command buffers must be recorded again
+	 *
+	 */
+	bool VERendererDeferred::updatePassLights()
+	{
+		veFrameVector<VELight *> passLights;
+		for (auto pLight : getSceneManagerPointer()->getLights())
+		{
+			if (!m_tiled || (hasShadowMaps(pLight) && pLight->m_shadowCameras.size() > 0))
+				passLights.push_back(pLight);
+		}
+
+		if (passLights.size() == m_passLights.size() &&
+			std::equal(passLights.begin(), passLights.end(), m_passLights.begin()))
+			return false;
+
+		m_passLights.assign(passLights.begin(), passLights.end());
+		return true;
+	}
+
+	/**
+	 *
+	 * \brief Copy the lights that are shaded by the tiled compute shader into the light buffer of the current image
+	 *
+	 * Called in each frame, since lights move. Directional and ambient lights reach all tiles, so they come first
+	 * and are not culled. The compute shader culls the point and spot lights by their reach.
+	 *
+	 */
+	void VERendererDeferred::updateTileLights()
+	{
+		veTileResources_t &res = m_tileResources[m_imageIndex];
+		void *data;
+		VECHECKRESULT(vmaMapMemory(m_vmaAllocator, res.lightsAllocation, &data));
+		glm::uvec4 *pCounts = (glm::uvec4 *)data;
+		veTileLight_t *pLights = (veTileLight_t *)(pCounts + 1);
+
+		uint32_t numGlobal = 0;
+		uint32_t numLights = 0;
+		std::vector<VELight *> &lights = getSceneManagerPointer()->getLights();
+		for (uint32_t pass = 0; pass < 2; pass++)
+		{ // first the global lights, then the culled lights
+			for (auto pLight : lights)
 			{
-				assert(false);
-				exit(1);
+				if (hasShadowMaps(pLight) && pLight->m_shadowCameras.size() > 0)
+					continue; // composed in its own pass
+
+				VELight::veLightType type = pLight->getLightType();
+				bool isGlobal = type == VELight::VE_LIGHT_TYPE_DIRECTIONAL || type == VELight::VE_LIGHT_TYPE_AMBIENT;
+				if (isGlobal != (pass == 0) || numLights == VE_MAX_TILED_LIGHTS)
+					continue;
+
+				VELight::veUBOPerLight_t &ubo = pLight->m_ubo;
+				veTileLight_t &light = pLights[numLights++];
+				light.type = ubo.type;
+				light.position = glm::vec4(glm::vec3(ubo.model[3]), ubo.param[0]);
+				light.direction = ubo.model[2];
+				light.col_ambient = ubo.col_ambient;
+				light.col_diffuse = ubo.col_diffuse;
+				light.col_specular = ubo.col_specular;
+				light.param = ubo.param;
 			}
+			if (pass == 0)
+				numGlobal = numLights;
 		}
+		*pCounts = glm::uvec4(numGlobal, numLights, 0, 0);
+
+		vmaFlushAllocation(m_vmaAllocator, res.lightsAllocation, 0,
+			sizeof(glm::uvec4) + numLights * sizeof(veTileLight_t));
+		vmaUnmapMemory(m_vmaAllocator, res.lightsAllocation);
+	}
+
+	/**
+	 *
+	 * \brief Record the tiled lighting compute shader after the offscreen pass
+	 *
+	 * The shader reads the G-buffer once and writes the lighting image, which the first onscreen pass copies
+	 * into the framebuffer. The light buffer is written in each frame, so the command buffer does not depend on the lights.
+	 *
+	 * \param[in] commandBuffer The offscreen command buffer of the current image
+	 * \param[in] pCamera Pointer to the scene camera
+	 *
+	 */
+	void VERendererDeferred::recordTiledLighting(VkCommandBuffer commandBuffer, VECamera *pCamera)
+	{
+		veTileResources_t &res = m_tileResources[m_imageIndex];
+
+		// the G-buffer must be written, the old lighting is overwritten completely
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		VkImageMemoryBarrier imageBarrier = {};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = 0;
+		imageBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = res.pLighting->m_image;
+		imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 1, &imageBarrier);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineTiled);
+
+		// set 0...cam UBO
+		// set 1...depth, normal, albedo map, lighting image, lights
+
+		VkDescriptorSet sets[2] = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[m_imageIndex],
+								   res.descriptorSet };
+		uint32_t offset = (uint32_t)(pCamera->m_memoryHandle.entryIndex * sizeof(VECamera::veUBOPerCamera_t));
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayoutTiled,
+			0, 2, sets, 1, &offset);
+
+		vkCmdDispatch(commandBuffer, (m_swapChainExtent.width + VE_TILE_SIZE - 1) / VE_TILE_SIZE,
+			(m_swapChainExtent.height + VE_TILE_SIZE - 1) / VE_TILE_SIZE, 1);
+
+		// the first onscreen pass samples the lighting
+		imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
 	}
 
 	//--------------------------------------------------------------------------------------------
@@ -660,13 +897,13 @@ namespace ve
 
 	VERendererDeferred::secondaryCmdBuf_t VERendererDeferred::recordRenderpass(
 		VkRenderPass *pRenderPass,
-		std::vector<VESubrender *> subRenderers,
+		const std::vector<VESubrender *> &subRenderers,
 		VkFramebuffer *pFrameBuffer,
 		uint32_t imageIndex,
 		uint32_t numPass,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet> descriptorSets)
+		const std::vector<VkDescriptorSet> &descriptorSets)
 	{
 		secondaryCmdBuf_t buf;
 		buf.pool = getThreadCommandPool();
@@ -729,8 +966,7 @@ namespace ve
 		std::vector<VkClearValue> clearValuesLight =
 		{}; // render target and depth buffer should be cleared only first time
 		VkClearValue cv1, cv2;
-		cv1.color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		clearValuesLight.push_back(cv1);
+		cv1.color = { 0.0f, 0.0f, 0.0f, 0.0f }; // albedo alpha 0 marks pixels without geometry as unlit
 		clearValuesLight.push_back(cv1);
 		clearValuesLight.push_back(cv1);
 		cv2.depthStencil = { 1.0f, 0 };
@@ -754,6 +990,12 @@ namespace ve
 		vkCmdExecuteCommands(m_commandBuffersOffscreen[m_imageIndex], 1,
 			&m_secondaryBuffersOffscreen[m_imageIndex][0].buffer);
 		vkCmdEndRenderPass(m_commandBuffersOffscreen[m_imageIndex]);
+
+		//-----------------------------------------------------------------------------------------
+		// Tiled lighting (shade all lights without shadow maps with one read of the gbuffer)
+		if (m_tiled)
+			recordTiledLighting(m_commandBuffersOffscreen[m_imageIndex], pCamera);
+
 		vkEndCommandBuffer(m_commandBuffersOffscreen[m_imageIndex]);
 
 		m_AvgRecordTimeOffscreen = vh::vhAverage(vh::vhTimeDuration(t_start), m_AvgRecordTimeOffscreen, 1.0f / m_swapChainImages.size());
@@ -777,58 +1019,78 @@ namespace ve
 				&(m_secondaryBuffersOnscreen[m_imageIndex][i].buffer));
 		}
 		m_secondaryBuffersOnscreen[m_imageIndex].clear();
-		m_secondaryBuffersOnscreenFutures[m_imageIndex].clear();
 
-		ThreadPool *tp = getEnginePointer()->getThreadPool();
+		VEJobSystem *pJobSystem = getEnginePointer()->getJobSystem();
 		// go through all active lights in the scene
 		std::chrono::high_resolution_clock::time_point t_start, t_now;
 		t_start = vh::vhTimeNow();
 
 		std::vector<VESubrender *> m_subrendererComposer = { m_subrenderComposer };
 		std::vector<VESubrender *> subrenderShadow = { m_subrenderShadow };
-		for (uint32_t i = 0; i < getSceneManagerPointer()->getLights().size(); i++)
+		std::vector<VkDescriptorSet> noDescriptorSets = {};
+
+		///Arguments of one recording task, the task only captures a pointer to them
+		struct veRecordJob_t
+		{
+			VkRenderPass *pRenderPass;
+			const std::vector<VESubrender *> *pSubrenderers;
+			VkFramebuffer *pFrameBuffer;
+			uint32_t numPass;
+			VECamera *pCamera;
+			VELight *pLight;
+			const std::vector<VkDescriptorSet> *pDescriptorSets;
+		};
+
+		veFrameVector<veRecordJob_t> jobs;
+		uint32_t numJobs = 1;
+		for (auto pLight : m_passLights)
+			numJobs += 1 + (uint32_t)pLight->m_shadowCameras.size();
+		jobs.reserve(numJobs);
+
+		// in tiled mode, the first pass copies the tiled lighting, then the lights with shadow maps are composed
+		uint32_t firstPass = m_tiled ? 1 : 0;
+		if (m_tiled)
 		{
-			VELight *pLight = getSceneManagerPointer()->getLights()[i];
+			jobs.push_back({ &m_renderPassOnscreenClear, &m_subrendererComposer, &m_swapChainFramebuffers[m_imageIndex],
+				0, pCamera, nullptr, &m_descriptorSetsShadow });
+		}
+
+		for (uint32_t i = 0; i < m_passLights.size(); i++)
+		{
+			VELight *pLight = m_passLights[i];
+			uint32_t numPass = firstPass + i;
 			//-----------------------------------------------------------------------------------------
 			// shadow pass
+			for (unsigned j = 0; j < pLight->m_shadowCameras.size(); j++)
 			{
-				t_now = vh::vhTimeNow();
-				for (unsigned j = 0; j < pLight->m_shadowCameras.size(); j++)
-				{
-					std::vector<VkDescriptorSet> empty = {};
-					auto future = tp->add(
-						&VERendererDeferred::recordRenderpass, this, &m_renderPassShadow,
-						subrenderShadow, &m_shadowFramebuffers[m_imageIndex][j],
-						m_imageIndex, i, pLight->m_shadowCameras[j], pLight, empty);
-					m_secondaryBuffersOnscreenFutures[m_imageIndex].push_back(
-						std::move(future));
-				}
-				m_AvgCmdShadowTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdShadowTime);
+				jobs.push_back({ &m_renderPassShadow, &subrenderShadow, &m_shadowFramebuffers[m_imageIndex][j],
+					numPass, pLight->m_shadowCameras[j], pLight, &noDescriptorSets });
 			}
 			//-----------------------------------------------------------------------------------------
 			// composition pass
-			{
-				t_now = vh::vhTimeNow();
-				auto future = tp->add(
-					&VERendererDeferred::recordRenderpass, this,
-					&(i == 0 ? m_renderPassOnscreenClear : m_renderPassOnscreenLoad),
-					m_subrendererComposer, &m_swapChainFramebuffers[m_imageIndex],
-					m_imageIndex, i, pCamera, pLight, m_descriptorSetsShadow);
-
-				m_secondaryBuffersOnscreenFutures[m_imageIndex].push_back(
-					std::move(future));
-				m_AvgCmdLightTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdLightTime);
-			}
+			jobs.push_back({ numPass == 0 ? &m_renderPassOnscreenClear : &m_renderPassOnscreenLoad, &m_subrendererComposer,
+				&m_swapChainFramebuffers[m_imageIndex], numPass, pCamera, pLight, &m_descriptorSetsShadow });
 		}
 
 		//------------------------------------------------------------------------------------------
-		// wait for all threads to finish and copy secondary command buffers into the
-		// vector
-		m_secondaryBuffersOnscreen[m_imageIndex].resize(m_secondaryBuffersOnscreenFutures[m_imageIndex].size());
-		for (uint32_t i = 0; i < m_secondaryBuffersOnscreenFutures[m_imageIndex].size(); i++)
+		// record in parallel, each task writes its buffer into its slot
+		t_now = vh::vhTimeNow();
+		m_secondaryBuffersOnscreen[m_imageIndex].resize(jobs.size());
 		{
-			m_secondaryBuffersOnscreen[m_imageIndex][i] = m_secondaryBuffersOnscreenFutures[m_imageIndex][i].get();
+			VETaskGroup group(pJobSystem);
+			for (uint32_t i = 0; i < jobs.size(); i++)
+			{
+				veRecordJob_t *pJob = &jobs[i];
+				secondaryCmdBuf_t *pBuffer = &m_secondaryBuffersOnscreen[m_imageIndex][i];
+				group.run([this, pJob, pBuffer]()
+					{
+						*pBuffer = recordRenderpass(pJob->pRenderPass, *pJob->pSubrenderers, pJob->pFrameBuffer,
+							m_imageIndex, pJob->numPass, pJob->pCamera, pJob->pLight, *pJob->pDescriptorSets);
+					});
+			}
+			group.wait(); // this thread records some of the buffers meanwhile
 		}
+		m_AvgCmdLightTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdLightTime);
 
 		//-----------------------------------------------------------------------------------------
 		// set clear values for shadow and light passes
@@ -857,9 +1119,21 @@ namespace ve
 		vh::vhCmdBeginCommandBuffer(m_device, m_commandBuffersOnscreen[m_imageIndex],
 			(VkCommandBufferUsageFlagBits)0);
 
-		for (uint32_t i = 0; i < getSceneManagerPointer()->getLights().size(); i++)
+		if (m_tiled)
+		{ // copy the tiled lighting
+			vh::vhRenderBeginRenderPass(
+				m_commandBuffersOnscreen[m_imageIndex], m_renderPassOnscreenClear,
+				m_swapChainFramebuffers[m_imageIndex], clearValuesLight,
+				m_swapChainExtent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			vkCmdExecuteCommands(
+				m_commandBuffersOnscreen[m_imageIndex], 1,
+				&m_secondaryBuffersOnscreen[m_imageIndex][bufferIdx++].buffer);
+			vkCmdEndRenderPass(m_commandBuffersOnscreen[m_imageIndex]);
+		}
+
+		for (uint32_t i = 0; i < m_passLights.size(); i++)
 		{
-			VELight *pLight = getSceneManagerPointer()->getLights()[i];
+			VELight *pLight = m_passLights[i];
 			// shadow pass
 			for (uint32_t j = 0; j < pLight->m_shadowCameras.size(); j++)
 			{
@@ -876,7 +1150,7 @@ namespace ve
 			// composition pass
 			vh::vhRenderBeginRenderPass(
 				m_commandBuffersOnscreen[m_imageIndex],
-				i == 0 ? m_renderPassOnscreenClear : m_renderPassOnscreenLoad,
+				firstPass + i == 0 ? m_renderPassOnscreenClear : m_renderPassOnscreenLoad,
 				m_swapChainFramebuffers[m_imageIndex], clearValuesLight,
 				m_swapChainExtent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 			vkCmdExecuteCommands(
@@ -917,10 +1191,7 @@ namespace ve
 			std::numeric_limits<uint64_t>::max());
 
 		// acquire the next image
-		VkResult result = vkAcquireNextImageKHR(
-			m_device, m_swapChain, std::numeric_limits<uint64_t>::max(),
-			m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE,
-			&m_imageIndex);
+		VkResult result = acquireNextImage(m_imageAvailableSemaphores[m_currentFrame]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -939,6 +1210,7 @@ namespace ve
 	 * \brief Draw the frame.
 	 *
 	 *- update all UBOs
+	 *- in tiled mode, update the lights of the tiled lighting
 	 *- get a single time command buffer from the pool, bind pipeline and begin the
 	 *render pass
 	 *- loop through all entities and draw them
@@ -947,6 +1219,16 @@ namespace ve
 	 */
 	void VERendererDeferred::drawFrame()
 	{
+		if (updatePassLights())
+		{ // lights were added or removed, or got shadow maps
+			updateCmdBuffers();
+		}
+
+		if (updateVisibility(m_imageIndex) && m_commandBuffersOffscreen[m_imageIndex] != VK_NULL_HANDLE)
+		{ //recorded entities are not the visible ones anymore
+			m_commandBuffersWithPendingUpdate[m_imageIndex] = true;
+		}
+
 		if (m_commandBuffersWithPendingUpdate[m_imageIndex])
 		{
 			vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffersOffscreen[m_imageIndex]);
@@ -965,6 +1247,9 @@ namespace ve
 			recordCmdBuffersOnscreen();
 		}
 
+		if (m_tiled)
+			updateTileLights();
+
 		// submit the command buffers
 		vh::vhCmdSubmitCommandBuffer(
 			m_device, m_graphicsQueue, m_commandBuffersOffscreen[m_imageIndex],
@@ -993,7 +1278,6 @@ namespace ve
 	 */
 	void VERendererDeferred::drawOverlay()
 	{
-		assert(m_subrenderOverlay != nullptr); // needs same change as in VERendererForward
 		if (m_subrenderOverlay == nullptr)
 			return;
 
@@ -1008,9 +1292,8 @@ namespace ve
 	 */
 	void VERendererDeferred::presentFrame()
 	{
-		VkResult result = vh::vhRenderPresentResult(
-			m_presentQueue, m_swapChain, m_imageIndex, // present it to the swap chain
-			m_overlaySemaphores[m_currentFrame]);
+		VkResult result = presentImage(
+			m_subrenderOverlay == nullptr ? m_renderFinishedSemaphores[m_currentFrame] : m_overlaySemaphores[m_currentFrame]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
 			m_framebufferResized)
@@ -15,25 +15,57 @@
 
 namespace ve
 {
+	const uint32_t VE_TILE_SIZE = 16; ///<Width and height of a tile of the tiled lighting in pixels, must match TILESIZE in the shader
+	const uint32_t VE_MAX_TILED_LIGHTS = 4096; ///<Max number of lights that are shaded by the tiled lighting
+	const VkFormat VE_GBUFFER_NORMAL_FORMAT = VK_FORMAT_R16G16_SNORM; ///<Octahedral encoded world normals
+	const VkFormat VE_GBUFFER_ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_UNORM; ///<Albedo, alpha is 0 for unlit pixels
+
 	class VEEngine;
 
 	/**
 		*
 		* \brief A deferred renderer
 		*
-		* This renderer creates four buffers per frame (position,normal,albedo,specular). The shadowing applied after the positions were calculated
+		* This renderer creates a G-buffer per frame (normal,albedo,depth). Normals are octahedral encoded in two channels,
+		* positions are reconstructed from the depth with the inverse projection of the camera.
+		* The shadowing applied after the positions were calculated
+		*
+		* In tiled mode, a compute shader shades all lights without shadow maps with a single read of the G-buffer.
+		* Each 16x16 tile finds the depth range of its pixels and shades only the lights reaching it. Lights with
+		* shadow maps are still composed in their own passes.
 		*
 		*/
 	class VERendererDeferred : public VERenderer
 	{
+	public:
+		///Light in the tile light buffer, layout must match clusterLight_t in the shaders
+		struct veTileLight_t
+		{
+			glm::ivec4 type; ///<Light type information
+			glm::vec4 position; ///<World position, w is the reach of the light
+			glm::vec4 direction; ///<World direction
+			glm::vec4 col_ambient; ///<Ambient color
+			glm::vec4 col_diffuse; ///<Diffuse color
+			glm::vec4 col_specular; ///<Specular color
+			glm::vec4 param; ///<Light parameters
+		};
+
+		///Resources of the tiled lighting, one set for each swapchain image
+		struct veTileResources_t
+		{
+			VkBuffer lights = VK_NULL_HANDLE; ///<Light counts and lights, written by the CPU in each frame
+			VmaAllocation lightsAllocation = nullptr; ///<VMA information for the lights
+			VETexture *pLighting = nullptr; ///<Lighting written by the compute shader, read by the first onscreen pass
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE; ///<G-buffer, lighting image and lights for the compute shader
+			VkDescriptorSet descriptorSetResolve = VK_NULL_HANDLE; ///<Lighting image for the first onscreen pass
+		};
+
 	protected:
-		std::vector<VkCommandPool> m_commandPools = {}; ///<Array of command pools so that each thread in the thread pool has its own pool
+		std::vector<VkCommandPool> m_commandPools = {}; ///<Array of command pools so that each thread of the job system has its own pool
 		std::vector<VkCommandBuffer> m_commandBuffersOffscreen = {}; ///<the main command buffers for recording draw commands
 		std::vector<VkCommandBuffer> m_commandBuffersOnscreen = {}; ///<the main command buffers for recording draw commands
 		std::vector<bool> m_commandBuffersWithPendingUpdate = {}; ///<flag storing if command buffer must be rerecorded
 		std::vector<std::vector<secondaryCmdBuf_t>> m_secondaryBuffersOffscreen = {}; ///<secondary buffers for parallel recording
-		std::vector<std::vector<std::future<secondaryCmdBuf_t>>>
-			m_secondaryBuffersOnscreenFutures = {}; ///<secondary buffers for parallel recording
 		std::vector<std::vector<secondaryCmdBuf_t>> m_secondaryBuffersOnscreen = {}; ///<secondary buffers for parallel recording
 
 		std::map<VELight *, lightBufferLists_t> m_lightBufferLists; ///<each light has its own command buffer list, one for each image in the swap chain
@@ -45,7 +77,6 @@ namespace ve
 
 		VETexture *m_depthMap = nullptr; ///<the image depth map
 		std::vector<VETexture *> m_depthMaps;
-		std::vector<VETexture *> m_positionMaps;
 		std::vector<VETexture *> m_normalMaps;
 		std::vector<VETexture *> m_albedoMaps;
 		std::vector<std::vector<VETexture *>> m_shadowMaps; ///<the shadow maps - a list of map cascades
@@ -62,6 +93,15 @@ namespace ve
 		VkDescriptorSetLayout m_descriptorSetLayoutShadow; ///<Descriptor set 2: shadow
 		std::vector<VkDescriptorSet> m_descriptorSetsShadow; ///<Per frame descriptor sets for set 2
 
+		//tiled lighting
+		bool m_tiled = false; ///<if true, lights without shadow maps are shaded by a tiled compute shader
+		std::vector<VELight *> m_passLights; ///<Lights with their own composition pass, in tiled mode only lights with shadow maps
+		std::vector<veTileResources_t> m_tileResources; ///<Tiled lighting resources, one for each swapchain image
+		VkDescriptorSetLayout m_descriptorSetLayoutTiled = VK_NULL_HANDLE; ///<Layout of the G-buffer, lighting image and lights
+		VkDescriptorSetLayout m_descriptorSetLayoutResolve = VK_NULL_HANDLE; ///<Layout of the lighting image for the first onscreen pass
+		VkPipelineLayout m_pipelineLayoutTiled = VK_NULL_HANDLE; ///<Pipeline layout of the tiled lighting compute shader
+		VkPipeline m_pipelineTiled = VK_NULL_HANDLE; ///<Compute pipeline that shades the lights of each tile
+
 		std::vector<VkSemaphore> m_imageAvailableSemaphores; ///<sem for waiting for the next swapchain image
 		std::vector<VkSemaphore> m_offscreenSemaphores; ///<sem for signalling that offscreen rendering done
 		std::vector<VkSemaphore> m_renderFinishedSemaphores; ///<sem for signalling that rendering done
@@ -79,6 +119,15 @@ namespace ve
 		virtual void recordCmdBuffersOffscreen(); //record the command buffers
 		virtual void recordCmdBuffersOnscreen(); //record the command buffers
 
+		void createGBuffer(); //create the normal, albedo and depth maps and the offscreen framebuffers
+		void destroyGBuffer(); //destroy the maps of the G-buffer
+		void updateOffscreenDescriptorSets(); //point the offscreen sets to the current G-buffer
+		void createTiledResources(); //create the lighting images and light buffers
+		void destroyTiledResources(); //destroy the lighting images and light buffers, keep the descriptor sets
+		bool updatePassLights(); //find the lights with their own composition pass
+		void updateTileLights(); //copy the lights without composition pass into the light buffer
+		void recordTiledLighting(VkCommandBuffer commandBuffer, VECamera *pCamera); //record the tiled lighting compute shader
+
 		virtual void acquireFrame(); //acquire the next frame
 		virtual void drawFrame(); //draw one frame
 		virtual void prepareOverlay(); //prepare to draw the overlay
@@ -88,17 +137,17 @@ namespace ve
 		virtual void recreateSwapchain(); //new swapchain due to window size change
 		virtual secondaryCmdBuf_t
 			recordRenderpass(VkRenderPass *pRenderPass, //record one render pass into a command buffer
-				std::vector<VESubrender *> subRenderers,
+				const std::vector<VESubrender *> &subRenderers,
 				VkFramebuffer *pFrameBuffer,
 				uint32_t imageIndex,
 				uint32_t numPass,
 				VECamera *pCamera,
 				VELight *pLight,
-				std::vector<VkDescriptorSet> descriptorSetsShadow);
+				const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 
 	public:
 		///Constructor
-		VERendererDeferred();
+		VERendererDeferred(bool tiled = false);
 
 		//Destructor
 		virtual ~VERendererDeferred() {};
@@ -106,13 +155,37 @@ namespace ve
 		virtual VkCommandPool
 			getThreadCommandPool()
 		{
-			return m_commandPools[getEnginePointer()->getThreadPool()->threadNum[std::this_thread::get_id()]];
+			return m_commandPools[getEnginePointer()->getJobSystem()->getThreadIndex()];
 		};
 
 		virtual void updateCmdBuffers();
 
 		virtual void deleteCmdBuffers();
 
+		///\returns true if lights without shadow maps are shaded by the tiled compute shader
+		bool isTiled()
+		{
+			return m_tiled;
+		};
+
+		///\returns true if shadow maps are rendered for the light, in tiled mode only if the light casts shadows
+		virtual bool hasShadowMaps(VELight *pLight)
+		{
+			return !m_tiled || pLight->m_castShadows;
+		};
+
+		///\returns the descriptor set layout of the lighting image for the first onscreen pass
+		VkDescriptorSetLayout getDescriptorSetLayoutResolve()
+		{
+			return m_descriptorSetLayoutResolve;
+		};
+
+		///\returns the descriptor set of the lighting image of a swapchain image
+		VkDescriptorSet getDescriptorSetResolve(uint32_t imageIndex)
+		{
+			return m_tileResources[imageIndex].descriptorSetResolve;
+		};
+
 		///\returns the shadow descriptor set layout for the shadow
 		virtual VkDescriptorSetLayout getDescriptorSetLayoutShadow()
 		{
@@ -8,12 +8,20 @@
 #include "VEInclude.h"
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
-const uint32_t SHADOW_MAP_DIM = 4096;
 
 namespace ve
 {
-	VERendererForward::VERendererForward()
-		: VERenderer()
+	/**
+		* \brief Constructor of the forward renderer
+		* \param[in] indirect If true, entities are culled by a compute shader and drawn with indirect draw calls.
+		* Needs multiDrawIndirect, drawIndirectFirstInstance and VK_KHR_draw_indirect_count, otherwise entities are drawn directly
+		* \param[in] clustered If true, lights without shadow maps are binned into clusters by a compute shader,
+		* and all of them are shaded in the first light pass
+		*/
+	VERendererForward::VERendererForward(bool indirect, bool clustered)
+		: VERenderer(),
+		m_indirect(indirect),
+		m_clustered(clustered)
 	{
 	}
 
@@ -29,7 +37,7 @@ namespace ve
 	{
 		VERenderer::initRenderer();
 
-		const std::vector<const char *> requiredDeviceExtensions = {
+		std::vector<const char *> requiredDeviceExtensions = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
 		const std::vector<const char *> requiredValidationLayers = {
@@ -40,8 +48,22 @@ namespace ve
 		enabledBufferDeviceAddresFeatures.bufferDeviceAddress = VK_TRUE;
 
 		if (vh::vhDevPickPhysicalDevice(getEnginePointer()->getInstance(), m_surface, requiredDeviceExtensions,
-			&m_physicalDevice, &m_deviceFeatures, &m_deviceLimits) != VK_SUCCESS ||
-			vh::vhDevCreateLogicalDevice(getEnginePointer()->getInstance(), m_physicalDevice, m_surface,
+			&m_physicalDevice, &m_deviceFeatures, &m_deviceLimits) != VK_SUCCESS)
+		{
+			assert(false);
+			exit(1);
+		}
+
+		if (m_indirect && !(m_deviceFeatures.multiDrawIndirect && m_deviceFeatures.drawIndirectFirstInstance &&
+			vh::checkDeviceExtensionSupport(m_physicalDevice, { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME })))
+		{ //shaders find the entity UBOs with gl_InstanceIndex, culled commands are compacted and counted
+			std::cout << "Indirect drawing is not supported by the device, drawing directly" << std::endl;
+			m_indirect = false;
+		}
+		if (m_indirect)
+			requiredDeviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+		if (vh::vhDevCreateLogicalDevice(getEnginePointer()->getInstance(), m_physicalDevice, m_surface,
 				requiredDeviceExtensions, requiredValidationLayers,
 				&enabledBufferDeviceAddresFeatures, &m_device, &m_graphicsQueue,
 				&m_presentQueue) != VK_SUCCESS)
@@ -50,11 +72,15 @@ namespace ve
 			exit(1);
 		}
 
+		if (m_indirect && vkCmdDrawIndexedIndirectCountKHR == nullptr)
+		{ //the extension is enabled, but the driver does not export the function
+			std::cout << "vkCmdDrawIndexedIndirectCountKHR not found, drawing directly" << std::endl;
+			m_indirect = false;
+		}
+
 		vh::vhMemCreateVMAAllocator(getEnginePointer()->getInstance(), m_physicalDevice, m_device, m_vmaAllocator);
 
-		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device, getWindowPointer()->getExtent(),
-			&m_swapChain, m_swapChainImages, m_swapChainImageViews,
-			&m_swapChainImageFormat, &m_swapChainExtent);
+		createSwapchain();
 
 		//------------------------------------------------------------------------------------------------------------
 		//create a command pools and the command buffers
@@ -62,7 +88,10 @@ namespace ve
 		vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface,
 			&m_commandPool); //command pool for the main thread
 
-		m_commandPools.resize(getEnginePointer()->getThreadPool()->threadCount()); //each thread in the thread pool gets its own command pool
+		vh::vhUploadInit(m_physicalDevice, m_device, m_surface, m_vmaAllocator, m_graphicsQueue,
+			VE_UPLOAD_RING_SIZE, &m_uploadRing); //staging ring for meshes and textures
+
+		m_commandPools.resize(getEnginePointer()->getJobSystem()->getThreadCount() + 1); //each worker thread gets its own command pool, the last one is for the main thread helping out
 		for (uint32_t i = 0; i < m_commandPools.size(); i++)
 		{
 			vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface, &m_commandPools[i]);
@@ -75,12 +104,6 @@ namespace ve
 			m_commandBuffersWithPendingUpdate[i] = false;   //UPDATE
 		}
 
-		m_secondaryBuffers.resize(m_swapChainImages.size());
-		for (uint32_t i = 0; i < m_swapChainImages.size(); i++)
-			m_secondaryBuffers[i] = {}; //will be created later
-
-		m_secondaryBuffersFutures.resize(m_swapChainImages.size());
-
 		//------------------------------------------------------------------------------------------------------------
 		//create resources for light pass
 
@@ -110,44 +133,33 @@ namespace ve
 		//------------------------------------------------------------------------------------------------------------
 		//create resources for shadow pass
 
-		//shadow render pass
-		vh::vhRenderCreateRenderPassShadow(m_device, m_depthMap->m_format, &m_renderPassShadow);
-
-		//shadow maps
-		m_shadowMaps.resize(m_swapChainImageViews.size());
-		m_shadowFramebuffers.resize(m_swapChainImageViews.size());
-		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++)
-		{
-			for (uint32_t j = 0; j < NUM_SHADOW_CASCADE; j++)
-			{ //point light has 6 shadow maps, thats the max
-				VkExtent2D extent = { SHADOW_MAP_DIM, SHADOW_MAP_DIM };
-
-				VETexture *pShadowMap = new VETexture("ShadowMap");
-				pShadowMap->m_extent = extent;
-				pShadowMap->m_format = m_depthMap->m_format;
+		//shadow render pass, keeping the tiles of the atlas that are not rendered
+		vh::vhRenderCreateRenderPassShadow(m_device, m_depthMap->m_format, &m_renderPassShadow,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-				//create the depth images
-				vh::vhBufCreateDepthResources(m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
-					extent, pShadowMap->m_format,
-					&pShadowMap->m_image, &pShadowMap->m_deviceAllocation,
-					&pShadowMap->m_imageInfo.imageView);
+		//shadow atlas, the shadow render pass waits for all earlier commands, so all images can share it
+		VkExtent2D extent = { VE_SHADOW_ATLAS_SIZE, VE_SHADOW_ATLAS_SIZE };
 
-				vh::vhBufTransitionImageLayout(m_device, m_graphicsQueue, m_commandPool,
-					pShadowMap->m_image, pShadowMap->m_format, VK_IMAGE_ASPECT_DEPTH_BIT, 1,
-					1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		m_shadowAtlas = new VETexture("ShadowAtlas");
+		m_shadowAtlas->m_extent = extent;
+		m_shadowAtlas->m_format = m_depthMap->m_format;
 
-				vh::vhBufCreateTextureSampler(m_device, &pShadowMap->m_imageInfo.sampler);
+		vh::vhBufCreateDepthResources(m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
+			extent, m_shadowAtlas->m_format,
+			&m_shadowAtlas->m_image, &m_shadowAtlas->m_deviceAllocation,
+			&m_shadowAtlas->m_imageInfo.imageView);
 
-				m_shadowMaps[i].push_back(pShadowMap);
+		vh::vhBufTransitionImageLayout(m_device, m_graphicsQueue, m_commandPool,
+			m_shadowAtlas->m_image, m_shadowAtlas->m_format, VK_IMAGE_ASPECT_DEPTH_BIT, 1,
+			1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-				//create the framebuffers holding only the depth images for the shadow maps
-				std::vector<VkFramebuffer> frameBuffers;
-				vh::vhBufCreateFramebuffers(m_device, { VK_NULL_HANDLE }, { pShadowMap->m_imageInfo.imageView },
-					m_renderPassShadow, extent, frameBuffers);
+		vh::vhBufCreateTextureSampler(m_device, &m_shadowAtlas->m_imageInfo.sampler);
 
-				m_shadowFramebuffers[i].push_back(frameBuffers[0]);
-			}
-		}
+		//create the framebuffer holding only the shadow atlas
+		std::vector<VkFramebuffer> frameBuffers;
+		vh::vhBufCreateFramebuffers(m_device, { VK_NULL_HANDLE }, { m_shadowAtlas->m_imageInfo.imageView },
+			m_renderPassShadow, extent, frameBuffers);
+		m_shadowFramebuffer = frameBuffers[0];
 
 		//------------------------------------------------------------------------------------------------------------
 		//create descriptor pool, layout and sets
@@ -155,55 +167,109 @@ namespace ve
 		uint32_t maxobjects = 100000;
 		vh::vhRenderCreateDescriptorPool(m_device,
 			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
-			 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-			{ maxobjects, maxobjects },
+			 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			 VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+			{ maxobjects, maxobjects, maxobjects },
 			&m_descriptorPool);
 
+		//maps of all entities, slots are freed when no frame in flight can use them anymore
+		m_pMaterialTable = new VEMaterialTable(m_device, VK_SHADER_STAGE_FRAGMENT_BIT, getSwapChainNumber() + 1);
+
 		//set 0...cam UBO
 		//set 1...light UBO
 		//set 2...shadow maps
 		//set 3...per object UBO
 		//set 4...additional per object resources
 
-		//set 2, binding 0 : shadow map + sampler
+		//set 2, binding 0 : shadow atlas + sampler
 		vh::vhRenderCreateDescriptorSetLayout(m_device,
-			{ NUM_SHADOW_CASCADE }, //add shadow UBOs here
+			{ 1 }, //add shadow UBOs here
 			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
 			{ VK_SHADER_STAGE_FRAGMENT_BIT },
 			&m_descriptorSetLayoutShadow);
 
+		//the geometry shader of single pass point light shadows reads the light UBO
+		VkShaderStageFlags geometryStage = hasCubeShadows() ? VK_SHADER_STAGE_GEOMETRY_BIT : 0;
 		vh::vhRenderCreateDescriptorSetLayout(m_device,
 			{ 1 },
 			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
 										  {
-											  VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+											  VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT | geometryStage,
 										  },
 										  &m_descriptorSetLayoutPerObject);
 
-		vh::vhRenderCreateDescriptorSets(m_device, (uint32_t)m_swapChainImages.size(), m_descriptorSetLayoutShadow, getDescriptorPool(), m_descriptorSetsShadow);
+		//set 3 of instanced and indirect pipelines...all entity UBOs of a memory block, indexed with gl_InstanceIndex
+		vh::vhRenderCreateDescriptorSetLayout(m_device,
+			{ 1 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+			{ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT },
+			&m_descriptorSetLayoutPerObjectStorage);
 
-		//update the descriptor set for light pass - array of shadow maps
-		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++)
+		if (!m_indirect)
 		{
-			std::vector<std::vector<VkImageView>> imageViews;
-			std::vector<std::vector<VkSampler>> samplers;
-			imageViews.resize(1);
-			samplers.resize(1);
-
-			for (uint32_t j = 0; j < NUM_SHADOW_CASCADE; j++)
-			{
-				imageViews[0].push_back(m_shadowMaps[i][j]->m_imageInfo.imageView);
-				samplers[0].push_back(m_shadowMaps[i][j]->m_imageInfo.sampler);
-			}
+			//last set of instanced pipelines...UBO entry index of each instance
+			vh::vhRenderCreateDescriptorSetLayout(m_device,
+				{ 1 },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+				{ VK_SHADER_STAGE_VERTEX_BIT },
+				&m_descriptorSetLayoutInstances);
+		}
+		else
+		{
+			//cull shader set 2...cull records, draw commands, draw counts
+			vh::vhRenderCreateDescriptorSetLayout(m_device,
+				{ 1, 1, 1 },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+				{ VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT, VK_SHADER_STAGE_COMPUTE_BIT },
+				&m_descriptorSetLayoutCull);
+
+			VkPushConstantRange pushConstantRange = {};
+			pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			pushConstantRange.offset = 0;
+			pushConstantRange.size = 3 * sizeof(uint32_t); //first record, number of records, compact flag
+
+			//set 0...cam UBO, set 1...entity UBOs, set 2...cull buffers
+			vh::vhPipeCreateGraphicsPipelineLayout(m_device,
+				{ m_descriptorSetLayoutPerObject, m_descriptorSetLayoutPerObjectStorage, m_descriptorSetLayoutCull },
+				{ pushConstantRange }, &m_pipelineLayoutCull);
+
+			vh::vhPipeCreateComputePipeline(m_device, "../../media/shader/Forward/Cull/comp.spv",
+				m_pipelineLayoutCull, &m_pipelineCull);
+		}
 
-			vh::vhRenderUpdateDescriptorSet(m_device, m_descriptorSetsShadow[i],
-				{ VK_NULL_HANDLE }, //UBOs
-				{ 0 }, //UBO sizes
-				{ imageViews }, //textureImageViews
-				{ samplers } //samplers
-			);
+		if (m_clustered)
+		{
+			//cluster set...lights, number of lights of each cluster, light indices of each cluster
+			vh::vhRenderCreateDescriptorSetLayout(m_device,
+				{ 1, 1, 1 },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+				{ VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				 VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT },
+				&m_descriptorSetLayoutCluster);
+
+			//set 0...cam UBO, set 1...cluster buffers
+			vh::vhPipeCreateGraphicsPipelineLayout(m_device,
+				{ m_descriptorSetLayoutPerObject, m_descriptorSetLayoutCluster },
+				{}, &m_pipelineLayoutCluster);
+
+			vh::vhPipeCreateComputePipeline(m_device, "../../media/shader/Forward/Cluster/comp.spv",
+				m_pipelineLayoutCluster, &m_pipelineCluster);
+
+			createClusterBuffers();
 		}
 
+		//the descriptor set for light pass - the shadow atlas, the same set for all images
+		std::vector<VkDescriptorSet> setsShadow;
+		vh::vhRenderCreateDescriptorSets(m_device, 1, m_descriptorSetLayoutShadow, getDescriptorPool(), setsShadow);
+
+		vh::vhRenderUpdateDescriptorSet(m_device, setsShadow[0],
+			{ VK_NULL_HANDLE }, //UBOs
+			{ 0 }, //UBO sizes
+			{ { m_shadowAtlas->m_imageInfo.imageView } }, //textureImageViews
+			{ { m_shadowAtlas->m_imageInfo.sampler } } //samplers
+		);
+		m_descriptorSetsShadow.assign(m_swapChainImages.size(), setsShadow[0]);
+
 		//------------------------------------------------------------------------------------------------------------
 
 		createSyncObjects();
@@ -221,7 +287,8 @@ namespace ve
 		addSubrenderer(new VESubrenderFW_DN(*this));
 		addSubrenderer(new VESubrenderFW_Skyplane(*this));
 		addSubrenderer(new VESubrenderFW_Shadow(*this));
-		addSubrenderer(new VESubrender_Nuklear(*this));
+		if (!isHeadless()) //the overlay needs a GLFW window
+			addSubrenderer(new VESubrender_Nuklear(*this));
 
 		//---------------------------------Cloth-Simulation-Stuff-----------------------------------
 		addSubrenderer(new VESubrenderFW_Cloth(*this));
@@ -247,7 +314,7 @@ namespace ve
 			vkDestroyImageView(m_device, imageView, nullptr);
 		}
 
-		vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
+		destroySwapchain();
 	}
 
 	/**
@@ -261,29 +328,38 @@ namespace ve
 
 		cleanupSwapChain();
 
-		for (auto framebufferList : m_shadowFramebuffers)
-		{
-			for (auto fb : framebufferList)
-			{
-				vkDestroyFramebuffer(m_device, fb, nullptr);
-			}
-		}
-
-		//destroy shadow maps
-		for (auto pShadowMapList : m_shadowMaps)
-		{
-			for (auto pS : pShadowMapList)
-			{
-				delete pS;
-			}
-		}
+		//destroy the shadow atlas
+		vkDestroyFramebuffer(m_device, m_shadowFramebuffer, nullptr);
+		delete m_shadowAtlas;
+		m_shadowAtlas = nullptr;
 		vkDestroyRenderPass(m_device, m_renderPassShadow, nullptr);
 
 		//destroy per frame resources
+		delete m_pMaterialTable;
+		m_pMaterialTable = nullptr;
 		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
 		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutPerObject, nullptr);
 		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutShadow, nullptr);
 
+		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutPerObjectStorage, nullptr);
+		if (m_clustered)
+		{
+			destroyClusterBuffers();
+			vkDestroyPipeline(m_device, m_pipelineCluster, nullptr);
+			vkDestroyPipelineLayout(m_device, m_pipelineLayoutCluster, nullptr);
+			vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutCluster, nullptr);
+		}
+		if (m_indirect)
+		{
+			vkDestroyPipeline(m_device, m_pipelineCull, nullptr);
+			vkDestroyPipelineLayout(m_device, m_pipelineLayoutCull, nullptr);
+			vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutCull, nullptr);
+		}
+		else
+		{
+			vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutInstances, nullptr);
+		}
+
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 		{
 			vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
@@ -296,6 +372,7 @@ namespace ve
 		for (auto pool : m_commandPools)
 			vkDestroyCommandPool(m_device, pool, nullptr);
 
+		vh::vhUploadDeinit(&m_uploadRing);
 		vmaDestroyAllocator(m_vmaAllocator);
 
 		vkDestroyDevice(m_device, nullptr);
@@ -310,10 +387,7 @@ namespace ve
 
 		cleanupSwapChain();
 
-		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device, 
-			getWindowPointer()->getExtent(), &m_swapChain,
-			m_swapChainImages, m_swapChainImageViews,
-			&m_swapChainImageFormat, &m_swapChainExtent);
+		createSwapchain();
 
 		m_depthMap = new VETexture("DepthMap");
 		m_depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
@@ -334,6 +408,12 @@ namespace ve
 		vh::vhBufCreateFramebuffers(m_device, m_swapChainImageViews, depthMaps, m_renderPassClear, m_swapChainExtent,
 			m_swapChainFramebuffers);
 
+		if (m_clustered)
+		{ //the grid depends on the extent
+			destroyClusterBuffers();
+			createClusterBuffers();
+		}
+
 		for (auto pSub : m_subrenderers)
 			pSub->recreateResources();
 
@@ -371,334 +451,1179 @@ namespace ve
 	}
 
 	//--------------------------------------------------------------------------------------------
+	//shadow atlas
 
 	/**
-		* \brief Queue an update for all command buffers, so next time they have to be
-		* deleted, recreated and recorded again
+		*
+		* \brief Assign the tiles of the shadow atlas to the shadow cameras of all lights with shadow maps
+		*
+		* Called at the start of each frame, before the lights update their UBOs. Each light wants tiles of a size
+		* that depends on its brightness and how much of the screen it can reach. A point or spot light outside
+		* of the view frustum gets no tiles. The size changes only if it is off by a factor of 2, so that tiles do not
+		* move all the time. Far cascades get half the size. If the tiles do not fit into the atlas, then the tiles of the
+		* least important lights are made smaller, and if this is not enough, these lights get no tiles and cast no shadows.
+		*
+		* All sizes are powers of 2, so placing the tiles from large to small along a Z curve packs them without gaps.
+		* A point light rendered in one pass takes a block of 8 tiles, 4 x 2 tiles in the atlas. Its 6 faces are next to each
+		* other, so its shadow pass clears only its own block, the 2 tiles left over are not used. Lights whose tiles
+		* do not fit get no tiles. If any tile moved, then the shadow command buffers are outdated and the moved tiles must
+		* be rendered again.
+		*
+		* The sizes and tiles are updated in place, so a frame in which the lights do not change does not allocate.
+		* Only lights getting tiles for the first time add map entries.
+		*
 		*/
-	void VERendererForward::updateCmdBuffers()
+	void VERendererForward::updateShadowAtlas()
 	{
-		for (uint32_t i = 0; i < m_commandBuffers.size(); i++)
+		///A light that wants tiles in the atlas
+		struct veShadowRequest_t
 		{
-			if (m_commandBuffers[i] != VK_NULL_HANDLE)
-			{
-				m_commandBuffersWithPendingUpdate[i] = true;
-			}
-		}
-	}
+			VELight *pLight; ///<The light
+			float wanted; ///<Tile size the light would like to have, its importance
+			uint32_t size; ///<Tile size of the light, far cascades get half of it
+		};
 
-	/**
-		* \brief Delete all command buffers and set them to VK_NULL_HANDLE, so next time they have to be
-		* created and recorded again
-		*/
-	void VERendererForward::deleteCmdBuffers()
-	{
-		for (uint32_t i = 0; i < m_commandBuffers.size(); i++)
+		///A tile to be placed in the atlas
+		struct veShadowPlace_t
 		{
-			if (m_commandBuffers[i] != VK_NULL_HANDLE)
-			{
-				vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffers[i]);
-				m_commandBuffers[i] = VK_NULL_HANDLE;
-				m_commandBuffersWithPendingUpdate[i] = false;
-			}
+			uint32_t size; ///<Width and height of the tile
+			uint32_t request; ///<Index of the request
+			uint32_t camera; ///<Index of the shadow camera of the light
+			bool cube; ///<The tile is a block of 8 tiles for all faces of a point light
+		};
+
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		veFrameVector<glm::vec4> planes;
+		glm::vec3 camPos = glm::vec3(0.0f);
+		if (pCamera != nullptr)
+		{
+			pCamera->getFrustumPlanes(planes);
+			camPos = glm::vec3(pCamera->getWorldTransform()[3]);
 		}
-	}
-
-	/**
-		* \brief Delete all command buffers and set them to VK_NULL_HANDLE, so next time they have to be
-		* created and recorded again
-		*
-		* \param[in] pRenderPass Pointer to the render pass that is executed
-		* \param[in] subRenderers List of subrenderers to call
-		* \param[in] pFrameBuffer Pointer to the framebuffer to be used
-		* \param[in] imageIndex Index of the current swap chain image
-		* \param[in] numPass Number of the pass on this call, one for each light
-		* \param[in] pCamera Pointer to the cmaera to be used
-		* \param[in] pLight Pointer to the light to be renderered for
-		* \param[in] descriptorSets List of descriptor sets for per objects resources
-		*
-		*/
-	VERendererForward::secondaryCmdBuf_t VERendererForward::recordRenderpass(VkRenderPass *pRenderPass,
-		std::vector<VESubrender *> subRenderers,
-		VkFramebuffer *pFrameBuffer,
-		uint32_t imageIndex,
-		uint32_t numPass,
-		VECamera *pCamera,
-		VELight *pLight,
-		std::vector<VkDescriptorSet> descriptorSets)
-	{
-		secondaryCmdBuf_t buf;
-		buf.pool = getThreadCommandPool();
-
-		vh::vhCmdCreateCommandBuffers(m_device, buf.pool,
-			VK_COMMAND_BUFFER_LEVEL_SECONDARY,
-			1, &buf.buffer);
-
-		vh::vhCmdBeginCommandBuffer(m_device, *pRenderPass, 0, *pFrameBuffer, buf.buffer,
-			VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
 
-		for (auto pSub : subRenderers)
+		auto tileSize = [](VELight *pLight, uint32_t size, uint32_t camera)
 		{
-			pSub->draw(buf.buffer, imageIndex, numPass, pCamera, pLight, descriptorSets);
-		}
+			bool far = pLight->getLightType() == VELight::VE_LIGHT_TYPE_DIRECTIONAL && camera >= VE_SHADOW_FAR_CASCADE;
+			return far ? std::max(size / 2, VE_SHADOW_TILE_MIN) : size;
+		};
 
-		vkEndCommandBuffer(buf.buffer);
+		//-----------------------------------------------------------------------------------------
+		//find the tile size of each light
 
-		return buf;
-	}
+		veFrameVector<veShadowRequest_t> requests;
+		requests.reserve(getSceneManagerPointer()->getLights().size());
+		for (auto pLight : getSceneManagerPointer()->getLights())
+		{
+			if (!hasShadowMaps(pLight) || pLight->m_shadowCameras.empty())
+				continue;
+
+			float brightness = pLight->m_switchedOn ? glm::max(glm::max(pLight->m_col_diffuse.r, pLight->m_col_diffuse.g),
+				pLight->m_col_diffuse.b) : 0.0f;
+			float coverage = 1.0f;
+			if (pLight->getLightType() != VELight::VE_LIGHT_TYPE_DIRECTIONAL)
+			{ //point and spot lights reach a sphere
+				glm::vec3 pos = glm::vec3(pLight->getWorldTransform()[3]);
+				float reach = pLight->m_param[0];
+				float dist = glm::length(pos - camPos);
+				if (dist > reach)
+					coverage = reach / dist;
+
+				for (auto &plane : planes)
+				{
+					if (glm::dot(glm::vec3(plane), pos) + plane.w < -reach)
+						coverage = 0.0f; //cannot light anything on the screen
+				}
+			}
 
-	/**
-		* \brief Create a new command buffer and record the whole scene into it, then end it
-		*/
-	void VERendererForward::recordCmdBuffers()
-	{
-		VECamera *pCamera;
-		VECHECKPOINTER(pCamera = getSceneManagerPointer()->getCamera());
+			float wanted = VE_SHADOW_TILE_MAX * std::min(brightness, 1.0f) * coverage;
+			if (wanted <= 0.0f)
+				continue;
 
-		pCamera->setExtent(getWindowPointer()->getExtent());
+			uint32_t size = m_shadowTileSizes.count(pLight) > 0 ? m_shadowTileSizes[pLight] : 0;
+			if (size == 0 || wanted >= 2.0f * size || wanted < 0.5f * size)
+			{ //the size is far off
+				size = VE_SHADOW_TILE_MIN;
+				while (2 * size <= wanted && 2 * size <= VE_SHADOW_TILE_MAX)
+					size *= 2;
+			}
+			m_shadowTileSizes[pLight] = size;
+			requests.push_back({ pLight, wanted, size });
+		}
 
-		for (uint32_t i = 0; i < m_secondaryBuffers[m_imageIndex].size(); i++)
+		//index of the request of a light, or -1
+		auto findRequest = [&](VELight *pLight)
 		{
-			vkFreeCommandBuffers(m_device, m_secondaryBuffers[m_imageIndex][i].pool,
-				1, &(m_secondaryBuffers[m_imageIndex][i].buffer));
+			for (uint32_t i = 0; i < requests.size(); i++)
+			{
+				if (requests[i].pLight == pLight)
+					return (int32_t)i;
+			}
+			return (int32_t)-1;
+		};
+
+		for (auto it = m_shadowTileSizes.begin(); it != m_shadowTileSizes.end();)
+		{ //forget lights that do not want tiles anymore
+			if (findRequest(it->first) < 0)
+				it = m_shadowTileSizes.erase(it);
+			else
+				++it;
 		}
-		m_secondaryBuffers[m_imageIndex].clear();
-		m_secondaryBuffersFutures[m_imageIndex].clear();
 
-		ThreadPool *tp = getEnginePointer()->getThreadPool();
+		//-----------------------------------------------------------------------------------------
+		//make the tiles fit into the atlas, most important lights first
 
-		//-----------------------------------------------------------------------------------------------------------------
-		//go through all active lights in the scene
+		std::stable_sort(requests.begin(), requests.end(),
+			[](const veShadowRequest_t &a, const veShadowRequest_t &b) { return a.wanted > b.wanted; });
 
-		std::chrono::high_resolution_clock::time_point t_start, t_now;
-		t_start = vh::vhTimeNow();
-		for (uint32_t i = 0; i < getSceneManagerPointer()->getLights().size(); i++)
+		auto area = [&](const veShadowRequest_t &request)
 		{
-			VELight *pLight = getSceneManagerPointer()->getLights()[i];
-
-			//-----------------------------------------------------------------------------------------
-			//shadow passes
-			{
-				t_now = vh::vhTimeNow();
-				for (unsigned j = 0; j < pLight->m_shadowCameras.size(); j++)
-				{
-					std::vector<VkDescriptorSet> empty = {};
-					std::vector<VESubrender *> subrender = { m_subrenderShadow };
+			if (isCubeShadow(request.pLight))
+				return 8 * (uint64_t)request.size * request.size;
 
-					auto future = tp->add(&VERendererForward::recordRenderpass, this, &m_renderPassShadow, subrender,
-						&m_shadowFramebuffers[m_imageIndex][j],
-						m_imageIndex, i, pLight->m_shadowCameras[j],
-						pLight, empty);
-
-					m_secondaryBuffersFutures[m_imageIndex].push_back(std::move(future));
-				}
-				m_AvgCmdShadowTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdShadowTime);
-			}
-			//-----------------------------------------------------------------------------------------
-			//light pass
+			uint64_t sum = 0;
+			for (uint32_t j = 0; j < request.pLight->m_shadowCameras.size(); j++)
 			{
-				t_now = vh::vhTimeNow();
-				auto future = tp->add(&VERendererForward::recordRenderpass, this,
-					&(i == 0 ? m_renderPassClear : m_renderPassLoad), m_subrenderers,
-					&m_swapChainFramebuffers[m_imageIndex],
-					m_imageIndex, i, pCamera, pLight, m_descriptorSetsShadow);
-
-				m_secondaryBuffersFutures[m_imageIndex].push_back(std::move(future));
-				m_AvgCmdLightTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdLightTime);
+				uint64_t size = tileSize(request.pLight, request.size, j);
+				sum += size * size;
 			}
-		}
+			return sum;
+		};
 
-		//------------------------------------------------------------------------------------------
-		//wait for all threads to finish and copy secondary command buffers into the vector
+		uint64_t total = 0;
+		for (auto &request : requests)
+			total += area(request);
 
-		m_secondaryBuffers[m_imageIndex].resize(m_secondaryBuffersFutures[m_imageIndex].size());
-		for (uint32_t i = 0; i < m_secondaryBuffersFutures[m_imageIndex].size(); i++)
+		while (total > (uint64_t)VE_SHADOW_ATLAS_SIZE * VE_SHADOW_ATLAS_SIZE)
 		{
-			m_secondaryBuffers[m_imageIndex][i] = m_secondaryBuffersFutures[m_imageIndex][i].get();
+			int32_t last = (int32_t)requests.size() - 1;
+			while (last >= 0 && requests[last].size == VE_SHADOW_TILE_MIN)
+				last--;
+
+			if (last >= 0)
+			{ //halve the tiles of the least important light that can be halved
+				total -= area(requests[last]);
+				requests[last].size /= 2;
+				total += area(requests[last]);
+			}
+			else
+			{ //all tiles are as small as possible, the least important light casts no shadows
+				total -= area(requests.back());
+				requests.pop_back();
+			}
 		}
 
 		//-----------------------------------------------------------------------------------------
-		//set clear values for shadow and light passes
-
-		std::vector<VkClearValue> clearValuesShadow = {}; //shadow map should be cleared every time
-		VkClearValue cv;
-		cv.depthStencil = { 1.0f, 0 };
-		clearValuesShadow.push_back(cv);
-
-		std::vector<VkClearValue> clearValuesLight = {}; //render target and depth buffer should be cleared only first time
-		VkClearValue cv1, cv2;
-		cv1.color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		cv2.depthStencil = { 1.0f, 0 };
-		clearValuesLight.push_back(cv1);
-		clearValuesLight.push_back(cv2);
-
-		//-----------------------------------------------------------------------------------------
-		//create a new primary command buffer and record all secondary buffers into it
+		//place the tiles from large to small, along a Z curve of VE_SHADOW_TILE_MIN sized cells
 
-		vh::vhCmdCreateCommandBuffers(m_device, m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1,
-			&m_commandBuffers[m_imageIndex]);
-		vh::vhCmdBeginCommandBuffer(m_device, m_commandBuffers[m_imageIndex], (VkCommandBufferUsageFlagBits)0);
+		uint32_t numPlaces = 0;
+		for (auto &request : requests)
+			numPlaces += isCubeShadow(request.pLight) ? 1 : (uint32_t)request.pLight->m_shadowCameras.size();
 
-		uint32_t bufferIdx = 0;
-		for (uint32_t i = 0; i < getSceneManagerPointer()->getLights().size(); i++)
+		veFrameVector<veShadowPlace_t> places;
+		places.reserve(numPlaces);
+		for (uint32_t i = 0; i < requests.size(); i++)
 		{
-			VELight *pLight = getSceneManagerPointer()->getLights()[i];
-			for (uint32_t j = 0; j < pLight->m_shadowCameras.size(); j++)
+			if (isCubeShadow(requests[i].pLight))
 			{
-				vh::vhRenderBeginRenderPass(m_commandBuffers[m_imageIndex], m_renderPassShadow,
-					m_shadowFramebuffers[m_imageIndex][j], clearValuesShadow,
-					m_shadowMaps[0][j]->m_extent,
-					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-				vkCmdExecuteCommands(m_commandBuffers[m_imageIndex], 1,
-					&m_secondaryBuffers[m_imageIndex][bufferIdx++].buffer);
-				vkCmdEndRenderPass(m_commandBuffers[m_imageIndex]);
+				places.push_back({ requests[i].size, i, 0, true });
+				continue;
 			}
-			vh::vhRenderBeginRenderPass(m_commandBuffers[m_imageIndex], i == 0 ? m_renderPassClear : m_renderPassLoad,
-				m_swapChainFramebuffers[m_imageIndex], clearValuesLight, m_swapChainExtent,
-				VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-			vkCmdExecuteCommands(m_commandBuffers[m_imageIndex], 1,
-				&m_secondaryBuffers[m_imageIndex][bufferIdx++].buffer);
-			vkCmdEndRenderPass(m_commandBuffers[m_imageIndex]);
 
-			clearValuesLight.clear(); //since we blend the images onto each other, do not clear them for passes 2 and further
+			for (uint32_t j = 0; j < requests[i].pLight->m_shadowCameras.size(); j++)
+				places.push_back({ tileSize(requests[i].pLight, requests[i].size, j), i, j, false });
 		}
-		m_AvgRecordTimeOnscreen = vh::vhAverage(vh::vhTimeDuration(t_start), m_AvgRecordTimeOnscreen, 1.0f / m_swapChainImages.size());
+		std::stable_sort(places.begin(), places.end(),
+			[](const veShadowPlace_t &a, const veShadowPlace_t &b)
+			{ //blocks first, they need more alignment
+				return a.size > b.size || (a.size == b.size && a.cube && !b.cube);
+			});
+
+		const uint8_t VE_PLACE_NONE = 0, VE_PLACE_OK = 1, VE_PLACE_DROPPED = 2;
+		veFrameVector<uint8_t> placed(requests.size(), VE_PLACE_NONE); //state of each request
+		bool moved = false;
+		uint32_t cell = 0; //index of the next free cell on the Z curve
+		const uint32_t numCells = (VE_SHADOW_ATLAS_SIZE / VE_SHADOW_TILE_MIN) * (VE_SHADOW_ATLAS_SIZE / VE_SHADOW_TILE_MIN);
+		for (auto &place : places)
+		{
+			VELight *pLight = requests[place.request].pLight;
+			uint32_t cells = place.size / VE_SHADOW_TILE_MIN;
+			cells *= cells;
+			if (place.cube)
+				cell = (cell + 8 * cells - 1) / (8 * cells) * (8 * cells); //an aligned block of 8 tiles is a rectangle
+
+			uint32_t numTiles = place.cube ? VE_SHADOW_CUBE_FACES : 1;
+			if (placed[place.request] == VE_PLACE_DROPPED || cell + numTiles * cells > numCells)
+			{ //the light cannot have all of its tiles
+				placed[place.request] = VE_PLACE_DROPPED;
+				continue;
+			}
 
-		if (m_subrenderOverlay == nullptr) {
-			// without overlay renderer we must transition the image to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-			vh::vhBufTransitionImageLayout(m_device, m_graphicsQueue,
-				m_commandBuffers[m_imageIndex], //transition the image layout to
-				getSwapChainImage(), VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 1,
-				1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-		}
+			std::vector<veShadowTile_t> &tiles = m_shadowTiles[pLight]; //keeps the state of the tiles from the last frame
+			if (placed[place.request] == VE_PLACE_NONE)
+			{
+				tiles.resize(pLight->m_shadowCameras.size());
+				placed[place.request] = VE_PLACE_OK;
+			}
 
-		vkEndCommandBuffer(m_commandBuffers[m_imageIndex]);
+			for (uint32_t f = 0; f < numTiles; f++, cell += cells)
+			{
+				uint32_t x = 0, y = 0;
+				for (uint32_t b = 0; b < 16; b++)
+				{ //every second bit of the index is x, the others are y
+					x |= ((cell >> (2 * b)) & 1) << b;
+					y |= ((cell >> (2 * b + 1)) & 1) << b;
+				}
 
-		//remember the last recorded entities, for incremental recording
-		for (auto subrender : m_subrenderers)
-		{
-			subrender->afterDrawFinished();
+				veShadowTile_t &tile = tiles[place.camera + f];
+				VkRect2D rect = { { (int32_t)(x * VE_SHADOW_TILE_MIN), (int32_t)(y * VE_SHADOW_TILE_MIN) }, { place.size, place.size } };
+				if (rect.offset.x != tile.rect.offset.x || rect.offset.y != tile.rect.offset.y || rect.extent.width != tile.rect.extent.width)
+				{ //the tile moved, it must be rendered again
+					tile.rect = rect;
+					tile.valid = false;
+					moved = true;
+				}
+				tile.far = pLight->getLightType() == VELight::VE_LIGHT_TYPE_DIRECTIONAL && place.camera >= VE_SHADOW_FAR_CASCADE;
+			}
+			if (place.cube)
+				cell += (8 - VE_SHADOW_CUBE_FACES) * cells; //the rest of the block
 		}
-	}
 
-	//---------------------------------------------------------------------------------------------------------------
-
-	/*VERendererForward::secondaryCmdBuf_t VERendererForward::recordRenderpass2(VkRenderPass *pRenderPass,
-			std::vector<VESubrender*> subRenderers,
-			VkFramebuffer *pFrameBuffer,
-			uint32_t imageIndex, uint32_t numPass,
-			VECamera *pCamera, VELight *pLight,
-			std::vector<VkDescriptorSet> descriptorSets) {
+		for (auto it = m_shadowTiles.begin(); it != m_shadowTiles.end();)
+		{ //lights that lost their tiles, the tiles of dropped lights that were placed are left empty
+			int32_t request = findRequest(it->first);
+			if (request < 0 || placed[request] != VE_PLACE_OK)
+			{
+				it = m_shadowTiles.erase(it);
+				moved = true;
+			}
+			else
+				++it;
+		}
 
-			return 0;
-		}*/
+		if (moved)
+			m_shadowAtlasVersion++;
+		m_shadowAtlasMoved = moved;
+	}
 
-	void VERendererForward::prepareRecording()
+	/**
+		*
+		* \brief Put the tiles of a light into its UBO
+		*
+		* Called by the light after copying its shadow cameras into its UBO, for each light with shadow maps and in parallel.
+		* If the tile of a shadow camera is not rendered in this frame, then the UBO gets the shadow camera that the tile
+		* was rendered with. A tile is rendered if its shadow camera moved, unless it is a far cascade that was rendered
+		* less than VE_SHADOW_FAR_INTERVAL frames ago. updateShadowSchedule() also renders tiles whose shadow casters changed.
+		*
+		* \param[in] pLight Pointer to the light
+		*
+		*/
+	void VERendererForward::updateShadowTiles(VELight *pLight)
 	{
-		VECamera *pCamera;
-		VECHECKPOINTER(pCamera = getSceneManagerPointer()->getCamera());
-		pCamera->setExtent(getWindowPointer()->getExtent());
+		auto itTiles = m_shadowTiles.find(pLight); //the map does not change while the lights are updated
 
-		std::map<VELight *, lightBufferLists_t>::iterator it;
-		for (it = m_lightBufferLists.begin(); it != m_lightBufferLists.end(); it++)
+		for (uint32_t i = 0; i < pLight->m_shadowCameras.size(); i++)
 		{
-			it->second.seenThisLight = false;
+			VECamera::veUBOPerCamera_t &ubo = pLight->m_ubo.shadowCameras[i];
+			if (itTiles == m_shadowTiles.end() || i >= itTiles->second.size() || itTiles->second[i].rect.extent.width == 0)
+			{ //no tile, no shadow
+				ubo.tile = glm::vec4(0.0f);
+				continue;
+			}
+
+			veShadowTile_t &tile = itTiles->second[i];
+			tile.locked = tile.valid && tile.far && m_shadowFrame < tile.frame + VE_SHADOW_FAR_INTERVAL;
+			tile.render = !tile.locked && (!tile.valid || ubo.view != tile.ubo.view || ubo.proj != tile.ubo.proj);
+			if (tile.render)
+				tile.ubo = ubo;
+			else
+				ubo = tile.ubo;
 
-			it->second.lightLists[m_imageIndex].lightBufferFutures.clear();
-			it->second.lightLists[m_imageIndex].lightBufferFutures.clear();
+			ubo.tile = glm::vec4(tile.rect.offset.x, tile.rect.offset.y, tile.rect.extent.width, tile.rect.extent.height) /
+				(float)VE_SHADOW_ATLAS_SIZE;
 		}
 	}
 
-	void VERendererForward::recordSecondaryBuffers()
+	/**
+		*
+		* \brief Check whether a light must update its UBO although it did not move
+		*
+		* Lights are updated only when they or the camera change. But a light must also be updated if its tiles moved,
+		* if a tile was rendered in the last frame, so that it is not rendered again, or if a tile still waits for
+		* being rendered. Called once per frame for each light with shadow maps, before the lights are updated.
+		*
+		* \param[in] pLight Pointer to the light
+		* \returns true if the light must be updated in this frame
+		*
+		*/
+	bool VERendererForward::needsLightUpdate(VELight *pLight)
 	{
-		for (uint32_t i = 0; i < getSceneManagerPointer()->getLights().size(); i++)
-		{
-			VELight *pLight = getSceneManagerPointer()->getLights()[i];
-			recordSecondaryBuffersForLight(pLight, i);
-		}
+		if (m_shadowAtlasMoved)
+			return true;
 
-		//------------------------------------------------------------------------------------------
-		//wait for all threads to finish and copy secondary command buffers into the vector
+		auto itTiles = m_shadowTiles.find(pLight);
+		if (itTiles == m_shadowTiles.end())
+			return false;
 
-		m_secondaryBuffers[m_imageIndex].resize(m_secondaryBuffersFutures[m_imageIndex].size());
-		for (uint32_t i = 0; i < m_secondaryBuffersFutures[m_imageIndex].size(); i++)
+		for (auto &tile : itTiles->second)
 		{
-			m_secondaryBuffers[m_imageIndex][i] = m_secondaryBuffersFutures[m_imageIndex][i].get();
+			if (tile.rect.extent.width > 0 && (!tile.valid || tile.render || tile.dirty || tile.locked))
+				return true;
 		}
+		return false;
+	}
 
-		//------------------------------------------------------------------------------------------
-		//wait for all threads to finish and copy secondary command buffers into the vector
-
-		std::vector<VELight *> deleteList = {};
-
-		std::map<VELight *, lightBufferLists_t>::iterator it;
-		for (it = m_lightBufferLists.begin(); it != m_lightBufferLists.end(); it++)
+	/**
+		*
+		* \brief Find the tiles of the shadow atlas that are rendered in this frame
+		*
+		* A tile that keeps its shadow camera is rendered again if its shadow casters changed. These are entities being added
+		* or removed, casting shadows that moved into the frustum of the shadow camera, or a change of the visible entities,
+		* e.g. because entities left the frustum. A moving caster only changes the tiles whose frustum contains its world
+		* bounding sphere before or after the move, so this works without visibility, i.e. when drawing indirectly.
+		* Far cascades remember changes until they are rendered again.
+		* The faces of a point light that is rendered in one pass are all rendered if any of them is.
+		*
+		* \returns true if the primary command buffer of the current image renders other tiles, so it must be recorded again
+		*
+		*/
+	bool VERendererForward::updateShadowSchedule()
+	{
+		uint64_t version = m_cmdBufferVersion; //changes if entities are added or removed
+		for (auto pSub : m_subrenderers)
+			version += pSub->getVersion();
+
+		//the spheres of the moved casters before and after the move, if entities were added or removed then all
+		//tiles are rendered anyway, so the spheres are only computed again
+		uint32_t numSubs = (uint32_t)m_subrenderers.size();
+		m_casterSpheres.resize(numSubs);
+		m_casterVersions.resize(numSubs, UINT64_MAX);
+		veFrameVector<glm::vec4> movedSpheres;
+		for (uint32_t k = 0; k < numSubs; k++)
 		{
-			if (!it->second.seenThisLight)
+			std::vector<VEEntity *> &entities = m_subrenderers[k]->getEntities();
+			std::vector<glm::vec4> &spheres = m_casterSpheres[k];
+			bool all = m_casterVersions[k] != m_subrenderers[k]->getVersion() || spheres.size() != entities.size();
+			m_casterVersions[k] = m_subrenderers[k]->getVersion();
+			spheres.resize(entities.size());
+			for (uint32_t i = 0; i < entities.size(); i++)
 			{
-				deleteList.push_back(it->first);
+				if (!all && !entities[i]->isWorldChanged())
+					continue;
+
+				glm::vec4 sphere = entities[i]->getWorldBoundingSphere();
+				if (!all && entities[i]->m_castsShadow)
+				{
+					movedSpheres.push_back(spheres[i]);
+					movedSpheres.push_back(sphere);
+				}
+				spheres[i] = sphere;
 			}
 		}
 
-		for (auto pLight : deleteList)
+		veFrameVector<uint8_t> rendered;
+		m_numShadowMapsRendered = 0;
+		m_numShadowMapsCached = 0;
+
+		for (auto &passLight : m_passLights)
 		{
-			//TODO release secondary cmd buffers
-			m_lightBufferLists.erase(it->first);
-		}
-	}
+			auto itTiles = m_shadowTiles.find(passLight.pLight);
+			auto hasTile = [&](uint32_t j)
+			{
+				return itTiles != m_shadowTiles.end() && j < itTiles->second.size() && itTiles->second[j].rect.extent.width > 0;
+			};
 
-	void VERendererForward::recordSecondaryBuffersForLight(VELight *pLight, uint32_t numPass)
-	{
-		VECamera *pCamera;
-		VECHECKPOINTER(pCamera = getSceneManagerPointer()->getCamera());
+			bool renderCube = false; //a face of a point light rendered in one pass is rendered, so all faces are
+			for (uint32_t j = 0; j < passLight.numCascades; j++)
+			{
+				if (!hasTile(j))
+					continue;
 
-		if (m_lightBufferLists.count(pLight) > 0)
-		{
-		}
-		else
-		{
-		}
+				veShadowTile_t &tile = itTiles->second[j];
+				if (tile.version != version)
+					tile.dirty = true;
 
-		ThreadPool *tp = getEnginePointer()->getThreadPool();
+				for (uint32_t k = 0; k < numSubs && !tile.dirty; k++)
+					tile.dirty = isVisibilityChanged(passLight.firstCamera + j, k);
 
-		//-----------------------------------------------------------------------------------------
-		//shadow passes
+				if (!tile.dirty && !movedSpheres.empty())
+				{
+					veFrameVector<glm::vec4> planes;
+					passLight.pLight->m_shadowCameras[j]->getFrustumPlanes(planes);
+					for (uint32_t s = 0; s < movedSpheres.size() && !tile.dirty; s++)
+						tile.dirty = VEEntity::isSphereInFrustum(movedSpheres[s], planes);
+				}
 
-		for (unsigned j = 0; j < pLight->m_shadowCameras.size(); j++)
-		{
-			std::vector<VkDescriptorSet> empty = {};
-			std::vector<VESubrender *> subrender = { m_subrenderShadow };
+				tile.render = tile.render || (tile.dirty && !tile.locked);
+				renderCube = renderCube || (passLight.cube && tile.render);
+			}
+
+			for (uint32_t j = 0; j < passLight.numCascades; j++)
+			{
+				if (!hasTile(j))
+				{
+					rendered.push_back(0);
+					continue;
+				}
 
-			auto future = tp->add(&VERendererForward::recordRenderpass, this, &m_renderPassShadow, subrender,
-				&m_shadowFramebuffers[m_imageIndex][j],
-				m_imageIndex, numPass, pLight->m_shadowCameras[j],
-				pLight, empty);
+				veShadowTile_t &tile = itTiles->second[j];
+				tile.render = tile.render || renderCube;
+				if (tile.render)
+				{
+					tile.valid = true;
+					tile.dirty = false;
+					tile.frame = m_shadowFrame;
+					tile.version = version;
+					m_numShadowMapsRendered++;
+				}
+				else
+					m_numShadowMapsCached++;
 
-			m_lightBufferLists[pLight].lightLists[m_imageIndex].shadowBufferFutures.push_back(std::move(future));
+				rendered.push_back(tile.render ? 1 : 0);
+			}
 		}
 
-		//-----------------------------------------------------------------------------------------
-		//light pass
+		if (m_shadowTilesRecorded.size() != m_swapChainImages.size())
+			m_shadowTilesRecorded.resize(m_swapChainImages.size());
 
-		auto future = tp->add(&VERendererForward::recordRenderpass, this,
-			&(numPass == 0 ? m_renderPassClear : m_renderPassLoad), m_subrenderers,
-			&m_swapChainFramebuffers[m_imageIndex],
-			m_imageIndex, numPass, pCamera, pLight, m_descriptorSetsShadow);
+		std::vector<uint8_t> &recorded = m_shadowTilesRecorded[m_imageIndex];
+		if (recorded.size() == rendered.size() && std::equal(rendered.begin(), rendered.end(), recorded.begin()))
+			return false;
 
-		m_lightBufferLists[pLight].lightLists[m_imageIndex].lightBufferFutures.push_back(std::move(future));
+		recorded.assign(rendered.begin(), rendered.end());
+		return true;
+	}
+
+	//--------------------------------------------------------------------------------------------
+	//clustered shading
+
+	/**
+		*
+		* \brief Create the cluster buffers of all swapchain images
+		*
+		* The grid covers the swapchain extent with tiles of VE_CLUSTER_TILE_SIZE pixels, and the view frustum with
+		* VE_CLUSTER_SLICES exponential depth slices. Each cluster lists up to VE_CLUSTER_MAX_LIGHTS lights.
+		* The descriptor sets are created once, and then only updated.
+		*
+		*/
+	void VERendererForward::createClusterBuffers()
+	{
+		m_clusterGrid = glm::uvec3((m_swapChainExtent.width + VE_CLUSTER_TILE_SIZE - 1) / VE_CLUSTER_TILE_SIZE,
+			(m_swapChainExtent.height + VE_CLUSTER_TILE_SIZE - 1) / VE_CLUSTER_TILE_SIZE,
+			VE_CLUSTER_SLICES);
+		uint32_t numClusters = m_clusterGrid.x * m_clusterGrid.y * m_clusterGrid.z;
+
+		VkDeviceSize sizeLights = sizeof(veClusterHeader_t) + VE_MAX_CLUSTERED_LIGHTS * sizeof(veClusterLight_t);
+		VkDeviceSize sizeCounts = numClusters * sizeof(uint32_t);
+		VkDeviceSize sizeIndices = (VkDeviceSize)numClusters * VE_CLUSTER_MAX_LIGHTS * sizeof(uint32_t);
+
+		m_clusterBuffers.resize(m_swapChainImages.size());
+		for (auto &buffers : m_clusterBuffers)
+		{
+			VECHECKRESULT(vh::vhBufCreateBuffer(m_vmaAllocator, sizeLights,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+				&buffers.lights, &buffers.lightsAllocation));
+			VECHECKRESULT(vh::vhBufCreateBuffer(m_vmaAllocator, sizeCounts,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+				&buffers.counts, &buffers.countsAllocation));
+			VECHECKRESULT(vh::vhBufCreateBuffer(m_vmaAllocator, sizeIndices,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+				&buffers.indices, &buffers.indicesAllocation));
+
+			if (buffers.descriptorSet == VK_NULL_HANDLE)
+			{
+				std::vector<VkDescriptorSet> sets;
+				VECHECKRESULT(vh::vhRenderCreateDescriptorSets(m_device, 1, m_descriptorSetLayoutCluster,
+					m_descriptorPool, sets));
+				buffers.descriptorSet = sets[0];
+			}
+
+			VECHECKRESULT(vh::vhRenderUpdateDescriptorSet(m_device, buffers.descriptorSet,
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+				{ buffers.lights, buffers.counts, buffers.indices },
+				{ sizeLights, sizeCounts, sizeIndices },
+				{ {VK_NULL_HANDLE}, {VK_NULL_HANDLE}, {VK_NULL_HANDLE} },
+				{ {VK_NULL_HANDLE}, {VK_NULL_HANDLE}, {VK_NULL_HANDLE} }));
+		}
+	}
+
+	/**
+		* \brief Destroy the cluster buffers of all swapchain images, but keep the descriptor sets
+		*/
+	void VERendererForward::destroyClusterBuffers()
+	{
+		for (auto &buffers : m_clusterBuffers)
+		{
+			if (buffers.lights == VK_NULL_HANDLE)
+				continue;
+
+			vmaDestroyBuffer(m_vmaAllocator, buffers.lights, buffers.lightsAllocation);
+			vmaDestroyBuffer(m_vmaAllocator, buffers.counts, buffers.countsAllocation);
+			vmaDestroyBuffer(m_vmaAllocator, buffers.indices, buffers.indicesAllocation);
+			buffers.lights = VK_NULL_HANDLE;
+			buffers.counts = VK_NULL_HANDLE;
+			buffers.indices = VK_NULL_HANDLE;
+		}
+	}
+
+	/**
+		*
+		* \brief Find the lights that have their own light pass
+		*
+		* Without clustering these are all lights. In clustered mode only lights with shadow maps have their own pass,
+		* all other lights are shaded in the clusters. The first pass light shares the first pass with the clusters.
+		* If no light has shadow maps, then the first light is bound in the first pass, but only shaded in its cluster.
+		*
+		* \returns true if the lights changed, so all command buffers must be recorded again
+		*
+		*/
+	bool VERendererForward::updatePassLights()
+	{
+		veFrameVector<vePassLight_t> passLights;
+		std::vector<VELight *> &lights = getSceneManagerPointer()->getLights();
+
+		uint32_t camera = 1; //0 is the scene camera, then come the shadow cameras of all lights with shadow maps
+		for (auto pLight : lights)
+		{
+			if (!hasShadowMaps(pLight))
+				continue;
+
+			uint32_t numCascades = (uint32_t)pLight->m_shadowCameras.size();
+			if (!m_clustered || numCascades > 0)
+				passLights.push_back({ pLight, camera, numCascades, isCubeShadow(pLight) });
+			camera += numCascades;
+		}
+
+		if (m_clustered && passLights.empty() && !lights.empty())
+			passLights.push_back({ lights[0], 0, 0, false });
+
+		if (passLights.size() == m_passLights.size() &&
+			std::equal(passLights.begin(), passLights.end(), m_passLights.begin()))
+			return false;
+
+		m_passLights.assign(passLights.begin(), passLights.end());
+		return true;
+	}
+
+	/**
+		*
+		* \brief Copy the lights that are shaded in the clusters into the light buffer of the current image
+		*
+		* Called in each frame, since lights and camera move. Directional and ambient lights reach all clusters,
+		* so they come first and are not binned. The cluster shader bins the point and spot lights by their reach.
+		*
+		* \param[in] pCamera Pointer to the scene camera
+		*
+		*/
+	void VERendererForward::updateClusterLights(VECamera *pCamera)
+	{
+		veClusterBuffers_t &buffers = m_clusterBuffers[m_imageIndex];
+		void *data;
+		VECHECKRESULT(vmaMapMemory(m_vmaAllocator, buffers.lightsAllocation, &data));
+		veClusterHeader_t *pHeader = (veClusterHeader_t *)data;
+		veClusterLight_t *pLights = (veClusterLight_t *)(pHeader + 1);
+
+		uint32_t numGlobal = 0;
+		uint32_t numLights = 0;
+		std::vector<VELight *> &lights = getSceneManagerPointer()->getLights();
+		for (uint32_t pass = 0; pass < 2; pass++)
+		{ //first the global lights, then the binned lights
+			for (auto pLight : lights)
+			{
+				if (hasShadowMaps(pLight) && pLight->m_shadowCameras.size() > 0)
+					continue; //shaded in its own light pass
+
+				VELight::veLightType type = pLight->getLightType();
+				bool isGlobal = type == VELight::VE_LIGHT_TYPE_DIRECTIONAL || type == VELight::VE_LIGHT_TYPE_AMBIENT;
+				if (isGlobal != (pass == 0) || numLights == VE_MAX_CLUSTERED_LIGHTS)
+					continue;
+
+				VELight::veUBOPerLight_t &ubo = pLight->m_ubo;
+				veClusterLight_t &light = pLights[numLights++];
+				light.type = ubo.type;
+				light.position = glm::vec4(glm::vec3(ubo.model[3]), ubo.param[0]);
+				light.direction = ubo.model[2];
+				light.col_ambient = ubo.col_ambient;
+				light.col_diffuse = ubo.col_diffuse;
+				light.col_specular = ubo.col_specular;
+				light.param = ubo.param;
+			}
+			if (pass == 0)
+				numGlobal = numLights;
+		}
+
+		bool shadeFirstPassLight = m_passLights.size() > 0 && m_passLights[0].numCascades > 0;
+		float nearPlane = pCamera->m_nearPlane;
+		float farPlane = pCamera->m_farPlane;
+		pHeader->grid = glm::uvec4(m_clusterGrid, VE_CLUSTER_TILE_SIZE);
+		pHeader->counts = glm::uvec4(numGlobal, numLights, shadeFirstPassLight ? 1 : 0, 0);
+		pHeader->depth = glm::vec4(nearPlane, farPlane, VE_CLUSTER_SLICES / log(farPlane / nearPlane), 0.0f);
+		pHeader->extent = glm::vec4((float)m_swapChainExtent.width, (float)m_swapChainExtent.height, 0.0f, 0.0f);
+
+		vmaFlushAllocation(m_vmaAllocator, buffers.lightsAllocation, 0,
+			sizeof(veClusterHeader_t) + numLights * sizeof(veClusterLight_t));
+		vmaUnmapMemory(m_vmaAllocator, buffers.lightsAllocation);
+	}
+
+	/**
+		*
+		* \brief Record the cluster shader, which lists the lights reaching each cluster
+		*
+		* The light buffer is written in each frame, so the command buffer does not depend on the lights.
+		*
+		* \param[in] commandBuffer The primary command buffer of the current image
+		* \param[in] pCamera Pointer to the scene camera
+		*
+		*/
+	void VERendererForward::recordClusterBinning(VkCommandBuffer commandBuffer, VECamera *pCamera)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineCluster);
+
+		//set 0...cam UBO
+		//set 1...lights, cluster counts, cluster indices
+
+		VkDescriptorSet sets[2] = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[m_imageIndex],
+								   m_clusterBuffers[m_imageIndex].descriptorSet };
+		uint32_t offset = (uint32_t)(pCamera->m_memoryHandle.entryIndex * sizeof(VECamera::veUBOPerCamera_t));
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayoutCluster,
+			0, 2, sets, 1, &offset);
+
+		uint32_t numClusters = m_clusterGrid.x * m_clusterGrid.y * m_clusterGrid.z;
+		vkCmdDispatch(commandBuffer, (numClusters + 63) / 64, 1, 1); //shader has 64 threads per group
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	//--------------------------------------------------------------------------------------------
+
+	/**
+		* \brief Queue an update for all command buffers, so next time their primary command buffers are
+		* recorded again
+		*
+		* Secondary command buffers are only recorded again if their subrenderer or its visible entities changed.
+		*/
+	void VERendererForward::updateCmdBuffers()
+	{
+		for (uint32_t i = 0; i < m_commandBuffers.size(); i++)
+		{
+			if (m_commandBuffers[i] != VK_NULL_HANDLE)
+			{
+				m_commandBuffersWithPendingUpdate[i] = true;
+			}
+		}
+	}
+
+	/**
+		*
+		* \brief The UBO entry of a scene object moved, so all command buffers binding it are outdated
+		*
+		* When a scene object is deleted, the last entry of its memory block is moved into the free place.
+		* The entry offset is recorded in the command buffers, so if the moved entry belongs to an entity, then
+		* the command buffers of its subrenderer must be recorded again. Cameras and lights are bound by
+		* all command buffers.
+		*
+		* \param[in] pObject Pointer to the object whose entry moved, or that is deleted
+		*
+		*/
+	void VERendererForward::invalidateCmdBuffers(VESceneObject *pObject)
+	{
+		if (pObject->getObjectType() == VESceneObject::VE_OBJECT_TYPE_ENTITY)
+		{
+			if (((VEEntity *)pObject)->m_pSubrenderer != nullptr)
+				((VEEntity *)pObject)->m_pSubrenderer->setChanged();
+		}
+		else
+		{
+			m_cmdBufferVersion++;
+		}
+		updateCmdBuffers();
+	}
+
+	/**
+		* \brief Delete all command buffers and set them to VK_NULL_HANDLE, so next time they have to be
+		* created and recorded again
+		*/
+	void VERendererForward::deleteCmdBuffers()
+	{
+		for (uint32_t i = 0; i < m_commandBuffers.size(); i++)
+		{
+			if (m_commandBuffers[i] != VK_NULL_HANDLE)
+			{
+				vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffers[i]);
+				m_commandBuffers[i] = VK_NULL_HANDLE;
+				m_commandBuffersWithPendingUpdate[i] = false;
+			}
+		}
+
+		for (auto &lightBuffers : m_lightBufferLists)
+		{
+			for (auto &list : lightBuffers.second.lightLists)
+			{
+				freeSecondaryBuffers(list);
+			}
+		}
+		m_lightBufferLists.clear();
+	}
+
+	/**
+		*
+		* \brief Free a secondary command buffer, if it has been created
+		*
+		* The buffer must not be pending, and no thread must allocate from its pool at the same time.
+		*
+		* \param[in] buffer The buffer, is set to VK_NULL_HANDLE
+		*
+		*/
+	void VERendererForward::freeSecondaryBuffer(secondaryCmdBuf_t &buffer)
+	{
+		if (buffer.buffer != VK_NULL_HANDLE)
+		{
+			vkFreeCommandBuffers(m_device, buffer.pool, 1, &buffer.buffer);
+			buffer.buffer = VK_NULL_HANDLE;
+		}
+		buffer.numDraws = 0;
+	}
+
+	/**
+		*
+		* \brief Free all secondary command buffers of one light and image
+		*
+		* \param[in] list The buffers, the list is emptied
+		*
+		*/
+	void VERendererForward::freeSecondaryBuffers(secondaryBufferLists_t &list)
+	{
+		for (auto &buffer : list.shadowBuffers)
+			freeSecondaryBuffer(buffer);
+		for (auto &buffer : list.lightBuffers)
+			freeSecondaryBuffer(buffer);
+		list.shadowBuffers.clear();
+		list.lightBuffers.clear();
+		list.shadowVersions.clear();
+		list.lightVersions.clear();
+	}
+
+	/**
+		*
+		* \brief Create a secondary command buffer and record one subrenderer of a light pass into it
+		*
+		* \param[in] pRenderPass Pointer to the render pass that is executed
+		* \param[in] pSub The subrenderer to call
+		* \param[in] pFrameBuffer Pointer to the framebuffer to be used
+		* \param[in] imageIndex Index of the current swap chain image
+		* \param[in] numPass Number of the pass on this call, one for each light
+		* \param[in] pCamera Pointer to the cmaera to be used
+		* \param[in] pLight Pointer to the light to be renderered for
+		* \param[in] descriptorSets List of descriptor sets for per objects resources
+		* \returns the new command buffer and the pool of this thread that it came from
+		*
+		*/
+	VERendererForward::secondaryCmdBuf_t VERendererForward::recordRenderpass(VkRenderPass *pRenderPass,
+		VESubrender *pSub,
+		VkFramebuffer *pFrameBuffer,
+		uint32_t imageIndex,
+		uint32_t numPass,
+		VECamera *pCamera,
+		VELight *pLight,
+		const std::vector<VkDescriptorSet> &descriptorSets)
+	{
+		secondaryCmdBuf_t buf;
+		buf.pool = getThreadCommandPool();
+
+		vh::vhCmdCreateCommandBuffers(m_device, buf.pool,
+			VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+			1, &buf.buffer);
+
+		vh::vhCmdBeginCommandBuffer(m_device, *pRenderPass, 0, *pFrameBuffer, buf.buffer,
+			VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+
+		pSub->draw(buf.buffer, imageIndex, numPass, pCamera, pLight, descriptorSets);
+
+		vkEndCommandBuffer(buf.buffer);
+
+		return buf;
+	}
+
+	/**
+		*
+		* \brief Create a secondary command buffer and record the shadow casters of one subrenderer into it
+		*
+		* The casters are drawn into a tile of the shadow atlas, the viewport maps the shadow camera frustum to the tile.
+		*
+		* \param[in] tile The tile of the shadow atlas
+		* \param[in] imageIndex Index of the current swap chain image
+		* \param[in] pCamera Pointer to the shadow camera
+		* \param[in] pLight Pointer to the light casting the shadow
+		* \param[in] pCaster The subrenderer whose entities are drawn
+		* \returns the new command buffer and the pool of this thread that it came from
+		*
+		*/
+	VERendererForward::secondaryCmdBuf_t VERendererForward::recordShadowpass(VkRect2D tile,
+		uint32_t imageIndex,
+		VECamera *pCamera,
+		VELight *pLight,
+		VESubrender *pCaster)
+	{
+		secondaryCmdBuf_t buf;
+		buf.pool = getThreadCommandPool();
+
+		vh::vhCmdCreateCommandBuffers(m_device, buf.pool,
+			VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+			1, &buf.buffer);
+
+		vh::vhCmdBeginCommandBuffer(m_device, m_renderPassShadow, 0, m_shadowFramebuffer, buf.buffer,
+			VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+
+		VkViewport viewport = {};
+		viewport.x = (float)tile.offset.x;
+		viewport.y = (float)tile.offset.y;
+		viewport.width = (float)tile.extent.width;
+		viewport.height = (float)tile.extent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(buf.buffer, 0, 1, &viewport);
+		vkCmdSetScissor(buf.buffer, 0, 1, &tile);
+
+		buf.numDraws = ((VESubrenderFW_Shadow *)m_subrenderShadow)->drawCasters(buf.buffer, imageIndex, pCamera, pLight, pCaster, {});
+
+		vkEndCommandBuffer(buf.buffer);
+
+		return buf;
+	}
+
+	/**
+		*
+		* \brief Create a secondary command buffer and record the shadow casters of one subrenderer into all faces of a point light
+		*
+		* Each face has its own viewport, mapping the frustum of its shadow camera to its tile. The geometry shader
+		* chooses the viewport, so each caster is drawn only once.
+		*
+		* \param[in] pFaces The tiles of the faces in the shadow atlas
+		* \param[in] numFaces Number of faces, at most 6
+		* \param[in] imageIndex Index of the current swap chain image
+		* \param[in] pLight Pointer to the point light
+		* \param[in] pCaster The subrenderer whose entities are drawn
+		* \returns the new command buffer and the pool of this thread that it came from
+		*
+		*/
+	VERendererForward::secondaryCmdBuf_t VERendererForward::recordShadowpassCube(const veShadowTile_t *pFaces,
+		uint32_t numFaces,
+		uint32_t imageIndex,
+		VELight *pLight,
+		VESubrender *pCaster)
+	{
+		secondaryCmdBuf_t buf;
+		buf.pool = getThreadCommandPool();
+
+		vh::vhCmdCreateCommandBuffers(m_device, buf.pool,
+			VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+			1, &buf.buffer);
+
+		vh::vhCmdBeginCommandBuffer(m_device, m_renderPassShadow, 0, m_shadowFramebuffer, buf.buffer,
+			VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+
+		std::array<VkViewport, 6> viewports;
+		std::array<VkRect2D, 6> scissors;
+		numFaces = std::min(numFaces, (uint32_t)scissors.size());
+		for (uint32_t f = 0; f < numFaces; f++)
+		{
+			scissors[f] = pFaces[f].rect;
+			viewports[f].x = (float)scissors[f].offset.x;
+			viewports[f].y = (float)scissors[f].offset.y;
+			viewports[f].width = (float)scissors[f].extent.width;
+			viewports[f].height = (float)scissors[f].extent.height;
+			viewports[f].minDepth = 0.0f;
+			viewports[f].maxDepth = 1.0f;
+		}
+		vkCmdSetViewport(buf.buffer, 0, numFaces, viewports.data());
+		vkCmdSetScissor(buf.buffer, 0, numFaces, scissors.data());
+
+		buf.numDraws = ((VESubrenderFW_Shadow *)m_subrenderShadow)->drawCastersCube(buf.buffer, imageIndex, pLight, pCaster);
+
+		vkEndCommandBuffer(buf.buffer);
+
+		return buf;
+	}
+
+	/**
+		*
+		* \brief Record the command buffers of the current image
+		*
+		* Each light has one secondary command buffer for each subrenderer in its light pass, and one for each shadow
+		* cascade and subrenderer in its shadow pass. These are kept and only recorded again if they are outdated,
+		* i.e. entities of the subrenderer were added or removed, or its visible entities changed. Then the cheap
+		* primary command buffer is recorded, which executes the secondary buffers inside the render passes.
+		*
+		*/
+	void VERendererForward::recordCmdBuffers()
+	{
+		VECamera *pCamera;
+		VECHECKPOINTER(pCamera = getSceneManagerPointer()->getCamera());
+
+		pCamera->setExtent(getWindowPointer()->getExtent());
+
+		std::chrono::high_resolution_clock::time_point t_start = vh::vhTimeNow();
+
+		prepareRecording(pCamera);
+		recordSecondaryBuffers(pCamera);
+		recordPrimaryBuffers(pCamera);
+
+		m_AvgRecordTimeOnscreen = vh::vhAverage(vh::vhTimeDuration(t_start), m_AvgRecordTimeOnscreen, 1.0f / m_swapChainImages.size());
+
+		//remember the last recorded entities, for incremental recording
+		for (auto subrender : m_subrenderers)
+		{
+			subrender->afterDrawFinished();
+		}
+	}
+
+	/**
+		*
+		* \brief Find and free the outdated secondary command buffers of the current image
+		*
+		* A buffer is outdated if its subrenderer has a new version, or if the visible entities of the subrenderer
+		* changed for the camera that the buffer draws with. Also if the light got a different pass number
+		* or the scene camera changed. Shadow buffers are outdated if the tiles of the shadow atlas moved. The buffers of deleted lights are freed too. Since the fence of the current
+		* image has been waited for, its buffers are not pending. Freed buffers get the version UINT64_MAX.
+		* Subrenderers that are recorded again get their draw groups prepared.
+		*
+		* \param[in] pCamera Pointer to the scene camera
+		*
+		*/
+	void VERendererForward::prepareRecording(VECamera *pCamera)
+	{
+		for (auto &lightBuffers : m_lightBufferLists)
+		{
+			lightBuffers.second.seenThisLight = false;
+		}
+
+		uint32_t numSubs = (uint32_t)m_subrenderers.size();
+		veFrameVector<uint8_t> recordSub(numSubs, 0); //1 if any light pass buffer of the subrenderer is recorded
+
+		for (uint32_t i = 0; i < m_passLights.size(); i++)
+		{
+			VELight *pLight = m_passLights[i].pLight;
+			uint32_t numPasses = m_passLights[i].numShadowPasses();
+			uint32_t numPassCameras = m_passLights[i].cube ? m_passLights[i].numCascades : 1; //shadow cameras drawn by one pass
+			uint32_t camera = m_passLights[i].firstCamera; //index of the first shadow camera, 0 is the scene camera
+
+			lightBufferLists_t &lightBuffers = m_lightBufferLists[pLight];
+			lightBuffers.seenThisLight = true;
+			if (lightBuffers.lightLists.size() != m_swapChainImages.size())
+				lightBuffers.lightLists.resize(m_swapChainImages.size());
+
+			secondaryBufferLists_t &list = lightBuffers.lightLists[m_imageIndex];
+			if (list.numPass != i || list.pCamera != pCamera || list.lightBuffers.size() != numSubs ||
+				list.shadowBuffers.size() != numPasses * numSubs)
+			{ //nothing can be reused
+				freeSecondaryBuffers(list);
+				list.lightBuffers.resize(numSubs);
+				list.lightVersions.resize(numSubs, UINT64_MAX);
+				list.shadowBuffers.resize(numPasses * numSubs);
+				list.shadowVersions.resize(numPasses * numSubs, UINT64_MAX);
+				list.numPass = i;
+				list.pCamera = pCamera;
+			}
+
+			if (list.shadowAtlasVersion != m_shadowAtlasVersion)
+			{ //the shadow buffers draw into the old tiles
+				for (uint32_t idx = 0; idx < list.shadowBuffers.size(); idx++)
+				{
+					freeSecondaryBuffer(list.shadowBuffers[idx]);
+					list.shadowVersions[idx] = UINT64_MAX;
+				}
+				list.shadowAtlasVersion = m_shadowAtlasVersion;
+			}
+
+			for (uint32_t k = 0; k < numSubs; k++)
+			{
+				uint64_t version = m_cmdBufferVersion + m_subrenderers[k]->getVersion();
+
+				if (list.lightVersions[k] != version || isVisibilityChanged(0, k))
+				{
+					freeSecondaryBuffer(list.lightBuffers[k]);
+					list.lightVersions[k] = UINT64_MAX;
+					recordSub[k] = 1;
+				}
+
+				for (uint32_t j = 0; j < numPasses; j++)
+				{
+					uint32_t idx = j * numSubs + k;
+					bool outdated = list.shadowVersions[idx] != version;
+					for (uint32_t c = 0; c < numPassCameras && !outdated; c++)
+						outdated = isVisibilityChanged(camera + j + c, k);
+
+					if (outdated)
+					{
+						freeSecondaryBuffer(list.shadowBuffers[idx]);
+						list.shadowVersions[idx] = UINT64_MAX;
+					}
+				}
+			}
+		}
+
+		//free the buffers of lights that were deleted, other images might still use theirs
+		for (auto it = m_lightBufferLists.begin(); it != m_lightBufferLists.end();)
+		{
+			if (!it->second.seenThisLight && m_imageIndex < it->second.lightLists.size())
+				freeSecondaryBuffers(it->second.lightLists[m_imageIndex]);
 
-		m_lightBufferLists[pLight].seenThisLight = true;
+			bool empty = true;
+			for (auto &list : it->second.lightLists)
+				empty = empty && list.lightBuffers.empty() && list.shadowBuffers.empty();
+
+			if (!it->second.seenThisLight && empty)
+				it = m_lightBufferLists.erase(it);
+			else
+				it++;
+		}
+
+		//the subrenderers must know their draw groups before the light passes are recorded in parallel
+		for (uint32_t k = 0; k < numSubs; k++)
+		{
+			if (recordSub[k])
+				m_subrenderers[k]->prepareDrawGroups(m_imageIndex, pCamera);
+		}
 	}
 
-	void VERendererForward::recordPrimaryBuffers()
+	/**
+		*
+		* \brief Record all outdated secondary command buffers of the current image in parallel
+		*
+		* m_AvgCmdShadowTime and m_AvgCmdLightTime average the time the tasks spent recording, summed over all threads.
+		*
+		* \param[in] pCamera Pointer to the scene camera
+		*
+		*/
+	void VERendererForward::recordSecondaryBuffers(VECamera *pCamera)
 	{
-		vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffers[m_imageIndex]);
-		m_commandBuffers[m_imageIndex] = VK_NULL_HANDLE;
+		VETaskGroup group(getEnginePointer()->getJobSystem());
+		m_cmdShadowTime = 0.0f;
+		m_cmdLightTime = 0.0f;
+
+		for (uint32_t i = 0; i < m_passLights.size(); i++)
+		{
+			recordSecondaryBuffersForLight(m_passLights[i], i, pCamera, group);
+		}
+
+		//wait for all render passes, this thread records some of them meanwhile
+		group.wait();
+
+		m_AvgCmdShadowTime = vh::vhAverage(m_cmdShadowTime, m_AvgCmdShadowTime);
+		m_AvgCmdLightTime = vh::vhAverage(m_cmdLightTime, m_AvgCmdLightTime);
+	}
+
+	/**
+		*
+		* \brief Start recording the outdated secondary command buffers of one light
+		*
+		* Each buffer is recorded by a task of the group, writing directly into its slot in the light's list.
+		* Subrenderers that draw nothing in this pass, and shadow cameras without a tile in the atlas get no buffer.
+		* The faces of a point light rendered in one pass share their buffers.
+		*
+		* \param[in] passLight The light and its shadow cascades
+		* \param[in] numPass Number of the light pass, the first pass clears the framebuffer
+		* \param[in] pCamera Pointer to the scene camera
+		* \param[in] group The task group to run the recording tasks in
+		*
+		*/
+	void VERendererForward::recordSecondaryBuffersForLight(vePassLight_t &passLight, uint32_t numPass, VECamera *pCamera, VETaskGroup &group)
+	{
+		VELight *pLight = passLight.pLight;
+		secondaryBufferLists_t &list = m_lightBufferLists[pLight].lightLists[m_imageIndex];
+		uint32_t numSubs = (uint32_t)m_subrenderers.size();
+
+		//-----------------------------------------------------------------------------------------
+		//shadow passes
+
+		auto itTiles = m_shadowTiles.find(pLight);
+		for (uint32_t j = 0; j < passLight.numShadowPasses(); j++)
+		{
+			//the tile of the pass, or the tiles of all faces, the tasks read them from m_shadowTiles
+			uint32_t numFaces = passLight.cube ? passLight.numCascades : 1;
+			bool hasTiles = itTiles != m_shadowTiles.end() && j + numFaces <= itTiles->second.size();
+			for (uint32_t c = j; hasTiles && c < j + numFaces; c++)
+				hasTiles = itTiles->second[c].rect.extent.width > 0;
+
+			for (uint32_t k = 0; k < numSubs; k++)
+			{
+				uint32_t idx = j * numSubs + k;
+				if (list.shadowVersions[idx] != UINT64_MAX)
+					continue; //still up to date
+
+				VESubrender *pSub = m_subrenderers[k];
+				list.shadowVersions[idx] = m_cmdBufferVersion + pSub->getVersion();
+				if (pSub->getEntities().size() == 0 || !hasTiles)
+					continue;
+
+				secondaryCmdBuf_t *pBuffer = &list.shadowBuffers[idx];
+				const veShadowTile_t *pTiles = &itTiles->second[j];
+				bool cube = passLight.cube;
+				group.run([this, pBuffer, pLight, pSub, pTiles, j, numFaces, cube]()
+					{ //fits into the task storage, so the task does not allocate
+						std::chrono::high_resolution_clock::time_point t_start = vh::vhTimeNow();
+						if (cube)
+							*pBuffer = recordShadowpassCube(pTiles, numFaces, m_imageIndex, pLight, pSub);
+						else
+							*pBuffer = recordShadowpass(pTiles->rect, m_imageIndex, pLight->m_shadowCameras[j], pLight, pSub);
+						m_cmdShadowTime.fetch_add(vh::vhTimeDuration(t_start), std::memory_order_relaxed);
+					});
+			}
+		}
+
+		//-----------------------------------------------------------------------------------------
+		//light pass
+
+		VkRenderPass *pRenderPass = numPass == 0 ? &m_renderPassClear : &m_renderPassLoad;
+		for (uint32_t k = 0; k < numSubs; k++)
+		{
+			if (list.lightVersions[k] != UINT64_MAX)
+				continue; //still up to date
+
+			VESubrender *pSub = m_subrenderers[k];
+			list.lightVersions[k] = m_cmdBufferVersion + pSub->getVersion();
+			if (pSub->getEntities().size() == 0 || (numPass > 0 && pSub->getClass() != VE_SUBRENDERER_CLASS_OBJECT))
+				continue; //only objects are lit by more than one light
+
+			secondaryCmdBuf_t *pBuffer = &list.lightBuffers[k];
+			group.run([this, pBuffer, pRenderPass, pSub, numPass, pCamera, pLight]()
+				{
+					std::chrono::high_resolution_clock::time_point t_start = vh::vhTimeNow();
+					*pBuffer = recordRenderpass(pRenderPass, pSub, &m_swapChainFramebuffers[m_imageIndex], m_imageIndex,
+						numPass, pCamera, pLight, m_descriptorSetsShadow);
+					m_cmdLightTime.fetch_add(vh::vhTimeDuration(t_start), std::memory_order_relaxed);
+				});
+		}
+	}
+
+	/**
+		*
+		* \brief Record the primary command buffer of the current image
+		*
+		* For each light, the shadow passes and the light pass execute the secondary command buffers of all subrenderers.
+		* Each shadow pass renders one tile of the shadow atlas, or the block of a point light rendered in one pass.
+		* Tiles that keep their shadow map are skipped.
+		* In clustered mode, the lights are binned into the clusters before the first light pass.
+		*
+		* \param[in] pCamera Pointer to the scene camera
+		*
+		*/
+	void VERendererForward::recordPrimaryBuffers(VECamera *pCamera)
+	{
+		if (m_commandBuffers[m_imageIndex] != VK_NULL_HANDLE)
+		{
+			vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffers[m_imageIndex]);
+			m_commandBuffers[m_imageIndex] = VK_NULL_HANDLE;
+		}
 
 		//-----------------------------------------------------------------------------------------
 		//set clear values for shadow and light passes
 
-		std::vector<VkClearValue> clearValuesShadow = {}; //shadow map should be cleared every time
+		std::vector<VkClearValue> clearValuesShadow = {}; //the rendered tile is cleared every time
 		VkClearValue cv;
 		cv.depthStencil = { 1.0f, 0 };
 		clearValuesShadow.push_back(cv);
@@ -706,8 +1631,8 @@ namespace ve
 		std::vector<VkClearValue> clearValuesLight = {}; //render target and depth buffer should be cleared only first time
 		VkClearValue cv1, cv2;
 		cv1.color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		clearValuesLight.push_back(cv1);
 		cv2.depthStencil = { 1.0f, 0 };
+		clearValuesLight.push_back(cv1);
 		clearValuesLight.push_back(cv2);
 
 		//-----------------------------------------------------------------------------------------
@@ -715,40 +1640,95 @@ namespace ve
 
 		vh::vhCmdCreateCommandBuffers(m_device, m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1,
 			&m_commandBuffers[m_imageIndex]);
-
 		vh::vhCmdBeginCommandBuffer(m_device, m_commandBuffers[m_imageIndex], (VkCommandBufferUsageFlagBits)0);
 
-		uint32_t bufferIdx = 0;
-		for (uint32_t i = 0; i < getSceneManagerPointer()->getLights().size(); i++)
+		if (m_indirect)
+		{ //cull all entities on the GPU, the light passes then draw the surviving draw commands
+			for (auto pSub : m_subrenderers)
+			{
+				pSub->recordCull(m_commandBuffers[m_imageIndex], m_imageIndex, pCamera);
+			}
+
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+			vkCmdPipelineBarrier(m_commandBuffers[m_imageIndex], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+
+		if (m_clustered)
+			recordClusterBinning(m_commandBuffers[m_imageIndex], pCamera);
+
+		uint32_t numSubs = (uint32_t)m_subrenderers.size();
+		veFrameVector<VkCommandBuffer> buffers;
+		buffers.reserve(numSubs);
+		uint32_t numShadowDraws = 0;
+
+		for (uint32_t i = 0; i < m_passLights.size(); i++)
 		{
-			VELight *pLight = getSceneManagerPointer()->getLights()[i];
-			secondaryBufferLists_t &lightList = m_lightBufferLists[pLight].lightLists[m_imageIndex];
+			secondaryBufferLists_t &list = m_lightBufferLists[m_passLights[i].pLight].lightLists[m_imageIndex];
+			auto itTiles = m_shadowTiles.find(m_passLights[i].pLight);
 
-			for (uint32_t j = 0; j < pLight->m_shadowCameras.size(); j++)
+			for (uint32_t j = 0; j < m_passLights[i].numShadowPasses(); j++)
 			{
-				vh::vhRenderBeginRenderPass(m_commandBuffers[m_imageIndex], m_renderPassShadow,
-					m_shadowFramebuffers[m_imageIndex][j], clearValuesShadow,
-					m_shadowMaps[0][j]->m_extent,
-					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-				for (auto secBuf : lightList.shadowBuffers)
+				if (itTiles == m_shadowTiles.end() || j >= itTiles->second.size() || !itTiles->second[j].render)
+					continue; //the tile keeps its shadow map, or the camera has no tile
+
+				VkRect2D area = itTiles->second[j].rect;
+				if (m_passLights[i].cube)
+				{ //the faces are next to each other in their block
+					int32_t x1 = area.offset.x + area.extent.width, y1 = area.offset.y + area.extent.height;
+					for (uint32_t f = 1; f < m_passLights[i].numCascades && f < itTiles->second.size(); f++)
+					{
+						VkRect2D &face = itTiles->second[f].rect;
+						x1 = std::max(x1, face.offset.x + (int32_t)face.extent.width);
+						y1 = std::max(y1, face.offset.y + (int32_t)face.extent.height);
+						area.offset.x = std::min(area.offset.x, face.offset.x);
+						area.offset.y = std::min(area.offset.y, face.offset.y);
+					}
+					area.extent = { (uint32_t)(x1 - area.offset.x), (uint32_t)(y1 - area.offset.y) };
+				}
+
+				buffers.clear();
+				for (uint32_t k = 0; k < numSubs; k++)
 				{
-					vkCmdExecuteCommands(m_commandBuffers[m_imageIndex], 1, &secBuf.buffer);
+					if (list.shadowBuffers[j * numSubs + k].buffer != VK_NULL_HANDLE)
+					{
+						buffers.push_back(list.shadowBuffers[j * numSubs + k].buffer);
+						numShadowDraws += list.shadowBuffers[j * numSubs + k].numDraws;
+					}
 				}
+
+				vh::vhRenderBeginRenderPass(m_commandBuffers[m_imageIndex], m_renderPassShadow,
+					m_shadowFramebuffer, clearValuesShadow, area,
+					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				if (buffers.size() > 0)
+					vkCmdExecuteCommands(m_commandBuffers[m_imageIndex], (uint32_t)buffers.size(), buffers.data());
 				vkCmdEndRenderPass(m_commandBuffers[m_imageIndex]);
 			}
 
+			buffers.clear();
+			for (uint32_t k = 0; k < numSubs; k++)
+			{
+				if (list.lightBuffers[k].buffer != VK_NULL_HANDLE)
+					buffers.push_back(list.lightBuffers[k].buffer);
+			}
+
 			vh::vhRenderBeginRenderPass(m_commandBuffers[m_imageIndex], i == 0 ? m_renderPassClear : m_renderPassLoad,
 				m_swapChainFramebuffers[m_imageIndex], clearValuesLight, m_swapChainExtent,
 				VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-			for (auto secBuf : lightList.lightBuffers)
-			{
-				vkCmdExecuteCommands(m_commandBuffers[m_imageIndex], 1, &secBuf.buffer);
-			}
+			if (buffers.size() > 0)
+				vkCmdExecuteCommands(m_commandBuffers[m_imageIndex], (uint32_t)buffers.size(), buffers.data());
 			vkCmdEndRenderPass(m_commandBuffers[m_imageIndex]);
 
 			clearValuesLight.clear(); //since we blend the images onto each other, do not clear them for passes 2 and further
 		}
 
+		if (m_shadowDrawCalls.size() != m_swapChainImages.size())
+			m_shadowDrawCalls.resize(m_swapChainImages.size(), 0);
+		m_shadowDrawCalls[m_imageIndex] = numShadowDraws;
+
 		if (m_subrenderOverlay == nullptr) {
 			// without overlay renderer we must transition the image to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
 			vh::vhBufTransitionImageLayout(m_device, m_graphicsQueue,
@@ -760,27 +1740,22 @@ namespace ve
 		vkEndCommandBuffer(m_commandBuffers[m_imageIndex]);
 	}
 
-	void VERendererForward::recordCmdBuffers2()
-	{
-		prepareRecording();
-		recordSecondaryBuffers();
-		recordPrimaryBuffers();
-	}
-
 	/**
 		* \brief Acquire the next frame.
 		*
+		*- assign the tiles of the shadow atlas
 		*- wait for draw completion using a fence of a previous cmd buffer
 		*- acquire the next image from the swap chain
 		*/
 	void VERendererForward::acquireFrame()
 	{
+		m_shadowFrame++;
+		updateShadowAtlas(); //before the lights put their tiles into their UBOs
+
 		vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
 
 		//acquire the next image
-		VkResult result = vkAcquireNextImageKHR(m_device, m_swapChain, std::numeric_limits<uint64_t>::max(),
-			m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE,
-			&m_imageIndex);
+		VkResult result = acquireNextImage(m_imageAvailableSemaphores[m_currentFrame]);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			recreateSwapchain();
@@ -797,21 +1772,39 @@ namespace ve
 		* \brief Draw the frame.
 		*
 		*- if there is no command buffer yet, record one with the current scene
+		*- if the lights with their own pass changed, record all command buffers again
+		*- if the scene or the set of visible entities changed, record it again, reusing the secondary command buffers
+		*  that are still up to date (visibility is not needed if culling is done on the GPU)
+		*- if other tiles of the shadow atlas must be rendered, record it again
 		*- submit it to the queue
 		*/
 	void VERendererForward::drawFrame()
 	{
-		if (m_commandBuffersWithPendingUpdate[m_imageIndex])
-		{
-			vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffers[m_imageIndex]);
-			m_commandBuffers[m_imageIndex] = VK_NULL_HANDLE;
-			m_commandBuffersWithPendingUpdate[m_imageIndex] = false;
+		if (updatePassLights())
+		{ //lights were added or removed, or got shadow maps
+			updateCmdBuffers();
 		}
 
-		if (m_commandBuffers[m_imageIndex] == VK_NULL_HANDLE)
+		if (!m_indirect && updateVisibility(m_imageIndex) && m_commandBuffers[m_imageIndex] != VK_NULL_HANDLE)
+		{ //recorded entities are not the visible ones anymore
+			m_commandBuffersWithPendingUpdate[m_imageIndex] = true;
+		}
+
+		if (updateShadowSchedule())
+		{ //other tiles of the shadow atlas are rendered
+			m_commandBuffersWithPendingUpdate[m_imageIndex] = true;
+		}
+
+		if (m_commandBuffers[m_imageIndex] == VK_NULL_HANDLE || m_commandBuffersWithPendingUpdate[m_imageIndex])
 		{
 			recordCmdBuffers();
+			m_commandBuffersWithPendingUpdate[m_imageIndex] = false;
 		}
+		m_numShadowDrawCalls = m_imageIndex < m_shadowDrawCalls.size() ? m_shadowDrawCalls[m_imageIndex] : 0;
+
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		if (m_clustered && pCamera != nullptr)
+			updateClusterLights(pCamera);
 
 		//submit the command buffers
 		vh::vhCmdSubmitCommandBuffer(m_device, m_graphicsQueue, m_commandBuffers[m_imageIndex],
@@ -848,9 +1841,7 @@ namespace ve
 		*/
 	void VERendererForward::presentFrame()
 	{
-		VkResult result = vh::vhRenderPresentResult(m_presentQueue, m_swapChain,
-			m_imageIndex, //present it to the swap chain
-			m_subrenderOverlay == nullptr ? m_renderFinishedSemaphores[m_currentFrame] : m_overlaySemaphores[m_currentFrame]);
+		VkResult result = presentImage(m_subrenderOverlay == nullptr ? m_renderFinishedSemaphores[m_currentFrame] : m_overlaySemaphores[m_currentFrame]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_framebufferResized)
 		{
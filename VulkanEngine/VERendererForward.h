@@ -12,6 +12,18 @@ const uint32_t NUM_SHADOW_CASCADE = 6;
 
 namespace ve
 {
+	const uint32_t VE_SHADOW_ATLAS_SIZE = 8192; ///<Width and height of the shadow atlas in texels
+	const uint32_t VE_SHADOW_TILE_MAX = 2048; ///<Size of the largest tile in the shadow atlas, must be a power of 2
+	const uint32_t VE_SHADOW_TILE_MIN = 256; ///<Size of the smallest tile, lights that do not get one cast no shadows
+	const uint32_t VE_SHADOW_FAR_CASCADE = 2; ///<Cascades of directional lights from this one on are far cascades
+	const uint32_t VE_SHADOW_FAR_INTERVAL = 4; ///<Far cascades are rendered again at most every that many frames
+	const uint32_t VE_SHADOW_CUBE_FACES = 6; ///<Faces of a point light, rendered in one pass if the device supports it
+
+	const uint32_t VE_CLUSTER_TILE_SIZE = 64; ///<Width and height of a cluster on the screen in pixels
+	const uint32_t VE_CLUSTER_SLICES = 24; ///<Number of depth slices of the cluster grid
+	const uint32_t VE_CLUSTER_MAX_LIGHTS = 128; ///<Max number of lights in one cluster, must match MAXCLUSTERLIGHTS in the shaders
+	const uint32_t VE_MAX_CLUSTERED_LIGHTS = 4096; ///<Max number of lights that are shaded in the clusters
+
 	class VEEngine;
 
 	/**
@@ -20,31 +32,135 @@ namespace ve
 		*
 		* This renderer first clears the framebuffer, then starts rendering each entity one by one.
 		*
+		* All shadow maps are tiles of one shadow atlas, which is shared by all swapchain images. Each shadow camera
+		* of a light gets a tile, the size depends on the brightness of the light and how much of the screen it can reach.
+		* A tile is rendered again only if its shadow camera moved, or if shadow casters in its frustum changed.
+		* Far cascades of directional lights keep their tile even then for up to VE_SHADOW_FAR_INTERVAL frames.
+		* If the device has geometry shaders and multiple viewports, the 6 faces of a point light are rendered in one pass,
+		* a geometry shader sends each triangle to the viewports of the faces, so each caster is drawn once.
+		*
 		*/
 	class VERendererForward : public VERenderer
 	{
+	public:
+		///Light in the cluster light buffer, layout must match the shaders
+		struct veClusterLight_t
+		{
+			glm::ivec4 type; ///<Light type information
+			glm::vec4 position; ///<World position, w is the reach of the light
+			glm::vec4 direction; ///<World direction
+			glm::vec4 col_ambient; ///<Ambient color
+			glm::vec4 col_diffuse; ///<Diffuse color
+			glm::vec4 col_specular; ///<Specular color
+			glm::vec4 param; ///<Light parameters
+		};
+
+		///Header of the cluster light buffer, followed by the lights, layout must match the shaders
+		struct veClusterHeader_t
+		{
+			glm::uvec4 grid; ///<Number of clusters in x, y, z, tile size in pixels
+			glm::uvec4 counts; ///<Number of global lights, number of all lights, 1 if the light UBO of the first pass is shaded too
+			glm::vec4 depth; ///<Near plane, far plane, slices / log(far / near)
+			glm::vec4 extent; ///<Framebuffer size in pixels
+		};
+
+		///Buffers of the clustered lights, one set for each swapchain image
+		struct veClusterBuffers_t
+		{
+			VkBuffer lights = VK_NULL_HANDLE; ///<Header and lights, written by the CPU in each frame
+			VmaAllocation lightsAllocation = nullptr; ///<VMA information for the lights
+			VkBuffer counts = VK_NULL_HANDLE; ///<Number of lights in each cluster, written by the cluster shader
+			VmaAllocation countsAllocation = nullptr; ///<VMA information for the counts
+			VkBuffer indices = VK_NULL_HANDLE; ///<Light indices of each cluster, written by the cluster shader
+			VmaAllocation indicesAllocation = nullptr; ///<VMA information for the indices
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE; ///<Descriptor set holding the three buffers
+		};
+
+		///A light that has its own light pass
+		struct vePassLight_t
+		{
+			VELight *pLight; ///<The light
+			uint32_t firstCamera; ///<Index of its first shadow camera for isVisibilityChanged()
+			uint32_t numCascades; ///<Number of shadow maps that are rendered for the light
+			bool cube; ///<The shadow maps are the faces of a point light and are rendered in one pass
+
+			bool operator==(const vePassLight_t &other) const
+			{
+				return pLight == other.pLight && firstCamera == other.firstCamera && numCascades == other.numCascades &&
+					cube == other.cube;
+			};
+
+			///\returns the number of shadow passes, each has one command buffer for each subrenderer
+			uint32_t numShadowPasses() const
+			{
+				return cube ? 1 : numCascades;
+			};
+		};
+
+		///A tile of the shadow atlas holding the shadow map of one shadow camera
+		struct veShadowTile_t
+		{
+			VkRect2D rect = {}; ///<Texels of the tile in the atlas, the extent is 0 if the camera got no tile
+			VECamera::veUBOPerCamera_t ubo = {}; ///<Shadow camera UBO that the tile was rendered with
+			uint64_t frame = 0; ///<Frame in which the tile was rendered the last time
+			uint64_t version = 0; ///<Sum of the subrenderer versions when the tile was rendered
+			bool far = false; ///<Far cascade, rendered at most every VE_SHADOW_FAR_INTERVAL frames
+			bool valid = false; ///<The tile holds the shadow map rendered with ubo
+			bool locked = false; ///<Far cascade that keeps its shadow map in this frame in any case
+			bool dirty = false; ///<Shadow casters in the frustum changed since the tile was rendered
+			bool render = false; ///<The tile is rendered in this frame
+		};
+
 	protected:
-		std::vector<VkCommandPool> m_commandPools = {}; ///<Array of command pools so that each thread in the thread pool has its own pool
+		std::vector<VkCommandPool> m_commandPools = {}; ///<Array of command pools so that each thread of the job system has its own pool
 		std::vector<VkCommandBuffer> m_commandBuffers = {}; ///<the main command buffers for recording draw commands
 		std::vector<bool> m_commandBuffersWithPendingUpdate = {}; ///<flag storing if command buffer must be rerecorded
-		std::vector<std::vector<std::future<secondaryCmdBuf_t>>>
-			m_secondaryBuffersFutures = {}; ///<secondary buffers for parallel recording
-		std::vector<std::vector<secondaryCmdBuf_t>> m_secondaryBuffers = {}; ///<secondary buffers for parallel recording
 
 		std::map<VELight *, lightBufferLists_t> m_lightBufferLists; ///<each light has its own command buffer list, one for each image in the swap chain
+		uint64_t m_cmdBufferVersion = 0; ///<Increased if all secondary command buffers are outdated, added to the versions of the subrenderers
 
 		//per frame render resources
 		VkRenderPass m_renderPassClear; ///<The first light render pass, clearing the framebuffers
 		VkRenderPass m_renderPassLoad; ///<The second light render pass - no clearing of framebuffer
 
 		VETexture *m_depthMap = nullptr; ///<the image depth map
-		std::vector<std::vector<VETexture *>> m_shadowMaps; ///<the shadow maps - a list of map cascades
 
-		//per frame render resources for the shadow pass
-		VkRenderPass m_renderPassShadow; ///<The shadow render pass
-		std::vector<std::vector<VkFramebuffer>> m_shadowFramebuffers; ///<list of Framebuffers for shadow pass (up to 6)
+		//render resources for the shadow pass, shared by all swapchain images
+		VkRenderPass m_renderPassShadow; ///<The shadow render pass, clearing only the tile that is rendered
+		VETexture *m_shadowAtlas = nullptr; ///<Depth image holding the shadow maps of all lights as tiles
+		VkFramebuffer m_shadowFramebuffer = VK_NULL_HANDLE; ///<Framebuffer holding the shadow atlas
 		VkDescriptorSetLayout m_descriptorSetLayoutShadow; ///<Descriptor set layout for using shadow maps in the light pass
-		std::vector<VkDescriptorSet> m_descriptorSetsShadow; ///<Descriptor sets for usage of shadow maps in the light pass
+		std::vector<VkDescriptorSet> m_descriptorSetsShadow; ///<The set of the shadow atlas, once for each swapchain image
+
+		//shadow atlas
+		std::map<VELight *, std::vector<veShadowTile_t>> m_shadowTiles; ///<Tiles of all lights with shadow maps, one for each shadow camera
+		std::map<VELight *, uint32_t> m_shadowTileSizes; ///<Tile size that each light wants, before fitting into the atlas
+		uint64_t m_shadowAtlasVersion = 0; ///<Increased whenever tiles move in the atlas, so the shadow command buffers are outdated
+		bool m_shadowAtlasMoved = false; ///<Tiles moved in the atlas in this frame, so the lights must update their UBOs
+		uint64_t m_shadowFrame = 0; ///<Number of the current frame, for updating far cascades
+		std::vector<std::vector<uint8_t>> m_shadowTilesRecorded; ///<For each image, 1 for each shadow camera whose tile its primary buffer renders
+		std::vector<uint32_t> m_shadowDrawCalls; ///<For each image, the number of shadow draw calls that its primary buffer executes
+		std::vector<std::vector<glm::vec4>> m_casterSpheres; ///<For each subrenderer, the world bounding spheres of its entities when they last moved
+		std::vector<uint64_t> m_casterVersions; ///<For each subrenderer, its version when the spheres were computed
+		std::atomic<float> m_cmdShadowTime = 0.0f; ///<Time all tasks spent recording shadow passes in this frame
+		std::atomic<float> m_cmdLightTime = 0.0f; ///<Time all tasks spent recording light passes in this frame
+
+		VkDescriptorSetLayout m_descriptorSetLayoutInstances = VK_NULL_HANDLE; ///<Descriptor set layout for the instance indices of instanced drawing
+
+		//GPU driven drawing
+		bool m_indirect = false; ///<if true, entities are culled by a compute shader and drawn with indirect draw calls
+		VkDescriptorSetLayout m_descriptorSetLayoutCull = VK_NULL_HANDLE; ///<Descriptor set layout for the cull records, draw commands and draw counts
+		VkPipelineLayout m_pipelineLayoutCull = VK_NULL_HANDLE; ///<Pipeline layout of the cull compute shader
+		VkPipeline m_pipelineCull = VK_NULL_HANDLE; ///<Compute pipeline that culls entities and writes the draw commands
+
+		//clustered shading
+		bool m_clustered = false; ///<if true, lights without shadow maps are binned into clusters and shaded in the first light pass
+		std::vector<vePassLight_t> m_passLights; ///<Lights with their own light pass, in clustered mode only lights with shadow maps
+		glm::uvec3 m_clusterGrid = glm::uvec3(0); ///<Number of clusters in x, y, z
+		std::vector<veClusterBuffers_t> m_clusterBuffers; ///<Cluster buffers, one for each swapchain image
+		VkDescriptorSetLayout m_descriptorSetLayoutCluster = VK_NULL_HANDLE; ///<Descriptor set layout for the lights, cluster counts and cluster indices
+		VkPipelineLayout m_pipelineLayoutCluster = VK_NULL_HANDLE; ///<Pipeline layout of the cluster compute shader
+		VkPipeline m_pipelineCluster = VK_NULL_HANDLE; ///<Compute pipeline that lists the lights of each cluster
 
 		std::vector<VkSemaphore> m_imageAvailableSemaphores; ///<sem for waiting for the next swapchain image
 		std::vector<VkSemaphore> m_renderFinishedSemaphores; ///<sem for signalling that rendering done
@@ -60,22 +176,21 @@ namespace ve
 		virtual void createSubrenderers(); //create the subrenderers
 		virtual void recordCmdBuffers(); //record the command buffers
 
-		void recordCmdBuffers2();
-
-		/*secondaryCmdBuf_t recordRenderpass2(VkRenderPass *pRenderPass,
-												std::vector<VESubrender*> subRenderers,
-												VkFramebuffer *pFrameBuffer,
-												uint32_t imageIndex, uint32_t numPass,
-												VECamera *pCamera, VELight *pLight,
-												std::vector<VkDescriptorSet> descriptorSets);*/
-
-		void prepareRecording();
+		void createClusterBuffers(); //create the cluster buffers fitting the swapchain extent
+		void destroyClusterBuffers(); //destroy the cluster buffers, keep the descriptor sets
+		bool updatePassLights(); //find the lights with their own light pass
+		void updateClusterLights(VECamera *pCamera); //copy the lights without light pass into the light buffer
+		void recordClusterBinning(VkCommandBuffer commandBuffer, VECamera *pCamera); //record the cluster shader
 
-		void recordSecondaryBuffers();
+		void updateShadowAtlas(); //assign the tiles of the shadow atlas to the shadow cameras
+		bool updateShadowSchedule(); //find the tiles that are rendered in this frame
 
-		void recordSecondaryBuffersForLight(VELight *Light, uint32_t numPass);
-
-		void recordPrimaryBuffers();
+		void freeSecondaryBuffer(secondaryCmdBuf_t &buffer); //free a secondary command buffer if it exists
+		void freeSecondaryBuffers(secondaryBufferLists_t &list); //free all buffers of a list
+		void prepareRecording(VECamera *pCamera); //free all outdated secondary command buffers
+		void recordSecondaryBuffers(VECamera *pCamera); //record all outdated secondary command buffers
+		void recordSecondaryBuffersForLight(vePassLight_t &passLight, uint32_t numPass, VECamera *pCamera, VETaskGroup &group); //record the outdated buffers of one light
+		void recordPrimaryBuffers(VECamera *pCamera); //record the primary command buffer executing the secondary ones
 
 		virtual void acquireFrame(); //acquire the next frame
 		virtual void drawFrame(); //draw one frame
@@ -84,18 +199,28 @@ namespace ve
 		virtual void presentFrame(); //Present the newly drawn frame
 		virtual void closeRenderer(); //close the renderer
 		virtual void recreateSwapchain(); //new swapchain due to window size change
-		virtual secondaryCmdBuf_t recordRenderpass(VkRenderPass *pRenderPass, //record one render pass into a command buffer
-			std::vector<VESubrender *> subRenderers,
+		virtual secondaryCmdBuf_t recordRenderpass(VkRenderPass *pRenderPass, //record one subrenderer of a render pass into a command buffer
+			VESubrender *pSub,
 			VkFramebuffer *pFrameBuffer,
 			uint32_t imageIndex,
 			uint32_t numPass,
 			VECamera *pCamera,
 			VELight *pLight,
-			std::vector<VkDescriptorSet> descriptorSetsShadow);
+			const std::vector<VkDescriptorSet> &descriptorSetsShadow);
+		virtual secondaryCmdBuf_t recordShadowpass(VkRect2D tile, //record the shadow casters of one subrenderer into a command buffer
+			uint32_t imageIndex,
+			VECamera *pCamera,
+			VELight *pLight,
+			VESubrender *pCaster);
+		virtual secondaryCmdBuf_t recordShadowpassCube(const veShadowTile_t *pFaces, //record the shadow casters into all faces of a point light
+			uint32_t numFaces,
+			uint32_t imageIndex,
+			VELight *pLight,
+			VESubrender *pCaster);
 
 	public:
 		///Constructor of class VERendererForward
-		VERendererForward();
+		VERendererForward(bool indirect = false, bool clustered = false);
 
 		///Destructor of class VERendererForward
 		virtual ~VERendererForward() {};
@@ -104,21 +229,95 @@ namespace ve
 		virtual VkCommandPool
 			getThreadCommandPool()
 		{
-			return m_commandPools[getEnginePointer()->getThreadPool()->threadNum[std::this_thread::get_id()]];
+			return m_commandPools[getEnginePointer()->getJobSystem()->getThreadIndex()];
 		};
 
 		///called whenever the scene graph of the scene manager changes
 		virtual void updateCmdBuffers();
 
+		virtual void invalidateCmdBuffers(VESceneObject *pObject); //the UBO entry of an object moved
+
 		virtual void deleteCmdBuffers();
 
+		///\returns true if entities are culled on the GPU and drawn with indirect draw calls
+		bool isIndirect()
+		{
+			return m_indirect;
+		};
+
+		///\returns true if lights without shadow maps are shaded in clusters in the first light pass
+		bool isClustered()
+		{
+			return m_clustered;
+		};
+
+		///\returns true if shadow maps are rendered for the light, in clustered mode only if the light casts shadows
+		virtual bool hasShadowMaps(VELight *pLight)
+		{
+			return !m_clustered || pLight->m_castShadows;
+		};
+
+		virtual void updateShadowTiles(VELight *pLight); //put the tiles of the light into its UBO
+		virtual bool needsLightUpdate(VELight *pLight); //the light has tiles to render or its tiles moved
+
+		///\returns true if the device can render the 6 faces of a point light in one pass
+		bool hasCubeShadows()
+		{
+			return m_deviceFeatures.geometryShader && m_deviceFeatures.multiViewport &&
+				m_deviceLimits.maxViewports >= VE_SHADOW_CUBE_FACES;
+		};
+
+		///\returns true if the shadow maps of the light are rendered in one pass
+		bool isCubeShadow(VELight *pLight)
+		{
+			return hasCubeShadows() && pLight->getLightType() == VELight::VE_LIGHT_TYPE_POINT &&
+				pLight->m_shadowCameras.size() == VE_SHADOW_CUBE_FACES;
+		};
+
+		///\returns the descriptor set layout of the cluster buffers
+		VkDescriptorSetLayout getDescriptorSetLayoutCluster()
+		{
+			return m_descriptorSetLayoutCluster;
+		};
+
+		///\returns the descriptor set of the cluster buffers of a swapchain image
+		VkDescriptorSet getDescriptorSetCluster(uint32_t imageIndex)
+		{
+			return m_clusterBuffers[imageIndex].descriptorSet;
+		};
+
+
+		///\returns the descriptor set layout of the instance indices, only if not drawing indirectly
+		VkDescriptorSetLayout getDescriptorSetLayoutInstances()
+		{
+			return m_descriptorSetLayoutInstances;
+		};
+
+		///\returns the descriptor set layout of the cull shader buffers
+		VkDescriptorSetLayout getDescriptorSetLayoutCull()
+		{
+			return m_descriptorSetLayoutCull;
+		};
+
+		///\returns the pipeline layout of the cull shader
+		VkPipelineLayout getPipelineLayoutCull()
+		{
+			return m_pipelineLayoutCull;
+		};
+
+		///\returns the compute pipeline of the cull shader
+		VkPipeline getPipelineCull()
+		{
+			return m_pipelineCull;
+		};
+
 		///\returns the shadow descriptor set layout for the shadow
 		virtual VkDescriptorSetLayout getDescriptorSetLayoutShadow()
 		{
 			return m_descriptorSetLayoutShadow;
 		};
 
-		///\returns the per frame descriptor set
+		///\returns the descriptor set of the shadow atlas, once for each swapchain image
 		virtual std::vector<VkDescriptorSet> &getDescriptorSetsShadow()
 		{
 			return m_descriptorSetsShadow;
@@ -142,16 +341,16 @@ namespace ve
 			return m_depthMap;
 		};
 
-		///\returns a specific depth map from the whole set
-		std::vector<VETexture *> getShadowMap(uint32_t idx)
+		///\returns the shadow atlas
+		VETexture *getShadowAtlas()
 		{
-			return m_shadowMaps[idx];
+			return m_shadowAtlas;
 		};
 
-		///\returns the 2D extent of the shadow map
+		///\returns the 2D extent of the shadow atlas, the shadow pipelines set the viewport of each tile
 		virtual VkExtent2D getShadowMapExtent()
 		{
-			return m_shadowMaps[0][0]->m_extent;
+			return m_shadowAtlas->m_extent;
 		};
 	};
 
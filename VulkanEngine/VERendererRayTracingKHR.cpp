@@ -67,9 +67,7 @@ namespace ve
 
 		vh::vhMemCreateVMAAllocator(getEnginePointer()->getInstance(), m_physicalDevice, m_device, m_vmaAllocator);
 
-		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device, getWindowPointer()->getExtent(),
-			&m_swapChain, m_swapChainImages, m_swapChainImageViews,
-			&m_swapChainImageFormat, &m_swapChainExtent);
+		createSwapchain();
 
 		//------------------------------------------------------------------------------------------------------------
 		//create a command pools and the command buffers
@@ -77,8 +75,11 @@ namespace ve
 		vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface,
 			&m_commandPool); //command pool for the main thread
 
+		vh::vhUploadInit(m_physicalDevice, m_device, m_surface, m_vmaAllocator, m_graphicsQueue,
+			VE_UPLOAD_RING_SIZE, &m_uploadRing); //staging ring for meshes and textures
+
 		m_commandPools.resize(
-			getEnginePointer()->getThreadPool()->threadCount()); //each thread in the thread pool gets its own command pool
+			getEnginePointer()->getJobSystem()->getThreadCount() + 1); //each worker thread gets its own command pool, the last one is for the main thread
 		for (uint32_t i = 0; i < m_commandPools.size(); i++)
 		{
 			vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface, &m_commandPools[i]);
@@ -95,8 +96,6 @@ namespace ve
 		for (uint32_t i = 0; i < m_swapChainImages.size(); i++)
 			m_secondaryBuffers[i] = {}; //will be created later
 
-		m_secondaryBuffersFutures.resize(m_swapChainImages.size());
-
 		//------------------------------------------------------------------------------------------------------------
 		//create resources for light pass
 
@@ -131,6 +130,9 @@ namespace ve
 			 maxobjects },
 			&m_descriptorPool));
 
+		//maps of all entities, slots are freed when no frame in flight can use them anymore
+		m_pMaterialTable = new VEMaterialTable(m_device, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, getSwapChainNumber() + 1);
+
 		VECHECKRESULT(vh::vhRenderCreateDescriptorSetLayout(m_device,
 			{ 1 },
 			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
@@ -168,7 +170,8 @@ namespace ve
 	void VERendererRayTracingKHR::createSubrenderers()
 	{
 		addSubrenderer(new VESubrenderRayTracingKHR_DN(*this));
-		addSubrenderer(new VESubrender_Nuklear(*this));
+		if (!isHeadless()) //the overlay needs a GLFW window
+			addSubrenderer(new VESubrender_Nuklear(*this));
 	}
 
 	/**
@@ -190,7 +193,7 @@ namespace ve
 			vkDestroyImageView(m_device, imageView, nullptr);
 		}
 
-		vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
+		destroySwapchain();
 	}
 
 	/**
@@ -207,6 +210,8 @@ namespace ve
 		cleanupSwapChain();
 
 		//destroy per frame resources
+		delete m_pMaterialTable;
+		m_pMaterialTable = nullptr;
 		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
 		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutPerObject, nullptr);
 
@@ -222,6 +227,7 @@ namespace ve
 		for (auto pool : m_commandPools)
 			vkDestroyCommandPool(m_device, pool, nullptr);
 
+		vh::vhUploadDeinit(&m_uploadRing);
 		vmaDestroyAllocator(m_vmaAllocator);
 
 		vkDestroyDevice(m_device, nullptr);
@@ -236,9 +242,7 @@ namespace ve
 
 		cleanupSwapChain();
 
-		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device, getWindowPointer()->getExtent(),
-			&m_swapChain, m_swapChainImages, m_swapChainImageViews,
-			&m_swapChainImageFormat, &m_swapChainExtent);
+		createSwapchain();
 
 		m_depthMap = new VETexture("DepthMap");
 		m_depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
@@ -264,7 +268,7 @@ namespace ve
 	}
 
 	VERendererRayTracingKHR::secondaryCmdBuf_t VERendererRayTracingKHR::recordRenderpass(
-		std::vector<VESubrender *> subRenderers,
+		const std::vector<VESubrender *> &subRenderers,
 		VkFramebuffer *pFrameBuffer,
 		uint32_t imageIndex,
 		uint32_t numPass,
@@ -365,43 +369,39 @@ namespace ve
 		}
 		m_secondaryBuffers[m_imageIndex].clear();
 
-		m_secondaryBuffersFutures[m_imageIndex].clear();
-
-		ThreadPool *tp = getEnginePointer()->getThreadPool();
+		VEJobSystem *pJobSystem = getEnginePointer()->getJobSystem();
 
 		//-----------------------------------------------------------------------------------------------------------------
 		//go through all active lights in the scene
 
-		auto lights = getSceneManagerPointer()->getLights();
+		std::vector<VELight *> &lights = getSceneManagerPointer()->getLights();
 
 		std::chrono::high_resolution_clock::time_point t_start, t_now;
 		t_start = vh::vhTimeNow();
+		t_now = vh::vhTimeNow();
+
+		//each task writes its buffer into its slot, the tasks capture only pointers and indices so they do not allocate
+		m_secondaryBuffers[m_imageIndex].resize(lights.size());
+		VETaskGroup group(pJobSystem);
 		for (uint32_t i = 0; i < lights.size(); i++)
 		{
-			VELight *pLight = lights[i];
-
 			//-----------------------------------------------------------------------------------------
 			//light pass
 
-			t_now = vh::vhTimeNow();
-			{
-				auto future = tp->add(&VERendererRayTracingKHR::recordRenderpass, this, m_subrenderers,
-					&m_swapChainFramebuffers[m_imageIndex],
-					m_imageIndex, i, pCamera, pLight);
-
-				m_secondaryBuffersFutures[m_imageIndex].push_back(std::move(future));
-			}
-			m_AvgCmdLightTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdLightTime);
+			VELight *pLight = lights[i];
+			secondaryCmdBuf_t *pBuffer = &m_secondaryBuffers[m_imageIndex][i];
+			group.run([this, pBuffer, i, pCamera, pLight]()
+				{
+					*pBuffer = recordRenderpass(m_subrenderers, &m_swapChainFramebuffers[m_imageIndex], m_imageIndex,
+						i, pCamera, pLight);
+				});
 		}
 
 		//------------------------------------------------------------------------------------------
-		//wait for all threads to finish and copy secondary command buffers into the vector
+		//wait for all tasks, this thread records some of the buffers meanwhile
 
-		m_secondaryBuffers[m_imageIndex].resize(m_secondaryBuffersFutures[m_imageIndex].size());
-		for (uint32_t i = 0; i < m_secondaryBuffersFutures[m_imageIndex].size(); i++)
-		{
-			m_secondaryBuffers[m_imageIndex][i] = m_secondaryBuffersFutures[m_imageIndex][i].get();
-		}
+		group.wait();
+		m_AvgCmdLightTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdLightTime);
 		//-----------------------------------------------------------------------------------------
 		//create a new primary command buffer and record all secondary buffers into it
 
@@ -450,9 +450,7 @@ namespace ve
 		vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
 
 		//acquire the next image
-		VkResult result = vkAcquireNextImageKHR(m_device, m_swapChain, std::numeric_limits<uint64_t>::max(),
-			m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE,
-			&m_imageIndex);
+		VkResult result = acquireNextImage(m_imageAvailableSemaphores[m_currentFrame]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -525,9 +523,7 @@ namespace ve
 		*/
 	void VERendererRayTracingKHR::presentFrame()
 	{
-		VkResult result = vh::vhRenderPresentResult(m_presentQueue, m_swapChain,
-			m_imageIndex, //present it to the swap chain
-			m_overlaySemaphores[m_currentFrame]);
+		VkResult result = presentImage(m_subrenderOverlay == nullptr ? m_renderFinishedSemaphores[m_currentFrame] : m_overlaySemaphores[m_currentFrame]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_framebufferResized)
 		{
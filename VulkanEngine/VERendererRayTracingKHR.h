@@ -78,7 +78,7 @@ namespace ve
 		virtual void presentFrame(); //Present the newly drawn frame
 		virtual void closeRenderer(); //close the renderer
 		virtual void recreateSwapchain(); //new swapchain due to window size change
-		virtual secondaryCmdBuf_t recordRenderpass(std::vector<VESubrender *> subRenderers,
+		virtual secondaryCmdBuf_t recordRenderpass(const std::vector<VESubrender *> &subRenderers,
 			VkFramebuffer *pFrameBuffer,
 			uint32_t imageIndex,
 			uint32_t numPass,
@@ -89,7 +89,7 @@ namespace ve
 		virtual VkCommandPool
 			getThreadCommandPool()
 		{
-			return m_commandPools[getEnginePointer()->getThreadPool()->threadNum[std::this_thread::get_id()]];
+			return m_commandPools[getEnginePointer()->getJobSystem()->getThreadIndex()];
 		};
 
 		virtual void updateCmdBuffers();
@@ -104,14 +104,12 @@ namespace ve
 		size_t m_currentFrame = 0; ///<int for the fences
 		bool m_framebufferResized = false; ///<signal that window size is changing
 
-		std::vector<VkCommandPool> m_commandPools = {}; ///<Array of command pools so that each thread in the thread pool has its own pool
+		std::vector<VkCommandPool> m_commandPools = {}; ///<Array of command pools so that each thread of the job system has its own pool
 		std::vector<VkCommandBuffer> m_commandBuffers = {}; ///<the main command buffers for recording draw commands
 		std::vector<bool> m_commandBuffersWithPendingUpdate = {}; ///<flag storing if command buffer must be rerecorded
 
 		VkRenderPass m_renderPass;
 
-		std::vector<std::vector<std::future<secondaryCmdBuf_t>>>
-			m_secondaryBuffersFutures = {}; ///<secondary buffers for parallel recording
 		std::vector<std::vector<secondaryCmdBuf_t>> m_secondaryBuffers = {}; ///<secondary buffers for parallel recording
 
 		vh::vhAccelerationStructure m_topLevelAS;
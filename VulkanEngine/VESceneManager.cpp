@@ -41,7 +41,8 @@ namespace ve
 			getEnginePointer()->getRenderer()->getDescriptorSetLayoutPerObject(),
 			2048, sizeof(VEEntity::veUBOPerEntity_t),
 			getEnginePointer()->getRenderer()->getSwapChainNumber(),
-			m_memoryBlockMap[VESceneObject::VE_OBJECT_TYPE_ENTITY]));
+			m_memoryBlockMap[VESceneObject::VE_OBJECT_TYPE_ENTITY],
+			getEnginePointer()->getRenderer()->getDescriptorSetLayoutPerObjectStorage()));
 
 		m_memoryBlockMap[VESceneObject::VE_OBJECT_TYPE_CAMERA] = emptyList;
 		VECHECKRESULT(vh::vhMemBlockListInit(getEnginePointer()->getRenderer()->getDevice(),
@@ -75,28 +76,321 @@ namespace ve
 	//-----------------------------------------------------------------------------------------------------------------------
 	//load stuff using Assimp
 
+	//A cooked model is a flat blob: a header, then the meshes, materials and nodes.
+	//Strings are stored as length + characters, all entries are 4 byte aligned, so vertex
+	//and index arrays can be used right where they are in the blob.
+	//The same blob is written to the cache file, keyed by file name, modification time and import flags.
+
+	const uint32_t VE_MODEL_CACHE_MAGIC = 0x434d4556; ///<"VEMC"
+	const uint32_t VE_MODEL_CACHE_VERSION = 2; ///<Increase whenever the layout of the blob changes
+
+	///Header of a cooked model blob
+	struct veModelCacheHeader_t
+	{
+		uint32_t magic = VE_MODEL_CACHE_MAGIC; ///<Must be VE_MODEL_CACHE_MAGIC
+		uint32_t version = VE_MODEL_CACHE_VERSION; ///<Must be VE_MODEL_CACHE_VERSION
+		uint32_t vertexSize = sizeof(vh::vhVertex); ///<Size of one vertex
+		uint32_t aiFlags = 0; ///<Additional Assimp import flags
+		uint64_t fileTime = 0; ///<Modification time of the model file
+		uint64_t size = 0; ///<Size of the whole blob
+		uint32_t numMeshes = 0; ///<Number of meshes
+		uint32_t numMaterials = 0; ///<Number of materials
+		uint32_t numNodes = 0; ///<Number of nodes
+		uint32_t reserved = 0; ///<Padding
+	};
+
+	///Append data to a blob, pad to 4 bytes
+	static void veCookWrite(std::vector<uint8_t> &blob, const void *pData, size_t size)
+	{
+		blob.insert(blob.end(), (const uint8_t *)pData, (const uint8_t *)pData + size);
+		blob.resize((blob.size() + 3) & ~(size_t)3);
+	}
+
+	///Append a string to a blob
+	static void veCookWriteString(std::vector<uint8_t> &blob, const std::string &str)
+	{
+		uint32_t length = (uint32_t)str.size();
+		veCookWrite(blob, &length, sizeof(length));
+		veCookWrite(blob, str.data(), length);
+	}
+
+	///\returns a pointer to the next size bytes of a blob, or nullptr if the blob is too short
+	static const uint8_t *veCookRead(const std::vector<uint8_t> &blob, size_t &pos, size_t size)
+	{
+		if (size > blob.size() - pos)
+			return nullptr;
+
+		const uint8_t *pData = blob.data() + pos;
+		pos = std::min((pos + size + 3) & ~(size_t)3, blob.size());
+		return pData;
+	}
+
+	///Read a value from a blob
+	template <typename T>
+	static bool veCookReadValue(const std::vector<uint8_t> &blob, size_t &pos, T &value)
+	{
+		const uint8_t *pData = veCookRead(blob, pos, sizeof(T));
+		if (pData == nullptr)
+			return false;
+
+		memcpy(&value, pData, sizeof(T));
+		return true;
+	}
+
+	///Read a string from a blob
+	static bool veCookReadString(const std::vector<uint8_t> &blob, size_t &pos, std::string &str)
+	{
+		uint32_t length;
+		if (!veCookReadValue(blob, pos, length))
+			return false;
+
+		const uint8_t *pData = veCookRead(blob, pos, length);
+		if (pData == nullptr)
+			return false;
+
+		str.assign((const char *)pData, length);
+		return true;
+	}
+
 	/**
 		*
-		* \brief Load assets from file ussing Assimp
+		* \brief Write an Assimp scene into a blob
 		*
-		* The scene manager loads assets from a file and creates the contained meshes and materials.
-		* It does not create entities. Meshes and materials are stored in the scene manager's member variables.
+		* \param[in] pScene The imported scene
+		* \param[in] aiFlags Additional Assimp import flags the scene was imported with
+		* \param[in] fileTime Modification time of the model file
+		* \param[out] blob The cooked model
+		*
+		*/
+	static void veCookScene(const aiScene *pScene, uint32_t aiFlags, uint64_t fileTime, std::vector<uint8_t> &blob)
+	{
+		veModelCacheHeader_t header;
+		header.aiFlags = aiFlags;
+		header.fileTime = fileTime;
+		header.numMeshes = pScene->mNumMeshes;
+		header.numMaterials = pScene->mNumMaterials;
+
+		blob.clear();
+		veCookWrite(blob, &header, sizeof(header));
+
+		for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+		{
+			std::vector<vh::vhVertex> vertices;
+			std::vector<uint32_t> indices;
+			VEMesh::copyAiMesh(pScene->mMeshes[i], vertices, indices);
+
+			vh::vhMeshStats stats;
+			vh::vhMeshOptimize(vertices, indices, &stats); //weld vertices, reorder for the vertex cache and for fetching
+
+			glm::vec3 center;
+			float radius;
+			VEMesh::computeBoundingSphere(vertices.data(), (uint32_t)vertices.size(), center, radius);
+
+			uint32_t vertexCount = (uint32_t)vertices.size();
+			uint32_t indexCount = (uint32_t)indices.size();
+			uint32_t indexSize = vertexCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t); //16 bit indices if they fit
+			veCookWriteString(blob, pScene->mMeshes[i]->mName.C_Str());
+			veCookWrite(blob, &vertexCount, sizeof(vertexCount));
+			veCookWrite(blob, &indexCount, sizeof(indexCount));
+			veCookWrite(blob, &indexSize, sizeof(indexSize));
+			veCookWrite(blob, &center, sizeof(center));
+			veCookWrite(blob, &radius, sizeof(radius));
+			veCookWrite(blob, vertices.data(), vertices.size() * sizeof(vh::vhVertex));
+			if (indexSize == sizeof(uint16_t))
+			{
+				std::vector<uint16_t> indices16(indices.begin(), indices.end());
+				veCookWrite(blob, indices16.data(), indices16.size() * sizeof(uint16_t));
+			}
+			else
+			{
+				veCookWrite(blob, indices.data(), indices.size() * sizeof(uint32_t));
+			}
+
+			std::cout << "Mesh " << pScene->mMeshes[i]->mName.C_Str() << ": vertices " << stats.vertexCountBefore
+				<< " -> " << stats.vertexCountAfter << ", ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter
+				<< ", " << 8 * indexSize << " bit indices\n";
+		}
+
+		for (uint32_t i = 0; i < pScene->mNumMaterials; i++)
+		{
+			aiMaterial *paiMat = pScene->mMaterials[i];
+			aiString matname("");
+			paiMat->Get(AI_MATKEY_NAME, matname);
+
+			int32_t mode = aiShadingMode_Phong;
+			paiMat->Get(AI_MATKEY_SHADING_MODEL, mode);
+
+			glm::vec4 color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			aiColor3D aiColor(0.f, 0.f, 0.f);
+			if (paiMat->Get(AI_MATKEY_COLOR_DIFFUSE, aiColor) == AI_SUCCESS)
+				color = glm::vec4(aiColor.r, aiColor.g, aiColor.b, 1.0f);
+
+			//the last diffuse texture is used, but the first of all other maps
+			std::string textures[4];
+			aiTextureType types[4] = { aiTextureType_DIFFUSE, aiTextureType_NORMALS, aiTextureType_DISPLACEMENT, aiTextureType_HEIGHT };
+			for (uint32_t t = 0; t < 4; t++)
+			{
+				for (uint32_t j = 0; j < paiMat->GetTextureCount(types[t]); j++)
+				{
+					aiString str;
+					paiMat->GetTexture(types[t], j, &str);
+
+					std::string name(str.C_Str());
+					if (name.empty() || name[0] == '*')
+						continue;
+					if (t == 0 || textures[t].empty())
+						textures[t] = name;
+				}
+			}
+
+			veCookWriteString(blob, matname.C_Str());
+			veCookWrite(blob, &mode, sizeof(mode));
+			veCookWrite(blob, &color, sizeof(color));
+			for (auto &tex : textures)
+				veCookWriteString(blob, tex);
+		}
+
+		//nodes in depth first order, so that parents come before their children
+		std::vector<std::pair<const aiNode *, int32_t>> stack = { { pScene->mRootNode, -1 } };
+		while (!stack.empty())
+		{
+			const aiNode *node = stack.back().first;
+			int32_t parent = stack.back().second;
+			stack.pop_back();
+
+			int32_t index = (int32_t)header.numNodes++;
+			veCookWriteString(blob, node->mName.C_Str());
+			veCookWrite(blob, &parent, sizeof(parent));
+			veCookWrite(blob, &node->mTransformation, sizeof(glm::mat4)); //used as glm matrix, like before
+			veCookWrite(blob, &node->mNumMeshes, sizeof(uint32_t));
+			for (uint32_t i = 0; i < node->mNumMeshes; i++)
+			{
+				glm::uvec2 entity(node->mMeshes[i], pScene->mMeshes[node->mMeshes[i]]->mMaterialIndex);
+				veCookWrite(blob, &entity, sizeof(entity));
+			}
+
+			for (uint32_t i = node->mNumChildren; i > 0; i--)
+			{ //reversed, so that the first child is created first
+				stack.push_back({ node->mChildren[i - 1], index });
+			}
+		}
+
+		header.size = blob.size();
+		memcpy(blob.data(), &header, sizeof(header));
+	}
+
+	/**
+		*
+		* \brief Parse the blob of a cooked model
+		*
+		* Fills the mesh, material and node lists of the model. Vertex and index arrays are not copied,
+		* they point into the blob.
+		*
+		* \param[in,out] model The model, its blob must hold a cooked model
+		* \param[in] aiFlags Additional Assimp import flags the model must have been imported with
+		* \param[in] fileTime Modification time the model file must have
+		* \returns true if the blob is complete and fits the model file
+		*
+		*/
+	static bool veParseCookedModel(VESceneManager::veCookedModel_t &model, uint32_t aiFlags, uint64_t fileTime)
+	{
+		const std::vector<uint8_t> &blob = model.blob;
+		size_t pos = 0;
+
+		veModelCacheHeader_t header;
+		if (!veCookReadValue(blob, pos, header) || header.magic != VE_MODEL_CACHE_MAGIC ||
+			header.version != VE_MODEL_CACHE_VERSION || header.vertexSize != sizeof(vh::vhVertex) ||
+			header.aiFlags != aiFlags || header.fileTime != fileTime || header.size != blob.size())
+			return false;
+
+		model.meshes.resize(header.numMeshes);
+		for (auto &mesh : model.meshes)
+		{
+			uint32_t indexSize;
+			if (!veCookReadString(blob, pos, mesh.name) ||
+				!veCookReadValue(blob, pos, mesh.vertexCount) || !veCookReadValue(blob, pos, mesh.indexCount) ||
+				!veCookReadValue(blob, pos, indexSize) ||
+				!veCookReadValue(blob, pos, mesh.boundingSphereCenter) || !veCookReadValue(blob, pos, mesh.boundingSphereRadius) ||
+				(indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t)))
+				return false;
+
+			mesh.indexType = indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+			mesh.pVertices = (const vh::vhVertex *)veCookRead(blob, pos, (size_t)mesh.vertexCount * sizeof(vh::vhVertex));
+			mesh.pIndices = veCookRead(blob, pos, (size_t)mesh.indexCount * indexSize);
+			if (mesh.pVertices == nullptr || mesh.pIndices == nullptr)
+				return false;
+		}
+
+		model.materials.resize(header.numMaterials);
+		for (auto &mat : model.materials)
+		{
+			if (!veCookReadString(blob, pos, mat.name) ||
+				!veCookReadValue(blob, pos, mat.shading) || !veCookReadValue(blob, pos, mat.color) ||
+				!veCookReadString(blob, pos, mat.texDiffuse) || !veCookReadString(blob, pos, mat.texNormal) ||
+				!veCookReadString(blob, pos, mat.texBump) || !veCookReadString(blob, pos, mat.texHeight))
+				return false;
+		}
+
+		model.nodes.resize(header.numNodes);
+		for (uint32_t i = 0; i < header.numNodes; i++)
+		{
+			VESceneManager::veCookedNode_t &node = model.nodes[i];
+			uint32_t numEntities;
+			if (!veCookReadString(blob, pos, node.name) || !veCookReadValue(blob, pos, node.parent) ||
+				!veCookReadValue(blob, pos, node.transform) || !veCookReadValue(blob, pos, numEntities) ||
+				node.parent >= (int32_t)i || (node.parent < 0) != (i == 0))
+				return false;
+
+			node.entities.resize(numEntities);
+			for (auto &entity : node.entities)
+			{
+				if (!veCookReadValue(blob, pos, entity) || entity.x >= header.numMeshes || entity.y >= header.numMaterials)
+					return false;
+			}
+		}
+
+		return pos == blob.size();
+	}
+
+	/**
+		*
+		* \brief Load a model file into a cooked model
+		*
+		* If the cache is turned on and there is a cache file that fits the model file, the cache file is read in
+		* one go. Otherwise the file is imported with Assimp, cooked, and written into the cache.
+		* Does not touch the scene manager or any Vulkan object, so it can be called from any thread.
 		*
 		* \param[in] basedir Name of directory the file is in
 		* \param[in] filename Name of the file containing the assets
-		* \param[in] aiFlags Import flags for Assimp, see code below for some examples
-		* \param[out] meshes A list containing pointers to the loaded meshes
-		* \param[out] materials A list of pointers to the loaded materials
+		* \param[in] aiFlags Additional Assimp import flags
+		* \param[out] model The cooked model
+		* \param[out] error Error message if the model could not be loaded
+		* \returns true if the model could be loaded
 		*
 		*/
-	const aiScene *VESceneManager::loadAssets(std::string basedir, std::string filename, uint32_t aiFlags, std::vector<VEMesh *> &meshes, std::vector<VEMaterial *> &materials)
+	bool VESceneManager::cookModel(std::string basedir, std::string filename, uint32_t aiFlags, veCookedModel_t &model, std::string &error)
 	{
-		std::lock_guard<std::mutex> lock(m_mutex);
+		std::string filekey = basedir + "/" + filename;
+		std::string cachekey = filekey + "." + std::to_string(aiFlags) + ".vecache";
 
-		Assimp::Importer importer;
+		std::error_code ec;
+		uint64_t fileTime = (uint64_t)std::filesystem::last_write_time(filekey, ec).time_since_epoch().count();
+		bool useCache = m_modelCache && !ec;
 
-		std::string filekey = basedir + "/" + filename;
+		if (useCache)
+		{
+			std::ifstream file(cachekey, std::ios::binary | std::ios::ate);
+			if (file.is_open())
+			{
+				model.blob.resize((size_t)file.tellg());
+				file.seekg(0);
+				file.read((char *)model.blob.data(), model.blob.size());
+				if (file && veParseCookedModel(model, aiFlags, fileTime))
+					return true;
+			}
+		}
 
+		Assimp::Importer importer;
 		const aiScene *pScene = importer.ReadFile(filekey,
 			//aiProcess_FlipWindingOrder |
 			//aiProcess_RemoveRedundantMaterials |
@@ -108,12 +402,64 @@ namespace ve
 			//aiProcess_FixInfacingNormals |
 			aiFlags);
 
-		VECHECKPOINTER((void *)pScene);
+		if (pScene == nullptr)
+		{
+			error = importer.GetErrorString();
+			return false;
+		}
+
+		veCookScene(pScene, aiFlags, fileTime, model.blob);
+		importer.FreeScene();
+
+		if (useCache)
+		{ //write to a temporary file first, so that no one reads a half written cache file
+			std::string tmpkey = cachekey + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			std::ofstream file(tmpkey, std::ios::binary | std::ios::trunc);
+			file.write((const char *)model.blob.data(), model.blob.size());
+			file.close();
+			if (file)
+				std::filesystem::rename(tmpkey, cachekey, ec);
+			if (!file || ec)
+				std::filesystem::remove(tmpkey, ec); //the directory might be read only
+		}
+
+		return veParseCookedModel(model, aiFlags, fileTime);
+	}
+
+	/**
+		*
+		* \brief Load assets from file ussing Assimp
+		*
+		* The scene manager loads assets from a file and creates the contained meshes and materials.
+		* It does not create entities. Meshes and materials are stored in the scene manager's member variables.
+		* If the model cache is turned on, a cooked version of the file is used instead of importing it (see cookModel()).
+		*
+		* \param[in] basedir Name of directory the file is in
+		* \param[in] filename Name of the file containing the assets
+		* \param[in] aiFlags Import flags for Assimp, see code below for some examples
+		* \param[out] meshes A list containing pointers to the loaded meshes
+		* \param[out] materials A list of pointers to the loaded materials
+		* \returns true if the file could be loaded
+		*
+		*/
+	bool VESceneManager::loadAssets(std::string basedir, std::string filename, uint32_t aiFlags, std::vector<VEMesh *> &meshes, std::vector<VEMaterial *> &materials)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::string filekey = basedir + "/" + filename;
 
-		createMeshes(pScene, filekey, meshes); //create new meshes if any
-		createMaterials(pScene, basedir, filekey, materials); //create new materials if any
+		veCookedModel_t model;
+		std::string error;
+		if (!cookModel(basedir, filename, aiFlags, model, error))
+		{
+			std::cout << "Error: could not load " << filekey << ": " << error << "\n";
+			return false;
+		}
+
+		createMeshes(model, filekey, meshes); //create new meshes if any
+		createMaterials(model, basedir, filekey, materials); //create new materials if any
 
-		return pScene;
+		return true;
 	}
 
 	/**
@@ -123,12 +469,14 @@ namespace ve
 		* The scene manager loads assets from a file and creates the contained meshes and materials.
 		* Meshes and materials are stored in the scene manager's member variables. It then followsa the entity
 		* tree recursively and creates the contained entities.
+		* If the model cache is turned on, a cooked version of the file is used instead of importing it (see cookModel()).
 		*
 		* \param[in] entityName The name of the new entity (its the parent of all created entities)
 		* \param[in] basedir Name of directory the file is in
 		* \param[in] filename Name of the file containing the assets
 		* \param[in] aiFlags Import flags for Assimp, see code below for some examples
 		* \param[in] parent Make the new entity a child of this parent entity
+		* \returns the new scene node, or nullptr if the file could not be loaded
 		*
 		*/
 	VESceneNode *VESceneManager::loadModel(std::string entityName,
@@ -139,40 +487,29 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if (m_sceneNodes.count(entityName) > 0)
-			return m_sceneNodes[entityName]; //if an entity with this name exists return it
-
-		Assimp::Importer importer;
+		VESceneNode *pExisting = m_sceneNodes.lookup(entityName);
+		if (pExisting != nullptr)
+			return pExisting; //if an entity with this name exists return it
 
 		std::string filekey = basedir + "/" + filename;
 
-		const aiScene *pScene = importer.ReadFile(filekey,
-			//aiProcess_FlipWindingOrder |
-			//aiProcess_RemoveRedundantMaterials |
-			//aiProcess_PreTransformVertices |
-			aiProcess_GenNormals |
-			aiProcess_CalcTangentSpace |
-			aiProcess_Triangulate |
-			//aiProcess_JoinIdenticalVertices |
-			//aiProcess_FixInfacingNormals |
-			aiFlags);
-
-		if (!pScene)
+		veCookedModel_t model;
+		std::string error;
+		if (!cookModel(basedir, filename, aiFlags, model, error))
 		{
-			std::string error = importer.GetErrorString();
+			std::cout << "Error: could not load " << filekey << ": " << error << "\n";
+			return nullptr;
 		}
-		VECHECKPOINTER((void *)pScene);
 
 		VESceneNode *pMO = createSceneNode2(entityName,
 			parent); //create a new scene node as parent of the whole scene
 
 		std::vector<VEMesh *> meshes;
-		createMeshes(pScene, filekey, meshes); //create the new meshes if any
+		createMeshes(model, filekey, meshes); //create the new meshes if any
 		std::vector<VEMaterial *> materials;
-		createMaterials(pScene, basedir, filekey, materials); //create the new materials if any
+		createMaterials(model, basedir, filekey, materials); //create the new materials if any
 
-		copyAiNodes(pScene, meshes, materials, pScene->mRootNode,
-			pMO); //create scene nodes and entities from the file
+		createNodes(model, meshes, materials, pMO); //create scene nodes and entities from the file
 
 		sceneGraphChanged2(); //notify renderer to rerecord the cmd buffers
 		return pMO;
@@ -180,197 +517,305 @@ namespace ve
 
 	/**
 		*
-		* \brief Follow the Assimp tree of nodes and create entities from them.
+		* \brief Load a model asynchronously, without stalling the render loop
 		*
-		* Assimp returns a tree of nodes, each node having one or more meshes. Since an VEEntity
-		* can have only one mesh, for each of the meshes one VEEntity is created and being made the child
-		* of the current parent.
+		* The file is imported and its meshes and textures are decoded by a background job of the engine's
+		* job system. At the start of each frame, the render thread uploads a limited number of them
+		* to the GPU (see setModelLoadBudget()). Once all are uploaded, the scene nodes and entities are
+		* created just like loadModel() does.
 		*
-		* \param[in] pScene A pointer to the Assimp scene
-		* \param[in] meshes The meshes that were loaded by Assimp from the file
-		* \param[in] materials The materials that were loaded by Assimp from the file
-		* \param[in] node The Assimp node currently being processed
-		* \param[in] parent The parent entity of the new entity
+		* \param[in] entityName The name of the new entity (its the parent of all created entities)
+		* \param[in] basedir Name of directory the file is in
+		* \param[in] filename Name of the file containing the assets
+		* \param[in] aiFlags Import flags for Assimp
+		* \param[in] parent Make the new entity a child of this parent entity
+		* \returns a handle for querying the progress and waiting for the new scene node
 		*
 		*/
-	void VESceneManager::copyAiNodes(const aiScene *pScene,
-		std::vector<VEMesh *> &meshes,
-		std::vector<VEMaterial *> &materials,
-		aiNode *node,
+	std::shared_ptr<VESceneManager::veModelLoad_t> VESceneManager::loadModelAsync(std::string entityName,
+		std::string basedir,
+		std::string filename,
+		uint32_t aiFlags,
 		VESceneNode *parent)
 	{
-		VESceneNode *pObject = createSceneNode2(parent->getName() + "/" + node->mName.C_Str(), parent);
-
-		for (uint32_t i = 0; i < node->mNumMeshes; i++)
-		{ //go through the meshes of the Assimp node
+		std::shared_ptr<veModelLoad_t> pLoad = std::make_shared<veModelLoad_t>();
+		pLoad->entityName = entityName;
+		pLoad->basedir = basedir;
+		pLoad->filename = filename;
+		pLoad->aiFlags = aiFlags;
+		pLoad->parentName = parent != nullptr ? parent->getName() : "";
+		pLoad->node = pLoad->promise.get_future().share();
 
-			VEMesh *pMesh = nullptr;
-			VEMaterial *pMaterial = nullptr;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_modelLoads.push_back(pLoad); //the loader thread is started with the next frame
+		return pLoad;
+	}
 
-			uint32_t paiMeshIdx = node->mMeshes[i]; //get mesh index in global mesh list
-			pMesh = meshes[paiMeshIdx]; //use index to get pointer to VEMesh
-			aiMesh *paiMesh = pScene->mMeshes[paiMeshIdx]; //also get handle to the Assimp mesh
+	/**
+		*
+		* \brief Cook a model file and decode its textures
+		*
+		* Runs as a background job of the job system. Does not touch the scene manager or any Vulkan object.
+		*
+		* \param[in] pLoad The load to work on
+		*
+		*/
+	void VESceneManager::decodeModel(std::shared_ptr<veModelLoad_t> pLoad)
+	{
+		pLoad->cooked = cookModel(pLoad->basedir, pLoad->filename, pLoad->aiFlags, pLoad->model, pLoad->error);
+		if (!pLoad->cooked)
+		{
+			pLoad->decoded = true;
+			return;
+		}
 
-			uint32_t paiMatIdx = paiMesh->mMaterialIndex; //get the material index for this mesh
-			pMaterial = materials[paiMatIdx]; //use the index to get the right VEMaterial
+		//the textures that createMaterials() loads
+		std::set<std::string> texNames;
+		for (auto &mat : pLoad->model.materials)
+		{
+			for (auto pTex : { &mat.texDiffuse, &mat.texNormal, &mat.texBump, &mat.texHeight })
+			{
+				if (!pTex->empty())
+					texNames.insert(*pTex);
+			}
+		}
+		pLoad->texNames.assign(texNames.begin(), texNames.end());
 
-			glm::mat4 *pMatrix = (glm::mat4 *)&node->mTransformation;
+		//cook, decode each texture, upload each mesh and texture, create the nodes
+		pLoad->numSteps = 2 + (uint32_t)pLoad->model.meshes.size() + 2 * (uint32_t)pLoad->texNames.size();
+		pLoad->numStepsDone = 1;
 
-			VEEntity *pEnt = createEntity2(pObject->getName() + "/Entity_" + std::to_string(i), //create the new entity
-				VEEntity::VE_ENTITY_TYPE_NORMAL,
-				pMesh, pMaterial, pObject, *pMatrix);
+		pLoad->images.resize(pLoad->texNames.size());
+		pLoad->textures.resize(pLoad->texNames.size());
+		for (uint32_t i = 0; i < pLoad->texNames.size(); i++)
+		{
+			if (vh::vhBufIsTextureFile(pLoad->texNames[i]))
+				vh::vhBufLoadTextureData(pLoad->basedir, pLoad->texNames[i], pLoad->textures[i]); //stays empty if it fails
+			else if (vh::vhBufLoadImageData(pLoad->basedir, { pLoad->texNames[i] }, pLoad->images[i]) != VK_SUCCESS)
+				pLoad->images[i].clear(); //createMaterials() will try again and report the error
+			pLoad->numStepsDone++;
 		}
 
-		for (uint32_t i = 0; i < node->mNumChildren; i++)
-		{ //recursivly go down the node tree
-			copyAiNodes(pScene, meshes, materials, node->mChildren[i], pObject);
-		}
+		pLoad->decoded = true;
 	}
 
 	/**
 		*
-		* \brief Create all VEMesh instances from a file loaded by Assimp
+		* \brief Advance all asynchronous model loads
 		*
-		* Once Assimp loaded a file it offers a global list of meshes. The function just
-		* goes through this list and creates VEMesh instances, then stores pointers to the in the meshes list.
-		*
-		* \param[in] pScene Pointer to the Assimp scene.
-		* \param[in] filekey Unique string identifying this file. Can be used for the mesh names.
-		* \param[out] meshes List of new meshes.
+		* Called by the engine at the start of each frame, before the scene nodes are updated.
+		* Starts waiting loads as background jobs, and uploads the results of decoded loads within the budget.
+		* At most half of the worker threads are used for loading, since they also record the command buffers.
 		*
 		*/
-	void VESceneManager::createMeshes(const aiScene *pScene, std::string filekey, std::vector<VEMesh *> &meshes)
+	void VESceneManager::updateModelLoads()
 	{
-		VEMesh *pMesh = nullptr;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_modelLoads.empty())
+			return;
 
-		for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+		VEJobSystem *pJobSystem = getEnginePointer()->getJobSystem();
+		uint32_t maxDecoding = std::max(pJobSystem->getThreadCount() / 2, 1u);
+		uint32_t numDecoding = 0;
+		for (auto &pLoad : m_modelLoads)
 		{
-			const aiMesh *paiMesh = pScene->mMeshes[i];
-			std::string name = filekey + "/" + paiMesh->mName.C_Str();
+			if (pLoad->started && !pLoad->decoded)
+				numDecoding++;
+		}
 
-			VEMesh *pMesh = nullptr;
-			if (m_meshes.count(name) == 0)
+		uint32_t budget = m_modelLoadBudget;
+		for (auto it = m_modelLoads.begin(); it != m_modelLoads.end();)
+		{
+			std::shared_ptr<veModelLoad_t> pLoad = *it;
+			if (!pLoad->started && numDecoding < maxDecoding)
 			{
-				pMesh = new VEMesh(name, paiMesh);
-				m_meshes[name] = pMesh;
+				pLoad->started = true;
+				numDecoding++;
+				pJobSystem->add(&VESceneManager::decodeModel, this, pLoad);
 			}
+
+			if (pLoad->started && pLoad->decoded && finishModelLoad2(pLoad.get(), budget))
+				it = m_modelLoads.erase(it);
 			else
-			{
-				pMesh = m_meshes[name];
-			}
-			meshes.push_back(pMesh);
+				it++;
 		}
 	}
 
 	/**
 		*
-		* \brief Create all VEMaterial instances from a file loaded by Assimp
-		*
-		* Once Assimp loaded a file it offers a global list of materials. The function just
-		* goes through this list and creates VEMaterial instances, then stores pointers to the in the materials list.
+		* \brief Upload the decoded meshes and textures of a model, then create its scene nodes
 		*
-		* \param[in] pScene Pointer to the Assimp scene.
-		* \param[in] basedir Name of the directory the file is in (for loading textures)
-		* \param[in] filekey Unique string identifying this file. Can be used for the mesh names.
-		* \param[out] materials List of new materials.
+		* \param[in] pLoad The load to work on, must have been decoded
+		* \param[in,out] budget Number of meshes and textures that may still be uploaded in this frame
+		* \returns true if the load is finished
 		*
 		*/
-	void VESceneManager::createMaterials(const aiScene *pScene, std::string basedir, std::string filekey, std::vector<VEMaterial *> &materials)
+	bool VESceneManager::finishModelLoad2(veModelLoad_t *pLoad, uint32_t &budget)
 	{
-		for (uint32_t i = 0; i < pScene->mNumMaterials; i++)
+		if (!pLoad->cooked)
 		{
-			aiMaterial *paiMat = pScene->mMaterials[i];
-			aiString matname("");
-			paiMat->Get(AI_MATKEY_NAME, matname);
+			std::cout << "Error: could not load " << pLoad->filename << ": " << pLoad->error << "\n";
+			pLoad->numStepsDone = (uint32_t)pLoad->numSteps;
+			pLoad->promise.set_value(nullptr);
+			return true;
+		}
+
+		std::string filekey = pLoad->basedir + "/" + pLoad->filename;
 
-			std::string name = filekey + "/" + matname.C_Str();
-			VEMaterial *pMat = nullptr;
-			if (m_materials.count(name) == 0)
+		for (; pLoad->nextMesh < pLoad->model.meshes.size() && budget > 0; pLoad->nextMesh++)
+		{
+			veCookedMesh_t &mesh = pLoad->model.meshes[pLoad->nextMesh];
+			std::string name = filekey + "/" + mesh.name;
+			if (!m_meshes.contains(name))
+			{ //createMeshes() will then find it
+				VEMesh *pMesh = new VEMesh(name, mesh.pVertices, mesh.vertexCount, mesh.pIndices, mesh.indexCount, mesh.indexType,
+					mesh.boundingSphereCenter, mesh.boundingSphereRadius);
+				pMesh->m_handle = m_meshes.insert(name, pMesh);
+				budget--;
+			}
+			pLoad->numStepsDone++;
+		}
+
+		for (; pLoad->nextTexture < pLoad->texNames.size() && budget > 0; pLoad->nextTexture++)
+		{
+			std::string name = filekey + "/" + pLoad->texNames[pLoad->nextTexture];
+			if (!m_textures.contains(name) && !pLoad->textures[pLoad->nextTexture].empty())
+			{ //createTexture2() will then find it
+				VETexture *pTex = new VETexture(name, pLoad->textures[pLoad->nextTexture]);
+				pTex->m_handle = m_textures.insert(name, pTex);
+				budget--;
+			}
+			else if (!m_textures.contains(name) && pLoad->images[pLoad->nextTexture].size() > 0)
 			{
-				pMat = createMaterial2(name);
+				VETexture *pTex = new VETexture(name, pLoad->images[pLoad->nextTexture]);
+				pTex->m_handle = m_textures.insert(name, pTex);
+				budget--;
+			}
+			std::vector<vh::vhImageData>().swap(pLoad->images[pLoad->nextTexture]);
+			pLoad->textures[pLoad->nextTexture] = gli::texture();
+			pLoad->numStepsDone++;
+		}
 
-				int mode;
-				paiMat->Get(AI_MATKEY_SHADING_MODEL, mode);
-				pMat->shading = (aiShadingMode)mode;
+		if (pLoad->nextMesh < pLoad->model.meshes.size() || pLoad->nextTexture < pLoad->texNames.size())
+			return false; //continue in the next frame
 
-				aiColor3D color(0.f, 0.f, 0.f);
-				if (paiMat->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS)
-				{
-					pMat->color.r = color.r;
-					pMat->color.g = color.g;
-					pMat->color.b = color.b;
-					pMat->color.a = 1.0f;
-				}
+		VESceneNode *pMO = m_sceneNodes.lookup(pLoad->entityName); //if an entity with this name exists return it
+		if (pMO == nullptr && (pLoad->parentName.empty() || m_sceneNodes.contains(pLoad->parentName)))
+		{
+			VESceneNode *parent = pLoad->parentName.empty() ? nullptr : m_sceneNodes.lookup(pLoad->parentName);
+			pMO = createSceneNode2(pLoad->entityName, parent); //create a new scene node as parent of the whole scene
 
-				/*for (uint32_t i = 0; i < paiMat->mNumProperties; i++) {
-						aiMaterialProperty *paimatprop = paiMat->mProperties[i];
-						aiString key = paimatprop->mKey;
-						std::string skey(key.C_Str());
-						uint32_t j = 0;
-					}*/
+			std::vector<VEMesh *> meshes;
+			createMeshes(pLoad->model, filekey, meshes); //all meshes exist already
+			std::vector<VEMaterial *> materials;
+			createMaterials(pLoad->model, pLoad->basedir, filekey, materials); //all textures exist already
 
-				for (uint32_t i = 0; i < paiMat->GetTextureCount(aiTextureType_AMBIENT); i++)
-				{
-					aiString str;
-					paiMat->GetTexture(aiTextureType_AMBIENT, i, &str);
-				}
-				for (uint32_t i = 0; i < paiMat->GetTextureCount(aiTextureType_DIFFUSE); i++)
-				{
-					aiString str;
-					paiMat->GetTexture(aiTextureType_DIFFUSE, i, &str);
+			createNodes(pLoad->model, meshes, materials, pMO); //create scene nodes and entities from the file
 
-					std::string name(str.C_Str());
-					if (name[0] == '*')
-						continue;
-					pMat->mapDiffuse = createTexture2(filekey + "/" + name, basedir, name);
-				}
-				for (uint32_t i = 0; i < paiMat->GetTextureCount(aiTextureType_SPECULAR); i++)
-				{
-					aiString str;
-					paiMat->GetTexture(aiTextureType_SPECULAR, i, &str);
-				}
-				for (uint32_t i = 0; i < paiMat->GetTextureCount(aiTextureType_LIGHTMAP); i++)
-				{
-					aiString str;
-					paiMat->GetTexture(aiTextureType_LIGHTMAP, i, &str);
-				}
-				for (uint32_t i = 0; i < paiMat->GetTextureCount(aiTextureType_NORMALS); i++)
-				{
-					aiString str;
-					paiMat->GetTexture(aiTextureType_NORMALS, i, &str);
+			sceneGraphChanged2(); //notify renderer to rerecord the cmd buffers
+		} //else the parent has been deleted in the meantime
 
-					std::string name(str.C_Str());
-					if (name[0] == '*')
-						continue;
-					if (pMat->mapNormal == nullptr)
-						pMat->mapNormal = createTexture2(filekey + "/" + name, basedir, name);
-				}
-				for (uint32_t i = 0; i < paiMat->GetTextureCount(aiTextureType_DISPLACEMENT); i++)
-				{
-					aiString str;
-					paiMat->GetTexture(aiTextureType_DISPLACEMENT, i, &str);
+		pLoad->model = veCookedModel_t(); //release the blob
+		pLoad->numStepsDone = (uint32_t)pLoad->numSteps;
+		pLoad->promise.set_value(pMO);
+		return true;
+	}
 
-					std::string name(str.C_Str());
-					if (name[0] == '*')
-						continue;
-					if (pMat->mapBump == nullptr)
-						pMat->mapBump = createTexture2(filekey + "/" + name, basedir, name);
-				}
-				for (uint32_t i = 0; i < paiMat->GetTextureCount(aiTextureType_HEIGHT); i++)
-				{
-					aiString str;
-					paiMat->GetTexture(aiTextureType_HEIGHT, i, &str);
+	/**
+		*
+		* \brief Create the scene nodes and entities of a cooked model
+		*
+		* Each node of the model becomes a scene node. Since an VEEntity can have only one mesh,
+		* for each of the meshes of a node one VEEntity is created and being made the child of the node.
+		*
+		* \param[in] model The cooked model
+		* \param[in] meshes The meshes of the model, see createMeshes()
+		* \param[in] materials The materials of the model, see createMaterials()
+		* \param[in] parent The parent of the root node of the model
+		*
+		*/
+	void VESceneManager::createNodes(veCookedModel_t &model,
+		std::vector<VEMesh *> &meshes,
+		std::vector<VEMaterial *> &materials,
+		VESceneNode *parent)
+	{
+		std::vector<VESceneNode *> nodes(model.nodes.size());
+		for (uint32_t i = 0; i < model.nodes.size(); i++)
+		{
+			veCookedNode_t &node = model.nodes[i];
+			VESceneNode *pParent = node.parent < 0 ? parent : nodes[node.parent]; //parents have been created before
+			nodes[i] = createSceneNode2(pParent->getName() + "/" + node.name, pParent);
 
-					std::string name(str.C_Str());
-					if (name[0] == '*')
-						continue;
-					if (pMat->mapHeight == nullptr)
-						pMat->mapHeight = createTexture2(filekey + "/" + name, basedir, name);
-				}
+			for (uint32_t j = 0; j < node.entities.size(); j++)
+			{
+				createEntity2(nodes[i]->getName() + "/Entity_" + std::to_string(j), //create the new entity
+					VEEntity::VE_ENTITY_TYPE_NORMAL,
+					meshes[node.entities[j].x], materials[node.entities[j].y], nodes[i], node.transform);
 			}
-			else
+		}
+	}
+
+	/**
+		*
+		* \brief Create all VEMesh instances of a cooked model
+		*
+		* Goes through the list of meshes of the model and creates VEMesh instances, then stores pointers to them in the meshes list.
+		*
+		* \param[in] model The cooked model
+		* \param[in] filekey Unique string identifying this file. Can be used for the mesh names.
+		* \param[out] meshes List of new meshes.
+		*
+		*/
+	void VESceneManager::createMeshes(veCookedModel_t &model, std::string filekey, std::vector<VEMesh *> &meshes)
+	{
+		for (auto &mesh : model.meshes)
+		{
+			std::string name = filekey + "/" + mesh.name;
+
+			VEMesh *pMesh = m_meshes.lookup(name);
+			if (pMesh == nullptr)
+			{
+				pMesh = new VEMesh(name, mesh.pVertices, mesh.vertexCount, mesh.pIndices, mesh.indexCount, mesh.indexType,
+					mesh.boundingSphereCenter, mesh.boundingSphereRadius);
+				pMesh->m_handle = m_meshes.insert(name, pMesh);
+			}
+			meshes.push_back(pMesh);
+		}
+	}
+
+	/**
+		*
+		* \brief Create all VEMaterial instances of a cooked model
+		*
+		* Goes through the list of materials of the model and creates VEMaterial instances and their textures,
+		* then stores pointers to them in the materials list.
+		*
+		* \param[in] model The cooked model
+		* \param[in] basedir Name of the directory the file is in (for loading textures)
+		* \param[in] filekey Unique string identifying this file. Can be used for the mesh names.
+		* \param[out] materials List of new materials.
+		*
+		*/
+	void VESceneManager::createMaterials(veCookedModel_t &model, std::string basedir, std::string filekey, std::vector<VEMaterial *> &materials)
+	{
+		for (auto &mat : model.materials)
+		{
+			std::string name = filekey + "/" + mat.name;
+			VEMaterial *pMat = m_materials.lookup(name);
+			if (pMat == nullptr)
 			{
-				pMat = m_materials[name];
+				pMat = createMaterial2(name);
+				pMat->shading = (aiShadingMode)mat.shading;
+				pMat->color = mat.color;
+
+				if (!mat.texDiffuse.empty())
+					pMat->mapDiffuse = createTexture2(filekey + "/" + mat.texDiffuse, basedir, mat.texDiffuse);
+				if (!mat.texNormal.empty())
+					pMat->mapNormal = createTexture2(filekey + "/" + mat.texNormal, basedir, mat.texNormal);
+				if (!mat.texBump.empty())
+					pMat->mapBump = createTexture2(filekey + "/" + mat.texBump, basedir, mat.texBump);
+				if (!mat.texHeight.empty())
+					pMat->mapHeight = createTexture2(filekey + "/" + mat.texHeight, basedir, mat.texHeight);
 			}
 
 			materials.push_back(pMat);
@@ -413,8 +858,9 @@ namespace ve
 		VESceneNode *parent,
 		glm::mat4 transf)
 	{
-		if (m_sceneNodes.count(objectName) > 0)
-			return m_sceneNodes[objectName];
+		VESceneNode *pExisting = m_sceneNodes.lookup(objectName);
+		if (pExisting != nullptr)
+			return pExisting;
 
 		VESceneNode *pMO = new VESceneNode(objectName, transf);
 		addSceneNodeAndChildren2(pMO, parent);
@@ -584,18 +1030,14 @@ namespace ve
 	{
 		std::string filekey = basedir + "/" + texName;
 		VEMesh *pMesh;
-		VECHECKPOINTER(pMesh = m_meshes[STANDARD_MESH_PLANE]);
+		VECHECKPOINTER(pMesh = m_meshes.lookup(STANDARD_MESH_PLANE));
 
-		VEMaterial *pMat = nullptr;
-		if (m_materials.count(filekey) == 0)
+		VEMaterial *pMat = m_materials.lookup(filekey);
+		if (pMat == nullptr)
 		{
 			pMat = createMaterial2(filekey);
 			pMat->mapDiffuse = createTexture2(filekey, basedir, texName);
 		}
-		else
-		{
-			pMat = m_materials[filekey];
-		}
 
 		VEEntity *pEntity = createEntity2(entityName, VEEntity::VE_ENTITY_TYPE_SKYPLANE, pMesh, pMat, parent);
 		pEntity->m_castsShadow = false;
@@ -727,6 +1169,7 @@ namespace ve
 			((VESceneObject *)pNode)->getObjectType() == VESceneObject::VE_OBJECT_TYPE_ENTITY)
 		{
 			((VEEntity *)pNode)->m_visible = flag;
+			pNode->setDirty();
 		}
 
 		std::vector<VESceneNode *> children = pNode->getChildrenCopy();
@@ -738,9 +1181,11 @@ namespace ve
 
 	/**
 		*
-		* \brief Find all scene nodes without a parent, then update them and their children
+		* \brief Update the world matrices of all scene nodes and copy their data to the GPU
 		*
-		* Makes this nodes and their children to copy their data to the GPU
+		* The transform hierarchy computes the world matrices level by level. Then all nodes whose world matrix
+		* has changed update their UBOs, in parallel. If the scene graph has changed, the list of lights is
+		* collected again.
 		*
 		* \param[in] imageIndex Index of the swapchain image that is currently used.
 		*
@@ -749,100 +1194,59 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		m_lights.clear(); //light vector will be created dynamically
-
-		updateSceneNodes2(getRoot(), glm::mat4(1.0f), imageIndex
-
-		);
+		m_numNodesUpdated = 0;
+		m_numBytesUploaded = 0;
 
-		while (m_updateFutures.size() > 0)
-		{ //gets all futures from the threads and waits for them
-			m_updateFutures.front().get();
-			m_updateFutures.pop();
-		}
+		//ray tracing reads the transforms from the UBO buffer when building the acceleration structures, so update everything
+		bool forceUpdate = getEnginePointer()->isRayTracing();
 
-		for (
-			auto list : m_memoryBlockMap)
-		{ //update all UBO buffers, i.e. copy them to the GPU
-			vh::vhMemBlockUpdateBlockList(list.second, imageIndex);
+		VEJobSystem *pJobSystem = getEnginePointer()->getJobSystem();
+		if (m_transformHierarchy.update(getRoot(), pJobSystem, forceUpdate))
+		{ //the scene graph has changed, find the lights
+			m_lights.clear();
+			for (uint32_t i = 0; i < m_transformHierarchy.getNumNodes(); i++)
+			{
+				VESceneNode *pNode = m_transformHierarchy.getNode(i);
+				if (pNode->getNodeType() == VESceneNode::VE_NODE_TYPE_SCENEOBJECT &&
+					((VESceneObject *)pNode)->getObjectType() == VESceneObject::VE_OBJECT_TYPE_LIGHT)
+				{
+					m_lights.push_back((VELight *)pNode);
+				}
+			}
 		}
-	}
-
-	/**
-	*
-	* \brief Update this node and all its children
-	*
-	* Makes this nodes and their children to copy their data to the GPU
-	*
-	* \param[in] pNode Pointer to the node to start updating
-	* \param[in] parentWorldMatrix World Matrix of the parent, used as a start
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
-	*
-	*/
-	void VESceneManager::updateSceneNodes2(VESceneNode *pNode, glm::mat4 parentWorldMatrix, uint32_t imageIndex)
-	{
-		glm::mat4 worldMatrix = parentWorldMatrix * pNode->getTransform(); //compute the world matrix
-
-		pNode->updateUBO(worldMatrix, imageIndex); //copy UBO data to the GPU
 
-		if (pNode->getNodeType() == VESceneNode::VE_NODE_TYPE_SCENEOBJECT &&
-			((VESceneObject *)pNode)->getObjectType() == VESceneObject::VE_OBJECT_TYPE_LIGHT)
+		//shadow cameras follow the camera, and the renderer might still have to render the shadow maps of a light,
+		//so lights are updated in these cases even if they did not move
+		VERenderer *pRenderer = getEnginePointer()->getRenderer();
+		bool cameraChanged = m_camera != nullptr && m_camera->m_transformIdx < m_transformHierarchy.getNumNodes() &&
+			m_transformHierarchy.isChanged(m_camera->m_transformIdx);
+		for (auto pLight : m_lights)
 		{
-			m_lights.push_back((VELight *)pNode); //put a light into the light vector
+			if (pLight->m_transformIdx < m_transformHierarchy.getNumNodes() && pRenderer->hasShadowMaps(pLight) &&
+				(cameraChanged || pRenderer->needsLightUpdate(pLight)))
+			{
+				m_transformHierarchy.setChanged(pLight->m_transformIdx);
+			}
 		}
 
-		if (pNode->m_children.size() > 0)
-		{
-			ThreadPool *tp = getEnginePointer()->getThreadPool();
-
-			const uint32_t granularity = 200;
-			if (tp->threadCount() > 1 && pNode->m_children.size() > granularity)
+		const uint32_t granularity = 200;
+		pJobSystem->parallelFor(m_transformHierarchy.getNumNodes(), granularity, [&](uint32_t begin, uint32_t end)
 			{
-				uint32_t numThreads = std::min((int)(pNode->m_children.size() / granularity), (int)tp->threadCount());
-				uint32_t numChildrenPerThread = (uint32_t)pNode->m_children.size() / numThreads;
-
-				uint32_t startIdx, endIdx;
-				for (uint32_t k = 0; k < numThreads; k++)
+				uint32_t numUpdated = 0;
+				for (uint32_t i = begin; i < end; i++)
 				{
-					startIdx = k * numChildrenPerThread; //start index for parallel run
-					endIdx = k == numThreads - 1 ? (uint32_t)pNode->m_children.size() - 1 : (k + 1) * numChildrenPerThread - 1; //end index
-
-					auto future = tp->add(&VESceneManager::updateSceneNodes3, this, pNode->m_children, worldMatrix,
-						startIdx, endIdx, imageIndex); //add to threadpool
+					if (m_transformHierarchy.isChanged(i))
 					{
-						static std::mutex mutex;
-						std::lock_guard<std::mutex> lock(mutex);
-						m_updateFutures.push(
-							std::move(future)); //add to list of futures, so main thread can wait for completion
+						m_transformHierarchy.getNode(i)->updateUBO(m_transformHierarchy.getWorld(i), imageIndex); //copy UBO data to the GPU
+						numUpdated++;
 					}
 				}
-			}
-			else
-			{
-				updateSceneNodes3(pNode->m_children, worldMatrix, 0, (uint32_t)pNode->m_children.size() - 1,
-					imageIndex); //do sequential update
-			}
-		}
-	}
+				m_numNodesUpdated += numUpdated;
+			});
 
-	/**
-	*
-	* \brief Update a list of nodes and all their children
-	*
-	* This function can be called in parallel on subparts of a children list
-	*
-	* \param[in] children Reference to a list of children
-	* \param[in] worldMatrix Parent world matrix for the children
-	* \param[in] startIdx Start index pointing to the child to start at in the children list
-	* \param[in] endIdx End index pointing to the child to end with in the children list
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
-	*
-	*/
-	void VESceneManager::updateSceneNodes3(std::vector<VESceneNode *> &children, glm::mat4 worldMatrix, uint32_t startIdx, uint32_t endIdx, uint32_t imageIndex)
-	{
-		for (uint32_t i = startIdx; i <= endIdx; i++)
-		{
-			updateSceneNodes2(children[i], worldMatrix, imageIndex);
+		for (auto &list : m_memoryBlockMap)
+		{ //update all UBO buffers, i.e. copy them to the GPU
+			vh::vhMemBlockUpdateBlockList(list.second, imageIndex, &m_numBytesUploaded);
 		}
 	}
 
@@ -873,7 +1277,7 @@ namespace ve
 		{ //attach to the parent
 			parent->addChild(pNode);
 		}
-		m_sceneNodes[pNode->getName()] = pNode; //store in scene node list
+		pNode->m_handle = m_sceneNodes.insert(pNode->getName(), pNode); //store in scene node list
 
 		for (auto pChild : pNode->getChildrenList())
 		{ //do the same for all children
@@ -892,10 +1296,23 @@ namespace ve
 	VESceneNode *VESceneManager::getSceneNode(std::string name)
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_sceneNodes.lookup(name);
+	}
 
-		if (m_sceneNodes.count(name) == 0)
-			return nullptr;
-		return m_sceneNodes[name];
+	/**
+	*
+	* \brief Find a scene node using its handle
+	*
+	* This is much faster than finding it by name, so code running every frame should keep the handle.
+	*
+	* \param[in] handle Handle of the scene node, as returned by VESceneNode::getHandle()
+	* \returns a pointer to the scene node, or nullptr if it has been deleted
+	*
+	*/
+	VESceneNode *VESceneManager::getSceneNode(VEHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_sceneNodes.lookup(handle);
 	}
 
 	/**
@@ -909,9 +1326,9 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if (m_sceneNodes.count(name) == 0)
+		VESceneNode *pNode = m_sceneNodes.lookup(name); //pointer to the node
+		if (pNode == nullptr)
 			return;
-		VESceneNode *pNode = m_sceneNodes[name]; //pointer to the node
 
 		if (pNode->hasParent())
 			pNode->getParent()->removeChild(pNode); //if it has a parent, remove from the children list
@@ -922,7 +1339,7 @@ namespace ve
 
 		for (auto nodename : namelist)
 		{
-			VESceneNode *pdelNode = m_sceneNodes[nodename];
+			VESceneNode *pdelNode = m_sceneNodes.lookup(nodename);
 			m_deletedSceneNodes.push_back(pdelNode); //push it to the deleted scene nodes list
 		}
 
@@ -992,17 +1409,23 @@ namespace ve
 				VESceneObject::VE_OBJECT_TYPE_ENTITY) //if its a object that is rendered
 				getEnginePointer()->getRenderer()->removeEntityFromSubrenderers(
 					(VEEntity *)pObject); //remove it from its subrenderer
+			else
+				getEnginePointer()->getRenderer()->invalidateCmdBuffers(pObject); //cameras and lights are used by all command buffers
 
 			if (pObject->m_memoryHandle.pMemBlock !=
 				nullptr)
-			{ //remove it from the UBO list
+			{ //remove it from the UBO list, the last entry of the block is moved into its place
+				vh::vhMemoryHandle *pLast = pObject->m_memoryHandle.pMemBlock->handles.back();
 				vh::vhMemBlockRemoveEntry(&pObject->m_memoryHandle);
+				if (pLast != &pObject->m_memoryHandle)
+					getEnginePointer()->getRenderer()->invalidateCmdBuffers((VESceneObject *)pLast->owner);
 			}
 		}
 
 		notifyEventListeners(pNode); //notify all event listeners that this node will soon be deleted
 
-		m_sceneNodes.erase(pNode->getName()); //remove it from the scene node list
+		m_sceneNodes.erase(pNode->m_handle); //remove it from the scene node list
+		pNode->m_handle = VE_NULL_HANDLE;
 		delete pNode; //delete the scene node
 		//}
 	}
@@ -1076,11 +1499,12 @@ namespace ve
 		VESceneManager::createMesh(std::string name, std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices)
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
-		if (m_meshes.count(name) > 0)
-			return m_meshes[name]; //if mesh already exists, resturn it
+		VEMesh *pMesh = m_meshes.lookup(name);
+		if (pMesh != nullptr)
+			return pMesh; //if mesh already exists, resturn it
 
-		VEMesh *pMesh = new VEMesh(name, vertices, indices); //create the mesh
-		m_meshes[name] = pMesh; //store in mesh map
+		pMesh = new VEMesh(name, vertices, indices); //create the mesh
+		pMesh->m_handle = m_meshes.insert(name, pMesh); //store in mesh map
 		return pMesh;
 	}
 
@@ -1094,9 +1518,20 @@ namespace ve
 	VEMesh *VESceneManager::getMesh(std::string name)
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
-		if (m_meshes.count(name) == 0)
-			return nullptr;
-		return m_meshes[name];
+		return m_meshes.lookup(name);
+	};
+
+	/**
+	* \brief Find a mesh by its handle and return a pointer to it
+	*
+	* \param[in] handle Handle of the mesh, as returned by VEMesh::getHandle()
+	* \returns the mesh, or nullptr if it has been deleted
+	*
+	*/
+	VEMesh *VESceneManager::getMesh(VEHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_meshes.lookup(handle);
 	};
 
 	/**
@@ -1113,10 +1548,10 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if (m_meshes.count(name) > 0)
+		VEMesh *pMesh = m_meshes.lookup(name); //get pointer to the mesh
+		if (pMesh != nullptr)
 		{
-			VEMesh *pMesh = m_meshes[name]; //get pointer to the mesh
-			m_meshes.erase(name); //remove it from the mesh list
+			m_meshes.erase(pMesh->m_handle); //remove it from the mesh list
 			delete pMesh; //delete the mesh
 		}
 	}
@@ -1149,11 +1584,12 @@ namespace ve
 	*/
 	VETexture *VESceneManager::createTexture2(std::string name, std::string basedir, std::string texName)
 	{
-		if (m_textures.count(name) > 0)
-			return m_textures[name]; //if the texture already exists, return it
+		VETexture *pTex = m_textures.lookup(name);
+		if (pTex != nullptr)
+			return pTex; //if the texture already exists, return it
 
-		VETexture *pTex = new VETexture(name, basedir, { texName }); //create the texture
-		m_textures[name] = pTex; //store in texture list
+		pTex = new VETexture(name, basedir, { texName }); //create the texture
+		pTex->m_handle = m_textures.insert(name, pTex); //store in texture list
 		return pTex;
 	}
 
@@ -1168,9 +1604,21 @@ namespace ve
 	VETexture *VESceneManager::getTexture(std::string name)
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
-		if (m_textures.count(name) == 0)
-			return nullptr;
-		return m_textures[name];
+		return m_textures.lookup(name);
+	}
+
+	/**
+	*
+	* \brief Get a texture with a given handle
+	*
+	* \param[in] handle Handle of the texture, as returned by VETexture::getHandle()
+	* \returns a pointer to the texture, or nullptr if it has been deleted
+	*
+	*/
+	VETexture *VESceneManager::getTexture(VEHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_textures.lookup(handle);
 	}
 
 	/**
@@ -1184,10 +1632,10 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if (m_textures.count(name) > 0)
+		VETexture *pTex = m_textures.lookup(name); //get pointer to the texture
+		if (pTex != nullptr)
 		{ //if the texture exists
-			VETexture *pTex = m_textures[name]; //get pointer to the texture
-			m_textures.erase(name); //remove from the texture list
+			m_textures.erase(pTex->m_handle); //remove from the texture list
 			delete pTex; //delete it
 		}
 	}
@@ -1216,11 +1664,12 @@ namespace ve
 	*/
 	VEMaterial *VESceneManager::createMaterial2(std::string name)
 	{
-		if (m_materials.count(name) > 0)
-			return m_materials[name]; //if the material alredy exists, return it
+		VEMaterial *pMat = m_materials.lookup(name);
+		if (pMat != nullptr)
+			return pMat; //if the material alredy exists, return it
 
-		VEMaterial *pMat = new VEMaterial(name); //create the material
-		m_materials[name] = pMat; //store in material map
+		pMat = new VEMaterial(name); //create the material
+		pMat->m_handle = m_materials.insert(name, pMat); //store in material map
 		return pMat; //return it
 	}
 
@@ -1232,9 +1681,18 @@ namespace ve
 	VEMaterial *VESceneManager::getMaterial(std::string name)
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
-		if (m_materials.count(name) == 0)
-			return nullptr;
-		return m_materials[name];
+		return m_materials.lookup(name);
+	};
+
+	/**
+	* \brief Find a material by its handle and return a pointer to it
+	* \param[in] handle Handle of the material, as returned by VEMaterial::getHandle()
+	* \returns the material, or nullptr if it has been deleted
+	*/
+	VEMaterial *VESceneManager::getMaterial(VEHandle handle)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_materials.lookup(handle);
 	};
 
 	/**
@@ -1248,10 +1706,10 @@ namespace ve
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if (m_materials.count(name) > 0)
+		VEMaterial *pMat = m_materials.lookup(name); //get a pointer to it
+		if (pMat != nullptr)
 		{ //if the material exists
-			VEMaterial *pMat = m_materials[name]; //get a pointer to it
-			m_materials.erase(name); //remove from material map
+			m_materials.erase(pMat->m_handle); //remove from material map
 			delete pMat; //delete it
 		}
 	}
@@ -1261,15 +1719,21 @@ namespace ve
 	*/
 	void VESceneManager::closeSceneManager()
 	{
-		for (auto ent : m_sceneNodes)
-			delete ent.second;
+		m_modelLoads.clear(); //waiting handles get a broken promise
+
+		for (auto pNode : m_sceneNodes)
+			delete pNode;
 		delete m_rootSceneNode;
-		for (auto mesh : m_meshes)
-			delete mesh.second;
-		for (auto mat : m_materials)
-			delete mat.second;
-		for (auto tex : m_textures)
-			delete tex.second;
+		for (auto pMesh : m_meshes)
+			delete pMesh;
+		for (auto pMat : m_materials)
+			delete pMat;
+		for (auto pTex : m_textures)
+			delete pTex;
+		m_sceneNodes.clear();
+		m_meshes.clear();
+		m_materials.clear();
+		m_textures.clear();
 
 		for (auto list : m_memoryBlockMap)
 		{
@@ -1285,7 +1749,7 @@ namespace ve
 		std::lock_guard<std::mutex> lock(m_mutex);
 		for (auto pEnt : m_sceneNodes)
 		{
-			std::cout << pEnt.second->getName() << "\n";
+			std::cout << pEnt->getName() << "\n";
 		}
 	}
 
@@ -1327,8 +1791,8 @@ namespace ve
 
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if (m_sceneNodes.count(entityName) > 0)														// If an entity with this name already exists return it
-			return (VEClothEntity*)m_sceneNodes[entityName];
+		if (m_sceneNodes.contains(entityName))														// If an entity with this name already exists return it
+			return (VEClothEntity*)m_sceneNodes.lookup(entityName);
 
 		Assimp::Importer importer;
 		std::string filekey = basedir + "/" + filename;
@@ -1344,8 +1808,12 @@ namespace ve
 
 		VEClothMesh* pClothMesh = new VEClothMesh(pScene->mMeshes[FIRST_MESH_INDEX]);				// Create a ClothMesh
 
+		veCookedModel_t model;																		// Cook the scene to create its materials
+		veCookScene(pScene, 0, 0, model.blob);
+		veParseCookedModel(model, 0, 0);
+
 		std::vector<VEMaterial*> materials;															// Create materials if there are any
-		createMaterials(pScene, basedir, filekey, materials);
+		createMaterials(model, basedir, filekey, materials);
 
 		VEMaterial* pMaterial = materials[FIRST_MATERIAL_INDEX];									// Only one material is assumed, since the material at 0 ist a default material 
 
@@ -1356,7 +1824,7 @@ namespace ve
 			vh::vhMemBlockListAdd(m_memoryBlockMap[pObject->getObjectType()], pObject,
 				&pObject->m_memoryHandle);
 
-		m_sceneNodes[pEntity->getName()] = pEntity;													// Store the Entity in the node list
+		pEntity->m_handle = m_sceneNodes.insert(pEntity->getName(), pEntity);						// Store the Entity in the node list
 
 		getEnginePointer()->getRenderer()->addEntityToSubrenderer(pEntity);							// Add the Entity to the Subrenderer
 
@@ -46,6 +46,91 @@ namespace ve
 		*/
 	class VESceneManager
 	{
+	public:
+		///A mesh of a cooked model, the arrays point into the blob of the model
+		struct veCookedMesh_t
+		{
+			std::string name; ///<Name of the mesh in the model file
+			const vh::vhVertex *pVertices = nullptr; ///<The vertices
+			uint32_t vertexCount = 0; ///<Number of vertices
+			const void *pIndices = nullptr; ///<The indices, 16 or 32 bit
+			uint32_t indexCount = 0; ///<Number of indices
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32; ///<Type of the indices
+			glm::vec3 boundingSphereCenter = glm::vec3(0.0f, 0.0f, 0.0f); ///<Center of bounding sphere in local space
+			float boundingSphereRadius = 0.0f; ///<Radius of bounding sphere in local space
+		};
+
+		///A material of a cooked model
+		struct veCookedMaterial_t
+		{
+			std::string name; ///<Name of the material in the model file
+			int32_t shading = aiShadingMode_Phong; ///<Shading model
+			glm::vec4 color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); ///<Diffuse color
+			std::string texDiffuse; ///<File name of the diffuse texture, or empty
+			std::string texNormal; ///<File name of the normal map, or empty
+			std::string texBump; ///<File name of the bump map, or empty
+			std::string texHeight; ///<File name of the height map, or empty
+		};
+
+		///A node of a cooked model, parents come before their children
+		struct veCookedNode_t
+		{
+			std::string name; ///<Name of the node in the model file
+			int32_t parent = -1; ///<Index of the parent node, -1 for the root
+			glm::mat4 transform = glm::mat4(1.0f); ///<Transform of the entities of the node
+			std::vector<glm::uvec2> entities; ///<Mesh and material index of each entity of the node
+		};
+
+		///Everything needed to create a model, stored in one flat blob that is also the cache file format
+		struct veCookedModel_t
+		{
+			std::vector<uint8_t> blob; ///<The cooked model, as read from or written to the cache
+			std::vector<veCookedMesh_t> meshes; ///<The meshes
+			std::vector<veCookedMaterial_t> materials; ///<The materials
+			std::vector<veCookedNode_t> nodes; ///<The nodes
+		};
+
+		///State of an asynchronous model load, see loadModelAsync()
+		struct veModelLoad_t
+		{
+			std::string entityName; ///<Name of the new scene node
+			std::string basedir; ///<Directory the file is in
+			std::string filename; ///<Name of the model file
+			uint32_t aiFlags = 0; ///<Additional Assimp import flags
+			std::string parentName; ///<Name of the parent node, empty for the root
+
+			//written by the loader thread
+			veCookedModel_t model; ///<The cooked model, empty once the nodes have been created
+			bool cooked = false; ///<true if the model could be loaded
+			std::string error; ///<Error message if the model could not be loaded
+			std::vector<std::string> texNames; ///<File names of the textures
+			std::vector<std::vector<vh::vhImageData>> images; ///<Decoded images of each texture, empty if decoding failed
+			std::vector<gli::texture> textures; ///<Textures loaded from KTX or DDS files, empty for other files
+			std::atomic<bool> decoded = false; ///<true if the loader thread is done
+
+			//written by the render thread
+			bool started = false; ///<true if the loader thread has been started
+			uint32_t nextMesh = 0; ///<Next mesh to upload
+			uint32_t nextTexture = 0; ///<Next texture to upload
+			std::promise<VESceneNode *> promise; ///<Set when the model is in the scene graph
+
+			std::atomic<uint32_t> numStepsDone = 0; ///<Number of finished steps
+			std::atomic<uint32_t> numSteps = 1; ///<Number of steps, known after the import
+			std::shared_future<VESceneNode *> node; ///<The new scene node, or nullptr if loading failed
+
+			///\returns the fraction of the work that is done, between 0 and 1
+			float getProgress()
+			{
+				return (float)numStepsDone / (float)numSteps;
+			};
+
+			///\returns true if the model is in the scene graph, or loading failed
+			bool isFinished()
+			{
+				return node.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			};
+		};
+
 		friend VEEngine;
 		friend VERenderer;
 		friend VERendererForward;
@@ -55,29 +140,42 @@ namespace ve
 		friend VESubrenderDF_Composer;
 
 	protected:
-		std::map<std::string, VEMesh *> m_meshes = {}; ///<Storage of all meshes currently in the engine
-		std::map<std::string, VETexture *> m_textures = {}; ///<Storage of all textures
-		std::map<std::string, VEMaterial *> m_materials = {}; ///<Storage of all materials currently in the engine
-		std::map<std::string, VESceneNode *> m_sceneNodes = {}; ///<Storage of all scene nodes currently in the engine
+		VESlotMap<VEMesh *> m_meshes; ///<Storage of all meshes currently in the engine
+		VESlotMap<VETexture *> m_textures; ///<Storage of all textures
+		VESlotMap<VEMaterial *> m_materials; ///<Storage of all materials currently in the engine
+		VESlotMap<VESceneNode *> m_sceneNodes; ///<Storage of all scene nodes currently in the engine
 		std::vector<VESceneNode *> m_deletedSceneNodes = {}; ///<List of deleted scene nodes and their children
 		VESceneNode *m_rootSceneNode; ///<The root node of the scene graph
+		VETransformHierarchy m_transformHierarchy; ///<Local and world matrices of all scene nodes
 		std::map<VESceneObject::veObjectType, std::vector<vh::vhMemoryBlock *>> m_memoryBlockMap; ///<memory for the UBOs of the entities
-		std::queue<std::future<void>> m_updateFutures; ///<we might do UBO updates in parallel, these are the futures to wait for
 
 		VECamera *m_camera = nullptr; ///<Ptr to the current camera
 		std::vector<VELight *> m_lights = {}; ///<ptrs to the lights to use - filled automatically
 		std::mutex m_mutex; ///<Mutex for multithreading, locks the scene manager
 		bool m_autoRecord = true; ///<if true, then scene graph changes automatically leasd to a cmd buffer rerecording
+		std::atomic<uint32_t> m_numNodesUpdated = 0; ///<number of scene nodes that were recomputed in the last update
+		VkDeviceSize m_numBytesUploaded = 0; ///<number of UBO bytes copied to the GPU in the last update
+		std::vector<std::shared_ptr<veModelLoad_t>> m_modelLoads; ///<asynchronous model loads that are not finished yet
+		uint32_t m_modelLoadBudget = 8; ///<max number of meshes and textures of asynchronous loads uploaded per frame
+		bool m_modelCache = true; ///<if true, imported models are cooked into cache files next to the model files
 
 		virtual void initSceneManager();
 
 		virtual void closeSceneManager();
 
-		void createMeshes(const aiScene *pScene, std::string filekey, std::vector<VEMesh *> &meshes);
+		bool cookModel(std::string basedir, std::string filename, uint32_t aiFlags, veCookedModel_t &model, std::string &error);
+
+		void createMeshes(veCookedModel_t &model, std::string filekey, std::vector<VEMesh *> &meshes);
+
+		void createMaterials(veCookedModel_t &model, std::string basedir, std::string filekey, std::vector<VEMaterial *> &materials);
+
+		void createNodes(veCookedModel_t &model, std::vector<VEMesh *> &meshes, std::vector<VEMaterial *> &materials, VESceneNode *parent);
 
-		void createMaterials(const aiScene *pScene, std::string basedir, std::string filekey, std::vector<VEMaterial *> &materials);
+		void decodeModel(std::shared_ptr<veModelLoad_t> pLoad);
 
-		void copyAiNodes(const aiScene *pScene, std::vector<VEMesh *> &meshes, std::vector<VEMaterial *> &materials, aiNode *node, VESceneNode *parent);
+		void updateModelLoads();
+
+		bool finishModelLoad2(veModelLoad_t *pLoad, uint32_t &budget);
 
 		//private shadow functions for the public API, so API does not lock itself
 		VESceneNode *createSceneNode2(std::string name, VESceneNode *parent, glm::mat4 transf = glm::mat4(1.0f));
@@ -101,10 +199,6 @@ namespace ve
 		void sceneGraphChanged3(); //tell renderer to rerecord the cmd buffers
 		void updateSceneNodes(uint32_t imageIndex);
 
-		void updateSceneNodes2(VESceneNode *pNode, glm::mat4 worldMatrix, uint32_t imageIndex);
-
-		void updateSceneNodes3(std::vector<VESceneNode *> &children, glm::mat4 worldMatrix, uint32_t startIdx, uint32_t endIdx, uint32_t imageIndex);
-
 		void setVisibility2(VESceneNode *pNode, bool flag); //set a whole subtree visible or not
 		void notifyEventListeners(VESceneNode *pNode);
 
@@ -122,10 +216,24 @@ namespace ve
 		//-------------------------------------------------------------------------------------
 		//Load assets
 
-		const aiScene *loadAssets(std::string basedir, std::string filename, uint32_t aiFlags, std::vector<VEMesh *> &meshes, std::vector<VEMaterial *> &materials);
+		bool loadAssets(std::string basedir, std::string filename, uint32_t aiFlags, std::vector<VEMesh *> &meshes, std::vector<VEMaterial *> &materials);
 
 		VESceneNode *loadModel(std::string entityName, std::string basedir, std::string filename, uint32_t aiFlags = 0, VESceneNode *parent = nullptr);
 
+		std::shared_ptr<veModelLoad_t> loadModelAsync(std::string entityName, std::string basedir, std::string filename, uint32_t aiFlags = 0, VESceneNode *parent = nullptr);
+
+		///\brief Set the max number of meshes and textures of asynchronous loads that are uploaded per frame
+		void setModelLoadBudget(uint32_t budget)
+		{
+			m_modelLoadBudget = std::max(budget, 1u);
+		};
+
+		///\brief Turn the cache of cooked models on or off, affects the models loaded afterwards
+		void setModelCache(bool flag)
+		{
+			m_modelCache = flag;
+		};
+
 		//-------------------------------------------------------------------------------------
 		//Create scene nodes and entities
 		//API that needs to by synchronized
@@ -168,6 +276,7 @@ namespace ve
 		//----------------------------------------------------------------
 		//API that needs to by synchronized
 		VESceneNode *getSceneNode(std::string entityName);
+		VESceneNode *getSceneNode(VEHandle handle); //find a scene node by its handle, faster than by name
 
 		void deleteSceneNodeAndChildren(std::string name);
 
@@ -180,18 +289,21 @@ namespace ve
 		VEMesh *createMesh(std::string name, std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices);
 
 		VEMesh *getMesh(std::string name);
+		VEMesh *getMesh(VEHandle handle); //find a mesh by its handle, faster than by name
 
 		void deleteMesh(std::string name);
 
 		VETexture *createTexture(std::string name, std::string basedir, std::string texName);
 
 		VETexture *getTexture(std::string name);
+		VETexture *getTexture(VEHandle handle); //find a texture by its handle, faster than by name
 
 		void deleteTexture(std::string name);
 
 		VEMaterial *createMaterial(std::string name);
 
 		VEMaterial *getMaterial(std::string name);
+		VEMaterial *getMaterial(VEHandle handle); //find a material by its handle, faster than by name
 
 		void deleteMaterial(std::string name);
 
@@ -208,6 +320,26 @@ namespace ve
 		void setCamera(VECamera *cam)
 		{
 			m_camera = cam;
+			if (cam != nullptr)
+				cam->setDirty(); //the shadow cameras of the lights follow the new camera
+		};
+
+		///\returns the number of scene nodes whose world matrix and UBO were recomputed in the last update
+		uint32_t getNumNodesUpdated()
+		{
+			return m_numNodesUpdated;
+		};
+
+		///\returns the number of UBO bytes that were copied to the GPU in the last update
+		VkDeviceSize getNumBytesUploaded()
+		{
+			return m_numBytesUploaded;
+		};
+
+		///\returns a pointer to the transform hierarchy holding the transforms of all scene nodes
+		VETransformHierarchy *getTransformHierarchy()
+		{
+			return &m_transformHierarchy;
 		};
 
 		///\returns a list with names of the current lights shining on the scene
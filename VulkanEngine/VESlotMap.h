@@ -0,0 +1,245 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#ifndef VESLOTMAP_H
+#define VESLOTMAP_H
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace ve
+{
+	/**
+		*
+		* \brief Handle of an object stored in a VESlotMap
+		*
+		* The lower 32 bits are the slot index, the upper 32 bits are the generation of the slot.
+		* When an object is erased, the generation of its slot is increased, so old handles do not find
+		* the next object stored in the same slot. The value 0 is never a valid handle.
+		*
+		*/
+	typedef uint64_t VEHandle;
+
+	const VEHandle VE_NULL_HANDLE = 0; ///<Handle that never refers to an object
+
+	///Hash for std::string that can also hash string views and C strings without creating a string
+	struct veStringHash_t
+	{
+		using is_transparent = void;
+
+		size_t operator()(std::string_view s) const
+		{
+			return std::hash<std::string_view>()(s);
+		};
+	};
+
+	/**
+		*
+		* \brief Container with O(1) access through generational handles
+		*
+		* The values are stored densely in one vector, so iterating over all values touches only contiguous memory.
+		* A handle points to a slot, and the slot holds the position of the value in the dense vector.
+		* Erasing moves the last value into the hole, and puts the slot on a free list. Freed slots are reused,
+		* with an increased generation.
+		*
+		* Values can have a name. Names are kept in a hash index that is only used for looking up values by name,
+		* all other accesses go through the handles. If two values are inserted with the same name, then
+		* the name refers to the newer one. Each name keeps all of its handles, so if the newer value is erased,
+		* then the name refers to the older one again.
+		*
+		* The slot map is not thread safe, the owner must lock it.
+		*
+		*/
+	template<typename T>
+	class VESlotMap
+	{
+	protected:
+		///A slot that handles point to
+		struct veSlot_t
+		{
+			uint32_t dense; ///<Position of the value in m_values, or next free slot if the slot is free
+			uint32_t generation; ///<Increased each time the slot is freed
+		};
+
+		std::vector<T> m_values; ///<The values, densely packed
+		std::vector<uint32_t> m_valueSlots; ///<Slot index of each value
+		std::vector<std::string> m_valueNames; ///<Name of each value, may be empty
+		std::vector<veSlot_t> m_slots; ///<The slots
+		uint32_t m_freeSlot = UINT32_MAX; ///<First slot of the free list
+		std::unordered_map<std::string, std::vector<VEHandle>, veStringHash_t, std::equal_to<>> m_names; ///<Index from names to their handles, the newest last
+
+		///\returns the slot of a handle, or nullptr if the handle is not valid
+		veSlot_t *getSlot(VEHandle handle)
+		{
+			uint32_t idx = (uint32_t)(handle & 0xFFFFFFFF);
+			uint32_t generation = (uint32_t)(handle >> 32);
+			if (idx >= m_slots.size() || m_slots[idx].generation != generation)
+				return nullptr;
+			return &m_slots[idx];
+		};
+
+	public:
+		///Constructor
+		VESlotMap() {};
+
+		///Destructor
+		~VESlotMap() {};
+
+		/**
+			* \brief Store a new value
+			* \param[in] name Name of the value, can be empty if the value is never looked up by name
+			* \param[in] value The value
+			* \returns the handle of the new value
+			*/
+		VEHandle insert(std::string_view name, const T &value)
+		{
+			uint32_t idx;
+			if (m_freeSlot != UINT32_MAX)
+			{
+				idx = m_freeSlot;
+				m_freeSlot = m_slots[idx].dense;
+			}
+			else
+			{
+				idx = (uint32_t)m_slots.size();
+				m_slots.push_back({ 0, 1 });
+			}
+			m_slots[idx].dense = (uint32_t)m_values.size();
+			m_values.push_back(value);
+			m_valueSlots.push_back(idx);
+			m_valueNames.emplace_back(name);
+
+			VEHandle handle = ((VEHandle)m_slots[idx].generation << 32) | idx;
+			if (!name.empty())
+			{
+				auto it = m_names.find(name);
+				if (it != m_names.end())
+					it->second.push_back(handle);
+				else
+					m_names.emplace(std::string(name), std::vector<VEHandle>{ handle });
+			}
+			return handle;
+		};
+
+		/**
+			* \brief Remove a value
+			* \param[in] handle Handle of the value, nothing happens if the handle is not valid
+			*/
+		void erase(VEHandle handle)
+		{
+			veSlot_t *pSlot = getSlot(handle);
+			if (pSlot == nullptr)
+				return;
+
+			uint32_t dense = pSlot->dense;
+			auto it = m_names.find(m_valueNames[dense]);
+			if (it != m_names.end())
+			{ //an older value with the same name is found again
+				std::vector<VEHandle> &handles = it->second;
+				handles.erase(std::remove(handles.begin(), handles.end(), handle), handles.end());
+				if (handles.empty())
+					m_names.erase(it);
+			}
+
+			uint32_t last = (uint32_t)m_values.size() - 1;
+			if (dense != last)
+			{ //move the last value into the hole
+				m_values[dense] = std::move(m_values[last]);
+				m_valueSlots[dense] = m_valueSlots[last];
+				m_valueNames[dense] = std::move(m_valueNames[last]);
+				m_slots[m_valueSlots[dense]].dense = dense;
+			}
+			m_values.pop_back();
+			m_valueSlots.pop_back();
+			m_valueNames.pop_back();
+
+			uint32_t idx = (uint32_t)(handle & 0xFFFFFFFF);
+			pSlot->generation++;
+			if (pSlot->generation == 0)
+				pSlot->generation = 1; //0 would allow VE_NULL_HANDLE to be valid
+			pSlot->dense = m_freeSlot;
+			m_freeSlot = idx;
+		};
+
+		///\returns a pointer to the value of a handle, or nullptr if the handle is not valid
+		T *get(VEHandle handle)
+		{
+			veSlot_t *pSlot = getSlot(handle);
+			return pSlot != nullptr ? &m_values[pSlot->dense] : nullptr;
+		};
+
+		///\returns a pointer to the value with this name, or nullptr
+		T *get(std::string_view name)
+		{
+			return get(find(name));
+		};
+
+		///\returns a copy of the value of a handle, or T() if the handle is not valid, e.g. nullptr for pointers
+		T lookup(VEHandle handle)
+		{
+			T *pValue = get(handle);
+			return pValue != nullptr ? *pValue : T();
+		};
+
+		///\returns a copy of the value with this name, or T() if there is none, e.g. nullptr for pointers
+		T lookup(std::string_view name)
+		{
+			return lookup(find(name));
+		};
+
+		///\returns the handle of the value with this name, or VE_NULL_HANDLE
+		VEHandle find(std::string_view name)
+		{
+			auto it = m_names.find(name);
+			return it != m_names.end() ? it->second.back() : VE_NULL_HANDLE;
+		};
+
+		///\returns true if the handle refers to a value
+		bool contains(VEHandle handle)
+		{
+			return getSlot(handle) != nullptr;
+		};
+
+		///\returns true if a value with this name exists
+		bool contains(std::string_view name)
+		{
+			return m_names.find(name) != m_names.end();
+		};
+
+		///\returns the number of values
+		size_t size()
+		{
+			return m_values.size();
+		};
+
+		///Remove all values, old handles become invalid
+		void clear()
+		{
+			while (!m_values.empty())
+			{
+				uint32_t idx = m_valueSlots.back();
+				erase(((VEHandle)m_slots[idx].generation << 32) | idx);
+			}
+		};
+
+		///\returns an iterator to the first value, the order changes when values are erased
+		typename std::vector<T>::iterator begin()
+		{
+			return m_values.begin();
+		};
+
+		///\returns an iterator behind the last value
+		typename std::vector<T>::iterator end()
+		{
+			return m_values.end();
+		};
+	};
+
+} // namespace ve
+
+#endif
@@ -24,6 +24,7 @@ namespace ve
 	{
 	protected:
 		std::vector<VEEntity *> m_entities; ///<List of associated entities
+		std::atomic<uint64_t> m_version = 0; ///<Increased whenever command buffers drawing this subrenderer become outdated, also by job threads
 		std::vector<VESubrender *> &
 			getSubrenderers(); ///<return a list with the current subrenderers, used for shadows
 
@@ -60,6 +61,18 @@ namespace ve
 			return m_entities;
 		};
 
+		///\returns the version, command buffers recorded with an older version must be recorded again
+		uint64_t getVersion()
+		{
+			return m_version.load(std::memory_order_acquire);
+		};
+
+		///\brief Mark all command buffers drawing this subrenderer as outdated, e.g. if entities were added or removed. Thread safe.
+		void setChanged()
+		{
+			m_version.fetch_add(1, std::memory_order_release);
+		};
+
 		//------------------------------------------------------------------------------------------------------------------
 		///\brief Prepare to perform draw operation, e.g. for an overlay
 		virtual void prepareDraw() {};
@@ -67,8 +80,14 @@ namespace ve
 		///\brief Called after all draw calls have been recorded. Used for incremental recording
 		virtual void afterDrawFinished() {};
 
+		///\brief Group the entities for instanced or GPU driven drawing before recording - empty base class function
+		virtual void prepareDrawGroups(uint32_t imageIndex, VECamera *pCamera) {};
+
+		///\brief Record the compute pass that culls the entities for GPU driven drawing - empty base class function
+		virtual void recordCull(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera) {};
+
 		///\brief Draw all entities that are managed by this subrenderer
-		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow = {}) {};
+		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow = {}) {};
 
 		///Perform an arbitrary draw operation
 		virtual void draw(uint32_t imageIndex, VkSemaphore wait_semaphore, VkSemaphore signal_semaphore) {};
@@ -26,10 +26,7 @@ namespace ve
 	{
 	protected:
 		VERendererDeferred &m_renderer;
-		uint32_t m_resourceArrayLength = 16; ///<Length of resource array in shader
-		VkDescriptorSetLayout m_descriptorSetLayoutResources = VK_NULL_HANDLE; ///<Descriptor set layout for per object resources (like images)
-		std::vector<VkDescriptorSet> m_descriptorSetsResources; ///<a list of resource descriptor set arrays, maps are condensed into these arrays of size K
-		std::vector<std::vector<VkDescriptorImageInfo>> m_maps; ///<descriptor write info for the  maps, m_maps[0] may contain all diffuse maps, m_maps[1] all normal maps etc
+		bool m_useMaterials = false; ///<true if the shaders read the entity maps from the material table in set 2
 		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE; ///<Pipeline layout
 		std::vector<VkPipeline> m_pipelines; ///<Pipelines for light pass(es)
 		uint32_t m_idxLastRecorded = 0; ///<Used for incremental command buffer recording, idx of last recorded entity
@@ -73,7 +70,7 @@ namespace ve
 
 		//Draw all entities that are managed by this subrenderer
 		virtual void
-			draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow) override;
+			draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow) override;
 
 		virtual void drawEntity(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity) override;
 
@@ -26,12 +26,13 @@ namespace ve
 			{},
 			&m_pipelineLayout);
 
+		bool packedVertices = getEnginePointer()->usePackedVertices(); //decode vhVertexPacked in the vertex shader
 		m_pipelines.resize(1);
 		vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
-			{ "../../media/shader/Deferred/C1/vert.spv", "../../media/shader/Deferred/C1/frag.spv" },
+			{ packedVertices ? "../../media/shader/Deferred/C1/vert_packed.spv" : "../../media/shader/Deferred/C1/vert.spv", "../../media/shader/Deferred/C1/frag.spv" },
 			m_renderer.getSwapChainExtent(),
 			m_pipelineLayout, m_renderer.getRenderPassOffscreen(),
 			{},
-			&m_pipelines[0], VK_CULL_MODE_BACK_BIT, 3);
+			&m_pipelines[0], VK_CULL_MODE_BACK_BIT, 2, packedVertices);
 	}
 } // namespace ve
@@ -46,6 +46,39 @@ namespace ve
 			m_pipelineLayout, m_renderer.getRenderPassOnscreen(),
 			{ VK_DYNAMIC_STATE_BLEND_CONSTANTS },
 			&m_pipelines[0], VK_CULL_MODE_FRONT_BIT, 1);
+
+		//tiled lighting: set 0...lighting image
+		if (m_renderer.isTiled())
+		{
+			vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
+				{ m_renderer.getDescriptorSetLayoutResolve() },
+				{},
+				&m_pipelineLayoutResolve);
+
+			vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
+				{ "../../media/shader/Deferred/Composition/vert.spv",
+				 "../../media/shader/Deferred/Tiled/frag.spv" },
+				m_renderer.getSwapChainExtent(),
+				m_pipelineLayoutResolve, m_renderer.getRenderPassOnscreen(),
+				{ VK_DYNAMIC_STATE_BLEND_CONSTANTS },
+				&m_pipelineResolve, VK_CULL_MODE_FRONT_BIT, 1);
+		}
+	}
+
+	/**
+		* \brief Close down the subrenderer and destroy all local resources.
+		*/
+	void VESubrenderDF_Composer::closeSubrenderer()
+	{
+		VESubrenderDF::closeSubrenderer();
+
+		if (m_pipelineResolve != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(m_renderer.getDevice(), m_pipelineResolve, nullptr);
+			vkDestroyPipelineLayout(m_renderer.getDevice(), m_pipelineLayoutResolve, nullptr);
+			m_pipelineResolve = VK_NULL_HANDLE;
+			m_pipelineLayoutResolve = VK_NULL_HANDLE;
+		}
 	}
 
 	/**
@@ -75,8 +108,8 @@ namespace ve
 		uint32_t imageIndex,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet>
-		descriptorSetsShadow)
+		const std::vector<VkDescriptorSet>
+		&descriptorSetsShadow)
 	{
 		//Onscreen Pass:
 		//
@@ -85,19 +118,20 @@ namespace ve
 		//set 2...shadow maps
 		//set 3...position, normal, albedo map
 
-		std::vector<VkDescriptorSet> set = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
-											pLight->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		VkDescriptorSet set[3] = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
+								  pLight->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		uint32_t numSets = 2;
 
 		uint32_t offsets[2] = { (uint32_t)(pCamera->m_memoryHandle.entryIndex * sizeof(VECamera::veUBOPerCamera_t)),
 							   (uint32_t)(pLight->m_memoryHandle.entryIndex * sizeof(VELight::veUBOPerLight_t)) };
 
 		if (descriptorSetsShadow.size() > 0)
 		{
-			set.push_back(descriptorSetsShadow[imageIndex]);
+			set[numSets++] = descriptorSetsShadow[imageIndex];
 		}
 
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-			0, (uint32_t)set.size(), set.data(), 2, offsets);
+			0, numSets, set, 2, offsets);
 	}
 
 	/**
@@ -117,12 +151,10 @@ namespace ve
 		uint32_t imageIndex)
 	{
 		//set 3...per frame, includes position, normal and albedo buffers
-		std::vector<VkDescriptorSet> sets = {
-			m_renderer.getDescriptorSetsOffscreen()[imageIndex],
-		};
+		VkDescriptorSet set = m_renderer.getDescriptorSetsOffscreen()[imageIndex];
 
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-			3, (uint32_t)sets.size(), sets.data(), 0, nullptr);
+			3, 1, &set, 0, nullptr);
 	}
 
 	void VESubrenderDF_Composer::setDynamicPipelineState(VkCommandBuffer
@@ -139,6 +171,8 @@ namespace ve
 	* The subrenderer maintains a list of all associated entities. In this function it goes through all of them
 	* and draws them. A vector is used in order to be able to parallelize this in case thousands or objects are in the list
 	*
+	* In tiled mode, the first pass copies the lighting of the tiled compute shader instead, pLight is not used then.
+	*
 	* \param[in] commandBuffer The command buffer to record into all draw calls
 	* \param[in] imageIndex Index of the current swap chain image
 	*
@@ -148,8 +182,19 @@ namespace ve
 		uint32_t numPass,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet> descriptorSetsShadow)
+		const std::vector<VkDescriptorSet> &descriptorSetsShadow)
 	{
+		if (numPass == 0 && m_pipelineResolve != VK_NULL_HANDLE)
+		{
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineResolve);
+			setDynamicPipelineState(commandBuffer, numPass);
+			VkDescriptorSet set = m_renderer.getDescriptorSetResolve(imageIndex);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayoutResolve,
+				0, 1, &set, 0, nullptr);
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+			return;
+		}
+
 		bindPipeline(commandBuffer);
 		setDynamicPipelineState(commandBuffer, numPass);
 		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, descriptorSetsShadow);
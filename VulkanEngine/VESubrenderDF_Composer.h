@@ -15,6 +15,10 @@ namespace ve
 		*/
 	class VESubrenderDF_Composer : public VESubrenderDF
 	{
+	protected:
+		VkPipelineLayout m_pipelineLayoutResolve = VK_NULL_HANDLE; ///<Pipeline layout for copying the tiled lighting
+		VkPipeline m_pipelineResolve = VK_NULL_HANDLE; ///<Pipeline copying the tiled lighting in the first onscreen pass
+
 	public:
 		///Constructor
 		VESubrenderDF_Composer(VERendererDeferred &renderer)
@@ -37,13 +41,15 @@ namespace ve
 
 		virtual void initSubrenderer() override;
 
+		virtual void closeSubrenderer() override;
+
 		virtual void addEntity(VEEntity *pEntity) override;
 
 		void setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass) override;
 
-		virtual void bindDescriptorSetsPerFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow);
+		virtual void bindDescriptorSetsPerFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 
-		void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow);
+		void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 
 		void bindOffscreenDescriptorSet(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 	};
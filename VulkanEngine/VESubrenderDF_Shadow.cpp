@@ -33,6 +33,17 @@ namespace ve
 			m_renderer.getShadowMapExtent(),
 			m_pipelineLayout, m_renderer.getRenderPassShadow(),
 			&m_pipelines[0]);
+
+		//with packed vertices, pipeline 1 draws them, pipeline 0 is still needed for meshes that are not packed, like cloth
+		if (getEnginePointer()->usePackedVertices())
+		{
+			m_pipelines.resize(2);
+			vh::vhPipeCreateGraphicsShadowPipeline(m_renderer.getDevice(),
+				"../../media/shader/Deferred/Shadow/vert_packed.spv",
+				m_renderer.getShadowMapExtent(),
+				m_pipelineLayout, m_renderer.getRenderPassShadow(),
+				&m_pipelines[1], true);
+		}
 	}
 
 	/**
@@ -62,27 +73,28 @@ namespace ve
 		uint32_t imageIndex,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet>
-		descriptorSetsShadow)
+		const std::vector<VkDescriptorSet>
+		&descriptorSetsShadow)
 	{
 		//set 0...cam UBO
 		//set 1...light resources
 		//set 2...shadow maps
 		//set 3...per object UBO
 
-		std::vector<VkDescriptorSet> set = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
-											pLight->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		VkDescriptorSet set[3] = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
+								  pLight->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		uint32_t numSets = 2;
 
 		uint32_t offsets[2] = { (uint32_t)(pCamera->m_memoryHandle.entryIndex * sizeof(VECamera::veUBOPerCamera_t)),
 							   (uint32_t)(pLight->m_memoryHandle.entryIndex * sizeof(VELight::veUBOPerLight_t)) };
 
 		if (descriptorSetsShadow.size() > 0)
 		{
-			set.push_back(descriptorSetsShadow[imageIndex]);
+			set[numSets++] = descriptorSetsShadow[imageIndex];
 		}
 
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-			0, (uint32_t)set.size(), set.data(), 2, offsets);
+			0, numSets, set, 2, offsets);
 	}
 
 	/**
@@ -105,11 +117,11 @@ namespace ve
 		//set 0...per frame, includes cam and shadow matrices
 		//set 1...per object UBO
 
-		std::vector<VkDescriptorSet> sets = { entity->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		VkDescriptorSet set = entity->m_memoryHandle.pMemBlock->descriptorSets[imageIndex];
 
 		uint32_t offset = entity->m_memoryHandle.entryIndex * sizeof(VEEntity::veUBOPerEntity_t);
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-			3, (uint32_t)sets.size(), sets.data(), 1, &offset);
+			3, 1, &set, 1, &offset);
 	}
 
 	/**
@@ -129,19 +141,29 @@ namespace ve
 		numPass,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet> descriptorSetsShadow)
+		const std::vector<VkDescriptorSet> &descriptorSetsShadow)
 	{
 		bindPipeline(commandBuffer);
+		VkPipeline boundPipeline = m_pipelines[0];
 
 		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, descriptorSetsShadow);
 
+		veFrameVector<glm::vec4> planes;
+		pCamera->getFrustumPlanes(planes); //cull against the shadow camera frustum
+
 		//go through all entities and draw them
 		for (auto subrender : getSubrenderers())
 		{
 			for (auto pEntity : subrender->getEntities())
 			{
-				if (pEntity->m_castsShadow)
+				if (pEntity->m_castsShadow && pEntity->isInFrustum(planes))
 				{
+					VkPipeline pipeline = m_pipelines[pEntity->m_pMesh->m_packed ? 1 : 0];
+					if (pipeline != boundPipeline)
+					{ //the vertex format of the mesh changed
+						vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+						boundPipeline = pipeline;
+					}
 					bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity); //bind the entity's descriptor sets
 					drawEntity(commandBuffer, imageIndex, pEntity);
 				}
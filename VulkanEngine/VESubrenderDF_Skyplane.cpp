@@ -20,29 +20,23 @@ namespace ve
 	{
 		VESubrender::initSubrenderer();
 
-		vh::vhRenderCreateDescriptorSetLayout(m_renderer.getDevice(),
-			{ m_resourceArrayLength },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-			{ VK_SHADER_STAGE_FRAGMENT_BIT },
-			&m_descriptorSetLayoutResources);
-
 		VkDescriptorSetLayout perObjectLayout = m_renderer.getDescriptorSetLayoutPerObject();
 		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
-			{ perObjectLayout, perObjectLayout, m_descriptorSetLayoutResources },
+			{ perObjectLayout, perObjectLayout, m_renderer.getMaterialTable()->getDescriptorSetLayout() },
 			{},
 			&m_pipelineLayout);
 
+		bool packedVertices = getEnginePointer()->usePackedVertices(); //decode vhVertexPacked in the vertex shader
 		m_pipelines.resize(1);
 		vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
-			{ "../../media/shader/Deferred/Skyplane/vert.spv",
+			{ packedVertices ? "../../media/shader/Deferred/Skyplane/vert_packed.spv" : "../../media/shader/Deferred/Skyplane/vert.spv",
 			 "../../media/shader/Deferred/Skyplane/frag.spv" },
 			m_renderer.getSwapChainExtent(),
 			m_pipelineLayout, m_renderer.getRenderPassOffscreen(),
 			{},
-			&m_pipelines[0], VK_CULL_MODE_BACK_BIT, 3);
+			&m_pipelines[0], VK_CULL_MODE_BACK_BIT, 2, packedVertices);
 
-		if (m_maps.empty())
-			m_maps.resize(1);
+		m_useMaterials = true;
 	}
 
 	/**
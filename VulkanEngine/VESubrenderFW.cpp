@@ -21,23 +21,6 @@ namespace ve
 	{
 		closeSubrenderer();
 		initSubrenderer();
-
-		uint32_t size = (uint32_t)m_descriptorSetsResources.size();
-		if (size > 0)
-		{
-			m_descriptorSetsResources.clear();
-			vh::vhRenderCreateDescriptorSets(m_renderer.getDevice(),
-				size, m_descriptorSetLayoutResources,
-				m_renderer.getDescriptorPool(),
-				m_descriptorSetsResources);
-
-			for (uint32_t i = 0; i < size; i++)
-			{
-				vh::vhRenderUpdateDescriptorSetMaps(m_renderer.getDevice(),
-					m_descriptorSetsResources[i],
-					0, i * m_resourceArrayLength, m_resourceArrayLength, m_maps);
-			}
-		}
 	}
 
 	/**
@@ -50,11 +33,26 @@ namespace ve
 			vkDestroyPipeline(m_renderer.getDevice(), pipeline, nullptr);
 		}
 
+		if (m_pipelineClustered != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(m_renderer.getDevice(), m_pipelineClustered, nullptr);
+			m_pipelineClustered = VK_NULL_HANDLE;
+		}
+
 		if (m_pipelineLayout != VK_NULL_HANDLE)
 			vkDestroyPipelineLayout(m_renderer.getDevice(), m_pipelineLayout, nullptr);
 
-		if (m_descriptorSetLayoutResources != VK_NULL_HANDLE)
-			vkDestroyDescriptorSetLayout(m_renderer.getDevice(), m_descriptorSetLayoutResources, nullptr);
+		for (auto &buffers : m_indirectBuffers)
+		{ //descriptor sets are kept and reused, the buffers are recreated with the next recording
+			destroyIndirectBuffers(buffers);
+		}
+
+		for (auto &buffer : m_instanceBuffers)
+		{
+			destroyInstanceBuffer(buffer);
+		}
+
+		destroyRetiredBuffers(true);
 	}
 
 	/**
@@ -84,28 +82,44 @@ namespace ve
 		uint32_t imageIndex,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet>
-		descriptorSetsShadow)
+		const std::vector<VkDescriptorSet>
+		&descriptorSetsShadow)
 	{
 		//set 0...cam UBO
 		//set 1...light resources
 		//set 2...shadow maps
 		//set 3...per object UBO
-		//set 4...additional per object resources
+		//set 4...material table
+		//set m_setCluster...cluster buffers, if the renderer is clustered
 
-		std::vector<VkDescriptorSet> set = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
-											pLight->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		VkDescriptorSet set[3] = { pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
+								  pLight->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		uint32_t numSets = 2;
 
 		uint32_t offsets[2] = { (uint32_t)(pCamera->m_memoryHandle.entryIndex * sizeof(VECamera::veUBOPerCamera_t)),
 							   (uint32_t)(pLight->m_memoryHandle.entryIndex * sizeof(VELight::veUBOPerLight_t)) };
 
 		if (descriptorSetsShadow.size() > 0)
 		{
-			set.push_back(descriptorSetsShadow[imageIndex]);
+			set[numSets++] = descriptorSetsShadow[imageIndex];
 		}
 
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-			0, (uint32_t)set.size(), set.data(), 2, offsets);
+			0, numSets, set, 2, offsets);
+
+		if (m_useMaterials)
+		{ //the table never changes, entities select their maps with the material index in their UBO
+			VkDescriptorSet materials = m_renderer.getMaterialTable()->getDescriptorSet();
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
+				4, 1, &materials, 0, nullptr);
+		}
+
+		if (m_setCluster > 0)
+		{ //only the first light pass reads the clusters, binding the set in later passes does no harm
+			VkDescriptorSet cluster = m_renderer.getDescriptorSetCluster(imageIndex);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
+				m_setCluster, 1, &cluster, 0, nullptr);
+		}
 	}
 
 	/**
@@ -128,17 +142,12 @@ namespace ve
 		//set 1...light resources
 		//set 2...shadow maps
 		//set 3...per object UBO
-		//set 4...additional per object resources
-
-		std::vector<VkDescriptorSet> sets = { entity->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
-		if (m_descriptorSetsResources.size() > 0 && entity->getResourceIdx() % m_resourceArrayLength == 0)
-		{
-			sets.push_back(m_descriptorSetsResources[entity->getResourceIdx() / m_resourceArrayLength]);
-		}
+		//set 4...material table
 
+		VkDescriptorSet set = entity->m_memoryHandle.pMemBlock->descriptorSets[imageIndex];
 		uint32_t offset = entity->m_memoryHandle.entryIndex * sizeof(VEEntity::veUBOPerEntity_t);
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-			3, (uint32_t)sets.size(), sets.data(), 1, &offset);
+			3, 1, &set, 1, &offset);
 	}
 
 	/**
@@ -160,7 +169,7 @@ namespace ve
 		uint32_t numPass,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet> descriptorSetsShadow)
+		const std::vector<VkDescriptorSet> &descriptorSetsShadow)
 	{
 		if (m_entities.size() == 0)
 			return;
@@ -169,15 +178,37 @@ namespace ve
 		if (numPass > 0 && getClass() != VE_SUBRENDERER_CLASS_OBJECT)
 			return;
 
-		bindPipeline(commandBuffer);
+		if (numPass == 0 && m_pipelineClustered != VK_NULL_HANDLE)
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineClustered); //also shades the lights of the clusters
+		else
+			bindPipeline(commandBuffer);
 
 		setDynamicPipelineState(commandBuffer, numPass);
 
 		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, descriptorSetsShadow);
 
-		//go through all entities and draw them
+		if (m_drawBatched)
+		{ //groups were prepared before recording
+			if (m_renderer.isIndirect())
+				drawIndirect(commandBuffer, imageIndex); //the cull shader writes the draw commands, so the command buffer does not depend on visibility
+			else
+				drawInstanced(commandBuffer, imageIndex);
+			return;
+		}
+
+		//cull against the camera frustum, background is always drawn
+		//a GPU driven renderer does not rerecord if visibility changes, so nothing is culled here
+		bool cull = getClass() != VE_SUBRENDERER_CLASS_BACKGROUND && !m_renderer.isIndirect();
+		veFrameVector<glm::vec4> planes;
+		if (cull)
+			pCamera->getFrustumPlanes(planes);
+
+		//go through all visible entities and draw them
 		for (auto pEntity : m_entities)
 		{
+			if (cull && !pEntity->isInFrustum(planes))
+				continue;
+
 			bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity); //bind the entity's descriptor sets
 			drawEntity(commandBuffer, imageIndex, pEntity);
 		}
@@ -213,77 +244,483 @@ namespace ve
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets); //bind vertex buffer
 
-		vkCmdBindIndexBuffer(commandBuffer, entity->m_pMesh->m_indexBuffer, 0, VK_INDEX_TYPE_UINT32); //bind index buffer
+		vkCmdBindIndexBuffer(commandBuffer, entity->m_pMesh->m_indexBuffer, 0, entity->m_pMesh->m_indexType); //bind index buffer
 
 		vkCmdDrawIndexed(commandBuffer, entity->m_pMesh->m_indexCount, 1, 0, 0, 0); //record the draw call
 	}
 
 	/**
 	*
-	* \brief Add some maps of an entity to the map list of this subrenderer
+	* \brief Group the entities before the command buffers are recorded
 	*
-	* m_maps is a list of map lists. Each entity may need 1-N maps, like diffuse, normal, etc.
-	* m_maps thus has N entries, one for such a map type. m_map[0] might hold all diffuse maps.
-	* m_map[1] might hold all normal maps. m_map[2] might hold all specular maps. etc.
-	* If a new entity is added, then its maps are just appended to the N lists.
-	* However, we have descriptor sets, each set having N slot bindings (one binding for each map type),
-	* each binding describing an array of e.g. K textures.
-	* So we break each list into chunks of size K, and bind each chunk to one descriptor.
-	* Variable offset denotes the start of such a chunk.
+	* Only subrenderers whose shaders read the entity UBOs from a storage buffer draw their entities in groups.
+	* A GPU driven renderer culls all entities in a compute pass, otherwise the visible entities are culled
+	* here and drawn instanced. Since light passes are recorded in parallel, this must be done before.
 	*
-	* \param[in] pEntity Pointer to the entity
-	* \param[in] newMaps List of 1..N maps to be added to this subrenderer, e.g. {diffuse texture}, or {diffuse tex, normal}
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pCamera Pointer to the camera whose frustum is used for culling
 	*
 	*/
-	void VESubrenderFW::addMaps(VEEntity *pEntity, std::vector<VkDescriptorImageInfo> &newMaps)
+	void VESubrenderFW::prepareDrawGroups(uint32_t imageIndex, VECamera *pCamera)
 	{
-		pEntity->setResourceIdx((uint32_t)
-			m_entities.size()); //index into the array of textures for this entity, shader will take remainder and not absolute value
-		
-		uint32_t offset = 0; //offset into the list of maps - index where a particular array starts
-		if (pEntity->getResourceIdx() % m_resourceArrayLength == 0)
-		{ //array is full or there is none yet? -> we need a new array
-			vh::vhRenderCreateDescriptorSets(m_renderer.getDevice(),
-				1,
-				m_descriptorSetLayoutResources, //layout contains arrays of this size
-				m_renderer.getDescriptorPool(),
-				m_descriptorSetsResources);
-			offset = (uint32_t)m_maps[0].size(); //number of maps of first bind slot, e.g. number of diffuse maps
-
-			for (uint32_t i = 0; i < m_maps.size(); i++)
-			{ //go through all map bind slots , e.g. first diffuse, then normal, then specular, then ...
-				m_maps[i].resize(offset + m_resourceArrayLength); //make room for the new array elements
-				for (uint32_t j = offset; j < offset + m_resourceArrayLength; j++) //have to fill the whole new array, even if there is only one map yet
-					m_maps[i][j] = newMaps[i]; //fill the new array up with copies of the first elemenet
+		destroyRetiredBuffers(false);
+
+		m_drawGroups.clear();
+		if (!m_drawBatched || m_entities.size() == 0)
+			return;
+
+		if (m_renderer.isIndirect())
+			prepareIndirectDraw(imageIndex);
+		else
+			prepareInstancedDraw(imageIndex, pCamera);
+	}
+
+	/**
+	*
+	* \brief Sort entities into draw groups
+	*
+	* Entities are sorted such that entities sharing UBO memory block and mesh are neighbors.
+	* Each such run becomes one group in m_drawGroups.
+	*
+	* \param[in] entities The entities to group, will be sorted
+	*
+	*/
+	void VESubrenderFW::sortIntoGroups(veFrameVector<VEEntity *> &entities)
+	{
+		std::sort(entities.begin(), entities.end(), [](VEEntity *a, VEEntity *b) {
+			if (a->m_memoryHandle.pMemBlock != b->m_memoryHandle.pMemBlock)
+				return std::less<vh::vhMemoryBlock *>()(a->m_memoryHandle.pMemBlock, b->m_memoryHandle.pMemBlock);
+			return std::less<VEMesh *>()(a->m_pMesh, b->m_pMesh);
+		});
+
+		m_drawGroups.clear();
+		for (uint32_t i = 0; i < entities.size(); i++)
+		{
+			VEEntity *pEntity = entities[i];
+
+			if (m_drawGroups.empty() ||
+				m_drawGroups.back().pMemBlock != pEntity->m_memoryHandle.pMemBlock ||
+				m_drawGroups.back().pMesh != pEntity->m_pMesh)
+			{ //start a new group, entities with different materials can share it
+				m_drawGroups.push_back({ pEntity->m_pMesh, pEntity->m_memoryHandle.pMemBlock, i, 0 });
 			}
+			m_drawGroups.back().count++;
 		}
-		else
-		{ //we are inside an array, size is ALWAYS a multiple of m_resourceArrayLength!
-			offset = (uint32_t)m_maps[0].size() / m_resourceArrayLength - 1; //get index of array
-			offset *= m_resourceArrayLength; //get start index where the array starts
-			for (uint32_t i = 0; i < m_maps.size(); i++)
-			{ //go through all map types
-				m_maps[i][m_entities.size()] = newMaps[i]; //copy the map into the array
+	}
+
+	/**
+	*
+	* \brief Create the draw groups and cull records for GPU driven drawing
+	*
+	* Each group is drawn by one indirect draw call. For each entity a record is written
+	* that the cull shader turns into a draw command if the entity is inside the camera frustum.
+	* Since the records only depend on the list of entities, this is only done when recording command buffers.
+	*
+	* \param[in] imageIndex Index of the current swap chain image
+	*
+	*/
+	void VESubrenderFW::prepareIndirectDraw(uint32_t imageIndex)
+	{
+		veFrameVector<VEEntity *> entities(m_entities.begin(), m_entities.end());
+		sortIntoGroups(entities);
+
+		veFrameVector<veIndirectRecord_t> records(entities.size());
+		for (uint32_t g = 0; g < m_drawGroups.size(); g++)
+		{
+			veDrawGroup_t &group = m_drawGroups[g];
+			for (uint32_t i = group.first; i < group.first + group.count; i++)
+			{
+				VEEntity *pEntity = entities[i];
+				veIndirectRecord_t &record = records[i];
+				record.command.indexCount = pEntity->m_pMesh->m_indexCount;
+				record.command.instanceCount = 1;
+				record.command.firstIndex = 0;
+				record.command.vertexOffset = 0;
+				record.command.firstInstance = pEntity->m_memoryHandle.entryIndex; //shaders find the UBO with gl_InstanceIndex
+				record.group = g;
+				record.firstCommand = group.first;
+				record.slot = i;
+				record.sphere = glm::vec4(pEntity->m_pMesh->m_boundingSphereCenter, pEntity->m_pMesh->m_boundingSphereRadius);
 			}
 		}
 
-		// workaround for synchronization problem: there must not be a command buffer in pending state while updating descriptor sets
-		// this happens if entities are added or removed
-		vkQueueWaitIdle(m_renderer.getGraphicsQueue());
+		if (m_indirectBuffers.size() != m_renderer.getSwapChainNumber())
+			m_indirectBuffers.resize(m_renderer.getSwapChainNumber());
+
+		if (m_indirectBuffers[imageIndex].capacity < records.size())
+			createIndirectBuffers(imageIndex, std::max((uint32_t)records.size(), 2 * m_indirectBuffers[imageIndex].capacity));
+
+		veIndirectBuffers_t &buffers = m_indirectBuffers[imageIndex];
+		VkDeviceSize size = records.size() * sizeof(veIndirectRecord_t);
+		void *data;
+		VECHECKRESULT(vmaMapMemory(m_renderer.getVmaAllocator(), buffers.recordsAllocation, &data));
+		memcpy(data, records.data(), (size_t)size);
+		vmaFlushAllocation(m_renderer.getVmaAllocator(), buffers.recordsAllocation, 0, size);
+		vmaUnmapMemory(m_renderer.getVmaAllocator(), buffers.recordsAllocation);
+	}
+
+	/**
+	*
+	* \brief Create the draw groups and instance indices for instanced drawing
+	*
+	* The entities are culled against the camera frustum, and the visible ones are sorted into groups.
+	* The instances of a group are consecutive in the instance buffer, each instance holding the UBO entry index
+	* of its entity. The shaders look up the entity UBO through gl_InstanceIndex.
+	*
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pCamera Pointer to the camera whose frustum is used for culling
+	*
+	*/
+	void VESubrenderFW::prepareInstancedDraw(uint32_t imageIndex, VECamera *pCamera)
+	{
+		veFrameVector<glm::vec4> planes;
+		pCamera->getFrustumPlanes(planes);
+
+		veFrameVector<VEEntity *> entities;
+		entities.reserve(m_entities.size());
+		for (auto pEntity : m_entities)
+		{
+			if (pEntity->isInFrustum(planes))
+				entities.push_back(pEntity);
+		}
+		if (entities.size() == 0)
+			return;
+
+		sortIntoGroups(entities);
+
+		veFrameVector<uint32_t> instances(entities.size());
+		for (uint32_t i = 0; i < entities.size(); i++)
+		{
+			instances[i] = entities[i]->m_memoryHandle.entryIndex;
+		}
+
+		if (m_instanceBuffers.size() != m_renderer.getSwapChainNumber())
+			m_instanceBuffers.resize(m_renderer.getSwapChainNumber());
+
+		if (m_instanceBuffers[imageIndex].capacity < instances.size())
+			createInstanceBuffer(imageIndex, std::max((uint32_t)instances.size(), 2 * m_instanceBuffers[imageIndex].capacity));
+
+		veInstanceBuffer_t &buffer = m_instanceBuffers[imageIndex];
+		VkDeviceSize size = instances.size() * sizeof(uint32_t);
+		void *data;
+		VECHECKRESULT(vmaMapMemory(m_renderer.getVmaAllocator(), buffer.allocation, &data));
+		memcpy(data, instances.data(), (size_t)size);
+		vmaFlushAllocation(m_renderer.getVmaAllocator(), buffer.allocation, 0, size);
+		vmaUnmapMemory(m_renderer.getVmaAllocator(), buffer.allocation);
+	}
+
+	/**
+	*
+	* \brief Create the cull buffers of one swapchain image
+	*
+	* \param[in] imageIndex Index of the swap chain image
+	* \param[in] capacity Max number of entities that can be culled
+	*
+	*/
+	void VESubrenderFW::createIndirectBuffers(uint32_t imageIndex, uint32_t capacity)
+	{
+		veIndirectBuffers_t &buffers = m_indirectBuffers[imageIndex];
+		if (buffers.capacity > 0)
+		{ //the old buffers might still be used by a pending command buffer
+			retireBuffer(buffers.records, buffers.recordsAllocation);
+			retireBuffer(buffers.commands, buffers.commandsAllocation);
+			retireBuffer(buffers.counts, buffers.countsAllocation);
+			buffers.capacity = 0;
+		}
+
+		VkDeviceSize sizeRecords = capacity * sizeof(veIndirectRecord_t);
+		VkDeviceSize sizeCommands = capacity * sizeof(VkDrawIndexedIndirectCommand);
+		VkDeviceSize sizeCounts = capacity * sizeof(uint32_t);
+
+		VECHECKRESULT(vh::vhBufCreateBuffer(m_renderer.getVmaAllocator(), sizeRecords,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			&buffers.records, &buffers.recordsAllocation));
+		VECHECKRESULT(vh::vhBufCreateBuffer(m_renderer.getVmaAllocator(), sizeCommands,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+			&buffers.commands, &buffers.commandsAllocation));
+		VECHECKRESULT(vh::vhBufCreateBuffer(m_renderer.getVmaAllocator(), sizeCounts,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_GPU_ONLY, &buffers.counts, &buffers.countsAllocation));
+
+		if (buffers.descriptorSet == VK_NULL_HANDLE)
+		{
+			std::vector<VkDescriptorSet> sets;
+			VECHECKRESULT(vh::vhRenderCreateDescriptorSets(m_renderer.getDevice(), 1, m_renderer.getDescriptorSetLayoutCull(),
+				m_renderer.getDescriptorPool(), sets));
+			buffers.descriptorSet = sets[0];
+		}
+
+		VECHECKRESULT(vh::vhRenderUpdateDescriptorSet(m_renderer.getDevice(), buffers.descriptorSet,
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+			{ buffers.records, buffers.commands, buffers.counts },
+			{ sizeRecords, sizeCommands, sizeCounts },
+			{ {VK_NULL_HANDLE}, {VK_NULL_HANDLE}, {VK_NULL_HANDLE} },
+			{ {VK_NULL_HANDLE}, {VK_NULL_HANDLE}, {VK_NULL_HANDLE} }));
+
+		buffers.capacity = capacity;
+	}
+
+	/**
+	*
+	* \brief Destroy the cull buffers of one swapchain image, but keep the descriptor set
+	*
+	* \param[in] buffers The cull buffers
+	*
+	*/
+	void VESubrenderFW::destroyIndirectBuffers(veIndirectBuffers_t &buffers)
+	{
+		if (buffers.capacity == 0)
+			return;
+
+		vmaDestroyBuffer(m_renderer.getVmaAllocator(), buffers.records, buffers.recordsAllocation);
+		vmaDestroyBuffer(m_renderer.getVmaAllocator(), buffers.commands, buffers.commandsAllocation);
+		vmaDestroyBuffer(m_renderer.getVmaAllocator(), buffers.counts, buffers.countsAllocation);
+		buffers.capacity = 0;
+	}
+
+	/**
+	*
+	* \brief Create the instance buffer of one swapchain image
+	*
+	* \param[in] imageIndex Index of the swap chain image
+	* \param[in] capacity Max number of instances
+	*
+	*/
+	void VESubrenderFW::createInstanceBuffer(uint32_t imageIndex, uint32_t capacity)
+	{
+		veInstanceBuffer_t &buffer = m_instanceBuffers[imageIndex];
+		if (buffer.capacity > 0)
+		{ //the old buffer might still be used by a pending command buffer
+			retireBuffer(buffer.buffer, buffer.allocation);
+			buffer.capacity = 0;
+		}
+
+		VkDeviceSize size = capacity * sizeof(uint32_t);
+		VECHECKRESULT(vh::vhBufCreateBuffer(m_renderer.getVmaAllocator(), size,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			&buffer.buffer, &buffer.allocation));
+
+		if (buffer.descriptorSet == VK_NULL_HANDLE)
+		{
+			std::vector<VkDescriptorSet> sets;
+			VECHECKRESULT(vh::vhRenderCreateDescriptorSets(m_renderer.getDevice(), 1, m_renderer.getDescriptorSetLayoutInstances(),
+				m_renderer.getDescriptorPool(), sets));
+			buffer.descriptorSet = sets[0];
+		}
+
+		VECHECKRESULT(vh::vhRenderUpdateDescriptorSet(m_renderer.getDevice(), buffer.descriptorSet,
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, { buffer.buffer }, { size },
+			{ {VK_NULL_HANDLE} }, { {VK_NULL_HANDLE} }));
+
+		buffer.capacity = capacity;
+	}
+
+	/**
+	*
+	* \brief Destroy the instance buffer of one swapchain image, but keep the descriptor set
+	*
+	* \param[in] buffer The instance buffer
+	*
+	*/
+	void VESubrenderFW::destroyInstanceBuffer(veInstanceBuffer_t &buffer)
+	{
+		if (buffer.capacity == 0)
+			return;
+
+		vmaDestroyBuffer(m_renderer.getVmaAllocator(), buffer.buffer, buffer.allocation);
+		buffer.capacity = 0;
+	}
+
+	/**
+	*
+	* \brief Retire a buffer that was replaced by a larger one
+	*
+	* Command buffers in flight might still read the buffer, so it is destroyed only after as many frames
+	* as the material table waits for released slots. This does not wait for the GPU.
+	*
+	* \param[in] buffer The buffer
+	* \param[in] allocation VMA information for the buffer
+	*
+	*/
+	void VESubrenderFW::retireBuffer(VkBuffer buffer, VmaAllocation allocation)
+	{
+		m_retiredBuffers.push_back({ buffer, allocation, getEnginePointer()->getLoopCount() });
+	}
+
+	/**
+	*
+	* \brief Destroy the retired buffers that no command buffer in flight uses anymore
+	*
+	* \param[in] all If true, all retired buffers are destroyed, the GPU must be idle
+	*
+	*/
+	void VESubrenderFW::destroyRetiredBuffers(bool all)
+	{
+		uint64_t frame = getEnginePointer()->getLoopCount();
+		uint64_t framesInFlight = m_renderer.getSwapChainNumber() + 1;
+		while (!m_retiredBuffers.empty() && (all || m_retiredBuffers.front().frame + framesInFlight <= frame))
+		{
+			vmaDestroyBuffer(m_renderer.getVmaAllocator(), m_retiredBuffers.front().buffer, m_retiredBuffers.front().allocation);
+			m_retiredBuffers.pop_front();
+		}
+	}
+
+	/**
+	*
+	* \brief Record the compute pass that culls all entities against the camera frustum
+	*
+	* One dispatch is recorded for each UBO memory block, since the shader reads the world matrices from there.
+	* The draw counts are reset first, then the shader appends the draw commands of all visible entities.
+	* The caller must put a barrier between this pass and the indirect draw calls.
+	*
+	* \param[in] commandBuffer The command buffer to record into, must be outside of a render pass
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pCamera Pointer to the camera whose frustum is used
+	*
+	*/
+	void VESubrenderFW::recordCull(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera)
+	{
+		if (m_drawGroups.size() == 0)
+			return;
+
+		veIndirectBuffers_t &buffers = m_indirectBuffers[imageIndex];
+		vkCmdFillBuffer(commandBuffer, buffers.counts, 0, VK_WHOLE_SIZE, 0); //no draw command survived yet
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_renderer.getPipelineCull());
+
+		//set 0...cam UBO
+		//set 1...entity UBOs of one memory block
+		//set 2...cull records, draw commands, draw counts
+
+		VkDescriptorSet cameraSet = pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex];
+		uint32_t offset = (uint32_t)(pCamera->m_memoryHandle.entryIndex * sizeof(VECamera::veUBOPerCamera_t));
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_renderer.getPipelineLayoutCull(),
+			0, 1, &cameraSet, 1, &offset);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_renderer.getPipelineLayoutCull(),
+			2, 1, &buffers.descriptorSet, 0, nullptr);
+
+		uint32_t firstRecord = 0;
+		for (uint32_t i = 0; i < m_drawGroups.size(); i++)
+		{
+			vh::vhMemoryBlock *pMemBlock = m_drawGroups[i].pMemBlock;
+			if (i + 1 < m_drawGroups.size() && m_drawGroups[i + 1].pMemBlock == pMemBlock)
+				continue; //groups are sorted by memory block, dispatch once the block changes
+
+			uint32_t lastRecord = m_drawGroups[i].first + m_drawGroups[i].count;
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_renderer.getPipelineLayoutCull(),
+				1, 1, &pMemBlock->descriptorSetsStorage[imageIndex], 0, nullptr);
+
+			uint32_t pushConstants[3] = { firstRecord, lastRecord - firstRecord, 1u }; //compact, draw counts are always supported
+			vkCmdPushConstants(commandBuffer, m_renderer.getPipelineLayoutCull(), VK_SHADER_STAGE_COMPUTE_BIT,
+				0, sizeof(pushConstants), pushConstants);
 
-		vh::vhRenderUpdateDescriptorSetMaps(m_renderer.getDevice(), //update the descriptor that holds the map array
-			m_descriptorSetsResources[m_descriptorSetsResources.size() - 1],
-			0,
-			offset, //start offset of the current map arrays that should be updated
-			m_resourceArrayLength,
-			m_maps);
+			vkCmdDispatch(commandBuffer, (lastRecord - firstRecord + 63) / 64, 1, 1); //shader has 64 threads per group
+			firstRecord = lastRecord;
+		}
+	}
+
+	/**
+	*
+	* \brief Draw all entities with one indirect draw call per group
+	*
+	* The draw count is read from a buffer, so only the surviving draw commands are executed.
+	* Indirect drawing is only used if the device supports VK_KHR_draw_indirect_count.
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	*
+	*/
+	void VESubrenderFW::drawIndirect(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		if (m_drawGroups.size() == 0)
+			return;
+
+		veIndirectBuffers_t &buffers = m_indirectBuffers[imageIndex];
+		uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+		for (uint32_t i = 0; i < m_drawGroups.size(); i++)
+		{
+			veDrawGroup_t &group = m_drawGroups[i];
+			bindDrawGroup(commandBuffer, imageIndex, group);
+
+			VkDeviceSize offset = (VkDeviceSize)group.first * stride;
+			vkCmdDrawIndexedIndirectCountKHR(commandBuffer, buffers.commands, offset,
+				buffers.counts, i * sizeof(uint32_t), group.count, stride);
+		}
+	}
+
+	/**
+	*
+	* \brief Draw all visible entities with one instanced draw call per group
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	*
+	*/
+	void VESubrenderFW::drawInstanced(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		if (m_drawGroups.size() == 0)
+			return;
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
+			m_setInstances, 1, &m_instanceBuffers[imageIndex].descriptorSet, 0, nullptr);
+
+		for (auto &group : m_drawGroups)
+		{
+			bindDrawGroup(commandBuffer, imageIndex, group);
+			vkCmdDrawIndexed(commandBuffer, group.pMesh->m_indexCount, group.count, 0, 0, group.first); //instances start at the group's first index
+		}
+	}
+
+	/**
+	*
+	* \brief Bind the descriptor sets and the vertex and index buffers of a draw group
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] group The draw group
+	*
+	*/
+	void VESubrenderFW::bindDrawGroup(VkCommandBuffer commandBuffer, uint32_t imageIndex, veDrawGroup_t &group)
+	{
+		//set 3...all entity UBOs of the memory block
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
+			3, 1, &group.pMemBlock->descriptorSetsStorage[imageIndex], 0, nullptr);
+
+		VkBuffer vertexBuffers[] = { group.pMesh->m_vertexBuffer };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets); //bind vertex buffer
+		vkCmdBindIndexBuffer(commandBuffer, group.pMesh->m_indexBuffer, 0, group.pMesh->m_indexType); //bind index buffer
+	}
+
+	/**
+	*
+	* \brief Put the maps of an entity into the material table
+	*
+	* The entity stores the index of its material slot in its UBO. Entities with the same maps share a slot.
+	* Only descriptors of a free slot are written, so this does not wait for pending command buffers.
+	*
+	* \param[in] pEntity Pointer to the entity
+	* \param[in] newMaps List of 1..N maps of the entity, e.g. {diffuse texture}, or {diffuse tex, normal}
+	*
+	*/
+	void VESubrenderFW::addMaps(VEEntity *pEntity, std::vector<VkDescriptorImageInfo> &newMaps)
+	{
+		pEntity->setResourceIdx(m_renderer.getMaterialTable()->acquire(newMaps));
 	}
 
 	/**
 	*
 	* \brief Removes an entity from this subrenderer - does NOT delete it
 	*
-	* Since we use indices and each entity knows its onw index, this is an O(1) operation.
+	* The material slot of the entity is released, the slots of the other entities do not change.
 	*
 	* \param[in] pEntity Pointer to the entity to be removed
 	*
@@ -291,51 +728,15 @@ namespace ve
 	void VESubrenderFW::removeEntity(VEEntity *pEntity)
 	{
 		uint32_t size = (uint32_t)m_entities.size();
-		if (size == 0)
-			return;
-
 		for (uint32_t i = 0; i < size; i++)
 		{
 			if (m_entities[i] == pEntity)
 			{
-				//move the last entity and its maps to the place of the removed entity
 				m_entities[i] = m_entities[size - 1]; //replace with former last entity (could be identical)
+				m_entities.pop_back(); //remove the last
 
-				if (m_maps.size() > 0)
-				{ //are there maps?
-					m_entities[i]->setResourceIdx(i); //new resource index
-					for (uint32_t j = 0; j < m_maps.size(); j++)
-					{ //move also the map entries
-						m_maps[j][i] = m_maps[j][size - 1];
-					}
-
-					// workaround for synchronization problem: there must not be a command buffer in pending state while updating descriptor sets
-					// this happens if entities are added or removed
-					vkQueueWaitIdle(m_renderer.getGraphicsQueue());
-
-					//update the descriptor set where the entity was removed
-					uint32_t arrayIndex = (uint32_t)(i / m_resourceArrayLength);
-					vh::vhRenderUpdateDescriptorSetMaps(m_renderer.getDevice(),
-						m_descriptorSetsResources[arrayIndex],
-						0,
-						arrayIndex * m_resourceArrayLength,
-						m_resourceArrayLength, m_maps);
-
-					//shrink the lists
-					m_entities.pop_back(); //remove the last
-					if (m_entities.size() % m_resourceArrayLength == 0)
-					{ //shrunk?
-						for (uint32_t j = 0; j < m_maps.size(); j++)
-						{
-							m_maps[j].resize(m_entities.size()); //remove map entries
-						}
-						m_descriptorSetsResources.resize(m_entities.size() / m_resourceArrayLength); //remove descriptor sets
-					}
-				}
-				else
-				{
-					m_entities.pop_back(); //remove the last
-				}
+				if (m_useMaterials)
+					m_renderer.getMaterialTable()->release(pEntity->getResourceIdx());
 				return;
 			}
 		}
@@ -25,15 +25,89 @@ namespace ve
 	class VESubrenderFW : public VESubrender
 	{
 	public:
+		///Entities sharing mesh and UBO memory block, drawn with one instanced or indirect draw call
+		struct veDrawGroup_t
+		{
+			VEMesh *pMesh; ///<Mesh of all entities in the group
+			vh::vhMemoryBlock *pMemBlock; ///<Memory block holding the UBOs of all entities in the group
+			uint32_t first; ///<Index of the first instance or draw command of the group
+			uint32_t count; ///<Number of entities in the group
+		};
+
+		///Per entity input of the cull shader, layout must match the shader
+		struct veIndirectRecord_t
+		{
+			VkDrawIndexedIndirectCommand command; ///<Draw command, firstInstance is the UBO entry index
+			uint32_t group; ///<Index of the group, selects the draw count
+			uint32_t firstCommand; ///<First draw command of the group
+			uint32_t slot; ///<Fixed draw command slot if the draw count cannot be read from a buffer
+			glm::vec4 sphere; ///<Bounding sphere in local space, w is the radius
+		};
+
+		///Buffers of the cull shader, one set for each swapchain image
+		struct veIndirectBuffers_t
+		{
+			uint32_t capacity = 0; ///<Max number of records
+			VkBuffer records = VK_NULL_HANDLE; ///<Per entity records, written by the CPU when recording
+			VmaAllocation recordsAllocation = nullptr; ///<VMA information for the records
+			VkBuffer commands = VK_NULL_HANDLE; ///<Draw commands written by the cull shader
+			VmaAllocation commandsAllocation = nullptr; ///<VMA information for the draw commands
+			VkBuffer counts = VK_NULL_HANDLE; ///<Number of draw commands of each group
+			VmaAllocation countsAllocation = nullptr; ///<VMA information for the draw counts
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE; ///<Descriptor set holding the three buffers
+		};
+
+		///Buffer of instance indices, one for each swapchain image
+		struct veInstanceBuffer_t
+		{
+			uint32_t capacity = 0; ///<Max number of instances
+			VkBuffer buffer = VK_NULL_HANDLE; ///<UBO entry index of each instance, written by the CPU when recording
+			VmaAllocation allocation = nullptr; ///<VMA information for the buffer
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE; ///<Descriptor set holding the buffer
+		};
+
+		///A buffer that pending command buffers might still read, destroyed after some frames
+		struct veRetiredBuffer_t
+		{
+			VkBuffer buffer; ///<The buffer
+			VmaAllocation allocation; ///<VMA information for the buffer
+			uint64_t frame; ///<Frame in which the buffer was retired
+		};
+
 	protected:
 		VERendererForward &m_renderer;
-		uint32_t m_resourceArrayLength = 16; ///<Length of resource array in shader
-		VkDescriptorSetLayout m_descriptorSetLayoutResources = VK_NULL_HANDLE; ///<Descriptor set layout for per object resources (like images)
-		std::vector<VkDescriptorSet> m_descriptorSetsResources; ///<a list of resource descriptor set arrays, maps are condensed into these arrays of size K
-		std::vector<std::vector<VkDescriptorImageInfo>> m_maps; ///<descriptor write info for the  maps, m_maps[0] may contain all diffuse maps, m_maps[1] all normal maps etc
+		bool m_useMaterials = false; ///<true if the shaders read the entity maps from the material table in set 4
 		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE; ///<Pipeline layout
 		std::vector<VkPipeline> m_pipelines; ///<Pipelines for light pass(es)
+		VkPipeline m_pipelineClustered = VK_NULL_HANDLE; ///<Pipeline of the first light pass of a clustered renderer, also shades the lights of the clusters
+		uint32_t m_setCluster = 0; ///<Index of the descriptor set holding the cluster buffers, 0 if the lights of the clusters are not shaded
 		uint32_t m_idxLastRecorded = 0; ///<Used for incremental command buffer recording, idx of last recorded entity
+		bool m_drawBatched = false; ///<true if the shaders read the entity UBOs from a storage buffer, so entities can be drawn in groups
+		uint32_t m_setInstances = 4; ///<Index of the descriptor set holding the instance indices
+		std::vector<veDrawGroup_t> m_drawGroups; ///<Draw groups of the last recording, empty if entities are drawn one by one
+		std::vector<veIndirectBuffers_t> m_indirectBuffers; ///<Cull buffers, one for each swapchain image
+		std::vector<veInstanceBuffer_t> m_instanceBuffers; ///<Instance indices, one for each swapchain image
+		std::deque<veRetiredBuffer_t> m_retiredBuffers; ///<Buffers replaced by larger ones, in the order of retiring
+
+		void sortIntoGroups(veFrameVector<VEEntity *> &entities);
+
+		void bindDrawGroup(VkCommandBuffer commandBuffer, uint32_t imageIndex, veDrawGroup_t &group);
+
+		void createIndirectBuffers(uint32_t imageIndex, uint32_t capacity);
+
+		void destroyIndirectBuffers(veIndirectBuffers_t &buffers);
+
+		void createInstanceBuffer(uint32_t imageIndex, uint32_t capacity);
+
+		void destroyInstanceBuffer(veInstanceBuffer_t &buffer);
+
+		void retireBuffer(VkBuffer buffer, VmaAllocation allocation);
+
+		void destroyRetiredBuffers(bool all);
+
+		void prepareIndirectDraw(uint32_t imageIndex);
+
+		void prepareInstancedDraw(uint32_t imageIndex, VECamera *pCamera);
 
 	public:
 		///Constructor of subrender fw class
@@ -59,7 +133,7 @@ namespace ve
 		//------------------------------------------------------------------------------------------------------------------
 		virtual void bindPipeline(VkCommandBuffer commandBuffer);
 
-		virtual void bindDescriptorSetsPerFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow);
+		virtual void bindDescriptorSetsPerFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 
 		virtual void bindDescriptorSetsPerEntity(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity);
 
@@ -73,7 +147,7 @@ namespace ve
 		virtual void afterDrawFinished(); //after all draw calls have been recorded
 
 		//Draw all entities that are managed by this subrenderer
-		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow);
+		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 
 		///Perform an arbitrary draw operation
 		///\returns a semaphore signalling when this draw operations has finished
@@ -84,6 +158,14 @@ namespace ve
 
 		virtual void drawEntity(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity);
 
+		virtual void prepareDrawGroups(uint32_t imageIndex, VECamera *pCamera);
+
+		virtual void recordCull(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera);
+
+		virtual void drawIndirect(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+		virtual void drawInstanced(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
 		//------------------------------------------------------------------------------------------------------------------
 		virtual void addEntity(VEEntity *pEntity)
 		{
@@ -100,6 +182,12 @@ namespace ve
 			return (uint32_t)m_entities.size();
 		};
 
+		///\returns the number of draw groups of the last recording, i.e. the number of draw calls if entities are drawn in groups
+		uint32_t getNumberDrawGroups()
+		{
+			return (uint32_t)m_drawGroups.size();
+		};
+
 		///return the layout of the local pipeline
 		VkPipelineLayout getPipelineLayout()
 		{
@@ -20,20 +20,30 @@ namespace ve
 	{
 		VESubrenderFW::initSubrenderer();
 
+		//entities are drawn in groups, their UBOs are read from a storage buffer
+		//instanced drawing needs the instance indices as set 4
 		VkDescriptorSetLayout perObjectLayout = m_renderer.getDescriptorSetLayoutPerObject();
+		std::vector<VkDescriptorSetLayout> layouts = { perObjectLayout, perObjectLayout,
+			 m_renderer.getDescriptorSetLayoutShadow(),
+			 m_renderer.getDescriptorSetLayoutPerObjectStorage() };
+		if (!m_renderer.isIndirect())
+			layouts.push_back(m_renderer.getDescriptorSetLayoutInstances());
+		m_setInstances = 4;
+		m_drawBatched = true;
 
-		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
-			{ perObjectLayout, perObjectLayout,
-			 m_renderer.getDescriptorSetLayoutShadow(), perObjectLayout },
-			{}, &m_pipelineLayout);
+		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(), layouts, {}, &m_pipelineLayout);
+
+		bool packedVertices = getEnginePointer()->usePackedVertices(); //decode vhVertexPacked in the vertex shader
+		std::string vertShader = std::string("../../media/shader/Forward/C1/") +
+			(m_renderer.isIndirect() ? "vert_indirect" : "vert_instanced") + (packedVertices ? "_packed.spv" : ".spv");
 
 		m_pipelines.resize(1);
 		vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
-			{ "../../media/shader/Forward/C1/vert.spv", "../../media/shader/Forward/C1/frag.spv" },
+			{ vertShader, "../../media/shader/Forward/C1/frag.spv" },
 			m_renderer.getSwapChainExtent(),
 			m_pipelineLayout, m_renderer.getRenderPass(),
 			{},
-			&m_pipelines[0]);
+			&m_pipelines[0], VK_CULL_MODE_NONE, 1, packedVertices);
 	}
 
 } // namespace ve
@@ -14,16 +14,19 @@ namespace ve
 	{
 		VESubrenderFW::initSubrenderer();
 
-		vh::vhRenderCreateDescriptorSetLayout(m_renderer.getDevice(), { m_resourceArrayLength },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER }, { VK_SHADER_STAGE_FRAGMENT_BIT },
-			&m_descriptorSetLayoutResources);
-
 		VkDescriptorSetLayout perObjectLayout = m_renderer.getDescriptorSetLayoutPerObject();
+		std::vector<VkDescriptorSetLayout> layouts = { perObjectLayout, perObjectLayout,
+			m_renderer.getDescriptorSetLayoutShadow(), perObjectLayout,
+			m_renderer.getMaterialTable()->getDescriptorSetLayout() };
+
+		// A clustered renderer also shades the lights of the clusters in the first light pass.
+		if (m_renderer.isClustered())
+		{
+			m_setCluster = (uint32_t)layouts.size();
+			layouts.push_back(m_renderer.getDescriptorSetLayoutCluster());
+		}
 
-		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
-			{ perObjectLayout, perObjectLayout, m_renderer.getDescriptorSetLayoutShadow(),
-				perObjectLayout, m_descriptorSetLayoutResources },
-			{}, &m_pipelineLayout);
+		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(), layouts, {}, &m_pipelineLayout);
 
 		m_pipelines.resize(1);
 		vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
@@ -31,8 +34,15 @@ namespace ve
 			m_renderer.getSwapChainExtent(), m_pipelineLayout, m_renderer.getRenderPass(),
 			{ VK_DYNAMIC_STATE_BLEND_CONSTANTS }, &m_pipelines[0]);
 
-		if (m_maps.empty())
-			m_maps.resize(1);
+		if (m_renderer.isClustered())
+		{
+			vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
+				{ "../../media/shader/Forward/D/vert.spv", "../../media/shader/Forward/Cloth/frag_clustered.spv" },
+				m_renderer.getSwapChainExtent(), m_pipelineLayout, m_renderer.getRenderPass(),
+				{ VK_DYNAMIC_STATE_BLEND_CONSTANTS }, &m_pipelineClustered);
+		}
+
+		m_useMaterials = true;
 	}
 
 	/// <summary>
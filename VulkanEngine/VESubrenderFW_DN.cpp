@@ -20,31 +20,50 @@ namespace ve
 	{
 		VESubrenderFW::initSubrenderer();
 
-		vh::vhRenderCreateDescriptorSetLayout(m_renderer.getDevice(), //binding 0...array, binding 1...array
-			{ m_resourceArrayLength, m_resourceArrayLength },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-			{ VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_FRAGMENT_BIT },
-			&m_descriptorSetLayoutResources);
-
+		//entities are drawn in groups, their UBOs are read from a storage buffer
+		//instanced drawing needs the instance indices as set 5
 		VkDescriptorSetLayout perObjectLayout = m_renderer.getDescriptorSetLayoutPerObject();
-
-		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
-			{ perObjectLayout, perObjectLayout,
+		std::vector<VkDescriptorSetLayout> layouts = { perObjectLayout, perObjectLayout,
 			 m_renderer.getDescriptorSetLayoutShadow(),
-			 perObjectLayout, m_descriptorSetLayoutResources },
-			{}, &m_pipelineLayout);
+			 m_renderer.getDescriptorSetLayoutPerObjectStorage(), m_renderer.getMaterialTable()->getDescriptorSetLayout() };
+		if (!m_renderer.isIndirect())
+			layouts.push_back(m_renderer.getDescriptorSetLayoutInstances());
+		m_setInstances = 5;
+		m_drawBatched = true;
+
+		//a clustered renderer also shades the lights of the clusters in the first light pass
+		if (m_renderer.isClustered())
+		{
+			m_setCluster = (uint32_t)layouts.size();
+			layouts.push_back(m_renderer.getDescriptorSetLayoutCluster());
+		}
 
+		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(), layouts, {}, &m_pipelineLayout);
+
+		bool packedVertices = getEnginePointer()->usePackedVertices(); //decode vhVertexPacked in the vertex shader
 		m_pipelines.resize(1);
 		vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
-			{ "../../media/shader/Forward/DN/vert.spv", "../../media/shader/Forward/DN/frag.spv" },
+			m_renderer.isIndirect() ?
+			std::vector<std::string>{ packedVertices ? "../../media/shader/Forward/DN/vert_indirect_packed.spv" : "../../media/shader/Forward/DN/vert_indirect.spv", "../../media/shader/Forward/DN/frag_indirect.spv" } :
+			std::vector<std::string>{ packedVertices ? "../../media/shader/Forward/DN/vert_instanced_packed.spv" : "../../media/shader/Forward/DN/vert_instanced.spv", "../../media/shader/Forward/DN/frag_instanced.spv" },
 			m_renderer.getSwapChainExtent(),
 			m_pipelineLayout, m_renderer.getRenderPass(),
 			{ VK_DYNAMIC_STATE_BLEND_CONSTANTS },
-			&m_pipelines[0]);
+			&m_pipelines[0], VK_CULL_MODE_NONE, 1, packedVertices);
+
+		if (m_renderer.isClustered())
+		{
+			vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
+				m_renderer.isIndirect() ?
+				std::vector<std::string>{ packedVertices ? "../../media/shader/Forward/DN/vert_indirect_packed.spv" : "../../media/shader/Forward/DN/vert_indirect.spv", "../../media/shader/Forward/DN/frag_indirect_clustered.spv" } :
+				std::vector<std::string>{ packedVertices ? "../../media/shader/Forward/DN/vert_instanced_packed.spv" : "../../media/shader/Forward/DN/vert_instanced.spv", "../../media/shader/Forward/DN/frag_instanced_clustered.spv" },
+				m_renderer.getSwapChainExtent(),
+				m_pipelineLayout, m_renderer.getRenderPass(),
+				{ VK_DYNAMIC_STATE_BLEND_CONSTANTS },
+				&m_pipelineClustered, VK_CULL_MODE_NONE, 1, packedVertices);
+		}
 
-		if (m_maps.empty())
-			m_maps.resize(2);
+		m_useMaterials = true;
 	}
 
 	/**
@@ -13,27 +13,72 @@ namespace ve
 	/**
 		* \brief Initialize the subrenderer
 		*
-		* Create descriptor set layout, pipeline layout and the PSO
+		* Create descriptor set layout, pipeline layout and the PSO. If the device supports it, also the PSOs
+		* drawing point light shadows in one pass, these get the faces of an entity as push constant.
 		*
 		*/
 	void VESubrenderFW_Shadow::initSubrenderer()
 	{
 		VESubrenderFW::initSubrenderer();
 
+		std::vector<VkPushConstantRange> pushConstants = {};
+		if (m_renderer.hasCubeShadows())
+			pushConstants.push_back({ VK_SHADER_STAGE_GEOMETRY_BIT, 0, sizeof(uint32_t) });
+
 		VkDescriptorSetLayout perObjectLayout = m_renderer.getDescriptorSetLayoutPerObject();
 		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
 			{ perObjectLayout, perObjectLayout,
 			 m_renderer.getDescriptorSetLayoutShadow(), perObjectLayout },
-			{},
+			pushConstants,
 			&m_pipelineLayout);
 
+		//the shadow maps are tiles of the shadow atlas, each command buffer sets the viewport of its tile
 		m_pipelines.resize(1);
 		vh::vhPipeCreateGraphicsShadowPipeline(m_renderer.getDevice(),
 			"../../media/shader/Forward/Shadow/vert.spv",
 			m_renderer.getShadowMapExtent(),
-			m_pipelineLayout,
-			m_renderer.getRenderPassShadow(),
-			&m_pipelines[0]);
+			m_pipelineLayout, m_renderer.getRenderPassShadow(),
+			&m_pipelines[0], false, { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR });
+
+		//with packed vertices, pipeline 1 draws them, pipeline 0 is still needed for meshes that are not packed, like cloth
+		if (getEnginePointer()->usePackedVertices())
+		{
+			m_pipelines.resize(2);
+			vh::vhPipeCreateGraphicsShadowPipeline(m_renderer.getDevice(),
+				"../../media/shader/Forward/Shadow/vert_packed.spv",
+				m_renderer.getShadowMapExtent(),
+				m_pipelineLayout, m_renderer.getRenderPassShadow(),
+				&m_pipelines[1], true, { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR });
+		}
+
+		if (!m_renderer.hasCubeShadows())
+			return;
+
+		//the geometry shader sends each triangle to the viewports of the faces, i.e. their tiles
+		m_pipelinesCube.resize(getEnginePointer()->usePackedVertices() ? 2 : 1);
+		for (uint32_t i = 0; i < m_pipelinesCube.size(); i++)
+		{
+			vh::vhPipeCreateGraphicsShadowPipeline(m_renderer.getDevice(),
+				i == 0 ? "../../media/shader/Forward/Shadow/vert_cube.spv" : "../../media/shader/Forward/Shadow/vert_cube_packed.spv",
+				m_renderer.getShadowMapExtent(),
+				m_pipelineLayout, m_renderer.getRenderPassShadow(),
+				&m_pipelinesCube[i], i == 1, { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR },
+				"../../media/shader/Forward/Shadow/geom.spv", VE_SHADOW_CUBE_FACES);
+		}
+	}
+
+	/**
+		* \brief Destroy the single pass pipelines, then the other resources
+		*/
+	void VESubrenderFW_Shadow::closeSubrenderer()
+	{
+		for (auto pipeline : m_pipelinesCube)
+		{
+			vkDestroyPipeline(m_renderer.getDevice(), pipeline, nullptr);
+		}
+		m_pipelinesCube.clear();
+
+		VESubrenderFW::closeSubrenderer();
 	}
 
 	/**
@@ -70,11 +115,11 @@ namespace ve
 		//set 3...per object UBO
 		//set 4...additional per object resources - NOT used in shadows
 
-		std::vector<VkDescriptorSet> sets = { entity->m_memoryHandle.pMemBlock->descriptorSets[imageIndex] };
+		VkDescriptorSet set = entity->m_memoryHandle.pMemBlock->descriptorSets[imageIndex];
 
 		uint32_t offset = entity->m_memoryHandle.entryIndex * sizeof(VEEntity::veUBOPerEntity_t);
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-			3, (uint32_t)sets.size(), sets.data(), 1, &offset);
+			3, 1, &set, 1, &offset);
 	}
 
 	/**
@@ -96,23 +141,130 @@ namespace ve
 		uint32_t numPass,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet> descriptorSetsShadow)
+		const std::vector<VkDescriptorSet> &descriptorSetsShadow)
 	{
+		for (auto subrender : getSubrenderers())
+		{
+			drawCasters(commandBuffer, imageIndex, pCamera, pLight, subrender, descriptorSetsShadow);
+		}
+	}
+
+	/**
+	* \brief Draw the shadow casting entities of one subrenderer
+	*
+	* The forward renderer records the shadow pass of each subrenderer into its own command buffer, so that
+	* only the buffers of subrenderers whose entities changed have to be recorded again.
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pCamera Pointer to the current light camera
+	* \param[in] pLight Pointer to the current light
+	* \param[in] pCaster The subrenderer whose entities are drawn
+	* \param[in] descriptorSetsShadow The shadow maps to be used.
+	* \returns the number of draw calls
+	*
+	*/
+	uint32_t VESubrenderFW_Shadow::drawCasters(VkCommandBuffer commandBuffer,
+		uint32_t imageIndex,
+		VECamera *pCamera,
+		VELight *pLight,
+		VESubrender *pCaster,
+		const std::vector<VkDescriptorSet> &descriptorSetsShadow)
+	{
+		if (pCaster->getEntities().size() == 0)
+			return 0;
+
 		bindPipeline(commandBuffer);
+		VkPipeline boundPipeline = m_pipelines[0];
 
 		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, descriptorSetsShadow);
 
+		//cull against the shadow camera frustum, except when drawing indirectly since then the command buffers
+		//are not recorded again if the visibility changes
+		bool cull = !m_renderer.isIndirect();
+		veFrameVector<glm::vec4> planes;
+		if (cull)
+			pCamera->getFrustumPlanes(planes);
+
 		//go through all entities and draw them
-		for (auto subrender : getSubrenderers())
+		uint32_t numDraws = 0;
+		for (auto pEntity : pCaster->getEntities())
 		{
-			for (auto pEntity : subrender->getEntities())
+			if (pEntity->m_castsShadow && (!cull || pEntity->isInFrustum(planes)))
 			{
-				if (pEntity->m_castsShadow)
-				{
-					bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity); //bind the entity's descriptor sets
-					drawEntity(commandBuffer, imageIndex, pEntity);
+				VkPipeline pipeline = m_pipelines[pEntity->m_pMesh->m_packed ? 1 : 0];
+				if (pipeline != boundPipeline)
+				{ //the vertex format of the mesh changed
+					vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+					boundPipeline = pipeline;
 				}
+				bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity); //bind the entity's descriptor sets
+				drawEntity(commandBuffer, imageIndex, pEntity);
+				numDraws++;
+			}
+		}
+		return numDraws;
+	}
+
+	/**
+	* \brief Draw the shadow casting entities of one subrenderer into all 6 faces of a point light
+	*
+	* Each entity is drawn once, the geometry shader sends its triangles to the faces. The faces whose frustum
+	* contains the entity are pushed as a mask, so the geometry shader skips the others. The viewports of the faces
+	* must have been set. When drawing indirectly, entities are not culled, as in drawCasters().
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pLight Pointer to the point light
+	* \param[in] pCaster The subrenderer whose entities are drawn
+	* \returns the number of draw calls
+	*
+	*/
+	uint32_t VESubrenderFW_Shadow::drawCastersCube(VkCommandBuffer commandBuffer,
+		uint32_t imageIndex,
+		VELight *pLight,
+		VESubrender *pCaster)
+	{
+		if (pCaster->getEntities().size() == 0 || m_pipelinesCube.empty())
+			return 0;
+
+		VkPipeline boundPipeline = m_pipelinesCube[0];
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundPipeline);
+
+		//the camera set is not read, the geometry shader takes the face cameras from the light
+		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pLight->m_shadowCameras[0], pLight, {});
+
+		bool cull = !m_renderer.isIndirect();
+		veFrameVector<glm::vec4> planes[VE_SHADOW_CUBE_FACES];
+		for (uint32_t f = 0; cull && f < VE_SHADOW_CUBE_FACES; f++)
+			pLight->m_shadowCameras[f]->getFrustumPlanes(planes[f]);
+
+		uint32_t numDraws = 0;
+		for (auto pEntity : pCaster->getEntities())
+		{
+			if (!pEntity->m_castsShadow)
+				continue;
+
+			uint32_t mask = (1 << VE_SHADOW_CUBE_FACES) - 1;
+			for (uint32_t f = 0; cull && f < VE_SHADOW_CUBE_FACES; f++)
+			{
+				if (!pEntity->isInFrustum(planes[f]))
+					mask &= ~(1 << f);
+			}
+			if (mask == 0)
+				continue;
+
+			VkPipeline pipeline = m_pipelinesCube[pEntity->m_pMesh->m_packed ? 1 : 0];
+			if (pipeline != boundPipeline)
+			{ //the vertex format of the mesh changed
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				boundPipeline = pipeline;
 			}
+			vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_GEOMETRY_BIT, 0, sizeof(uint32_t), &mask);
+			bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity);
+			drawEntity(commandBuffer, imageIndex, pEntity);
+			numDraws++;
 		}
+		return numDraws;
 	}
 } // namespace ve
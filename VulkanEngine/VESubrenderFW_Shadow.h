@@ -16,6 +16,8 @@ namespace ve
 	class VESubrenderFW_Shadow : public VESubrenderFW
 	{
 	protected:
+		std::vector<VkPipeline> m_pipelinesCube = {}; ///<Pipelines drawing the 6 faces of a point light in one pass, 1 is for packed vertices
+
 	public:
 		///Constructor
 		VESubrenderFW_Shadow(VERendererForward &renderer)
@@ -37,12 +39,16 @@ namespace ve
 		};
 
 		virtual void initSubrenderer();
+		virtual void closeSubrenderer();
 
 		virtual void addEntity(VEEntity *pEntity);
 
 		void bindDescriptorSetsPerEntity(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity);
 
-		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow);
+		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow);
+
+		uint32_t drawCasters(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera, VELight *pLight, VESubrender *pCaster, const std::vector<VkDescriptorSet> &descriptorSetsShadow); //draw the shadow casters of one subrenderer
+		uint32_t drawCastersCube(VkCommandBuffer commandBuffer, uint32_t imageIndex, VELight *pLight, VESubrender *pCaster); //draw the shadow casters into all faces of a point light
 	};
 } // namespace ve
 
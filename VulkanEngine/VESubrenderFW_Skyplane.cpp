@@ -20,31 +20,25 @@ namespace ve
 	{
 		VESubrender::initSubrenderer();
 
-		vh::vhRenderCreateDescriptorSetLayout(m_renderer.getDevice(),
-			{ m_resourceArrayLength },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-			{ VK_SHADER_STAGE_FRAGMENT_BIT },
-			&m_descriptorSetLayoutResources);
-
 		VkDescriptorSetLayout perObjectLayout = m_renderer.getDescriptorSetLayoutPerObject();
 
 		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
 			{ perObjectLayout, perObjectLayout,
 			 m_renderer.getDescriptorSetLayoutShadow(), perObjectLayout,
-			 m_descriptorSetLayoutResources },
+			 m_renderer.getMaterialTable()->getDescriptorSetLayout() },
 			{}, &m_pipelineLayout);
 
+		bool packedVertices = getEnginePointer()->usePackedVertices(); //decode vhVertexPacked in the vertex shader
 		m_pipelines.resize(1);
 		vh::vhPipeCreateGraphicsPipeline(m_renderer.getDevice(),
-			{ "../../media/shader/Forward/Skyplane/vert.spv",
+			{ packedVertices ? "../../media/shader/Forward/Skyplane/vert_packed.spv" : "../../media/shader/Forward/Skyplane/vert.spv",
 			 "../../media/shader/Forward/Skyplane/frag.spv" },
 			m_renderer.getSwapChainExtent(),
 			m_pipelineLayout, m_renderer.getRenderPass(),
 			{},
-			&m_pipelines[0]);
+			&m_pipelines[0], VK_CULL_MODE_NONE, 1, packedVertices);
 
-		if (m_maps.empty())
-			m_maps.resize(1);
+		m_useMaterials = true;
 	}
 
 	/**
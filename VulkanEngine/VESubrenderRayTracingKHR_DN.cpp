@@ -36,14 +36,13 @@ namespace ve
 		vh::vhPipeCreateGraphicsPipelineLayout(m_renderer.getDevice(),
 			{ perObjectLayout, perObjectLayout, m_descriptorSetLayoutOutput,
 			 m_descriptorSetLayoutAS, m_descriptorSetLayoutGeometry,
-			 m_descriptorSetLayoutObjectUBOs, m_descriptorSetLayoutResources },
+			 m_descriptorSetLayoutObjectUBOs, m_renderer.getMaterialTable()->getDescriptorSetLayout() },
 			{ pushRange }, &m_pipelineLayout);
 
 		createRTGraphicsPipeline();
 		createShaderBindingTable();
 
-		if (m_maps.empty())
-			m_maps.resize(2);
+		m_useMaterials = true;
 	};
 
 	void VESubrenderRayTracingKHR_DN::createRaytracingDescriptorSets()
@@ -122,15 +121,6 @@ namespace ve
 			{ VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR },
 			&m_descriptorSetLayoutObjectUBOs);
 
-		//Textures binding (set 6)
-		vh::vhRenderCreateDescriptorSetLayout(m_renderer.getDevice(), //binding 0...array, binding 1...array
-			{ m_resourceArrayLength, m_resourceArrayLength },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-			{ VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
-			 VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR },
-			&m_descriptorSetLayoutResources);
-
 		// Acceleration structure and geometry are the same for all swapchains
 		vh::vhRenderCreateDescriptorSets(m_renderer.getDevice(), m_renderer.getSwapChainNumber(),
 			m_descriptorSetLayoutAS, m_renderer.getDescriptorPool(), m_descriptorSetsAS);
@@ -293,22 +283,6 @@ namespace ve
 		closeSubrenderer();
 		initSubrenderer();
 		updateRTDescriptorSets();
-		uint32_t size = (uint32_t)m_descriptorSetsResources.size();
-		if (size > 0)
-		{
-			m_descriptorSetsResources.clear();
-			vh::vhRenderCreateDescriptorSets(m_renderer.getDevice(),
-				size, m_descriptorSetLayoutResources,
-				m_renderer.getDescriptorPool(),
-				m_descriptorSetsResources);
-
-			for (uint32_t i = 0; i < size; i++)
-			{
-				vh::vhRenderUpdateDescriptorSetMaps(m_renderer.getDevice(),
-					m_descriptorSetsResources[i],
-					0, i * m_resourceArrayLength, m_resourceArrayLength, m_maps);
-			}
-		}
 	}
 
 	/**
@@ -334,10 +308,8 @@ namespace ve
 			vkDestroyDescriptorSetLayout(m_renderer.getDevice(), m_descriptorSetLayoutOutput, nullptr);
 		if (m_descriptorSetLayoutGeometry != VK_NULL_HANDLE)
 			vkDestroyDescriptorSetLayout(m_renderer.getDevice(), m_descriptorSetLayoutGeometry, nullptr);
-		if (m_descriptorSetLayoutResources != VK_NULL_HANDLE)
+		if (m_descriptorSetLayoutObjectUBOs != VK_NULL_HANDLE)
 			vkDestroyDescriptorSetLayout(m_renderer.getDevice(), m_descriptorSetLayoutObjectUBOs, nullptr);
-		if (m_descriptorSetLayoutResources != VK_NULL_HANDLE)
-			vkDestroyDescriptorSetLayout(m_renderer.getDevice(), m_descriptorSetLayoutResources, nullptr);
 
 		vmaDestroyBuffer(m_renderer.getVmaAllocator(), m_SBTBuffer, m_SBTAllocation);
 	}
@@ -376,9 +348,9 @@ namespace ve
 		//set 3...acceleration structure
 		//set 4...vertex and index
 		//set 5...per object UBOs
-		//set 6...additional per object resources
+		//set 6...material table
 
-		std::vector<VkDescriptorSet> set = {
+		VkDescriptorSet set[2] = {
 			pCamera->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
 			pLight->m_memoryHandle.pMemBlock->descriptorSets[imageIndex],
 		};
@@ -389,16 +361,16 @@ namespace ve
 		};
 
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_pipelineLayout,
-			0, (uint32_t)set.size(), set.data(), 2, offsets);
+			0, 2, set, 2, offsets);
 
-		std::vector<VkDescriptorSet> set2 = {
+		VkDescriptorSet set2[4] = {
 			m_descriptorSetsOutput[imageIndex],
 			m_descriptorSetsAS[0],
 			m_descriptorSetsGeometry[0],
 			m_descriptorSetsUBOs[imageIndex],
 		};
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_pipelineLayout,
-			2, (uint32_t)set2.size(), set2.data(), 0, {});
+			2, 4, set2, 0, {});
 	}
 
 	/**
@@ -423,17 +395,11 @@ namespace ve
 		//set 3...acceleration structure
 		//set 4...vertex and index
 		//set 5...per object UBO
-		//set 6...additional per object resources
-
-		std::vector<VkDescriptorSet> sets = {};
-
-		if (m_descriptorSetsResources.size() > 0 && entity->getResourceIdx() % m_resourceArrayLength == 0)
-		{
-			sets.push_back(m_descriptorSetsResources[entity->getResourceIdx() / m_resourceArrayLength]);
-		}
+		//set 6...material table
 
+		VkDescriptorSet set = m_renderer.getMaterialTable()->getDescriptorSet(); //the same table for all entities
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_pipelineLayout,
-			6, (uint32_t)sets.size(), sets.data(), 0, {});
+			6, 1, &set, 0, {});
 	}
 
 	// link buffers with a descriptor sets. If any of this ressources are changed, this method must be called.
@@ -586,7 +552,7 @@ namespace ve
 		numPass,
 		VECamera *pCamera,
 		VELight *pLight,
-		std::vector<VkDescriptorSet> descriptorSetsShadow)
+		const std::vector<VkDescriptorSet> &descriptorSetsShadow)
 	{
 		if (m_entities.size() == 0)
 			return;
@@ -96,7 +96,7 @@ namespace ve
 		virtual void afterDrawFinished(); //after all draw calls have been recorded
 
 		//Draw all entities that are managed by this subrenderer
-		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow = {});
+		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow = {});
 
 		///Perform an arbitrary draw operation
 		///\returns a semaphore signalling when this draw operations has finished
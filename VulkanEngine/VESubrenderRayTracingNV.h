@@ -27,10 +27,8 @@ namespace ve
 	public:
 	protected:
 		VERendererRayTracingNV &m_renderer;
-		uint32_t m_resourceArrayLength = 256; ///<Length of resource array in shader
-		VkDescriptorSetLayout m_descriptorSetLayoutResources = VK_NULL_HANDLE; ///<Descriptor set layout for per object resources (like images)
-		std::vector<VkDescriptorSet> m_descriptorSetsResources; ///<a list of resource descriptor set arrays, maps are condensed into these arrays of size K
-		std::vector<std::vector<VkDescriptorImageInfo>> m_maps; ///<descriptor write info for the  maps, m_maps[0] may contain all diffuse maps, m_maps[1] all normal maps etc
+		uint32_t m_resourceArrayLength = 256; ///<Length of the geometry and UBO arrays in the shaders
+		bool m_useMaterials = false; ///<true if the shaders read the entity maps from the material table in set 6
 		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE; ///<Pipeline layout
 		std::vector<VkPipeline> m_pipelines; ///<Pipelines for light pass(es)
 		uint32_t m_idxLastRecorded = 0; ///<Used for incremental command buffer recording, idx of last recorded entity
@@ -59,7 +57,7 @@ namespace ve
 		//------------------------------------------------------------------------------------------------------------------
 		virtual void bindPipeline(VkCommandBuffer commandBuffer);
 
-		virtual void bindDescriptorSetsPerFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow);
+		virtual void bindDescriptorSetsPerFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 
 		virtual void bindDescriptorSetsPerEntity(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity);
 
@@ -73,7 +71,7 @@ namespace ve
 		virtual void afterDrawFinished(); //after all draw calls have been recorded
 
 		//Draw all entities that are managed by this subrenderer
-		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, std::vector<VkDescriptorSet> descriptorSetsShadow = {});
+		virtual void draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass, VECamera *pCamera, VELight *pLight, const std::vector<VkDescriptorSet> &descriptorSetsShadow = {});
 
 		///Perform an arbitrary draw operation
 		///\returns a semaphore signalling when this draw operations has finished
@@ -0,0 +1,243 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VEInclude.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define VE_TRANSFORM_SSE
+#endif
+
+namespace ve
+{
+	/**
+		*
+		* \brief Multiply two 4x4 matrices, c = a * b
+		*
+		* The matrices are column major like in glm. Each column of c is a linear combination of the columns of a,
+		* weighted by the entries of the same column of b. With AVX two columns of c are computed at once.
+		*
+		* \param[in] a Left matrix
+		* \param[in] b Right matrix
+		* \param[out] c The product, must not be a or b
+		*
+		*/
+	static inline void veMatMul(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &c)
+	{
+#if defined(__AVX__)
+		const float *pa = &a[0][0];
+		const float *pb = &b[0][0];
+		float *pc = &c[0][0];
+		__m256 a0 = _mm256_broadcast_ps((const __m128 *)(pa + 0)); //column k of a in both halves
+		__m256 a1 = _mm256_broadcast_ps((const __m128 *)(pa + 4));
+		__m256 a2 = _mm256_broadcast_ps((const __m128 *)(pa + 8));
+		__m256 a3 = _mm256_broadcast_ps((const __m128 *)(pa + 12));
+		for (uint32_t j = 0; j < 16; j += 8)
+		{
+			__m256 bj = _mm256_loadu_ps(pb + j); //columns j and j+1 of b
+			__m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(bj, 0x00));
+			r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_permute_ps(bj, 0x55)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_permute_ps(bj, 0xAA)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_permute_ps(bj, 0xFF)));
+			_mm256_storeu_ps(pc + j, r);
+		}
+#elif defined(VE_TRANSFORM_SSE)
+		const float *pa = &a[0][0];
+		const float *pb = &b[0][0];
+		float *pc = &c[0][0];
+		__m128 a0 = _mm_loadu_ps(pa + 0);
+		__m128 a1 = _mm_loadu_ps(pa + 4);
+		__m128 a2 = _mm_loadu_ps(pa + 8);
+		__m128 a3 = _mm_loadu_ps(pa + 12);
+		for (uint32_t j = 0; j < 16; j += 4)
+		{
+			__m128 bj = _mm_loadu_ps(pb + j); //column j of b
+			__m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, 0x00));
+			r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, 0x55)));
+			r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, 0xAA)));
+			r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, 0xFF)));
+			_mm_storeu_ps(pc + j, r);
+		}
+#else
+		c = a * b;
+#endif
+	}
+
+	/**
+		*
+		* \brief Create an entry for a new scene node
+		*
+		* The entry is stored behind all other entries and is dirty, so it is sorted into its level in the next update.
+		*
+		* \param[in] pNode The new node
+		* \param[in] transform The local to parent transform of the node
+		* \returns the index of the new entry
+		*
+		*/
+	uint32_t VETransformHierarchy::allocate(VESceneNode *pNode, const glm::mat4 &transform)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+		m_local.push_back(transform);
+		m_world.push_back(transform);
+		m_parent.push_back(VE_TRANSFORM_NONE);
+		m_dirty.push_back(1);
+		m_changed.push_back(0);
+		m_nodes.push_back(pNode);
+		m_structureChanged = true;
+		return (uint32_t)m_nodes.size() - 1;
+	}
+
+	/**
+		*
+		* \brief Free the entry of a deleted scene node
+		*
+		* The entry is removed when the entries are sorted in the next update.
+		*
+		* \param[in] idx Index of the entry
+		*
+		*/
+	void VETransformHierarchy::release(uint32_t idx)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+		m_nodes[idx] = nullptr;
+		m_structureChanged = true;
+	}
+
+	/**
+		*
+		* \brief Sort the entries by their depth in the scene graph
+		*
+		* Goes through the scene graph breadth first, so the children of each level become the next level.
+		* Nodes that are not reachable from the root come last, freed entries are removed.
+		* The nodes get their new entry indices. Must be called with the exclusive lock.
+		*
+		* \param[in] pRoot The root of the scene graph
+		*
+		*/
+	void VETransformHierarchy::sort(VESceneNode *pRoot)
+	{
+		uint32_t numEntries = (uint32_t)m_nodes.size();
+		std::vector<uint32_t> order; //old index of each new entry
+		std::vector<uint32_t> newParent; //new parent index of each new entry
+		std::vector<uint8_t> placed(numEntries, 0);
+		order.reserve(numEntries);
+		newParent.reserve(numEntries);
+
+		m_levels.clear();
+		m_levels.push_back(0);
+		if (pRoot != nullptr)
+		{
+			order.push_back(pRoot->m_transformIdx);
+			newParent.push_back(VE_TRANSFORM_NONE);
+			placed[pRoot->m_transformIdx] = 1;
+		}
+
+		uint32_t levelStart = 0;
+		while (levelStart < order.size())
+		{
+			uint32_t levelEnd = (uint32_t)order.size();
+			m_levels.push_back(levelEnd);
+			for (uint32_t i = levelStart; i < levelEnd; i++)
+			{
+				for (auto pChild : m_nodes[order[i]]->m_children)
+				{
+					order.push_back(pChild->m_transformIdx);
+					newParent.push_back(i);
+					placed[pChild->m_transformIdx] = 1;
+				}
+			}
+			levelStart = levelEnd;
+		}
+		if (m_levels.size() == 1)
+			m_levels.push_back(0);
+
+		for (uint32_t i = 0; i < numEntries; i++)
+		{ //nodes outside of the scene graph
+			if (m_nodes[i] != nullptr && !placed[i])
+			{
+				order.push_back(i);
+				newParent.push_back(VE_TRANSFORM_NONE);
+			}
+		}
+
+		std::vector<glm::mat4> local(order.size());
+		std::vector<glm::mat4> world(order.size());
+		std::vector<uint8_t> dirty(order.size());
+		std::vector<VESceneNode *> nodes(order.size());
+		for (uint32_t i = 0; i < order.size(); i++)
+		{
+			local[i] = m_local[order[i]];
+			world[i] = m_world[order[i]];
+			dirty[i] = m_dirty[order[i]];
+			nodes[i] = m_nodes[order[i]];
+			nodes[i]->m_transformIdx = i;
+		}
+		m_local = std::move(local);
+		m_world = std::move(world);
+		m_dirty = std::move(dirty);
+		m_nodes = std::move(nodes);
+		m_parent = std::move(newParent);
+		m_changed.assign(order.size(), 0);
+	}
+
+	/**
+		*
+		* \brief Compute the world matrices of all nodes in the scene graph
+		*
+		* First sorts the entries again if the scene graph has changed. Then goes through the levels, starting at the root.
+		* An entry has changed if it is dirty or its parent has changed, then its world matrix is the parent world
+		* matrix times its local transform. Each level is split into chunks of at least 4096 entries, which run
+		* on the worker threads of the job system, see the class description for the cost.
+		*
+		* \param[in] pRoot The root of the scene graph
+		* \param[in] pJobSystem The job system for computing in parallel
+		* \param[in] force If true, then all world matrices are computed
+		* \returns true if the entries were sorted again, i.e. the scene graph has changed
+		*
+		*/
+	bool VETransformHierarchy::update(VESceneNode *pRoot, VEJobSystem *pJobSystem, bool force)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+		bool sorted = m_structureChanged.exchange(false);
+		if (sorted)
+			sort(pRoot);
+
+		if (getNumNodes() == 0)
+			return sorted;
+
+		uint8_t forceFlag = force ? 1 : 0;
+		m_changed[0] = m_dirty[0] | forceFlag; //the root
+		m_dirty[0] = 0;
+		if (m_changed[0])
+			m_world[0] = m_local[0];
+
+		const uint32_t granularity = 4096;
+		for (uint32_t level = 1; level + 1 < m_levels.size(); level++)
+		{
+			uint32_t levelStart = m_levels[level];
+			pJobSystem->parallelFor(m_levels[level + 1] - levelStart, granularity, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = levelStart + begin; i < levelStart + end; i++)
+					{
+						uint32_t parent = m_parent[i];
+						uint8_t changed = m_dirty[i] | m_changed[parent] | forceFlag;
+						m_changed[i] = changed;
+						m_dirty[i] = 0;
+						if (changed)
+							veMatMul(m_world[parent], m_local[i], m_world[i]);
+					}
+				});
+		}
+		return sorted;
+	}
+
+} // namespace ve
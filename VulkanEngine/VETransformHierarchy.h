@@ -0,0 +1,144 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#ifndef VETRANSFORMHIERARCHY_H
+#define VETRANSFORMHIERARCHY_H
+
+#include <shared_mutex>
+
+namespace ve
+{
+	class VESceneNode;
+	class VEJobSystem;
+
+	const uint32_t VE_TRANSFORM_NONE = UINT32_MAX; ///<Parent index of nodes without a parent
+
+	/**
+		*
+		* \brief Contiguous storage of the local and world matrices of all scene nodes
+		*
+		* Each scene node owns one entry, the node only stores the index of its entry. The entries are sorted
+		* by depth in the scene graph: first the root, then its children, then their children and so on.
+		* Each entry knows the index of its parent entry, which always lies in the previous level.
+		* So the world matrices can be computed level by level, each level in parallel and without
+		* following any pointers. Nodes that are not part of the scene graph are stored behind the last level.
+		*
+		* When nodes are created, deleted, or moved in the graph, the entries are sorted again in the next update.
+		* Accessing single entries takes a shared lock, so many threads can read and write different nodes at
+		* the same time. Allocating, freeing and sorting takes the exclusive lock.
+		*
+		* Known limitation: the update is memory bound, about 15 to 20 ns per changed node on one core. A full update
+		* of 1M nodes takes 15 to 20 ms on one core, with SSE or AVX alike, so the goal of a few ms for 1M nodes is
+		* not reached yet. Whether more cores get there has not been measured. Only changed subtrees are computed,
+		* so the usual case of few moving nodes is much cheaper, e.g. 2.6 ms for a subtree of 100k nodes on one core.
+		*
+		*/
+	class VETransformHierarchy
+	{
+	protected:
+		std::vector<glm::mat4> m_local; ///<Transforms from local to parent space
+		std::vector<glm::mat4> m_world; ///<World matrices computed in the last update
+		std::vector<uint32_t> m_parent; ///<Index of the parent entry, or VE_TRANSFORM_NONE
+		std::vector<uint8_t> m_dirty; ///<1 if the local transform changed since the last update
+		std::vector<uint8_t> m_changed; ///<1 if the world matrix changed in the last update
+		std::vector<VESceneNode *> m_nodes; ///<The node of each entry, nullptr for freed entries
+		std::vector<uint32_t> m_levels = { 0, 0 }; ///<Start index of each level, the last value is the number of nodes in the graph
+		std::atomic<bool> m_structureChanged = true; ///<The entries must be sorted again
+		std::shared_mutex m_mutex; ///<Shared for accessing entries, exclusive for allocating and sorting
+
+		void sort(VESceneNode *pRoot); //sort the entries by depth
+
+	public:
+		///Constructor
+		VETransformHierarchy() {};
+
+		///Destructor
+		~VETransformHierarchy() {};
+
+		uint32_t allocate(VESceneNode *pNode, const glm::mat4 &transform); //create an entry for a new node
+		void release(uint32_t idx); //free the entry of a deleted node
+
+		/**
+			* \param[in] idx Index of the entry
+			* \returns the local to parent transform
+			*/
+		glm::mat4 getLocal(uint32_t idx)
+		{
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			return m_local[idx];
+		};
+
+		/**
+			* \brief Set the local to parent transform and mark the entry as dirty
+			* \param[in] idx Index of the entry
+			* \param[in] transform The new transform
+			*/
+		void setLocal(uint32_t idx, const glm::mat4 &transform)
+		{
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			m_local[idx] = transform;
+			std::atomic_ref<uint8_t>(m_dirty[idx]).store(1, std::memory_order_relaxed);
+		};
+
+		/**
+			* \brief Mark an entry as dirty, so its world matrix and the world matrices of its subtree are recomputed
+			* \param[in] idx Index of the entry
+			*/
+		void setDirty(uint32_t idx)
+		{
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			std::atomic_ref<uint8_t>(m_dirty[idx]).store(1, std::memory_order_relaxed);
+		};
+
+		///Tell the hierarchy that nodes were added, removed or moved, so the entries are sorted in the next update
+		void setStructureChanged()
+		{
+			m_structureChanged = true;
+		};
+
+		bool update(VESceneNode *pRoot, VEJobSystem *pJobSystem, bool force); //compute the world matrices
+
+		//-------------------------------------------------------------------------------------
+		//Results of the last update, the entries must not change while they are read
+
+		///\returns the number of nodes in the scene graph, they have the indices 0 to getNumNodes()-1
+		uint32_t getNumNodes()
+		{
+			return m_levels.back();
+		};
+
+		///\returns the node of an entry
+		VESceneNode *getNode(uint32_t idx)
+		{
+			return m_nodes[idx];
+		};
+
+		///\returns the world matrix of an entry
+		const glm::mat4 &getWorld(uint32_t idx)
+		{
+			return m_world[idx];
+		};
+
+		///\returns whether the world matrix of an entry changed in the last update
+		bool isChanged(uint32_t idx)
+		{
+			return m_changed[idx] != 0;
+		};
+
+		/**
+			* \brief Treat an entry as changed in the last update, so its node is updated although it did not move
+			* \param[in] idx Index of the entry
+			*/
+		void setChanged(uint32_t idx)
+		{
+			m_changed[idx] = 1;
+		};
+	};
+
+} // namespace ve
+
+#endif
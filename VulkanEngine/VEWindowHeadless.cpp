@@ -0,0 +1,70 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VEInclude.h"
+
+namespace ve
+{
+	/**
+		*
+		* \brief Initialize the headless window
+		*
+		* \param[in] width Width of the offscreen images
+		* \param[in] height Height of the offscreen images
+		*
+		*/
+	void VEWindowHeadless::initWindow(int width, int height)
+	{
+		m_extent = { (uint32_t)width, (uint32_t)height };
+		m_frame = 0;
+		m_startTime = vh::vhTimeNow();
+	}
+
+	/**
+		*
+		* \brief Return the required instance extensions
+		*
+		* No surface is created, but the engine loads the surface functions of the instance, so the
+		* surface extension is still needed. It does not depend on a window system.
+		*
+		* \returns a list holding the surface extension
+		*
+		*/
+	std::vector<const char *> VEWindowHeadless::getRequiredInstanceExtensions()
+	{
+		return { VK_KHR_SURFACE_EXTENSION_NAME };
+	}
+
+	/**
+		* \brief Leave the surface empty, the renderer then draws into offscreen images
+		* \param[in] instance The Vulkan instance
+		* \param[out] pSurface  Pointer to the surface, is set to VK_NULL_HANDLE
+		* \returns false, since no surface is created
+		*/
+	bool VEWindowHeadless::createSurface(VkInstance instance, VkSurfaceKHR *pSurface)
+	{
+		*pSurface = VK_NULL_HANDLE;
+		return false;
+	}
+
+	/**
+		*
+		* \brief Count the frames and end the render loop if the frames or the time are used up
+		*
+		* Called once per loop. The loop still finishes the current frame after being ended.
+		*
+		*/
+	void VEWindowHeadless::pollEvents()
+	{
+		m_frame++;
+		if (m_numFrames > 0 && m_frame >= m_numFrames)
+			getEnginePointer()->end();
+		if (m_duration > 0.0 && vh::vhTimeDuration(m_startTime) >= m_duration)
+			getEnginePointer()->end();
+	}
+
+} // namespace ve
@@ -0,0 +1,65 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#ifndef VEWINDOWHEADLESS_H
+#define VEWINDOWHEADLESS_H
+
+namespace ve
+{
+	class VEEngine;
+
+	/**
+		*
+		* \brief A window without a display, for benchmarking
+		*
+		* The window does not create a surface, so the renderer draws into offscreen images instead of a swapchain.
+		* There is no input, instead the window ends the render loop after a given number of frames or a given time.
+		*
+		*/
+	class VEWindowHeadless : public VEWindow
+	{
+		friend VEEngine;
+
+	protected:
+		VkExtent2D m_extent = { 0, 0 }; ///<Size of the offscreen images
+		uint32_t m_numFrames = 0; ///<Number of frames to render, 0 for no limit
+		double m_duration = 0.0; ///<Time to render (s), 0 for no limit
+		uint32_t m_frame = 0; ///<Number of frames rendered so far
+		std::chrono::high_resolution_clock::time_point m_startTime; ///<Time the window was created
+
+		virtual void initWindow(int width, int height); //set the size of the offscreen images
+		virtual std::vector<const char *>
+			getRequiredInstanceExtensions(); //return the surface extension only
+		virtual bool createSurface(VkInstance instance, VkSurfaceKHR *pSurface); //no surface
+		virtual void pollEvents(); //end the render loop when the frames or the time are used up
+
+	public:
+		///Constructor
+		VEWindowHeadless(uint32_t numFrames = 0, double duration = 0.0)
+			: VEWindow()
+			, m_numFrames(numFrames)
+			, m_duration(duration) {};
+
+		///Destructor
+		~VEWindowHeadless() {};
+
+		///\returns the size of the offscreen images
+		virtual VkExtent2D getExtent()
+		{
+			return m_extent;
+		};
+
+		///\returns the number of frames rendered so far
+		uint32_t getFrameCount()
+		{
+			return m_frame;
+		};
+	};
+
+} // namespace ve
+
+#endif
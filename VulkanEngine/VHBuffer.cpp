@@ -76,10 +76,11 @@ namespace vh
 	* \param[in] layerCount Number of image layers
 	* \param[in] aspectFlags Flags for how to use the view
 	* \param[out] imageView The created image view
+	* \param[in] mipLevels Number of mip levels seen by the view
 	* \returns VK_SUCCESS or a Vulkan error code
 	*
 	*/
-	VkResult vhBufCreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageViewType viewtype, uint32_t layerCount, VkImageAspectFlags aspectFlags, VkImageView *imageView)
+	VkResult vhBufCreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageViewType viewtype, uint32_t layerCount, VkImageAspectFlags aspectFlags, VkImageView *imageView, uint32_t mipLevels)
 	{
 		VkImageViewCreateInfo viewInfo = {};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -88,7 +89,7 @@ namespace vh
 		viewInfo.format = format;
 		viewInfo.subresourceRange.aspectMask = aspectFlags;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = layerCount;
 
@@ -159,6 +160,37 @@ namespace vh
 			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 	}
 
+	/**
+	* \brief Create an image and a view that compute shaders write and other shaders sample
+	*
+	* The image is left in VK_IMAGE_LAYOUT_GENERAL, which allows both.
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] allocator VMA allocator
+	* \param[in] graphicsQueue Device queue for submitting commands
+	* \param[in] commandPool Command pool for allocating command bbuffers
+	* \param[in] extent Extent of the image
+	* \param[in] format Image format, must support storage images
+	* \param[out] image The new image
+	* \param[out] imageAllocation VMA allocation info
+	* \param[out] imageView View of the image
+	* \returns VK_SUCCESS or a Vulkan error code
+	*/
+	VkResult vhBufCreateStorageImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, VkExtent2D extent, VkFormat format, VkImage *image, VmaAllocation *imageAllocation, VkImageView *imageView)
+	{
+		VHCHECKRESULT(vhBufCreateImage(allocator, extent.width, extent.height, 1, 1,
+			format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 0,
+			image, imageAllocation));
+
+		VHCHECKRESULT(vh::vhBufCreateImageView(device, *image, format, VK_IMAGE_VIEW_TYPE_2D, 1, VK_IMAGE_ASPECT_COLOR_BIT,
+			imageView));
+
+		return vhBufTransitionImageLayout(device, graphicsQueue, commandPool,
+			*image, format, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
 	//-------------------------------------------------------------------------------------------------------
 	/**
 	* \brief Create a Vulkan image using VMA
@@ -490,35 +522,111 @@ namespace vh
 	VkResult
 		vhBufCreateTextureImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, std::string basedir, std::vector<std::string> texNames, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent)
 	{
-		struct image_data
-		{
-			VkDeviceSize imageSize = 0;
-			stbi_uc *pixels;
-			int texWidth, texHeight, texChannels;
-		};
+		std::vector<vhImageData> imageData;
+		VkResult result = vhBufLoadImageData(basedir, texNames, imageData);
+		if (result != VK_SUCCESS)
+			return result;
 
-		std::vector<image_data> imageData;
-		imageData.resize(texNames.size());
-		VkDeviceSize imageSize = 0;
+		return vhBufCreateTextureImage(device, allocator, graphicsQueue, commandPool, imageData, flags,
+			textureImage, textureImageAllocation, extent);
+	}
+
+	/**
+	* \brief Decode image files into RGBA pixels
+	*
+	* Does not use any Vulkan object, so it can be called from any thread.
+	*
+	* \param[in] basedir Directoy the files are in
+	* \param[in] texNames List of file names holding the textures
+	* \param[out] images The decoded images, one for each file
+	* \returns VK_SUCCESS or VK_INCOMPLETE if a file could not be decoded
+	*
+	*/
+	VkResult vhBufLoadImageData(std::string basedir, std::vector<std::string> texNames, std::vector<vhImageData> &images)
+	{
+		images.resize(texNames.size());
 
 		for (uint32_t i = 0; i < texNames.size(); i++)
 		{
 			std::string filename = basedir + "/" + texNames[i];
-			imageData[i].pixels = stbi_load(filename.c_str(), &imageData[i].texWidth, &imageData[i].texHeight,
-				&imageData[i].texChannels, STBI_rgb_alpha);
+			int texChannels;
+			stbi_uc *pixels = stbi_load(filename.c_str(), &images[i].width, &images[i].height,
+				&texChannels, STBI_rgb_alpha);
 
-			if (imageData[i].pixels == nullptr)
+			if (pixels == nullptr)
 			{
 				return VK_INCOMPLETE;
 			}
 
-			imageData[i].imageSize += imageData[i].texWidth * imageData[i].texHeight * 4;
-			imageSize += imageData[i].imageSize;
+			images[i].pixels.assign(pixels, pixels + (size_t)images[i].width * images[i].height * 4);
+			stbi_image_free(pixels);
+		}
+		return VK_SUCCESS;
+	}
 
-			if (!imageData[i].pixels)
-			{
-				return VK_INCOMPLETE;
-			}
+	/**
+	* \brief Test whether a file is a KTX or DDS texture container
+	*
+	* \param[in] texName Name of the file
+	* \returns true if the file must be loaded with vhBufLoadTextureData() instead of vhBufLoadImageData()
+	*
+	*/
+	bool vhBufIsTextureFile(std::string texName)
+	{
+		size_t pos = texName.find_last_of('.');
+		if (pos == std::string::npos)
+			return false;
+
+		std::string ext = texName.substr(pos + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		return ext == "ktx" || ext == "dds";
+	}
+
+	/**
+	* \brief Load a KTX or DDS file with all its layers, faces and mip levels
+	*
+	* The data is not decoded, so block compressed formats stay compressed.
+	* Does not use any Vulkan object, so it can be called from any thread.
+	*
+	* \param[in] basedir Directoy the file is in
+	* \param[in] texName Name of the file
+	* \param[out] texture The loaded texture
+	* \returns VK_SUCCESS or VK_INCOMPLETE if the file could not be loaded
+	*
+	*/
+	VkResult vhBufLoadTextureData(std::string basedir, std::string texName, gli::texture &texture)
+	{
+		texture = gli::load(basedir + "/" + texName);
+		if (texture.empty())
+			return VK_INCOMPLETE;
+
+		return VK_SUCCESS;
+	}
+
+	/**
+	* \brief Create a texture image from decoded images
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] allocator The VMA allocator
+	* \param[in] graphicsQueue Device queue for submitting commands
+	* \param[in] commandPool Command pool for allocating command buffers
+	* \param[in] images List of decoded images, become the layers of the texture (should have same resolution)
+	* \param[in] flags Image create flags
+	* \param[out] textureImage The new image
+	* \param[out] textureImageAllocation The VMA allocation info
+	* \param[out] extent The extent of the image
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateTextureImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, std::vector<vhImageData> &images, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent)
+	{
+		if (images.size() == 0)
+			return VK_INCOMPLETE;
+
+		VkDeviceSize imageSize = 0;
+		for (auto &image : images)
+		{
+			imageSize += image.pixels.size();
 		}
 
 		VkBuffer stagingBuffer;
@@ -531,11 +639,10 @@ namespace vh
 		/*gli::byte*/ unsigned char *memPointer;
 		VHCHECKRESULT(vmaMapMemory(allocator, stagingBufferAllocation, (void **)&mappedData));
 		memPointer = mappedData;
-		for (auto image : imageData)
+		for (auto &image : images)
 		{
-			memcpy(memPointer, image.pixels, static_cast<size_t>(image.imageSize));
-			memPointer += image.imageSize;
-			stbi_image_free(image.pixels);
+			memcpy(memPointer, image.pixels.data(), image.pixels.size());
+			memPointer += image.pixels.size();
 		}
 		vmaUnmapMemory(allocator, stagingBufferAllocation);
 
@@ -543,7 +650,7 @@ namespace vh
 		std::vector<VkBufferImageCopy> bufferCopyRegions;
 		uint32_t offset = 0, mipLevels = 1;
 
-		for (uint32_t face = 0; face < imageData.size(); face++)
+		for (uint32_t face = 0; face < images.size(); face++)
 		{
 			for (uint32_t level = 0; level < mipLevels; level++)
 			{
@@ -552,40 +659,39 @@ namespace vh
 				bufferCopyRegion.imageSubresource.mipLevel = level;
 				bufferCopyRegion.imageSubresource.baseArrayLayer = face;
 				bufferCopyRegion.imageSubresource.layerCount = 1;
-				bufferCopyRegion.imageExtent.width = imageData[face].texWidth;
-				bufferCopyRegion.imageExtent.height = imageData[face].texHeight;
+				bufferCopyRegion.imageExtent.width = images[face].width;
+				bufferCopyRegion.imageExtent.height = images[face].height;
 				bufferCopyRegion.imageExtent.depth = 1;
 				bufferCopyRegion.bufferOffset = offset;
 
 				bufferCopyRegions.push_back(bufferCopyRegion);
 
 				// Increase offset into staging buffer for next level / face
-				offset += (uint32_t)
-					imageData[face]
-					.imageSize;
+				offset += (uint32_t)images[face].pixels.size();
 			}
 		}
 
-		VHCHECKRESULT(vhBufCreateImage(allocator, imageData[0].texWidth, imageData[0].texHeight, 1,
-			(uint32_t)imageData.size(),
+		VHCHECKRESULT(vhBufCreateImage(allocator, images[0].width, images[0].height, 1,
+			(uint32_t)images.size(),
 			VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			flags, textureImage, textureImageAllocation));
+		*extent = { (uint32_t)images[0].width, (uint32_t)images[0].height };
 
 		VHCHECKRESULT(vhBufTransitionImageLayout(device, graphicsQueue, commandPool, *textureImage,
 			VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels,
-			(uint32_t)imageData.size(),
+			(uint32_t)images.size(),
 			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
 
 		VHCHECKRESULT(vhBufCopyBufferToImage(device, graphicsQueue, commandPool, stagingBuffer,
 			*textureImage, bufferCopyRegions,
-			static_cast<uint32_t>(imageData[0].texWidth),
-			static_cast<uint32_t>(imageData[0].texHeight)));
+			static_cast<uint32_t>(images[0].width),
+			static_cast<uint32_t>(images[0].height)));
 
 		VHCHECKRESULT(vhBufTransitionImageLayout(device, graphicsQueue, commandPool, *textureImage,
 			VK_FORMAT_R8G8B8A8_UNORM,
 			VK_IMAGE_ASPECT_COLOR_BIT, mipLevels,
-			(uint32_t)imageData.size(),
+			(uint32_t)images.size(),
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
 
@@ -710,10 +816,12 @@ namespace vh
 	*
 	* \param[in] device Logical Vulkan device
 	* \param[out] textureSampler The new sampler
+	* \param[in] mipLevels Number of mip levels of the sampled images
+	* \param[in] maxAnisotropy Maximum anisotropy, must not exceed the device limit
 	* \returns VK_SUCCESS or a Vulkan error code
 	*
 	*/
-	VkResult vhBufCreateTextureSampler(VkDevice device, VkSampler *textureSampler)
+	VkResult vhBufCreateTextureSampler(VkDevice device, VkSampler *textureSampler, uint32_t mipLevels, float maxAnisotropy)
 	{
 		VkSamplerCreateInfo samplerInfo = {};
 		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -723,16 +831,34 @@ namespace vh
 		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		samplerInfo.anisotropyEnable = VK_TRUE;
-		samplerInfo.maxAnisotropy = 16;
+		samplerInfo.maxAnisotropy = maxAnisotropy;
 		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 		samplerInfo.unnormalizedCoordinates = VK_FALSE;
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = (float)mipLevels;
 
 		return vkCreateSampler(device, &samplerInfo, nullptr, textureSampler);
 	}
 
+	/**
+	* \brief Compute the length of a full mip chain
+	*
+	* \param[in] width Width of the largest level
+	* \param[in] height Height of the largest level
+	* \returns the number of mip levels down to 1x1
+	*
+	*/
+	uint32_t vhBufMipLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+			levels++;
+		return levels;
+	}
+
 	/**
 	* \brief Create framebuffers (color + depth), one for each swap chain image
 	*
@@ -781,10 +907,8 @@ namespace vh
 	}
 
 	/**
-	* \brief Create framebuffers (position, normal, albedo, depth), one for each swap chain image
+	* \brief Create framebuffers (normal, albedo, depth), one for each swap chain image
 	* \param[in] device Logical Vulkan device
-	* \param[in] imageViews Color images from the swap chain
-	* \param[in] positionImageViews List with views of the position images
 	* \param[in] normalImageViews List with views of the normal images
 	* \param[in] albedoImageViews List with views of the albedo images
 	* \param[in] depthImageViews List with views of the depth images
@@ -793,8 +917,7 @@ namespace vh
 	* \param[out] frameBuffers The resulting frame buffers
 	*/
 	VkResult vhBufCreateFramebuffersOffscreen(VkDevice device,
-		std::vector<VkImageView> positionImageViews,
-		std::vector<VkImageView> normalImageViews, //should have same length!
+		std::vector<VkImageView> normalImageViews,
 		std::vector<VkImageView> albedoImageViews, //should have same length!
 		std::vector<VkImageView> depthImageViews, //should have same length!
 		VkRenderPass renderPass,
@@ -808,15 +931,13 @@ namespace vh
 		framebufferInfo.height = extent.height;
 		framebufferInfo.layers = 1;
 
-		uint32_t loops = (uint32_t)std::max(positionImageViews.size(), depthImageViews.size());
+		uint32_t loops = (uint32_t)std::max(normalImageViews.size(), depthImageViews.size());
 		frameBuffers.resize(loops);
 
 		for (size_t i = 0; i < loops; i++)
 		{
 			std::vector<VkImageView> attachments;
 
-			if (positionImageViews.size() > i && positionImageViews[i] != VK_NULL_HANDLE)
-				attachments.push_back(positionImageViews[i]);
 			if (normalImageViews.size() > i && normalImageViews[i] != VK_NULL_HANDLE)
 				attachments.push_back(normalImageViews[i]);
 			if (albedoImageViews.size() > i && albedoImageViews[i] != VK_NULL_HANDLE)
@@ -96,7 +96,7 @@ namespace vh
 		* \brief Find suitable queue families of a given physical device
 		*
 		* \param[in] device A physical device
-		* \param[in] surface The surface of a window
+		* \param[in] surface The surface of a window, or VK_NULL_HANDLE if there is none, then the graphics family also presents
 		* \returns a structure containing queue family indices of suitable families
 		*
 		*/
@@ -119,7 +119,11 @@ namespace vh
 			}
 
 			VkBool32 presentSupport = false;
-			if (vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport) != VK_SUCCESS)
+			if (surface == VK_NULL_HANDLE)
+			{ //rendering without a window, frames are not presented
+				presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+			}
+			else if (vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport) != VK_SUCCESS)
 			{
 				indices.graphicsFamily = -1;
 				indices.presentFamily = -1;
@@ -221,8 +225,8 @@ namespace vh
 
 		bool extensionsSupported = checkDeviceExtensionSupport(device, requiredDeviceExtensions);
 
-		bool swapChainAdequate = false;
-		if (extensionsSupported)
+		bool swapChainAdequate = surface == VK_NULL_HANDLE; //without a window there is no swapchain
+		if (extensionsSupported && !swapChainAdequate)
 		{
 			SwapChainSupportDetails swapChainSupport = vhDevQuerySwapChainSupport(device, surface);
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -352,7 +356,7 @@ namespace vh
 		* \param[out] device The new logical device
 		* \param[out] graphicsQueue A graphics queue into the device
 		* \param[out] presentQueue A present queue into the device
-		* \returns VK_SUCCESS or a Vulkan error code
+		* \returns VK_SUCCESS or a Vulkan error code, VK_ERROR_FEATURE_NOT_PRESENT if the device lacks timeline semaphores or descriptor indexing
 		*
 		*/
 	VkResult vhDevCreateLogicalDevice(VkInstance instance, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, std::vector<const char *> requiredDeviceExtensions, std::vector<const char *> requiredValidationLayers, void *pNextChain, VkDevice *device, VkQueue *graphicsQueue, VkQueue *presentQueue)
@@ -381,8 +385,49 @@ namespace vh
 		deviceFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
 		deviceFeatures.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
 
-		VkPhysicalDeviceDescriptorIndexingFeaturesEXT ext = {};
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect; //optional, needed for indirect drawing
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+		deviceFeatures.geometryShader = supportedFeatures.geometryShader; //optional, needed for single pass cube shadow maps
+		deviceFeatures.multiViewport = supportedFeatures.multiViewport;
+
+		//the timeline semaphores of the upload ring and the descriptor indexing of the bindless material table are required
+		VkPhysicalDeviceTimelineSemaphoreFeatures supportedTimeline = {};
+		supportedTimeline.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedIndexing = {};
+		supportedIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		supportedIndexing.pNext = &supportedTimeline;
+		VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+		supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures2.pNext = &supportedIndexing;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+
+		if (!supportedTimeline.timelineSemaphore)
+		{
+			std::cout << "Error! The device does not support timeline semaphores\n";
+			return VK_ERROR_FEATURE_NOT_PRESENT;
+		}
+		if (!supportedIndexing.shaderSampledImageArrayNonUniformIndexing ||
+			!supportedIndexing.descriptorBindingSampledImageUpdateAfterBind ||
+			!supportedIndexing.descriptorBindingUpdateUnusedWhilePending || !supportedIndexing.descriptorBindingPartiallyBound)
+		{
+			std::cout << "Error! The device does not support the descriptor indexing features of the material table\n";
+			return VK_ERROR_FEATURE_NOT_PRESENT;
+		}
+
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {}; //needed by the upload ring
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timelineFeatures.timelineSemaphore = VK_TRUE;
+		timelineFeatures.pNext = pNextChain;
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT ext = {}; //needed by the bindless material table
 		ext.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		ext.pNext = &timelineFeatures;
+		ext.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		ext.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		ext.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		ext.descriptorBindingPartiallyBound = VK_TRUE;
 		//ext.runtimeDescriptorArray = VK_TRUE;
 
 		VkDeviceCreateInfo createInfo = {};
@@ -397,7 +442,7 @@ namespace vh
 		{
 			physicalDeviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
 			physicalDeviceFeatures2.features = deviceFeatures;
-			physicalDeviceFeatures2.pNext = pNextChain;
+			physicalDeviceFeatures2.pNext = &ext;
 			createInfo.pEnabledFeatures = nullptr;
 			createInfo.pNext = &physicalDeviceFeatures2;
 		}
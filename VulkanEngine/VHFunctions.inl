@@ -49,6 +49,7 @@ VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceProperties)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceProperties2)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceFormatProperties)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceFeatures)
+VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceFeatures2)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceQueueFamilyProperties)
 VK_INSTANCE_LEVEL_FUNCTION(vkCreateDevice)
 VK_INSTANCE_LEVEL_FUNCTION(vkGetDeviceProcAddr)
@@ -85,6 +86,8 @@ VK_INSTANCE_LEVEL_FUNCTION(vkGetPhysicalDeviceMemoryProperties)
 VK_DEVICE_LEVEL_FUNCTION(vkInvalidateMappedMemoryRanges)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdBindIndexBuffer)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdDrawIndexed)
+VK_DEVICE_LEVEL_FUNCTION(vkCmdDrawIndexedIndirect)
+VK_DEVICE_LEVEL_FUNCTION(vkCmdDrawIndexedIndirectCountKHR)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdTraceRaysNV)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdSetBlendConstants)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateCommandPool)
@@ -104,6 +107,8 @@ VK_DEVICE_LEVEL_FUNCTION(vkQueueSubmit)
 VK_DEVICE_LEVEL_FUNCTION(vkFreeCommandBuffers)
 VK_DEVICE_LEVEL_FUNCTION(vkDestroyCommandPool)
 VK_DEVICE_LEVEL_FUNCTION(vkDestroySemaphore)
+VK_DEVICE_LEVEL_FUNCTION(vkWaitSemaphores)
+VK_DEVICE_LEVEL_FUNCTION(vkGetSemaphoreCounterValue)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateSwapchainKHR)
 VK_DEVICE_LEVEL_FUNCTION(vkGetSwapchainImagesKHR)
 VK_DEVICE_LEVEL_FUNCTION(vkAcquireNextImageKHR)
@@ -115,10 +120,13 @@ VK_DEVICE_LEVEL_FUNCTION(vkCreateFramebuffer)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateShaderModule)
 VK_DEVICE_LEVEL_FUNCTION(vkCreatePipelineLayout)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateGraphicsPipelines)
+VK_DEVICE_LEVEL_FUNCTION(vkCreateComputePipelines)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdBeginRenderPass)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdNextSubpass)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdBindPipeline)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdDraw)
+VK_DEVICE_LEVEL_FUNCTION(vkCmdDispatch)
+VK_DEVICE_LEVEL_FUNCTION(vkCmdFillBuffer)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdEndRenderPass)
 VK_DEVICE_LEVEL_FUNCTION(vkDestroyShaderModule)
 VK_DEVICE_LEVEL_FUNCTION(vkDestroyPipelineLayout)
@@ -148,6 +156,7 @@ VK_DEVICE_LEVEL_FUNCTION(vkGetImageMemoryRequirements)
 VK_DEVICE_LEVEL_FUNCTION(vkBindImageMemory)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateSampler)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdCopyBufferToImage)
+VK_DEVICE_LEVEL_FUNCTION(vkCmdBlitImage)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateDescriptorSetLayout)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateDescriptorPool)
 VK_DEVICE_LEVEL_FUNCTION(vkAllocateDescriptorSets)
@@ -173,7 +182,6 @@ VK_DEVICE_LEVEL_FUNCTION(vkGetRayTracingShaderGroupHandlesNV)
 VK_DEVICE_LEVEL_FUNCTION(vkGetBufferDeviceAddress)
 VK_DEVICE_LEVEL_FUNCTION(vkGetAccelerationStructureBuildSizesKHR)
 VK_DEVICE_LEVEL_FUNCTION(vkCreateAccelerationStructureKHR)
-VK_DEVICE_LEVEL_FUNCTION(vkGetPhysicalDeviceFeatures2)
 VK_DEVICE_LEVEL_FUNCTION(vkCmdBuildAccelerationStructuresKHR)
 VK_DEVICE_LEVEL_FUNCTION(vkGetAccelerationStructureDeviceAddressKHR)
 VK_DEVICE_LEVEL_FUNCTION(vkDestroyAccelerationStructureKHR)
@@ -10,13 +10,19 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <random>
 #include <set>
@@ -30,6 +36,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtx/hash.hpp>
 #include <glm/gtx/transform.hpp>
 
@@ -43,10 +50,9 @@
 
 #include "vk_mem_alloc.h"
 
-#include <ThreadPool.h>
 #include <stb_image.h>
 #include <stb_image_write.h>
-//#include <gli/gli.hpp>
+#include <gli/gli.hpp>
 //#include "CLInclude.h"
 
 #include <assimp/Importer.hpp>
@@ -151,6 +157,79 @@ namespace vh
 		}
 	};
 
+	/**
+		*
+		* \brief Compact vertex format with 20 instead of 60 bytes per vertex
+		*
+		* The position is stored as unorm16 relative to the bounding box of the mesh, the shaders
+		* decode it with the offset and scale stored in the entity UBO. Normal and tangent are
+		* octahedral encoded as snorm16, texture coordinates are half floats.
+		*
+		*/
+	struct vhVertexPacked
+	{
+		uint16_t pos[4]; ///<Position relative to the mesh bounds as unorm16, the fourth component is padding
+		int16_t normal[2]; ///<Octahedral encoded normal vector as snorm16
+		int16_t tangent[2]; ///<Octahedral encoded tangent vector as snorm16
+		uint16_t texCoord[2]; ///<Texture coordinates as half floats
+
+		///\returns the binding description of this vertex data structure
+		static VkVertexInputBindingDescription getBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(vhVertexPacked);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		///\returns the vertex attribute description of the vertex data
+		static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+			attributeDescriptions[0].offset = offsetof(vhVertexPacked, pos);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[1].offset = offsetof(vhVertexPacked, normal);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[2].offset = offsetof(vhVertexPacked, tangent);
+
+			attributeDescriptions[3].binding = 0;
+			attributeDescriptions[3].location = 3;
+			attributeDescriptions[3].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[3].offset = offsetof(vhVertexPacked, texCoord);
+
+			return attributeDescriptions;
+		}
+	};
+
+	///decoded pixels of one image file, always 4 bytes RGBA per pixel
+	struct vhImageData
+	{
+		int width = 0; ///<Width in pixels
+		int height = 0; ///<Height in pixels
+		std::vector<unsigned char> pixels; ///<RGBA pixel data
+	};
+
+	///statistics of a mesh optimization
+	struct vhMeshStats
+	{
+		uint32_t vertexCountBefore = 0; ///<Number of vertices before the optimization
+		uint32_t vertexCountAfter = 0; ///<Number of vertices after the optimization
+		float acmrBefore = 0.0f; ///<Average cache miss ratio before the optimization
+		float acmrAfter = 0.0f; ///<Average cache miss ratio after the optimization
+	};
+
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//structures for managing blocks of memory in the GPU
 
@@ -166,18 +245,37 @@ namespace vh
 		VkDescriptorPool descriptorPool; ///<Descriptor pool
 		VkDescriptorSetLayout descriptorLayout; ///<Descriptor layout
 		std::vector<VkDescriptorSet> descriptorSets; ///<Descriptor sets for UBO
+		VkDescriptorSetLayout descriptorLayoutStorage = VK_NULL_HANDLE; ///<Descriptor layout for accessing the whole block as storage buffer, optional
+		std::vector<VkDescriptorSet> descriptorSetsStorage; ///<Descriptor sets for accessing the whole block as storage buffer
+
+		std::vector<void *> mappedMemory; ///<persistently mapped pointers to the buffers
 
 		int8_t *pMemory; ///<pointer to the host memory containing a copy of the block
 		uint32_t maxNumEntries; ///<maximum number of entries
 		uint32_t sizeEntry; ///<length of one entry
 		std::vector<vhMemoryHandle *> handles = {}; ///<list of pointers to the entry handles
-		std::vector<bool> dirty; ///<if dirty this block needs to be updated
+		std::atomic<uint32_t> changedFirst = std::numeric_limits<uint32_t>::max(); ///<first entry changed since the last upload
+		std::atomic<uint32_t> changedLast = 0; ///<one past the last entry changed since the last upload
+		std::vector<uint32_t> dirtyFirst; ///<first entry that must be copied into a buffer, one for each buffer
+		std::vector<uint32_t> dirtyLast; ///<one past the last entry that must be copied into a buffer, one for each buffer
+
+		/**
+			* \brief Mark a range of entries as dirty, can be called from several threads
+			* \param[in] first First dirty entry
+			* \param[in] last One past the last dirty entry
+			*/
+		void setDirty(uint32_t first, uint32_t last)
+		{
+			uint32_t old = changedFirst;
+			while (first < old && !changedFirst.compare_exchange_weak(old, first));
+			old = changedLast;
+			while (last > old && !changedLast.compare_exchange_weak(old, last));
+		};
 
 		///mark all UBO blocks as dirty
 		void setDirty()
 		{
-			for (auto d : dirty)
-				d = true; //mark as dirty
+			setDirty(0, maxNumEntries);
 		};
 	};
 
@@ -195,6 +293,40 @@ namespace vh
 		};
 	};
 
+	//--------------------------------------------------------------------------------------------------------------------------------
+	//structures for uploading data into GPU only buffers and images
+
+	///A batch of copy commands that is submitted at once
+	struct vhUploadBatch
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE; ///<Command buffer holding the copies, VK_NULL_HANDLE if the batch is empty
+		uint64_t value = 0; ///<Timeline semaphore value that is signalled when the batch is done
+		uint64_t end = 0; ///<Ring position after the last byte used by this batch
+		std::vector<VkBuffer> buffers; ///<Dedicated staging buffers for uploads larger than the ring
+		std::vector<VmaAllocation> allocations; ///<VMA allocations of the dedicated staging buffers
+	};
+
+	///A persistently mapped staging ring, collecting many uploads into one submission
+	struct vhUploadRing
+	{
+		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE; ///<Physical device, for querying format features
+		VkDevice device = VK_NULL_HANDLE; ///<Logical device
+		VmaAllocator allocator = nullptr; ///<VMA allocator
+		VkQueue queue = VK_NULL_HANDLE; ///<Queue the batches are submitted to
+		VkCommandPool commandPool = VK_NULL_HANDLE; ///<Command pool owned by the ring
+		VkBuffer buffer = VK_NULL_HANDLE; ///<The staging ring buffer
+		VmaAllocation allocation = nullptr; ///<VMA allocation of the ring buffer
+		unsigned char *pData = nullptr; ///<Persistently mapped pointer to the ring buffer
+		VkDeviceSize size = 0; ///<Size of the ring in bytes
+		uint64_t head = 0; ///<Number of bytes ever allocated from the ring
+		uint64_t tail = 0; ///<Number of bytes ever given back to the ring
+		VkSemaphore semaphore = VK_NULL_HANDLE; ///<Timeline semaphore counting finished batches
+		uint64_t submittedValue = 0; ///<Semaphore value of the last submitted batch
+		vhUploadBatch current; ///<The batch that is currently recorded
+		std::deque<vhUploadBatch> pending; ///<Submitted batches that may still be running on the GPU
+		std::mutex mutex; ///<Uploads can be issued by several threads
+	};
+
 	// Ray tracing structures
 	struct vhRayTracingScratchBuffer
 	{
@@ -257,6 +389,8 @@ namespace vh
 
 	QueueFamilyIndices vhDevFindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
 
+	bool checkDeviceExtensionSupport(VkPhysicalDevice device, std::vector<const char *> requiredDeviceExtensions);
+
 	VkFormat vhDevFindSupportedFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
 	VkFormat vhDevFindDepthFormat(VkPhysicalDevice physicalDevice);
@@ -279,6 +413,14 @@ namespace vh
 
 	VkResult vhSwapCreateSwapChain(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkDevice device, VkExtent2D frameBufferExtent, VkSwapchainKHR *swapChain, std::vector<VkImage> &swapChainImages, std::vector<VkImageView> &swapChainImageViews, VkFormat *swapChainImageFormat, VkExtent2D *swapChainExtent);
 
+	VkResult vhSwapCreateOffscreenImages(VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator allocator, VkExtent2D frameBufferExtent, uint32_t imageCount, std::vector<VkImage> &swapChainImages, std::vector<VmaAllocation> &allocations, std::vector<VkImageView> &swapChainImageViews, VkFormat *swapChainImageFormat, VkExtent2D *swapChainExtent);
+
+	void vhSwapDestroyOffscreenImages(VmaAllocator allocator, std::vector<VkImage> &swapChainImages, std::vector<VmaAllocation> &allocations);
+
+	VkResult vhSwapAcquireOffscreenImage(VkQueue queue, uint32_t imageCount, VkSemaphore signalSemaphore, uint32_t *imageIndex);
+
+	VkResult vhSwapPresentOffscreenImage(VkQueue queue, VkSemaphore waitSemaphore);
+
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//buffer
 	VkResult vhBufCreateBuffer(VmaAllocator
@@ -293,12 +435,14 @@ namespace vh
 	VkResult vhBufCopyBuffer(VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
 	VkResult
-		vhBufCreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageViewType viewtype, uint32_t layerCount, VkImageAspectFlags aspectFlags, VkImageView *imageView);
+		vhBufCreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageViewType viewtype, uint32_t layerCount, VkImageAspectFlags aspectFlags, VkImageView *imageView, uint32_t mipLevels = 1);
 
 	VkResult vhBufCreateDepthResources(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, VkExtent2D swapChainExtent, VkFormat depthFormat, VkImage *depthImage, VmaAllocation *depthImageAllocation, VkImageView *depthImageView);
 
 	VkResult vhBufCreateOffscreenResources(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, VkExtent2D extent, VkFormat format, VkImage *image, VmaAllocation *colorImageAllocation, VkImageView *colorImageView);
 
+	VkResult vhBufCreateStorageImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, VkExtent2D extent, VkFormat format, VkImage *image, VmaAllocation *imageAllocation, VkImageView *imageView);
+
 	VkResult vhBufCreateImage(VmaAllocator
 		allocator,
 		uint32_t width,
@@ -331,12 +475,22 @@ namespace vh
 	VkResult
 		vhBufCreateTextureImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, std::string basedir, std::vector<std::string> names, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent);
 
+	VkResult vhBufCreateTextureImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, std::vector<vhImageData> &images, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent);
+
+	VkResult vhBufLoadImageData(std::string basedir, std::vector<std::string> names, std::vector<vhImageData> &images);
+
+	bool vhBufIsTextureFile(std::string texName);
+
+	VkResult vhBufLoadTextureData(std::string basedir, std::string texName, gli::texture &texture);
+
 	//VkResult vhBufCreateTexturecubeImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, gli::texture_cube &cube, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkFormat *pformat);
-	VkResult vhBufCreateTextureSampler(VkDevice device, VkSampler *textureSampler);
+	VkResult vhBufCreateTextureSampler(VkDevice device, VkSampler *textureSampler, uint32_t mipLevels = 1, float maxAnisotropy = 16.0f);
+
+	uint32_t vhBufMipLevels(uint32_t width, uint32_t height);
 
 	VkResult vhBufCreateFramebuffers(VkDevice device, std::vector<VkImageView> imageViews, std::vector<VkImageView> depthImageViews, VkRenderPass renderPass, VkExtent2D extent, std::vector<VkFramebuffer> &frameBuffers);
 
-	VkResult vhBufCreateFramebuffersOffscreen(VkDevice device, std::vector<VkImageView> positionImageViews, std::vector<VkImageView> normalImageViews, std::vector<VkImageView> albedoImageViews, std::vector<VkImageView> depthImageViews, VkRenderPass renderPass, VkExtent2D extent, std::vector<VkFramebuffer> &frameBuffers);
+	VkResult vhBufCreateFramebuffersOffscreen(VkDevice device, std::vector<VkImageView> normalImageViews, std::vector<VkImageView> albedoImageViews, std::vector<VkImageView> depthImageViews, VkRenderPass renderPass, VkExtent2D extent, std::vector<VkFramebuffer> &frameBuffers);
 
 	VkResult vhBufCopySwapChainImageToHost(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, VkImage image, VkFormat format, VkImageAspectFlagBits aspect, VkImageLayout layout,
 		/*gli::byte*/ unsigned char *bufferData,
@@ -367,15 +521,15 @@ namespace vh
 	//rendering
 	VkResult vhRenderCreateRenderPass(VkDevice device, VkFormat swapChainImageFormat, VkFormat depthFormat, VkAttachmentLoadOp loadOp, VkRenderPass *renderPass, VkImageLayout colorAttachmentFinalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 
-	VkResult vhRenderCreateRenderPassOffscreen(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPassOffscreen(VkDevice device, VkFormat normalFormat, VkFormat albedoFormat, VkFormat depthFormat, VkRenderPass *renderPass);
 
 	VkResult vhRenderCreateRenderPassRayTracing(VkDevice device, VkFormat swapChainImageFormat, VkFormat depthFormat, VkRenderPass *renderPass);
 
-	VkResult vhRenderCreateRenderPassShadow(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPassShadow(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass, VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED);
 
-	VkResult vhRenderCreateDescriptorSetLayout(VkDevice device, std::vector<uint32_t> counts, std::vector<VkDescriptorType> types, std::vector<VkShaderStageFlags> stageFlags, VkDescriptorSetLayout *descriptorSetLayout);
+	VkResult vhRenderCreateDescriptorSetLayout(VkDevice device, std::vector<uint32_t> counts, std::vector<VkDescriptorType> types, std::vector<VkShaderStageFlags> stageFlags, VkDescriptorSetLayout *descriptorSetLayout, VkDescriptorBindingFlags bindingFlags = 0);
 
-	VkResult vhRenderCreateDescriptorPool(VkDevice device, std::vector<VkDescriptorType> types, std::vector<uint32_t> numberDesc, VkDescriptorPool *descriptorPool);
+	VkResult vhRenderCreateDescriptorPool(VkDevice device, std::vector<VkDescriptorType> types, std::vector<uint32_t> numberDesc, VkDescriptorPool *descriptorPool, VkDescriptorPoolCreateFlags flags = 0);
 
 	VkResult vhRenderCreateDescriptorSets(VkDevice device, uint32_t numberDesc, VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool descriptorPool, std::vector<VkDescriptorSet> &descriptorSets);
 
@@ -409,6 +563,8 @@ namespace vh
 		extent,
 		VkSubpassContents subPassContents);
 
+	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer, std::vector<VkClearValue> &clearValues, VkRect2D renderArea, VkSubpassContents subPassContents);
+
 	VkResult vhRenderPresentResult(VkQueue presentQueue, VkSwapchainKHR swapChain, uint32_t imageIndex, VkSemaphore signalSemaphore);
 
 	VkResult
@@ -416,9 +572,11 @@ namespace vh
 
 	VkShaderModule vhPipeCreateShaderModule(VkDevice device, const std::vector<char> &code);
 
-	VkResult vhPipeCreateGraphicsPipeline(VkDevice device, std::vector<std::string> shaderFileNames, VkExtent2D swapChainExtent, VkPipelineLayout pipelineLayout, VkRenderPass renderPass, std::vector<VkDynamicState> dynamicStates, VkPipeline *graphicsPipeline, VkCullModeFlags cullMode = VK_CULL_MODE_NONE, int32_t blendAttachmentSize = 1);
+	VkResult vhPipeCreateGraphicsPipeline(VkDevice device, std::vector<std::string> shaderFileNames, VkExtent2D swapChainExtent, VkPipelineLayout pipelineLayout, VkRenderPass renderPass, std::vector<VkDynamicState> dynamicStates, VkPipeline *graphicsPipeline, VkCullModeFlags cullMode = VK_CULL_MODE_NONE, int32_t blendAttachmentSize = 1, bool packedVertices = false);
+
+	VkResult vhPipeCreateGraphicsShadowPipeline(VkDevice device, std::string verShaderFilename, VkExtent2D shadowMapExtent, VkPipelineLayout pipelineLayout, VkRenderPass renderPass, VkPipeline *graphicsPipeline, bool packedVertices = false, std::vector<VkDynamicState> dynamicStates = {}, std::string geomShaderFilename = "", uint32_t viewportCount = 1);
 
-	VkResult vhPipeCreateGraphicsShadowPipeline(VkDevice device, std::string verShaderFilename, VkExtent2D shadowMapExtent, VkPipelineLayout pipelineLayout, VkRenderPass renderPass, VkPipeline *graphicsPipeline);
+	VkResult vhPipeCreateComputePipeline(VkDevice device, std::string compShaderFilename, VkPipelineLayout pipelineLayout, VkPipeline *computePipeline);
 
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//file
@@ -459,9 +617,9 @@ namespace vh
 	VkResult vhMemCreateVMAAllocator(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator &allocator);
 
 	//Memory blocks
-	VkResult vhMemBlockListInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, std::vector<vhMemoryBlock *> &blocklist);
+	VkResult vhMemBlockListInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, std::vector<vhMemoryBlock *> &blocklist, VkDescriptorSetLayout descriptorLayoutStorage = VK_NULL_HANDLE);
 
-	VkResult vhMemBlockInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, vhMemoryBlock *pBlock);
+	VkResult vhMemBlockInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, vhMemoryBlock *pBlock, VkDescriptorSetLayout descriptorLayoutStorage = VK_NULL_HANDLE);
 
 	VkResult vhMemBlockListAdd(std::vector<vhMemoryBlock *> &blocklist, void *owner, vhMemoryHandle *handle);
 
@@ -469,7 +627,7 @@ namespace vh
 
 	VkResult vhMemBlockUpdateEntry(vhMemoryHandle *pHandle, void *data);
 
-	VkResult vhMemBlockUpdateBlockList(std::vector<vhMemoryBlock *> &blocklist, uint32_t index);
+	VkResult vhMemBlockUpdateBlockList(std::vector<vhMemoryBlock *> &blocklist, uint32_t index, VkDeviceSize *pBytesCopied = nullptr);
 
 	VkResult vhMemBlockRemoveEntry(vhMemoryHandle *pHandle);
 
@@ -477,6 +635,52 @@ namespace vh
 
 	VkResult vhMemBlockDeallocate(vhMemoryBlock *pBlock);
 
+	//--------------------------------------------------------------------------------------------------------------------------------
+	//upload
+	VkResult vhUploadInit(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, VmaAllocator allocator, VkQueue queue, VkDeviceSize size, vhUploadRing *pRing);
+
+	VkResult vhUploadBuffer(vhUploadRing *pRing, const void *pData, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+	VkResult vhUploadImage(vhUploadRing *pRing, std::vector<vhImageData> &images, VkImage image, VkFormat format, uint32_t mipLevels = 1);
+
+	VkResult vhUploadSubmit(vhUploadRing *pRing, uint64_t *pValue = nullptr);
+
+	VkResult vhUploadWait(vhUploadRing *pRing, uint64_t value);
+
+	VkResult vhUploadFinish(vhUploadRing *pRing);
+
+	VkResult vhUploadDeinit(vhUploadRing *pRing);
+
+	VkResult vhBufCreateVertexBuffer(VmaAllocator allocator, vhUploadRing *pRing, std::vector<vh::vhVertex> &vertices, VkBuffer *vertexBuffer, VmaAllocation *vertexBufferAllocation);
+
+	VkResult vhBufCreateVertexBuffer(VmaAllocator allocator, vhUploadRing *pRing, const vh::vhVertex *pVertices, uint32_t vertexCount, VkBuffer *vertexBuffer, VmaAllocation *vertexBufferAllocation);
+
+	VkResult vhBufCreateVertexBuffer(VmaAllocator allocator, vhUploadRing *pRing, const vh::vhVertexPacked *pVertices, uint32_t vertexCount, VkBuffer *vertexBuffer, VmaAllocation *vertexBufferAllocation);
+
+	VkResult vhBufCreateIndexBuffer(VmaAllocator allocator, vhUploadRing *pRing, std::vector<uint32_t> &indices, VkBuffer *indexBuffer, VmaAllocation *indexBufferAllocation);
+
+	VkResult vhBufCreateIndexBuffer(VmaAllocator allocator, vhUploadRing *pRing, const void *pIndices, uint32_t indexCount, VkIndexType indexType, VkBuffer *indexBuffer, VmaAllocation *indexBufferAllocation);
+
+	VkResult vhBufCreateTextureImage(VmaAllocator allocator, vhUploadRing *pRing, std::vector<vhImageData> &images, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent, uint32_t *mipLevels);
+
+	VkResult vhUploadTexture(vhUploadRing *pRing, gli::texture &texture, VkImage image, VkFormat format);
+
+	VkResult vhBufCreateTextureImage(VmaAllocator allocator, vhUploadRing *pRing, gli::texture &texture, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent, uint32_t *mipLevels, VkFormat *format);
+
+	//--------------------------------------------------------------------------------------------------------------------------------
+	//mesh
+	void vhMeshWeldVertices(std::vector<vhVertex> &vertices, std::vector<uint32_t> &indices);
+
+	void vhMeshOptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+	void vhMeshOptimizeVertexFetch(std::vector<vhVertex> &vertices, std::vector<uint32_t> &indices);
+
+	float vhMeshACMR(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+	void vhMeshOptimize(std::vector<vhVertex> &vertices, std::vector<uint32_t> &indices, vhMeshStats *pStats = nullptr);
+
+	void vhMeshPackVertices(const vhVertex *pVertices, uint32_t vertexCount, std::vector<vhVertexPacked> &packed, glm::vec4 &dequantize);
+
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//ray tracing
 	vhRayTracingScratchBuffer vhCreateScratchBuffer(VkDevice device, VmaAllocator vmaAllocator, VkDeviceSize size);
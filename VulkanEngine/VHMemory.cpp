@@ -75,16 +75,17 @@ namespace vh
 		* \param[in] sizeEntry Size of an entry in bytes
 		* \param[in] numBuffers Number of buffers (one for each framebuffer)
 		* \param[in] blocklist A reference to the memory block list
+		* \param[in] descriptorLayoutStorage If not null, also create descriptor sets for indexing the whole block as storage buffer
 		* \returns VK_SUCCESS or a Vulkan error code
 		*
 		*/
-	VkResult vhMemBlockListInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, std::vector<vhMemoryBlock *> &blocklist)
+	VkResult vhMemBlockListInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, std::vector<vhMemoryBlock *> &blocklist, VkDescriptorSetLayout descriptorLayoutStorage)
 	{
 		if (blocklist.empty())
 		{
 			vhMemoryBlock *pBlock = new vhMemoryBlock;
 			VHCHECKRESULT(vhMemBlockInit(device, allocator, descriptorPool, descriptorLayout, maxNumEntries, sizeEntry,
-				numBuffers, pBlock));
+				numBuffers, pBlock, descriptorLayoutStorage));
 			blocklist.push_back(pBlock);
 		}
 		return VK_SUCCESS;
@@ -102,25 +103,34 @@ namespace vh
 		* \param[in] sizeEntry Size of an entry in bytes
 		* \param[in] numBuffers Number of buffers (one for each framebuffer)
 		* \param[in] pBlock A pointer to the memory block
+		* \param[in] descriptorLayoutStorage If not null, also create descriptor sets for indexing the whole block as storage buffer
 		* \returns VK_SUCCESS or a Vulkan error code
 		*
 		*/
-	VkResult vhMemBlockInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, vhMemoryBlock *pBlock)
+	VkResult vhMemBlockInit(VkDevice device, VmaAllocator allocator, VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorLayout, uint32_t maxNumEntries, uint32_t sizeEntry, uint32_t numBuffers, vhMemoryBlock *pBlock, VkDescriptorSetLayout descriptorLayoutStorage)
 	{
 		pBlock->device = device; //needed for creating descriptor sets
 		pBlock->allocator = allocator; //needed for allocating buffers
 		pBlock->descriptorPool = descriptorPool; //for creating descriptor sets
 		pBlock->descriptorLayout = descriptorLayout; //for creating descriptor sets
+		pBlock->descriptorLayoutStorage = descriptorLayoutStorage; //for creating storage buffer descriptor sets
 
 		pBlock->pMemory = new int8_t[sizeEntry * maxNumEntries]; //allocate host memory
 		pBlock->maxNumEntries = maxNumEntries; //max number of entries in a block
 		pBlock->sizeEntry = sizeEntry; //size of an entry (a UBO)
-		pBlock->dirty.resize(
-			numBuffers); //flags for determining whether to update GPU buffers from host buffer
-		pBlock->setDirty(); //default is dirty -> update the next time
+		pBlock->dirtyFirst.assign(numBuffers, 0); //ranges for determining which part of the GPU buffers to update
+		pBlock->dirtyLast.assign(numBuffers, maxNumEntries); //default is dirty -> update the next time
+		pBlock->changedFirst = std::numeric_limits<uint32_t>::max(); //nothing changed since then
+		pBlock->changedLast = 0;
 
 		VHCHECKRESULT(vhBufCreateUniformBuffers(allocator, numBuffers, sizeEntry * maxNumEntries, pBlock->buffers,
 			pBlock->allocations));
+
+		pBlock->mappedMemory.resize(numBuffers);
+		for (uint32_t i = 0; i < numBuffers; i++)
+		{ //buffers stay mapped for the whole lifetime of the block
+			VHCHECKRESULT(vmaMapMemory(allocator, pBlock->allocations[i], &pBlock->mappedMemory[i]));
+		}
 		auto result = vhRenderCreateDescriptorSets(device, numBuffers, descriptorLayout, descriptorPool,
 			pBlock->descriptorSets);
 		VHCHECKRESULT(result);
@@ -133,6 +143,21 @@ namespace vh
 				{ {VK_NULL_HANDLE} }, { {VK_NULL_HANDLE} }));
 		}
 
+		if (descriptorLayoutStorage == VK_NULL_HANDLE)
+			return VK_SUCCESS;
+
+		pBlock->descriptorSetsStorage.clear();
+		VHCHECKRESULT(vhRenderCreateDescriptorSets(device, numBuffers, descriptorLayoutStorage, descriptorPool,
+			pBlock->descriptorSetsStorage));
+
+		for (uint32_t i = 0; i < numBuffers; i++)
+		{ //shaders can index all entries of the block, e.g. with gl_InstanceIndex
+			VHCHECKRESULT(vhRenderUpdateDescriptorSet(device, pBlock->descriptorSetsStorage[i],
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+				{ pBlock->buffers[i] }, { sizeEntry * maxNumEntries },
+				{ {VK_NULL_HANDLE} }, { {VK_NULL_HANDLE} }));
+		}
+
 		return VK_SUCCESS;
 	}
 
@@ -170,7 +195,8 @@ namespace vh
 				blocklist[0]->descriptorLayout,
 				blocklist[0]->maxNumEntries,
 				blocklist[0]->sizeEntry,
-				(uint32_t)blocklist[0]->buffers.size(), pMemBlock));
+				(uint32_t)blocklist[0]->buffers.size(), pMemBlock,
+				blocklist[0]->descriptorLayoutStorage));
 
 			blocklist.push_back(pMemBlock); //add the new mem block to the block list
 		}
@@ -206,13 +232,14 @@ namespace vh
 			pBlock->maxNumEntries *= 2; //double the capacity
 			for (uint32_t i = 0; i < pBlock->buffers.size(); i++)
 			{ //destroy the old Vulkan buffers
+				vmaUnmapMemory(pBlock->allocator, pBlock->allocations[i]);
 				vmaDestroyBuffer(pBlock->allocator, pBlock->buffers[i], pBlock->allocations[i]);
 			}
 
 			VHCHECKRESULT(vhMemBlockInit(pBlock->device, pBlock->allocator,
 				pBlock->descriptorPool, pBlock->descriptorLayout,
 				pBlock->maxNumEntries, pBlock->sizeEntry,
-				(uint32_t)pBlock->buffers.size(), pBlock));
+				(uint32_t)pBlock->buffers.size(), pBlock, pBlock->descriptorLayoutStorage));
 
 			memcpy(pBlock->pMemory, pOldMem, oldSize); //copy old data to the new buffer
 			delete[] pOldMem; //deallocate the old buffer memory
@@ -237,7 +264,7 @@ namespace vh
 	VkResult vhMemBlockUpdateEntry(vhMemoryHandle *pHandle, void *data)
 	{
 		memcpy(pHandle->getPointer(), data, pHandle->pMemBlock->sizeEntry);
-		pHandle->pMemBlock->setDirty();
+		pHandle->pMemBlock->setDirty(pHandle->entryIndex, pHandle->entryIndex + 1);
 		return VK_SUCCESS;
 	}
 
@@ -245,23 +272,43 @@ namespace vh
 		*
 		* \brief Update all memory blocks by copying them to the GPU
 		*
+		* Entries changed since the last call are added to the dirty ranges of all buffers.
+		* Then only the dirty range of the given buffer is copied into its persistently mapped memory.
+		*
 		* \param[in] blocklist The memory blocks
 		* \param[in] index The index of the buffer to use
+		* \param[out] pBytesCopied If not null, the number of bytes copied is added to this counter
 		* \returns VK_SUCCESS or a Vulkan error code
 		*
 		*/
-	VkResult vhMemBlockUpdateBlockList(std::vector<vhMemoryBlock *> &blocklist, uint32_t index)
+	VkResult vhMemBlockUpdateBlockList(std::vector<vhMemoryBlock *> &blocklist, uint32_t index, VkDeviceSize *pBytesCopied)
 	{
 		for (auto pBlock : blocklist)
 		{ //go through all blocks
-			if (pBlock->dirty[index])
+			uint32_t changedFirst = pBlock->changedFirst.exchange(std::numeric_limits<uint32_t>::max());
+			uint32_t changedLast = pBlock->changedLast.exchange(0);
+			if (changedFirst < changedLast)
+			{ //all buffers need the changed entries
+				for (uint32_t i = 0; i < pBlock->buffers.size(); i++)
+				{
+					pBlock->dirtyFirst[i] = std::min(pBlock->dirtyFirst[i], changedFirst);
+					pBlock->dirtyLast[i] = std::max(pBlock->dirtyLast[i], changedLast);
+				}
+			}
+
+			uint32_t first = pBlock->dirtyFirst[index];
+			uint32_t last = std::min(pBlock->dirtyLast[index], (uint32_t)pBlock->handles.size()); //unused entries are not needed
+			if (first < last)
 			{ //update only if dirty
-				void *data = nullptr;
-				vmaMapMemory(pBlock->allocator, pBlock->allocations[index], &data); //map device to host memory
-				memcpy(data, pBlock->pMemory, pBlock->maxNumEntries * pBlock->sizeEntry); //copy host memory
-				vmaUnmapMemory(pBlock->allocator, pBlock->allocations[index]); //unmap
-				pBlock->dirty[index] = false; //no more dirty
+				VkDeviceSize offset = (VkDeviceSize)first * pBlock->sizeEntry;
+				VkDeviceSize size = (VkDeviceSize)(last - first) * pBlock->sizeEntry;
+				memcpy((int8_t *)pBlock->mappedMemory[index] + offset, pBlock->pMemory + offset, size); //copy host memory
+				vmaFlushAllocation(pBlock->allocator, pBlock->allocations[index], offset, size); //in case memory is not coherent
+				if (pBytesCopied != nullptr)
+					*pBytesCopied += size;
 			}
+			pBlock->dirtyFirst[index] = std::numeric_limits<uint32_t>::max(); //no more dirty
+			pBlock->dirtyLast[index] = 0;
 		}
 		return VK_SUCCESS;
 	}
@@ -290,8 +337,7 @@ namespace vh
 
 		pMemBlock->handles.pop_back(); //remove last handle, could also be identical to the removed one
 
-		for (auto d : pMemBlock->dirty)
-			d = true; //mark as dirty
+		pMemBlock->setDirty(idxEntry, idxEntry + 1); //only the moved entry changed
 
 		return VK_SUCCESS;
 	}
@@ -342,6 +388,7 @@ namespace vh
 		delete[] pBlock->pMemory;
 		for (uint32_t i = 0; i < pBlock->buffers.size(); i++)
 		{
+			vmaUnmapMemory(pBlock->allocator, pBlock->allocations[i]);
 			vmaDestroyBuffer(pBlock->allocator, pBlock->buffers[i], pBlock->allocations[i]);
 		}
 		delete pBlock;
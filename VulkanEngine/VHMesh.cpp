@@ -0,0 +1,402 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VHHelper.h"
+
+namespace vh
+{
+	//-------------------------------------------------------------------------------------------------------
+	//mesh optimization
+	//
+	//Assimp delivers triangle soups, where each triangle has its own three vertices.
+	//Welding identical vertices lets the GPU reuse transformed vertices from its post-transform cache,
+	//reordering the triangles increases the number of hits in this cache, and reordering the vertices
+	//makes the vertex fetches follow the index buffer.
+
+	const uint32_t VH_MESH_CACHE_SIZE = 32; ///<Size of the modelled cache when ordering triangles
+
+	///Hash of the bytes of a vertex, so that only exactly identical vertices are welded
+	struct vhVertexHash
+	{
+		size_t operator()(const vhVertex &vertex) const
+		{
+			const uint8_t *pData = (const uint8_t *)&vertex;
+			uint64_t hash = 14695981039346656037ull; //FNV-1a
+			for (size_t i = 0; i < sizeof(vhVertex); i++)
+			{
+				hash = (hash ^ pData[i]) * 1099511628211ull;
+			}
+			return (size_t)hash;
+		}
+	};
+
+	///Byte wise comparison of two vertices
+	struct vhVertexEqual
+	{
+		bool operator()(const vhVertex &v1, const vhVertex &v2) const
+		{
+			return memcmp(&v1, &v2, sizeof(vhVertex)) == 0;
+		}
+	};
+
+	/**
+		*
+		* \brief Weld identical vertices
+		*
+		* Vertices that are identical in all attributes are stored only once, the indices are changed accordingly.
+		*
+		* \param[in,out] vertices The vertices of the mesh
+		* \param[in,out] indices The indices of the mesh
+		*
+		*/
+	void vhMeshWeldVertices(std::vector<vhVertex> &vertices, std::vector<uint32_t> &indices)
+	{
+		std::unordered_map<vhVertex, uint32_t, vhVertexHash, vhVertexEqual> map;
+		map.reserve(vertices.size());
+
+		std::vector<uint32_t> remap(vertices.size());
+		std::vector<vhVertex> welded;
+		welded.reserve(vertices.size());
+		for (uint32_t i = 0; i < vertices.size(); i++)
+		{
+			auto result = map.insert({ vertices[i], (uint32_t)welded.size() });
+			if (result.second)
+				welded.push_back(vertices[i]);
+			remap[i] = result.first->second;
+		}
+
+		for (auto &index : indices)
+		{
+			index = remap[index];
+		}
+		vertices.swap(welded);
+	}
+
+	///\returns the score of a vertex, see Tom Forsyth, Linear-Speed Vertex Cache Optimisation
+	static float vhMeshVertexScore(int32_t cachePosition, uint32_t numActiveTriangles)
+	{
+		if (numActiveTriangles == 0)
+			return -1.0f; //no triangle needs this vertex any more
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				score = 0.75f; //vertices of the last triangle are punished a bit, to avoid long strips
+			else
+				score = powf(1.0f - (float)(cachePosition - 3) / (VH_MESH_CACHE_SIZE - 3), 1.5f);
+		}
+		return score + 2.0f * powf((float)numActiveTriangles, -0.5f); //prefer vertices with few triangles left
+	}
+
+	/**
+		*
+		* \brief Reorder the triangles of a mesh for the post-transform vertex cache
+		*
+		* Greedily emits the triangle with the best score, the score of a triangle is the sum of the
+		* scores of its vertices. The score of a vertex depends on its position in a modelled LRU cache,
+		* and on the number of its triangles that have not been emitted yet.
+		*
+		* \param[in,out] indices The triangle list of the mesh
+		* \param[in] vertexCount Number of vertices of the mesh
+		*
+		*/
+	void vhMeshOptimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount)
+	{
+		uint32_t numTriangles = (uint32_t)indices.size() / 3;
+		if (numTriangles == 0)
+			return;
+
+		//triangles of each vertex
+		std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+		for (auto index : indices)
+		{
+			triangleOffsets[index + 1]++;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		}
+		std::vector<uint32_t> vertexTriangles(indices.size());
+		std::vector<uint32_t> numActive(vertexCount, 0);
+		for (uint32_t t = 0; t < numTriangles; t++)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[3 * t + k];
+				vertexTriangles[triangleOffsets[v] + numActive[v]++] = t;
+			}
+		}
+
+		std::vector<float> vertexScore(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			vertexScore[v] = vhMeshVertexScore(-1, numActive[v]);
+		}
+
+		std::vector<float> triangleScore(numTriangles);
+		std::vector<bool> emitted(numTriangles, false);
+		for (uint32_t t = 0; t < numTriangles; t++)
+		{
+			triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+		}
+
+		std::vector<uint32_t> cache;
+		cache.reserve(VH_MESH_CACHE_SIZE + 3);
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		uint32_t nextTriangle = 0; //used when no cached vertex has a triangle left
+
+		int64_t best = -1;
+		for (uint32_t t = 0; t < numTriangles; t++)
+		{
+			if (best < 0 || triangleScore[t] > triangleScore[best])
+				best = t;
+		}
+
+		std::vector<uint32_t> newCache;
+		newCache.reserve(VH_MESH_CACHE_SIZE + 3);
+		while (best >= 0)
+		{
+			//emit the triangle, and remove it from the lists of its vertices
+			emitted[best] = true;
+			newCache.clear();
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[3 * best + k];
+				result.push_back(v);
+				if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+					newCache.push_back(v);
+
+				uint32_t *pTriangles = &vertexTriangles[triangleOffsets[v]];
+				for (uint32_t i = 0; i < numActive[v]; i++)
+				{
+					if (pTriangles[i] == best)
+					{
+						pTriangles[i] = pTriangles[--numActive[v]];
+						break;
+					}
+				}
+			}
+
+			//move the vertices of the triangle to the front of the cache
+			uint32_t numNew = (uint32_t)newCache.size();
+			for (auto v : cache)
+			{
+				if (std::find(newCache.begin(), newCache.begin() + numNew, v) == newCache.begin() + numNew)
+					newCache.push_back(v);
+			}
+			for (uint32_t i = VH_MESH_CACHE_SIZE; i < newCache.size(); i++)
+			{ //fell out of the cache
+				vertexScore[newCache[i]] = vhMeshVertexScore(-1, numActive[newCache[i]]);
+			}
+			newCache.resize(std::min((uint32_t)newCache.size(), VH_MESH_CACHE_SIZE));
+			cache.swap(newCache);
+
+			//update the scores of the cached vertices and their triangles, find the best one
+			for (uint32_t i = 0; i < cache.size(); i++)
+			{
+				vertexScore[cache[i]] = vhMeshVertexScore(i, numActive[cache[i]]);
+			}
+
+			best = -1;
+			for (auto v : cache)
+			{
+				uint32_t *pTriangles = &vertexTriangles[triangleOffsets[v]];
+				for (uint32_t i = 0; i < numActive[v]; i++)
+				{
+					uint32_t t = pTriangles[i];
+					triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+					if (best < 0 || triangleScore[t] > triangleScore[best])
+						best = t;
+				}
+			}
+
+			if (best < 0)
+			{ //no cached vertex has a triangle left, continue with the next triangle that has not been emitted
+				while (nextTriangle < numTriangles && emitted[nextTriangle])
+					nextTriangle++;
+				if (nextTriangle < numTriangles)
+					best = nextTriangle;
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	/**
+		*
+		* \brief Reorder the vertices of a mesh in the order they are first used by the indices
+		*
+		* Vertices that are not used by any index are removed.
+		*
+		* \param[in,out] vertices The vertices of the mesh
+		* \param[in,out] indices The indices of the mesh
+		*
+		*/
+	void vhMeshOptimizeVertexFetch(std::vector<vhVertex> &vertices, std::vector<uint32_t> &indices)
+	{
+		std::vector<uint32_t> remap(vertices.size(), std::numeric_limits<uint32_t>::max());
+		std::vector<vhVertex> result;
+		result.reserve(vertices.size());
+		for (auto &index : indices)
+		{
+			if (remap[index] == std::numeric_limits<uint32_t>::max())
+			{
+				remap[index] = (uint32_t)result.size();
+				result.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		vertices.swap(result);
+	}
+
+	/**
+		*
+		* \brief Compute the average cache miss ratio (ACMR) of a triangle list
+		*
+		* Simulates a FIFO post-transform cache, as found in most GPUs.
+		*
+		* \param[in] indices The triangle list
+		* \param[in] vertexCount Number of vertices of the mesh
+		* \param[in] cacheSize Number of vertices in the cache
+		* \returns the number of transformed vertices per triangle, between 0.5 (ideal) and 3
+		*
+		*/
+	float vhMeshACMR(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		if (indices.size() < 3)
+			return 0.0f;
+
+		std::vector<uint32_t> insertedAt(vertexCount, 0); //time of entering the cache, 0 means never
+		uint32_t misses = 0;
+		for (auto index : indices)
+		{
+			if (insertedAt[index] == 0 || misses - insertedAt[index] + 1 > cacheSize)
+			{
+				misses++;
+				insertedAt[index] = misses;
+			}
+		}
+		return (float)misses / (float)(indices.size() / 3);
+	}
+
+	/**
+		*
+		* \brief Optimize a mesh for rendering
+		*
+		* Welds identical vertices, reorders the triangles for the post-transform vertex cache,
+		* and reorders the vertices for fetch locality. Does not use any Vulkan object, so it can
+		* be called from any thread.
+		*
+		* \param[in,out] vertices The vertices of the mesh
+		* \param[in,out] indices The triangle list of the mesh
+		* \param[out] pStats If not nullptr, receives vertex counts and ACMR before and after the optimization
+		*
+		*/
+	void vhMeshOptimize(std::vector<vhVertex> &vertices, std::vector<uint32_t> &indices, vhMeshStats *pStats)
+	{
+		if (pStats != nullptr)
+		{
+			pStats->vertexCountBefore = (uint32_t)vertices.size();
+			pStats->acmrBefore = vhMeshACMR(indices, (uint32_t)vertices.size());
+		}
+
+		vhMeshWeldVertices(vertices, indices);
+		vhMeshOptimizeVertexCache(indices, (uint32_t)vertices.size());
+		vhMeshOptimizeVertexFetch(vertices, indices);
+
+		if (pStats != nullptr)
+		{
+			pStats->vertexCountAfter = (uint32_t)vertices.size();
+			pStats->acmrAfter = vhMeshACMR(indices, (uint32_t)vertices.size());
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	//vertex packing
+
+	///\returns a unit vector mapped onto the octahedron and unfolded into [-1,1]^2
+	static glm::vec2 vhMeshOctEncode(glm::vec3 v)
+	{
+		float l1 = fabs(v.x) + fabs(v.y) + fabs(v.z);
+		if (l1 == 0.0f)
+			return glm::vec2(0.0f, 0.0f);
+
+		v /= l1;
+		glm::vec2 e(v.x, v.y);
+		if (v.z < 0.0f)
+		{ //fold the lower half over the diagonals
+			e.x = (1.0f - fabs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+			e.y = (1.0f - fabs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return e;
+	}
+
+	///\returns a value in [-1,1] as snorm16
+	static int16_t vhMeshSnorm16(float f)
+	{
+		return (int16_t)roundf(glm::clamp(f, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	/**
+		*
+		* \brief Pack vertices into the compact vertex format
+		*
+		* Positions are quantized relative to the bounding box of the mesh, using the same scale for
+		* all axes. A shader gets the position back as dequantize.xyz + dequantize.w * pos.
+		*
+		* \param[in] pVertices Pointer to the vertices
+		* \param[in] vertexCount Number of vertices
+		* \param[out] packed The packed vertices
+		* \param[out] dequantize Offset (xyz) and scale (w) for decoding the positions
+		*
+		*/
+	void vhMeshPackVertices(const vhVertex *pVertices, uint32_t vertexCount, std::vector<vhVertexPacked> &packed, glm::vec4 &dequantize)
+	{
+		glm::vec3 minPos(0.0f), maxPos(0.0f);
+		if (vertexCount > 0)
+		{
+			minPos = maxPos = pVertices[0].pos;
+			for (uint32_t i = 1; i < vertexCount; i++)
+			{
+				minPos = glm::min(minPos, pVertices[i].pos);
+				maxPos = glm::max(maxPos, pVertices[i].pos);
+			}
+		}
+		glm::vec3 extent = maxPos - minPos;
+		float scale = std::max(extent.x, std::max(extent.y, extent.z));
+		if (scale == 0.0f)
+			scale = 1.0f;
+		dequantize = glm::vec4(minPos, scale);
+
+		packed.resize(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			const vhVertex &vertex = pVertices[i];
+			vhVertexPacked &p = packed[i];
+
+			glm::vec3 pos = glm::clamp((vertex.pos - minPos) / scale, 0.0f, 1.0f);
+			p.pos[0] = (uint16_t)roundf(pos.x * 65535.0f);
+			p.pos[1] = (uint16_t)roundf(pos.y * 65535.0f);
+			p.pos[2] = (uint16_t)roundf(pos.z * 65535.0f);
+			p.pos[3] = 0;
+
+			glm::vec2 normal = vhMeshOctEncode(vertex.normal);
+			p.normal[0] = vhMeshSnorm16(normal.x);
+			p.normal[1] = vhMeshSnorm16(normal.y);
+
+			glm::vec2 tangent = vhMeshOctEncode(vertex.tangent);
+			p.tangent[0] = vhMeshSnorm16(tangent.x);
+			p.tangent[1] = vhMeshSnorm16(tangent.y);
+
+			p.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+			p.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+		}
+	}
+
+} // namespace vh
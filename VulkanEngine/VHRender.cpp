@@ -99,27 +99,22 @@ namespace vh
 #/**
 	*
 	* \brief Create a render pass for a g-buffer pass
+	*
+	* The g-buffer holds normals, albedo and depth. Positions are reconstructed from the depth,
+	* so the depth is stored and left ready for sampling like the color attachments.
+	*
 	* \param[in] device The logical Vulkan device
-	* \param[in] swapChainImageFormat The swap chain image format
+	* \param[in] normalFormat The normal map image format
+	* \param[in] albedoFormat The albedo map image format
 	* \param[in] depthFormat The depth map image format
 	* \param[out] renderPass The new render pass
 	*
 	*/
 
-	VkResult vhRenderCreateRenderPassOffscreen(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass)
+	VkResult vhRenderCreateRenderPassOffscreen(VkDevice device, VkFormat normalFormat, VkFormat albedoFormat, VkFormat depthFormat, VkRenderPass *renderPass)
 	{
-		VkAttachmentDescription positionAttachment = {};
-		positionAttachment.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-		positionAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		positionAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		positionAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		positionAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		positionAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		positionAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		positionAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
 		VkAttachmentDescription normalAttachment = {};
-		normalAttachment.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+		normalAttachment.format = normalFormat;
 		normalAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		normalAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		normalAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -129,7 +124,7 @@ namespace vh
 		normalAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 		VkAttachmentDescription albedoAttachment = {};
-		albedoAttachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+		albedoAttachment.format = albedoFormat;
 		albedoAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		albedoAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		albedoAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -146,30 +141,24 @@ namespace vh
 		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-		std::array<VkAttachmentDescription, 4> attachments = { positionAttachment, normalAttachment, albedoAttachment,
-															  depthAttachment };
+		std::array<VkAttachmentDescription, 3> attachments = { normalAttachment, albedoAttachment, depthAttachment };
 
 		std::vector<VkAttachmentReference> colorReferences;
 
-		VkAttachmentReference positionAttachmentRef = {};
-		positionAttachmentRef.attachment = 0;
-		positionAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		colorReferences.push_back(positionAttachmentRef);
-
 		VkAttachmentReference normalAttachmentRef = {};
-		normalAttachmentRef.attachment = 1;
+		normalAttachmentRef.attachment = 0;
 		normalAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		colorReferences.push_back(normalAttachmentRef);
 
 		VkAttachmentReference albedoAttachmentRef = {};
-		albedoAttachmentRef.attachment = 2;
+		albedoAttachmentRef.attachment = 1;
 		albedoAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		colorReferences.push_back(albedoAttachmentRef);
 
 		VkAttachmentReference depthAttachmentRef = {};
-		depthAttachmentRef.attachment = 3;
+		depthAttachmentRef.attachment = 2;
 		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 		VkSubpassDescription subpass = {};
@@ -192,9 +181,9 @@ namespace vh
 		VkSubpassDependency dependency2 = {};
 		dependency2.srcSubpass = 0;
 		dependency2.dstSubpass = VK_SUBPASS_EXTERNAL;
-		dependency2.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency2.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 		dependency2.dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-		dependency2.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+		dependency2.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		dependency2.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
 		dependency2.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
@@ -287,13 +276,17 @@ namespace vh
 		*
 		* \brief Create a render pass for a shadow pass
 		*
+		* The depth is cleared only inside the render area. If the initial layout is not undefined, then the
+		* texels outside of the render area are kept, so that one map can hold several shadow maps as tiles.
+		*
 		* \param[in] device The logical Vulkan device
 		* \param[in] depthFormat The depth map image format
 		* \param[out] renderPass The new render pass
+		* \param[in] initialLayout Layout of the depth map when the render pass starts
 		* \returns VK_SUCCESS or a Vulkan error code
 		*
 		*/
-	VkResult vhRenderCreateRenderPassShadow(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass)
+	VkResult vhRenderCreateRenderPassShadow(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass, VkImageLayout initialLayout)
 	{
 		VkAttachmentDescription attachmentDescription{};
 		attachmentDescription.format = depthFormat;
@@ -302,7 +295,7 @@ namespace vh
 		attachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // We will read from depth, so it's important to store the depth attachment results
 		attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		attachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; // We don't care about initial layout of the attachment
+		attachmentDescription.initialLayout = initialLayout; // Undefined if the whole map is rendered
 		attachmentDescription.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // Attachment will be transitioned to shader read at render pass end
 
 		VkAttachmentReference depthReference = {};
@@ -356,6 +349,7 @@ namespace vh
 		* \param[in] types Contains the resource types for the increasing bindings
 		* \param[in] stageFlags Denotes in which stages they should be used
 		* \param[out] descriptorSetLayout The new descriptor set layout
+		* \param[in] bindingFlags Descriptor indexing flags for all bindings, e.g. for updating descriptors after binding the set
 		* \returns VK_SUCCESS or a Vulkan error code
 		*
 		*/
@@ -363,7 +357,8 @@ namespace vh
 		std::vector<uint32_t> counts,
 		std::vector<VkDescriptorType> types,
 		std::vector<VkShaderStageFlags> stageFlags,
-		VkDescriptorSetLayout *descriptorSetLayout)
+		VkDescriptorSetLayout *descriptorSetLayout,
+		VkDescriptorBindingFlags bindingFlags)
 	{
 		std::vector<VkDescriptorSetLayoutBinding> bindings;
 		bindings.resize(types.size());
@@ -382,6 +377,16 @@ namespace vh
 		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
 		layoutInfo.pBindings = bindings.data();
 
+		std::vector<VkDescriptorBindingFlags> flags(bindings.size(), bindingFlags);
+		VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = {};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		flagsInfo.bindingCount = static_cast<uint32_t>(flags.size());
+		flagsInfo.pBindingFlags = flags.data();
+		if (bindingFlags != 0)
+			layoutInfo.pNext = &flagsInfo;
+		if (bindingFlags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+			layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT; //sets must come from a pool created with the same flag
+
 		return vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, descriptorSetLayout);
 	}
 
@@ -393,13 +398,15 @@ namespace vh
 		* \param[in] types Contains the resource types in the pool
 		* \param[in] numberDesc Denotes how many of them are in the pool
 		* \param[out] descriptorPool The new descriptor pool
+		* \param[in] flags Additional creation flags, e.g. for sets whose descriptors are updated after binding
 		* \returns VK_SUCCESS or a Vulkan error code
 		*
 		*/
 	VkResult vhRenderCreateDescriptorPool(VkDevice device,
 		std::vector<VkDescriptorType> types,
 		std::vector<uint32_t> numberDesc,
-		VkDescriptorPool *descriptorPool)
+		VkDescriptorPool *descriptorPool,
+		VkDescriptorPoolCreateFlags flags)
 	{
 		std::vector<VkDescriptorPoolSize> poolSizes = {};
 		poolSizes.resize(types.size());
@@ -415,7 +422,7 @@ namespace vh
 		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
 		poolInfo.maxSets = numberDesc[0];
-		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT | flags;
 
 		return vkCreateDescriptorPool(device, &poolInfo, nullptr, descriptorPool);
 	}
@@ -544,18 +551,21 @@ namespace vh
 			}
 			else if (textureImageViews[i].size() > 0)
 			{
+				descriptorWrites[i].descriptorType = descriptorTypes.size() > i ? descriptorTypes[i] : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
 				for (uint32_t j = 0; j < textureImageViews[i].size(); j++)
 				{
 					VkDescriptorImageInfo imageInfo;
 
-					imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					//storage images are written by shaders, so they stay in the general layout
+					imageInfo.imageLayout = descriptorWrites[i].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ?
+						VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 					imageInfo.imageView = textureImageViews[i][j];
 					imageInfo.sampler = textureSamplers[i][j];
 
 					imageInfos[i].push_back(imageInfo);
 				}
 
-				descriptorWrites[i].descriptorType = descriptorTypes.size() > i ? descriptorTypes[i] : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 				descriptorWrites[i].pImageInfo = imageInfos[i].data();
 				descriptorWrites[i].descriptorCount = (uint32_t)
 					textureImageViews[i]
@@ -664,13 +674,37 @@ namespace vh
 		std::vector<VkClearValue> &clearValues,
 		VkExtent2D extent,
 		VkSubpassContents subPassContents)
+	{
+		VkRect2D renderArea = {};
+		renderArea.extent = extent;
+		return vhRenderBeginRenderPass(commandBuffer, renderPass, frameBuffer, clearValues, renderArea, subPassContents);
+	}
+
+	/**
+	*
+	* \brief Start rendering into a part of the framebuffer
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] renderPass The render pass that should be begun
+	* \param[in] frameBuffer The framebuffer for the render pass
+	* \param[in] clearValues A list of clear values to clear render targets
+	* \param[in] renderArea The texels that are rendered, only these are cleared
+	* \param[in] subPassContents Specifies whether cmd buffers are inline or use secondary bufers
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer,
+		VkRenderPass renderPass,
+		VkFramebuffer frameBuffer,
+		std::vector<VkClearValue> &clearValues,
+		VkRect2D renderArea,
+		VkSubpassContents subPassContents)
 	{
 		VkRenderPassBeginInfo renderPassInfo = {};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassInfo.renderPass = renderPass;
 		renderPassInfo.framebuffer = frameBuffer;
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = extent;
+		renderPassInfo.renderArea = renderArea;
 
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		if (clearValues.size() > 0)
@@ -777,6 +811,9 @@ namespace vh
 	* \param[in] renderPass Renderpass to be used
 	* \param[in] dynamicStates List of dynamic states that can be changed during usage of the pipeline
 	* \param[out] graphicsPipeline The new PSO
+	* \param[in] cullMode Faces to be culled
+	* \param[in] blendAttachmentSize Number of color attachments
+	* \param[in] packedVertices If true, the vertex input is vhVertexPacked instead of vhVertex
 	* \returns VK_SUCCESS or a Vulkan error code
 	*
 	*/
@@ -788,7 +825,8 @@ namespace vh
 		std::vector<VkDynamicState> dynamicStates,
 		VkPipeline *graphicsPipeline,
 		VkCullModeFlags cullMode,
-		int32_t blendAttachmentSize)
+		int32_t blendAttachmentSize,
+		bool packedVertices)
 	{
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
 
@@ -823,13 +861,22 @@ namespace vh
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-		auto bindingDescription = vhVertex::getBindingDescription();
+		auto bindingDescription = packedVertices ? vhVertexPacked::getBindingDescription() : vhVertex::getBindingDescription();
 		auto attributeDescriptions = vhVertex::getAttributeDescriptions();
+		auto attributeDescriptionsPacked = vhVertexPacked::getAttributeDescriptions();
 
 		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+		if (packedVertices)
+		{
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptionsPacked.size());
+			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptionsPacked.data();
+		}
+		else
+		{
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+		}
 
 		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -958,6 +1005,10 @@ namespace vh
 	* \param[in] pipelineLayout Pipeline layout
 	* \param[in] renderPass Renderpass to be used
 	* \param[out] graphicsPipeline The new PSO
+	* \param[in] packedVertices If true, the vertex input is vhVertexPacked instead of vhVertex
+	* \param[in] dynamicStates List of dynamic states, e.g. viewport and scissor for rendering into tiles of a shadow atlas
+	* \param[in] geomShaderFilename Name of an optional geometry shader file, e.g. for sending triangles to several viewports
+	* \param[in] viewportCount Number of viewports, if more than 1 then viewport and scissor must be dynamic states
 	* \returns VK_SUCCESS or a Vulkan error code
 	*
 	*/
@@ -966,11 +1017,16 @@ namespace vh
 		VkExtent2D shadowMapExtent,
 		VkPipelineLayout pipelineLayout,
 		VkRenderPass renderPass,
-		VkPipeline *graphicsPipeline)
+		VkPipeline *graphicsPipeline,
+		bool packedVertices,
+		std::vector<VkDynamicState> dynamicStates,
+		std::string geomShaderFilename,
+		uint32_t viewportCount)
 	{
 		auto vertShaderCode = vhFileRead(verShaderFilename);
 
 		VkShaderModule vertShaderModule = vhPipeCreateShaderModule(device, vertShaderCode);
+		VkShaderModule geomShaderModule = VK_NULL_HANDLE;
 
 		VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
 		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -978,18 +1034,40 @@ namespace vh
 		vertShaderStageInfo.module = vertShaderModule;
 		vertShaderStageInfo.pName = "main";
 
-		VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo };
+		VkPipelineShaderStageCreateInfo shaderStages[2] = { vertShaderStageInfo };
+		uint32_t stageCount = 1;
+
+		if (geomShaderFilename.size() > 0)
+		{
+			auto geomShaderCode = vhFileRead(geomShaderFilename);
+			geomShaderModule = vhPipeCreateShaderModule(device, geomShaderCode);
+
+			shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[1].stage = VK_SHADER_STAGE_GEOMETRY_BIT;
+			shaderStages[1].module = geomShaderModule;
+			shaderStages[1].pName = "main";
+			stageCount = 2;
+		}
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-		auto bindingDescription = vhVertex::getBindingDescription();
+		auto bindingDescription = packedVertices ? vhVertexPacked::getBindingDescription() : vhVertex::getBindingDescription();
 		auto attributeDescriptions = vhVertex::getAttributeDescriptions();
+		auto attributeDescriptionsPacked = vhVertexPacked::getAttributeDescriptions();
 
 		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+		if (packedVertices)
+		{
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptionsPacked.size());
+			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptionsPacked.data();
+		}
+		else
+		{
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+			vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+		}
 
 		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -1010,9 +1088,9 @@ namespace vh
 
 		VkPipelineViewportStateCreateInfo viewportState = {};
 		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
+		viewportState.viewportCount = viewportCount;
+		viewportState.pViewports = &viewport; //ignored if dynamic
+		viewportState.scissorCount = viewportCount;
 		viewportState.pScissors = &scissor;
 
 		VkPipelineRasterizationStateCreateInfo rasterizer = {};
@@ -1055,9 +1133,14 @@ namespace vh
 		colorBlending.blendConstants[2] = 0.0f;
 		colorBlending.blendConstants[3] = 0.0f;
 
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = (uint32_t)dynamicStates.size();
+		dynamicState.pDynamicStates = dynamicStates.data();
+
 		VkGraphicsPipelineCreateInfo pipelineInfo = {};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 1;
+		pipelineInfo.stageCount = stageCount;
 		pipelineInfo.pStages = shaderStages;
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
 		pipelineInfo.pInputAssemblyState = &inputAssembly;
@@ -1066,6 +1149,8 @@ namespace vh
 		pipelineInfo.pMultisampleState = &multisampling;
 		pipelineInfo.pDepthStencilState = &depthStencil;
 		pipelineInfo.pColorBlendState = &colorBlending;
+		if (dynamicStates.size() > 0)
+			pipelineInfo.pDynamicState = &dynamicState;
 		pipelineInfo.layout = pipelineLayout;
 		pipelineInfo.renderPass = renderPass;
 		pipelineInfo.subpass = 0;
@@ -1074,6 +1159,46 @@ namespace vh
 		VHCHECKRESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, graphicsPipeline));
 
 		vkDestroyShaderModule(device, vertShaderModule, nullptr);
+		if (geomShaderModule != VK_NULL_HANDLE)
+			vkDestroyShaderModule(device, geomShaderModule, nullptr);
+		return VK_SUCCESS;
+	}
+
+	/**
+	*
+	* \brief Create a pipeline state object (PSO) for a compute shader
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] compShaderFilename Name of the compute shader file
+	* \param[in] pipelineLayout Pipeline layout
+	* \param[out] computePipeline The new PSO
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhPipeCreateComputePipeline(VkDevice device,
+		std::string compShaderFilename,
+		VkPipelineLayout pipelineLayout,
+		VkPipeline *computePipeline)
+	{
+		auto compShaderCode = vhFileRead(compShaderFilename);
+
+		VkShaderModule compShaderModule = vhPipeCreateShaderModule(device, compShaderCode);
+
+		VkPipelineShaderStageCreateInfo compShaderStageInfo = {};
+		compShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		compShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		compShaderStageInfo.module = compShaderModule;
+		compShaderStageInfo.pName = "main";
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = compShaderStageInfo;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		VHCHECKRESULT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, computePipeline));
+
+		vkDestroyShaderModule(device, compShaderModule, nullptr);
 		return VK_SUCCESS;
 	}
 
@@ -174,4 +174,125 @@ namespace vh
 		}
 		return VK_SUCCESS;
 	}
+
+	//-------------------------------------------------------------------------------------------------------
+	//offscreen images for rendering without a window
+
+	/**
+		*
+		* \brief Create images that replace the swapchain when there is no window surface
+		*
+		* The images have the same format and usage as swapchain images, except that storage is only
+		* added if the format supports it.
+		*
+		* \param[in] physicalDevice The physical device
+		* \param[in] device Logical device
+		* \param[in] allocator VMA allocator
+		* \param[in] frameBufferExtent Extent of the images
+		* \param[in] imageCount Number of images
+		* \param[out] swapChainImages A list containing the new images
+		* \param[out] allocations VMA allocations of the images
+		* \param[out] swapChainImageViews A list containing the image views
+		* \param[out] swapChainImageFormat The image format
+		* \param[out] swapChainExtent The image extent
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhSwapCreateOffscreenImages(VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator allocator, VkExtent2D frameBufferExtent, uint32_t imageCount, std::vector<VkImage> &swapChainImages, std::vector<VmaAllocation> &allocations, std::vector<VkImageView> &swapChainImageViews, VkFormat *swapChainImageFormat, VkExtent2D *swapChainExtent)
+	{
+		VkFormat format = VK_FORMAT_B8G8R8A8_UNORM; //what chooseSwapSurfaceFormat() prefers
+
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+		if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+			usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+		swapChainImages.resize(imageCount);
+		allocations.resize(imageCount);
+		swapChainImageViews.resize(imageCount);
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			VHCHECKRESULT(vhBufCreateImage(allocator, frameBufferExtent.width, frameBufferExtent.height, 1, 1,
+				format, VK_IMAGE_TILING_OPTIMAL, usage, 0,
+				&swapChainImages[i], &allocations[i]));
+
+			VHCHECKRESULT(vhBufCreateImageView(device, swapChainImages[i], format,
+				VK_IMAGE_VIEW_TYPE_2D, 1, VK_IMAGE_ASPECT_COLOR_BIT,
+				&swapChainImageViews[i]));
+		}
+
+		*swapChainImageFormat = format;
+		*swapChainExtent = frameBufferExtent;
+		return VK_SUCCESS;
+	}
+
+	/**
+		*
+		* \brief Destroy the offscreen images, the image views must have been destroyed
+		*
+		* \param[in] allocator VMA allocator
+		* \param[in] swapChainImages The images, the list is emptied
+		* \param[in] allocations VMA allocations of the images, the list is emptied
+		*
+		*/
+	void vhSwapDestroyOffscreenImages(VmaAllocator allocator, std::vector<VkImage> &swapChainImages, std::vector<VmaAllocation> &allocations)
+	{
+		for (uint32_t i = 0; i < swapChainImages.size(); i++)
+		{
+			vmaDestroyImage(allocator, swapChainImages[i], allocations[i]);
+		}
+		swapChainImages.clear();
+		allocations.clear();
+	}
+
+	/**
+		*
+		* \brief Acquire the next offscreen image
+		*
+		* The images are used round robin. Like vkAcquireNextImageKHR(), the semaphore is signaled,
+		* so the renderers can wait for it as usual.
+		*
+		* \param[in] queue The queue that the frames are submitted to
+		* \param[in] imageCount Number of images
+		* \param[in] signalSemaphore Semaphore that is signaled when the image can be used
+		* \param[in,out] imageIndex Index of the last image, gets the index of the next image
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhSwapAcquireOffscreenImage(VkQueue queue, uint32_t imageCount, VkSemaphore signalSemaphore, uint32_t *imageIndex)
+	{
+		*imageIndex = (*imageIndex + 1) % imageCount;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &signalSemaphore;
+
+		return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+	}
+
+	/**
+		*
+		* \brief Finish an offscreen frame
+		*
+		* Nothing is presented, but like vkQueuePresentKHR() the semaphore is waited for, so it can be signaled again.
+		*
+		* \param[in] queue The queue that the frames are submitted to
+		* \param[in] waitSemaphore Semaphore that is signaled when the frame is done
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhSwapPresentOffscreenImage(VkQueue queue, VkSemaphore waitSemaphore)
+	{
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &waitSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+
+		return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+	}
 } // namespace vh
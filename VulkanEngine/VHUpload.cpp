@@ -0,0 +1,854 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#include "VHHelper.h"
+
+namespace vh
+{
+	//-------------------------------------------------------------------------------------------------------
+	//upload ring
+	//
+	//All copies into GPU only buffers and images are recorded into one command buffer, which is submitted
+	//once per frame (or when the ring is full). Each submission signals the next value of a timeline semaphore.
+	//The staging data is written into a persistently mapped ring buffer, and its space is given back as soon
+	//as the semaphore shows that the batch using it has finished.
+
+	const VkDeviceSize VH_UPLOAD_ALIGNMENT = 16; ///<Alignment of staging data, enough for all texel formats
+
+	/**
+		*
+		* \brief Create an upload ring
+		*
+		* \param[in] physicalDevice Physical Vulkan device
+		* \param[in] device Logical Vulkan device
+		* \param[in] surface Window surface, needed for finding the graphics queue family
+		* \param[in] allocator VMA allocator
+		* \param[in] queue Queue the uploads are submitted to, must be of the graphics family
+		* \param[in] size Size of the staging ring in bytes
+		* \param[out] pRing The ring to initialize
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadInit(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, VmaAllocator allocator, VkQueue queue, VkDeviceSize size, vhUploadRing *pRing)
+	{
+		pRing->physicalDevice = physicalDevice;
+		pRing->device = device;
+		pRing->allocator = allocator;
+		pRing->queue = queue;
+		pRing->size = size;
+		pRing->head = 0;
+		pRing->tail = 0;
+		pRing->submittedValue = 0;
+
+		VHCHECKRESULT(vhCmdCreateCommandPool(physicalDevice, device, surface, &pRing->commandPool));
+
+		VHCHECKRESULT(vhBufCreateBuffer(allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VMA_MEMORY_USAGE_CPU_ONLY, &pRing->buffer, &pRing->allocation));
+		VHCHECKRESULT(vmaMapMemory(allocator, pRing->allocation, (void **)&pRing->pData));
+
+		VkSemaphoreTypeCreateInfo typeInfo = {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		return vkCreateSemaphore(device, &semaphoreInfo, nullptr, &pRing->semaphore);
+	}
+
+	/**
+		*
+		* \brief Give back the resources of all batches the GPU has finished
+		*
+		* \param[in] pRing The upload ring
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	static VkResult vhUploadRetire(vhUploadRing *pRing)
+	{
+		if (pRing->pending.empty())
+			return VK_SUCCESS;
+
+		uint64_t value;
+		VHCHECKRESULT(vkGetSemaphoreCounterValue(pRing->device, pRing->semaphore, &value));
+
+		while (!pRing->pending.empty() && pRing->pending.front().value <= value)
+		{
+			vhUploadBatch &batch = pRing->pending.front();
+			pRing->tail = batch.end;
+			vkFreeCommandBuffers(pRing->device, pRing->commandPool, 1, &batch.commandBuffer);
+			for (uint32_t i = 0; i < batch.buffers.size(); i++)
+			{
+				vmaUnmapMemory(pRing->allocator, batch.allocations[i]);
+				vmaDestroyBuffer(pRing->allocator, batch.buffers[i], batch.allocations[i]);
+			}
+			pRing->pending.pop_front();
+		}
+		return VK_SUCCESS;
+	}
+
+	/**
+		*
+		* \brief Submit the current batch, the ring mutex must be locked
+		*
+		* \param[in] pRing The upload ring
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	static VkResult vhUploadSubmit2(vhUploadRing *pRing)
+	{
+		vhUploadBatch &batch = pRing->current;
+		if (batch.commandBuffer == VK_NULL_HANDLE)
+			return VK_SUCCESS;
+
+		//make all copies visible to every command that is submitted later to this queue
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VHCHECKRESULT(vkEndCommandBuffer(batch.commandBuffer));
+
+		batch.value = pRing->submittedValue + 1;
+		batch.end = pRing->head;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &batch.value;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &pRing->semaphore;
+
+		VHCHECKRESULT(vkQueueSubmit(pRing->queue, 1, &submitInfo, VK_NULL_HANDLE));
+
+		pRing->submittedValue = batch.value;
+		pRing->pending.push_back(std::move(batch));
+		pRing->current = {};
+		return VK_SUCCESS;
+	}
+
+	/**
+		*
+		* \brief Wait until a batch is done, the ring mutex must be locked
+		*
+		* \param[in] pRing The upload ring
+		* \param[in] value The semaphore value of the batch
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	static VkResult vhUploadWait2(vhUploadRing *pRing, uint64_t value)
+	{
+		VkSemaphoreWaitInfo waitInfo = {};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &pRing->semaphore;
+		waitInfo.pValues = &value;
+
+		VHCHECKRESULT(vkWaitSemaphores(pRing->device, &waitInfo, std::numeric_limits<uint64_t>::max()));
+		return vhUploadRetire(pRing);
+	}
+
+	/**
+		*
+		* \brief Reserve staging memory and make sure the current batch is being recorded, the ring mutex must be locked
+		*
+		* If the ring is full, the current batch is submitted and the oldest batches are waited for.
+		* Uploads larger than the whole ring get their own staging buffer, which is destroyed with the batch.
+		*
+		* \param[in] pRing The upload ring
+		* \param[in] size Number of bytes needed
+		* \param[out] pBuffer The staging buffer to copy from
+		* \param[out] pOffset Offset of the reserved memory in the staging buffer
+		* \param[out] ppData Host pointer to the reserved memory
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	static VkResult vhUploadAllocate(vhUploadRing *pRing, VkDeviceSize size, VkBuffer *pBuffer, VkDeviceSize *pOffset, unsigned char **ppData)
+	{
+		VHCHECKRESULT(vhUploadRetire(pRing));
+
+		if (size > pRing->size)
+		{
+			VkBuffer buffer;
+			VmaAllocation allocation;
+			VHCHECKRESULT(vhBufCreateBuffer(pRing->allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VMA_MEMORY_USAGE_CPU_ONLY, &buffer, &allocation));
+			VHCHECKRESULT(vmaMapMemory(pRing->allocator, allocation, (void **)ppData));
+			pRing->current.buffers.push_back(buffer);
+			pRing->current.allocations.push_back(allocation);
+			*pBuffer = buffer;
+			*pOffset = 0;
+		}
+		else
+		{
+			uint64_t pos;
+			while (true)
+			{
+				pos = (pRing->head + VH_UPLOAD_ALIGNMENT - 1) & ~(VH_UPLOAD_ALIGNMENT - 1);
+				if (pos % pRing->size + size > pRing->size)
+					pos = (pos / pRing->size + 1) * pRing->size; //does not fit before the end, start over at 0
+				if (pos + size <= pRing->tail + pRing->size)
+					break;
+
+				if (pRing->pending.empty() && pRing->current.commandBuffer == VK_NULL_HANDLE)
+				{ //the ring is empty, start again at its beginning
+					pRing->head = pRing->tail = 0;
+					continue;
+				}
+				if (pRing->pending.empty())
+					VHCHECKRESULT(vhUploadSubmit2(pRing)); //the current batch holds the rest of the ring
+				VHCHECKRESULT(vhUploadWait2(pRing, pRing->pending.front().value));
+			}
+			pRing->head = pos + size;
+			*pBuffer = pRing->buffer;
+			*pOffset = pos % pRing->size;
+			*ppData = pRing->pData + *pOffset;
+		}
+
+		if (pRing->current.commandBuffer == VK_NULL_HANDLE)
+		{
+			pRing->current.commandBuffer = vhCmdBeginSingleTimeCommands(pRing->device, pRing->commandPool);
+			if (pRing->current.commandBuffer == VK_NULL_HANDLE)
+				return VK_ERROR_INITIALIZATION_FAILED;
+		}
+		return VK_SUCCESS;
+	}
+
+	/**
+		*
+		* \brief Copy data into a buffer
+		*
+		* The data is copied into the staging ring immediately, so it can be freed after the call.
+		* The copy into the buffer is executed with the next call to vhUploadSubmit().
+		*
+		* \param[in] pRing The upload ring
+		* \param[in] pData Pointer to the data
+		* \param[in] size Number of bytes to copy
+		* \param[in] dstBuffer The destination buffer, must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		* \param[in] dstOffset Offset into the destination buffer
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadBuffer(vhUploadRing *pRing, const void *pData, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+	{
+		if (size == 0)
+			return VK_SUCCESS;
+
+		std::lock_guard<std::mutex> lock(pRing->mutex);
+
+		VkBuffer srcBuffer;
+		VkDeviceSize srcOffset;
+		unsigned char *pStaging;
+		VHCHECKRESULT(vhUploadAllocate(pRing, size, &srcBuffer, &srcOffset, &pStaging));
+		memcpy(pStaging, pData, (size_t)size);
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.srcOffset = srcOffset;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(pRing->current.commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+		return VK_SUCCESS;
+	}
+
+	/**
+		*
+		* \brief Record the generation of all mip levels from level 0
+		*
+		* Each level is blitted from the previous one with a linear filter. Level 0 must be in
+		* VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, afterwards all levels are in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+		*
+		* \param[in] commandBuffer Command buffer to record into
+		* \param[in] image The image, must have been created with VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+		* \param[in] width Width of level 0
+		* \param[in] height Height of level 0
+		* \param[in] mipLevels Number of mip levels of the image
+		* \param[in] layerCount Number of layers of the image
+		*
+		*/
+	static void vhUploadGenerateMipmaps(VkCommandBuffer commandBuffer, VkImage image, int32_t width, int32_t height, uint32_t mipLevels, uint32_t layerCount)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = layerCount;
+
+		for (uint32_t level = 1; level < mipLevels; level++)
+		{
+			//the previous level has been written, now it is read by the blit
+			barrier.subresourceRange.baseMipLevel = level - 1;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			//this level is written by the blit
+			barrier.subresourceRange.baseMipLevel = level;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkImageBlit blit = {};
+			blit.srcOffsets[1] = { std::max(width >> (level - 1), 1), std::max(height >> (level - 1), 1), 1 };
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = layerCount;
+			blit.dstOffsets[1] = { std::max(width >> level, 1), std::max(height >> level, 1), 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = layerCount;
+			vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+			//the previous level is done
+			barrier.subresourceRange.baseMipLevel = level - 1;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		//the last level has only been written
+		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	/**
+		*
+		* \brief Copy decoded images into the layers of an image
+		*
+		* The image is transitioned from undefined layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+		* If the image has more than one mip level, the levels are computed from the images by blitting.
+		* The copy is executed with the next call to vhUploadSubmit().
+		*
+		* \param[in] pRing The upload ring
+		* \param[in] images The decoded images, one for each layer
+		* \param[in] image The destination image
+		* \param[in] format Format of the image
+		* \param[in] mipLevels Number of mip levels of the image
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadImage(vhUploadRing *pRing, std::vector<vhImageData> &images, VkImage image, VkFormat format, uint32_t mipLevels)
+	{
+		VkDeviceSize imageSize = 0;
+		for (auto &img : images)
+		{
+			imageSize += img.pixels.size();
+		}
+
+		std::lock_guard<std::mutex> lock(pRing->mutex);
+
+		VkBuffer srcBuffer;
+		VkDeviceSize srcOffset;
+		unsigned char *pStaging;
+		VHCHECKRESULT(vhUploadAllocate(pRing, imageSize, &srcBuffer, &srcOffset, &pStaging));
+
+		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		VkDeviceSize offset = srcOffset;
+		for (uint32_t layer = 0; layer < images.size(); layer++)
+		{
+			memcpy(pStaging + (offset - srcOffset), images[layer].pixels.data(), images[layer].pixels.size());
+
+			VkBufferImageCopy bufferCopyRegion = {};
+			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bufferCopyRegion.imageSubresource.mipLevel = 0;
+			bufferCopyRegion.imageSubresource.baseArrayLayer = layer;
+			bufferCopyRegion.imageSubresource.layerCount = 1;
+			bufferCopyRegion.imageExtent.width = images[layer].width;
+			bufferCopyRegion.imageExtent.height = images[layer].height;
+			bufferCopyRegion.imageExtent.depth = 1;
+			bufferCopyRegion.bufferOffset = offset;
+			bufferCopyRegions.push_back(bufferCopyRegion);
+
+			offset += images[layer].pixels.size();
+		}
+
+		VHCHECKRESULT(vhBufTransitionImageLayout(pRing->device, pRing->queue, pRing->current.commandBuffer, image,
+			format, VK_IMAGE_ASPECT_COLOR_BIT, 1, (uint32_t)images.size(),
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+
+		vkCmdCopyBufferToImage(pRing->current.commandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			(uint32_t)bufferCopyRegions.size(), bufferCopyRegions.data());
+
+		if (mipLevels > 1)
+		{
+			vhUploadGenerateMipmaps(pRing->current.commandBuffer, image, images[0].width, images[0].height,
+				mipLevels, (uint32_t)images.size());
+			return VK_SUCCESS;
+		}
+
+		return vhBufTransitionImageLayout(pRing->device, pRing->queue, pRing->current.commandBuffer, image,
+			format, VK_IMAGE_ASPECT_COLOR_BIT, 1, (uint32_t)images.size(),
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	/**
+		*
+		* \brief Submit all uploads recorded so far in one batch
+		*
+		* Commands submitted to the same queue afterwards see the uploaded data.
+		*
+		* \param[in] pRing The upload ring
+		* \param[out] pValue If not nullptr, receives the semaphore value that signals the end of the batch
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadSubmit(vhUploadRing *pRing, uint64_t *pValue)
+	{
+		std::lock_guard<std::mutex> lock(pRing->mutex);
+		VHCHECKRESULT(vhUploadSubmit2(pRing));
+		if (pValue != nullptr)
+			*pValue = pRing->submittedValue;
+		return vhUploadRetire(pRing);
+	}
+
+	/**
+		*
+		* \brief Wait on the host until a batch has finished
+		*
+		* \param[in] pRing The upload ring
+		* \param[in] value The semaphore value returned by vhUploadSubmit()
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadWait(vhUploadRing *pRing, uint64_t value)
+	{
+		std::lock_guard<std::mutex> lock(pRing->mutex);
+		return vhUploadWait2(pRing, value);
+	}
+
+	/**
+		*
+		* \brief Submit the current batch and wait until all uploads have finished
+		*
+		* Call this before destroying a buffer or image that might still be the target of an upload.
+		* Returns immediately if no upload is outstanding.
+		*
+		* \param[in] pRing The upload ring
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadFinish(vhUploadRing *pRing)
+	{
+		std::lock_guard<std::mutex> lock(pRing->mutex);
+		if (pRing->semaphore == VK_NULL_HANDLE)
+			return VK_SUCCESS;
+
+		VHCHECKRESULT(vhUploadRetire(pRing));
+		if (pRing->current.commandBuffer == VK_NULL_HANDLE && pRing->pending.empty())
+			return VK_SUCCESS;
+
+		VHCHECKRESULT(vhUploadSubmit2(pRing));
+		return vhUploadWait2(pRing, pRing->submittedValue);
+	}
+
+	/**
+		*
+		* \brief Wait for all uploads and destroy the ring
+		*
+		* \param[in] pRing The upload ring
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadDeinit(vhUploadRing *pRing)
+	{
+		VHCHECKRESULT(vhUploadFinish(pRing));
+
+		vkDestroySemaphore(pRing->device, pRing->semaphore, nullptr);
+		pRing->semaphore = VK_NULL_HANDLE;
+		vmaUnmapMemory(pRing->allocator, pRing->allocation);
+		vmaDestroyBuffer(pRing->allocator, pRing->buffer, pRing->allocation);
+		vkDestroyCommandPool(pRing->device, pRing->commandPool, nullptr);
+		return VK_SUCCESS;
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	//buffers and images filled through the upload ring
+
+	/**
+	* \brief Create a Vulkan vertex buffer, the vertices are uploaded with the next batch of the ring
+	*
+	* \param[in] allocator VMA allocator
+	* \param[in] pRing The upload ring
+	* \param[in] vertices List of vertices
+	* \param[out] vertexBuffer The new vertex buffer
+	* \param[out] vertexBufferAllocation VMA allocation information
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateVertexBuffer(VmaAllocator allocator, vhUploadRing *pRing, std::vector<vh::vhVertex> &vertices, VkBuffer *vertexBuffer, VmaAllocation *vertexBufferAllocation)
+	{
+		return vhBufCreateVertexBuffer(allocator, pRing, vertices.data(), (uint32_t)vertices.size(), vertexBuffer, vertexBufferAllocation);
+	}
+
+	/**
+	* \brief Create a Vulkan vertex buffer from an array, the vertices are uploaded with the next batch of the ring
+	*
+	* The array is copied into the staging ring right away, so it can be released after the call.
+	*
+	* \param[in] allocator VMA allocator
+	* \param[in] pRing The upload ring
+	* \param[in] pVertices Pointer to the vertices
+	* \param[in] vertexCount Number of vertices
+	* \param[out] vertexBuffer The new vertex buffer
+	* \param[out] vertexBufferAllocation VMA allocation information
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateVertexBuffer(VmaAllocator allocator, vhUploadRing *pRing, const vh::vhVertex *pVertices, uint32_t vertexCount, VkBuffer *vertexBuffer, VmaAllocation *vertexBufferAllocation)
+	{
+		VkDeviceSize bufferSize = sizeof(vh::vhVertex) * vertexCount;
+
+		VHCHECKRESULT(vhBufCreateBuffer(allocator, bufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VMA_MEMORY_USAGE_GPU_ONLY, vertexBuffer, vertexBufferAllocation));
+
+		return vhUploadBuffer(pRing, pVertices, bufferSize, *vertexBuffer);
+	}
+
+	/**
+	* \brief Create a Vulkan vertex buffer from an array of packed vertices, the vertices are uploaded with the next batch of the ring
+	*
+	* \param[in] allocator VMA allocator
+	* \param[in] pRing The upload ring
+	* \param[in] pVertices Pointer to the packed vertices
+	* \param[in] vertexCount Number of vertices
+	* \param[out] vertexBuffer The new vertex buffer
+	* \param[out] vertexBufferAllocation VMA allocation information
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateVertexBuffer(VmaAllocator allocator, vhUploadRing *pRing, const vh::vhVertexPacked *pVertices, uint32_t vertexCount, VkBuffer *vertexBuffer, VmaAllocation *vertexBufferAllocation)
+	{
+		VkDeviceSize bufferSize = sizeof(vh::vhVertexPacked) * vertexCount;
+
+		VHCHECKRESULT(vhBufCreateBuffer(allocator, bufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VMA_MEMORY_USAGE_GPU_ONLY, vertexBuffer, vertexBufferAllocation));
+
+		return vhUploadBuffer(pRing, pVertices, bufferSize, *vertexBuffer);
+	}
+
+	/**
+	* \brief Create a Vulkan index buffer, the indices are uploaded with the next batch of the ring
+	*
+	* \param[in] allocator VMA allocator
+	* \param[in] pRing The upload ring
+	* \param[in] indices List of indices
+	* \param[out] indexBuffer The new index buffer
+	* \param[out] indexBufferAllocation VMA allocation information
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateIndexBuffer(VmaAllocator allocator, vhUploadRing *pRing, std::vector<uint32_t> &indices, VkBuffer *indexBuffer, VmaAllocation *indexBufferAllocation)
+	{
+		return vhBufCreateIndexBuffer(allocator, pRing, indices.data(), (uint32_t)indices.size(), VK_INDEX_TYPE_UINT32, indexBuffer, indexBufferAllocation);
+	}
+
+	/**
+	* \brief Create a Vulkan index buffer from an array, the indices are uploaded with the next batch of the ring
+	*
+	* The array is copied into the staging ring right away, so it can be released after the call.
+	*
+	* \param[in] allocator VMA allocator
+	* \param[in] pRing The upload ring
+	* \param[in] pIndices Pointer to the indices
+	* \param[in] indexCount Number of indices
+	* \param[in] indexType VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32
+	* \param[out] indexBuffer The new index buffer
+	* \param[out] indexBufferAllocation VMA allocation information
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateIndexBuffer(VmaAllocator allocator, vhUploadRing *pRing, const void *pIndices, uint32_t indexCount, VkIndexType indexType, VkBuffer *indexBuffer, VmaAllocation *indexBufferAllocation)
+	{
+		VkDeviceSize bufferSize = (indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)) * indexCount;
+
+		VHCHECKRESULT(vhBufCreateBuffer(allocator, bufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VMA_MEMORY_USAGE_GPU_ONLY,
+			indexBuffer, indexBufferAllocation));
+
+		return vhUploadBuffer(pRing, pIndices, bufferSize, *indexBuffer);
+	}
+
+	/**
+	* \brief Create a texture image with a full mip chain from decoded images, the pixels are uploaded with the next batch of the ring
+	*
+	* If the device cannot blit the format with a linear filter, the image gets only one mip level.
+	*
+	* \param[in] allocator The VMA allocator
+	* \param[in] pRing The upload ring
+	* \param[in] images List of decoded images, become the layers of the texture (should have same resolution)
+	* \param[in] flags Image create flags
+	* \param[out] textureImage The new image
+	* \param[out] textureImageAllocation The VMA allocation info
+	* \param[out] extent The extent of the image
+	* \param[out] mipLevels The number of mip levels of the image
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateTextureImage(VmaAllocator allocator, vhUploadRing *pRing, std::vector<vhImageData> &images, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent, uint32_t *mipLevels)
+	{
+		if (images.size() == 0)
+			return VK_INCOMPLETE;
+
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(pRing->physicalDevice, VK_FORMAT_R8G8B8A8_UNORM, &formatProperties);
+		VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+			VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+		*mipLevels = 1;
+		if ((formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures)
+			*mipLevels = vhBufMipLevels(images[0].width, images[0].height);
+
+		VHCHECKRESULT(vhBufCreateImage(allocator, images[0].width, images[0].height, *mipLevels,
+			(uint32_t)images.size(),
+			VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			flags, textureImage, textureImageAllocation));
+		*extent = { (uint32_t)images[0].width, (uint32_t)images[0].height };
+
+		return vhUploadImage(pRing, images, *textureImage, VK_FORMAT_R8G8B8A8_UNORM, *mipLevels);
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	//compressed textures
+	//
+	//KTX and DDS files loaded with gli already contain their mip chain, and often a block compressed format.
+	//If the device can sample the format, the blocks are copied into the image as they are. Otherwise the
+	//texture is transcoded to RGBA8 on the CPU first.
+
+	/**
+		*
+		* \brief Map a gli format to a Vulkan format
+		*
+		* gli enumerates its formats in the same order as Vulkan, up to the ASTC formats.
+		* The formats after them have no Vulkan equivalent.
+		*
+		* \param[in] format The gli format
+		* \returns the Vulkan format, or VK_FORMAT_UNDEFINED
+		*
+		*/
+	static VkFormat vhUploadTextureFormat(gli::format format)
+	{
+		if (format > gli::FORMAT_RGBA_ASTC_12X12_SRGB_BLOCK16)
+			return VK_FORMAT_UNDEFINED;
+
+		return (VkFormat)format;
+	}
+
+	/**
+		*
+		* \brief Transcode a texture to RGBA8 on the CPU
+		*
+		* All layers, faces and mip levels are decoded texel by texel, so compressed textures
+		* keep their pre-baked mip chain.
+		*
+		* \param[in] texture The texture to transcode, must be a 2D array or cube array view
+		* \returns a new texture with the same layout and format RGBA8
+		*
+		*/
+	template <typename textureType>
+	static gli::texture vhUploadTranscode(textureType const &texture)
+	{
+		gli::format format = gli::is_srgb(texture.format()) ? gli::FORMAT_RGBA8_SRGB_PACK8 : gli::FORMAT_RGBA8_UNORM_PACK8;
+		textureType result(format, texture.extent(), texture.layers(), texture.levels());
+
+		typedef gli::detail::convert<textureType, float, gli::defaultp> convertType;
+		typename convertType::fetchFunc fetch = convertType::call(texture.format()).Fetch;
+		typename convertType::writeFunc write = convertType::call(format).Write;
+
+		for (size_t layer = 0; layer < texture.layers(); layer++)
+		{
+			for (size_t face = 0; face < texture.faces(); face++)
+			{
+				for (size_t level = 0; level < texture.levels(); level++)
+				{
+					typename textureType::extent_type extent = texture.extent(level);
+					for (int y = 0; y < extent.y; y++)
+					{
+						for (int x = 0; x < extent.x; x++)
+						{
+							typename textureType::extent_type coord(x, y);
+							write(result, coord, layer, face, level, fetch(texture, coord, layer, face, level));
+						}
+					}
+				}
+			}
+		}
+		return result;
+	}
+
+	/**
+		*
+		* \brief Copy all layers, faces and mip levels of a gli texture into an image
+		*
+		* The data is copied as it is, so the image must have the same format, number of levels and
+		* layers * faces array layers. The image is transitioned from undefined layout to
+		* VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. The copy is executed with the next call to vhUploadSubmit().
+		*
+		* \param[in] pRing The upload ring
+		* \param[in] texture The texture to upload
+		* \param[in] image The destination image
+		* \param[in] format Format of the image
+		* \returns VK_SUCCESS or a Vulkan error code
+		*
+		*/
+	VkResult vhUploadTexture(vhUploadRing *pRing, gli::texture &texture, VkImage image, VkFormat format)
+	{
+		uint32_t mipLevels = (uint32_t)texture.levels();
+		uint32_t layerCount = (uint32_t)(texture.layers() * texture.faces());
+
+		VkDeviceSize imageSize = 0;
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			imageSize += ((texture.size(level) + VH_UPLOAD_ALIGNMENT - 1) & ~(VH_UPLOAD_ALIGNMENT - 1)) * layerCount;
+		}
+
+		std::lock_guard<std::mutex> lock(pRing->mutex);
+
+		VkBuffer srcBuffer;
+		VkDeviceSize srcOffset;
+		unsigned char *pStaging;
+		VHCHECKRESULT(vhUploadAllocate(pRing, imageSize, &srcBuffer, &srcOffset, &pStaging));
+
+		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		VkDeviceSize offset = srcOffset;
+		for (size_t layer = 0; layer < texture.layers(); layer++)
+		{
+			for (size_t face = 0; face < texture.faces(); face++)
+			{
+				for (uint32_t level = 0; level < mipLevels; level++)
+				{
+					memcpy(pStaging + (offset - srcOffset), texture.data(layer, face, level), texture.size(level));
+
+					gli::extent3d extent = texture.extent(level);
+					VkBufferImageCopy bufferCopyRegion = {};
+					bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					bufferCopyRegion.imageSubresource.mipLevel = level;
+					bufferCopyRegion.imageSubresource.baseArrayLayer = (uint32_t)(layer * texture.faces() + face);
+					bufferCopyRegion.imageSubresource.layerCount = 1;
+					bufferCopyRegion.imageExtent.width = (uint32_t)extent.x;
+					bufferCopyRegion.imageExtent.height = (uint32_t)extent.y;
+					bufferCopyRegion.imageExtent.depth = 1;
+					bufferCopyRegion.bufferOffset = offset;
+					bufferCopyRegions.push_back(bufferCopyRegion);
+
+					offset += (texture.size(level) + VH_UPLOAD_ALIGNMENT - 1) & ~(VH_UPLOAD_ALIGNMENT - 1);
+				}
+			}
+		}
+
+		VHCHECKRESULT(vhBufTransitionImageLayout(pRing->device, pRing->queue, pRing->current.commandBuffer, image,
+			format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, layerCount,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+
+		vkCmdCopyBufferToImage(pRing->current.commandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			(uint32_t)bufferCopyRegions.size(), bufferCopyRegions.data());
+
+		return vhBufTransitionImageLayout(pRing->device, pRing->queue, pRing->current.commandBuffer, image,
+			format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, layerCount,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	/**
+	* \brief Create a texture image from a KTX or DDS texture, the texture data is uploaded with the next batch of the ring
+	*
+	* The image gets the format and all mip levels of the texture. If the device cannot sample the format,
+	* the texture is transcoded to RGBA8 on the CPU. Cube maps get one array layer per face and
+	* VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT.
+	*
+	* \param[in] allocator The VMA allocator
+	* \param[in] pRing The upload ring
+	* \param[in] texture The texture loaded with gli::load()
+	* \param[in] flags Image create flags
+	* \param[out] textureImage The new image
+	* \param[out] textureImageAllocation The VMA allocation info
+	* \param[out] extent The extent of the image
+	* \param[out] mipLevels The number of mip levels of the image
+	* \param[out] format The format of the image
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateTextureImage(VmaAllocator allocator, vhUploadRing *pRing, gli::texture &texture, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent, uint32_t *mipLevels, VkFormat *format)
+	{
+		if (texture.empty())
+			return VK_INCOMPLETE;
+
+		bool cube = texture.target() == gli::TARGET_CUBE || texture.target() == gli::TARGET_CUBE_ARRAY;
+		if (!cube && texture.target() != gli::TARGET_2D && texture.target() != gli::TARGET_2D_ARRAY)
+			return VK_ERROR_FORMAT_NOT_SUPPORTED;
+
+		*format = vhUploadTextureFormat(texture.format());
+
+		VkFormatProperties formatProperties = {};
+		if (*format != VK_FORMAT_UNDEFINED)
+			vkGetPhysicalDeviceFormatProperties(pRing->physicalDevice, *format, &formatProperties);
+		VkFormatFeatureFlags sampleFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+
+		gli::texture data = texture;
+		if ((formatProperties.optimalTilingFeatures & sampleFeatures) != sampleFeatures)
+		{
+			if (cube)
+				data = vhUploadTranscode(gli::texture_cube_array(texture));
+			else
+				data = vhUploadTranscode(gli::texture2d_array(texture));
+			*format = vhUploadTextureFormat(data.format());
+		}
+
+		if (cube)
+			flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+
+		gli::extent3d texExtent = data.extent(0);
+		*mipLevels = (uint32_t)data.levels();
+		VHCHECKRESULT(vhBufCreateImage(allocator, texExtent.x, texExtent.y, *mipLevels,
+			(uint32_t)(data.layers() * data.faces()),
+			*format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			flags, textureImage, textureImageAllocation));
+		*extent = { (uint32_t)texExtent.x, (uint32_t)texExtent.y };
+
+		return vhUploadTexture(pRing, data, *textureImage, *format);
+	}
+
+} // namespace vh
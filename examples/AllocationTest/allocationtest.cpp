@@ -0,0 +1,123 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+//Checks that the render loop does not allocate on the heap in a steady scene.
+//A static scene is rendered headless with the forward renderer. After a warm up, in which the frame arena
+//grows and the secondary command buffers are recorded for every swap chain image, no frame may allocate.
+//Steady means that nothing moves, so no command buffers are recorded again. Recording itself and background
+//jobs started with VEJobSystem::add() may allocate.
+//The allocations are only counted in debug builds, in release builds the test is skipped.
+
+#include <cstdio>
+#include <cstring>
+
+#include "VEInclude.h"
+
+///Frames before the scene is steady
+const uint32_t WARMUP_FRAMES = 100;
+
+///Frames that are checked
+const uint32_t TEST_FRAMES = 200;
+
+///CTest treats this return value as skipped
+const int SKIPPED = 77;
+
+namespace ve
+{
+	uint32_t g_numChecked = 0; //frames that were checked
+	uint32_t g_numFailed = 0; //frames that allocated
+	uint64_t g_maxAllocations = 0; //most allocations in one frame
+
+	///Counts the frames that allocated
+	class AllocationListener : public VEEventListener
+	{
+	protected:
+		///Called before the events of a frame, the allocations of the last whole frame are known then
+		virtual void onFrameStarted(veEvent event)
+		{
+			if (getEnginePointer()->getLoopCount() <= WARMUP_FRAMES)
+				return;
+			uint64_t numAllocations = getEnginePointer()->getAllocationsPerFrame();
+			g_numChecked++;
+			if (numAllocations > 0)
+				g_numFailed++;
+			g_maxAllocations = std::max(g_maxAllocations, numAllocations);
+		};
+
+	public:
+		///Constructor
+		AllocationListener(std::string name)
+			: VEEventListener(name) {};
+
+		///Destructor
+		virtual ~AllocationListener() {};
+	};
+
+	///Engine rendering a static scene
+	class AllocationTestEngine : public VEEngine
+	{
+	public:
+		///Constructor
+		AllocationTestEngine(veRendererType type)
+			: VEEngine(type, false) {};
+
+		///Only the counting listener, there is no input
+		virtual void registerEventListeners()
+		{
+			registerEventListener(new AllocationListener("AllocationListener"), { veEvent::VE_EVENT_FRAME_STARTED });
+		};
+
+		///The standard cameras and lights, a plane and a cube
+		virtual void loadLevel(uint32_t numLevel = 1)
+		{
+			VEEngine::loadLevel(numLevel);
+
+			VESceneNode *pScene;
+			VECHECKPOINTER(pScene = getSceneManagerPointer()->createSceneNode("Level 1", getRoot()));
+
+			VESceneNode *pPlane;
+			VECHECKPOINTER(pPlane = getSceneManagerPointer()->loadModel("The Plane", "../../media/models/test/plane", "plane_t_n_s.obj", 0, pScene));
+			pPlane->setTransform(glm::scale(glm::mat4(1.0f), glm::vec3(1000.0f, 1.0f, 1000.0f)));
+
+			VESceneNode *pCube;
+			VECHECKPOINTER(pCube = getSceneManagerPointer()->loadModel("The Cube0", "../../media/models/test/crate0", "cube.obj", 0, pScene));
+			pCube->setTransform(glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.5f, 10.0f)));
+		};
+	};
+
+} // namespace ve
+
+using namespace ve;
+
+int main(int argc, char *argv[])
+{
+	std::vector<char> probe(64); //counted if the counter is on
+	if (veGetNumAllocations() == 0)
+	{
+		printf("Allocations are only counted in debug builds, skipped\n");
+		return SKIPPED;
+	}
+
+	veRendererType type = veRendererType::VE_RENDERER_TYPE_FORWARD;
+	if (argc > 1 && strcmp(argv[1], "clustered") == 0)
+		type = veRendererType::VE_RENDERER_TYPE_FORWARD_CLUSTERED;
+
+	AllocationTestEngine engine(type);
+	engine.setHeadless(1280, 720, WARMUP_FRAMES + TEST_FRAMES);
+	engine.initEngine();
+	engine.loadLevel(1);
+	engine.run();
+
+	if (g_numChecked == 0)
+	{
+		printf("No frame was checked\n");
+		return 1;
+	}
+	printf("%u of %u steady frames allocated, at most %llu times\n", g_numFailed, g_numChecked,
+		(unsigned long long)g_maxAllocations);
+	return g_numFailed == 0 ? 0 : 1;
+}
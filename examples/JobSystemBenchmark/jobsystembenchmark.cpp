@@ -0,0 +1,232 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+//Compares the work stealing VEJobSystem with the old mutex queue ThreadPool:
+//- task throughput: many tiny tasks, waited for as a group
+//- frame update: a scene graph update like VESceneManager::updateSceneNodes, with wide nodes
+//  split into chunks, the old way copying the children into each job and waiting for futures.
+//  Both ways wait only once per frame, waiting for the chunks of each wide node would add a
+//  fork and join with thread wake ups for each of them
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <string>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ThreadPool.h"
+#include "VEJobSystem.h"
+
+using namespace ve;
+
+///A scene node of the benchmark scene
+struct benchNode_t
+{
+	glm::mat4 transform;
+	glm::mat4 world;
+	std::vector<benchNode_t *> children;
+};
+
+const uint32_t GRANULARITY = 200; ///<Same as in the engine
+
+static std::atomic<uint32_t> g_sink = 0; ///<keeps the work from being optimized away
+
+static double seconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+///A tiny task
+static void tinyWork(uint32_t i)
+{
+	uint32_t x = i;
+	for (uint32_t k = 0; k < 32; k++)
+		x = x * 1664525u + 1013904223u;
+	g_sink.store(g_sink.load(std::memory_order_relaxed) + (x & 1), std::memory_order_relaxed); //no read modify write, like the old volatile
+}
+
+//-----------------------------------------------------------------------------------------------
+//scene update, old way
+
+static void updateOld(ThreadPool &tp, benchNode_t *pNode, glm::mat4 parent, std::queue<std::future<void>> &futures, std::mutex &mutex);
+
+static void updateOld3(ThreadPool &tp, std::vector<benchNode_t *> children, glm::mat4 world, uint32_t startIdx, uint32_t endIdx,
+	std::queue<std::future<void>> *pFutures, std::mutex *pMutex)
+{
+	for (uint32_t i = startIdx; i <= endIdx; i++)
+		updateOld(tp, children[i], world, *pFutures, *pMutex);
+}
+
+static void updateOld(ThreadPool &tp, benchNode_t *pNode, glm::mat4 parent, std::queue<std::future<void>> &futures, std::mutex &mutex)
+{
+	pNode->world = parent * pNode->transform;
+	if (pNode->children.size() > GRANULARITY && tp.threadCount() > 1)
+	{
+		uint32_t numThreads = std::min((uint32_t)(pNode->children.size() / GRANULARITY), (uint32_t)tp.threadCount());
+		uint32_t numPerThread = (uint32_t)pNode->children.size() / numThreads;
+		for (uint32_t k = 0; k < numThreads; k++)
+		{
+			uint32_t startIdx = k * numPerThread;
+			uint32_t endIdx = k == numThreads - 1 ? (uint32_t)pNode->children.size() - 1 : (k + 1) * numPerThread - 1;
+			auto future = tp.add(&updateOld3, std::ref(tp), pNode->children, pNode->world, startIdx, endIdx, &futures, &mutex);
+			std::lock_guard<std::mutex> lock(mutex);
+			futures.push(std::move(future));
+		}
+	}
+	else
+	{
+		for (auto pChild : pNode->children)
+			updateOld(tp, pChild, pNode->world, futures, mutex);
+	}
+}
+
+static void frameOld(ThreadPool &tp, benchNode_t *pRoot)
+{
+	std::queue<std::future<void>> futures;
+	std::mutex mutex;
+	updateOld(tp, pRoot, glm::mat4(1.0f), futures, mutex);
+	while (true)
+	{
+		std::future<void> future;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (futures.empty())
+				break;
+			future = std::move(futures.front());
+			futures.pop();
+		}
+		future.get();
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+//scene update, new way
+
+static void updateNew(VEJobSystem &js, VETaskGroup &group, benchNode_t *pNode, const glm::mat4 &parent);
+
+static void updateNewRange(VEJobSystem &js, VETaskGroup &group, benchNode_t *pNode, uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; i++)
+		updateNew(js, group, pNode->children[i], pNode->world);
+}
+
+///Wide nodes are split into chunks like in parallelFor(), but the chunks join the group of the frame
+static void updateNew(VEJobSystem &js, VETaskGroup &group, benchNode_t *pNode, const glm::mat4 &parent)
+{
+	pNode->world = parent * pNode->transform;
+	uint32_t count = (uint32_t)pNode->children.size();
+	uint32_t numChunks = std::min(count / GRANULARITY, js.getThreadCount() + 1);
+	if (numChunks <= 1)
+	{
+		updateNewRange(js, group, pNode, 0, count);
+		return;
+	}
+
+	uint32_t chunkSize = count / numChunks;
+	for (uint32_t k = 1; k < numChunks; k++)
+	{
+		uint32_t begin = k * chunkSize;
+		uint32_t end = k == numChunks - 1 ? count : begin + chunkSize;
+		group.run([&js, &group, pNode, begin, end]()
+			{ updateNewRange(js, group, pNode, begin, end); });
+	}
+	updateNewRange(js, group, pNode, 0, chunkSize);
+}
+
+static void frameNew(VEJobSystem &js, benchNode_t *pRoot)
+{
+	VETaskGroup group(&js);
+	updateNew(js, group, pRoot, glm::mat4(1.0f));
+	group.wait();
+}
+
+//-----------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	uint32_t numThreads = argc > 1 ? (uint32_t)atoi(argv[1]) : 0;
+	const uint32_t numTasks = 200000;
+	const uint32_t numFrames = 200;
+
+	//scene: 10 groups with 2000 entities each, each entity has 4 children
+	std::vector<std::unique_ptr<benchNode_t>> nodes;
+	auto newNode = [&]()
+	{
+		nodes.push_back(std::make_unique<benchNode_t>());
+		nodes.back()->transform = glm::translate(glm::mat4(1.0f), glm::vec3((float)nodes.size(), 1.0f, 2.0f));
+		return nodes.back().get();
+	};
+	benchNode_t *pRoot = newNode();
+	for (uint32_t g = 0; g < 10; g++)
+	{
+		benchNode_t *pGroup = newNode();
+		pRoot->children.push_back(pGroup);
+		for (uint32_t e = 0; e < 2000; e++)
+		{
+			benchNode_t *pEntity = newNode();
+			pGroup->children.push_back(pEntity);
+			for (uint32_t c = 0; c < 4; c++)
+				pEntity->children.push_back(newNode());
+		}
+	}
+
+	double oldTasks, newTasks, oldFrame, newFrame;
+	{
+		ThreadPool tp(numThreads);
+		printf("ThreadPool, %u threads\n", (uint32_t)tp.threadCount());
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::future<void>> futures(numTasks);
+		for (uint32_t i = 0; i < numTasks; i++)
+			futures[i] = tp.add(&tinyWork, i);
+		for (auto &future : futures)
+			future.get();
+		oldTasks = numTasks / seconds(start);
+
+		frameOld(tp, pRoot); //warm up
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < numFrames; f++)
+			frameOld(tp, pRoot);
+		oldFrame = seconds(start) / numFrames;
+	}
+	glm::mat4 oldWorld = nodes.back()->world;
+
+	{
+		VEJobSystem js(numThreads);
+		printf("VEJobSystem, %u threads\n", js.getThreadCount());
+
+		auto start = std::chrono::high_resolution_clock::now();
+		{
+			VETaskGroup group(&js);
+			for (uint32_t i = 0; i < numTasks; i++)
+				group.run([i]()
+					{ tinyWork(i); });
+			group.wait();
+		}
+		newTasks = numTasks / seconds(start);
+
+		frameNew(js, pRoot); //warm up
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < numFrames; f++)
+			frameNew(js, pRoot);
+		newFrame = seconds(start) / numFrames;
+	}
+
+	if (nodes.back()->world != oldWorld)
+	{
+		printf("Error: the scene updates differ\n");
+		return 1;
+	}
+
+	printf("task throughput: ThreadPool %10.0f tasks/s, VEJobSystem %10.0f tasks/s (%.1fx)\n", oldTasks, newTasks, newTasks / oldTasks);
+	printf("frame update:    ThreadPool %10.3f ms,      VEJobSystem %10.3f ms      (%.1fx)\n", oldFrame * 1000.0, newFrame * 1000.0, oldFrame / newFrame);
+	return 0;
+}
@@ -120,22 +120,31 @@ namespace ve {
 	//
 	class EventListenerCollision : public VEEventListener {
 	protected:
+		VEHandle m_cubeParent = VE_NULL_HANDLE;		//handles are looked up once, names are slow
+		VEHandle m_cameraParent = VE_NULL_HANDLE;
+
 		virtual void onFrameStarted(veEvent event) {
 			static uint32_t cubeid = 0;
 
+			if (m_cubeParent == VE_NULL_HANDLE) {
+				m_cubeParent = getSceneManagerPointer()->getSceneNode("The Cube Parent")->getHandle();
+				m_cameraParent = getSceneManagerPointer()->getSceneNode("StandardCameraParent")->getHandle();
+			}
+			VESceneNode *pCubeParent = getSceneManagerPointer()->getSceneNode(m_cubeParent);
+
 			if (g_restart) {
 				g_gameLost = false;
 				g_restart = false;
 				g_time = 30;
 				g_score = 0;
-				getSceneManagerPointer()->getSceneNode("The Cube Parent")->setPosition(glm::vec3(d(e), 1.0f, d(e)));
+				pCubeParent->setPosition(glm::vec3(d(e), 1.0f, d(e)));
 				((MyVulkanEngine*)getEnginePointer())->m_irrklangEngine->play2D("../../media/sounds/ophelia.wav", true);
 				return;
 			}
 			if (g_gameLost) return;
 
-			glm::vec3 positionCube   = getSceneManagerPointer()->getSceneNode("The Cube Parent")->getPosition();
-			glm::vec3 positionCamera = getSceneManagerPointer()->getSceneNode("StandardCameraParent")->getPosition();
+			glm::vec3 positionCube   = pCubeParent->getPosition();
+			glm::vec3 positionCamera = getSceneManagerPointer()->getSceneNode(m_cameraParent)->getPosition();
 
 			float distance = glm::length(positionCube - positionCamera);
 			if (distance < 1) {
@@ -146,7 +155,7 @@ namespace ve {
 					((MyVulkanEngine*)getEnginePointer())->m_irrklangEngine->play2D("../../media/sounds/bell.wav", false);
 				}
 
-				VESceneNode *eParent = getSceneManagerPointer()->getSceneNode("The Cube Parent");
+				VESceneNode *eParent = pCubeParent;
 				eParent->setPosition(glm::vec3(d(e), 0.5f, d(e)));
 
 				getSceneManagerPointer()->deleteSceneNodeAndChildren("The Cube"+ std::to_string(cubeid));
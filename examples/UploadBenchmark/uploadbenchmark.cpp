@@ -0,0 +1,172 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+//Compares uploading whole memory blocks with uploading only their dirty ranges:
+//- whole: every frame all blocks are marked dirty, like before the dirty ranges were introduced
+//- ranged: only the entries written with vhMemBlockUpdateEntry are copied
+//The moving entities are either clustered (one contiguous range) or scattered over all blocks.
+//Runs on a Vulkan device without a window, using the same memory blocks as VESceneManager.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "VHHelper.h"
+
+///Same size as VEEntity::veUBOPerEntity_t
+const uint32_t ENTRY_SIZE = 256;
+
+///Same as the entity blocks of VESceneManager
+const uint32_t BLOCK_ENTRIES = 2048;
+
+///Frames in flight
+const uint32_t NUM_BUFFERS = 3;
+
+///One benchmark case
+struct benchCase_t
+{
+	const char *name;
+	uint32_t numMoving; ///<number of entities changing each frame
+	bool scattered; ///<spread the moving entities over all blocks
+};
+
+static double seconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+///Vulkan objects needed for the memory blocks
+struct benchDevice_t
+{
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	VmaAllocator allocator = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSetLayout descriptorLayout = VK_NULL_HANDLE;
+};
+
+///Create an instance and a device without a surface
+static bool initDevice(benchDevice_t &dev, uint32_t numBlocks)
+{
+	if (vhLoadVulkanLibrary() != VK_SUCCESS || vhLoadExportedEntryPoints() != VK_SUCCESS ||
+		vhLoadGlobalLevelEntryPoints() != VK_SUCCESS)
+		return false;
+
+	std::vector<const char *> extensions = { VK_KHR_SURFACE_EXTENSION_NAME }; //the surface functions are always loaded
+	std::vector<const char *> layers = {};
+	if (vh::vhDevCreateInstance(extensions, layers, &dev.instance) != VK_SUCCESS ||
+		vhLoadInstanceLevelEntryPoints(dev.instance) != VK_SUCCESS)
+		return false;
+
+	VkPhysicalDeviceFeatures features;
+	VkPhysicalDeviceLimits limits;
+	VkQueue graphicsQueue, presentQueue;
+	if (vh::vhDevPickPhysicalDevice(dev.instance, VK_NULL_HANDLE, {}, &dev.physicalDevice, &features, &limits) != VK_SUCCESS)
+		return false;
+	if (vh::vhDevCreateLogicalDevice(dev.instance, dev.physicalDevice, VK_NULL_HANDLE, {}, {}, nullptr, &dev.device,
+		&graphicsQueue, &presentQueue) != VK_SUCCESS)
+		return false;
+	if (vh::vhMemCreateVMAAllocator(dev.instance, dev.physicalDevice, dev.device, dev.allocator) != VK_SUCCESS)
+		return false;
+
+	uint32_t numSets = numBlocks * NUM_BUFFERS;
+	if (vh::vhRenderCreateDescriptorPool(dev.device, { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC }, { numSets },
+		&dev.descriptorPool) != VK_SUCCESS)
+		return false;
+	return vh::vhRenderCreateDescriptorSetLayout(dev.device, { 1 }, { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC },
+		{ VK_SHADER_STAGE_VERTEX_BIT }, &dev.descriptorLayout) == VK_SUCCESS;
+}
+
+static void destroyDevice(benchDevice_t &dev)
+{
+	vkDestroyDescriptorSetLayout(dev.device, dev.descriptorLayout, nullptr);
+	vkDestroyDescriptorPool(dev.device, dev.descriptorPool, nullptr);
+	vmaDestroyAllocator(dev.allocator);
+	vkDestroyDevice(dev.device, nullptr);
+	vkDestroyInstance(dev.instance, nullptr);
+}
+
+///Run one case, returns the time per frame (s) and the bytes copied per frame
+static void runCase(std::vector<vh::vhMemoryBlock *> &blocklist, std::vector<vh::vhMemoryHandle> &handles,
+	benchCase_t &c, bool whole, uint32_t numFrames, double &time, double &bytes)
+{
+	uint32_t numEntities = (uint32_t)handles.size();
+	uint32_t stride = c.scattered && c.numMoving > 0 ? numEntities / c.numMoving : 1;
+	uint8_t ubo[ENTRY_SIZE] = {};
+
+	for (uint32_t i = 0; i < NUM_BUFFERS; i++)
+	{ //start without dirty entries
+		vh::vhMemBlockUpdateBlockList(blocklist, i);
+	}
+
+	VkDeviceSize bytesCopied = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t frame = 0; frame < numFrames; frame++)
+	{
+		ubo[0] = (uint8_t)frame;
+		for (uint32_t i = 0; i < c.numMoving; i++)
+		{ //the game logic moves some entities
+			vh::vhMemBlockUpdateEntry(&handles[i * stride], ubo);
+		}
+		if (whole)
+		{
+			for (auto pBlock : blocklist)
+				pBlock->setDirty();
+		}
+		vh::vhMemBlockUpdateBlockList(blocklist, frame % NUM_BUFFERS, &bytesCopied);
+	}
+	time = seconds(start) / numFrames;
+	bytes = (double)bytesCopied / numFrames;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t numEntities = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 20000;
+	uint32_t numFrames = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 1000;
+	uint32_t numBlocks = (numEntities + BLOCK_ENTRIES - 1) / BLOCK_ENTRIES;
+
+	benchDevice_t dev;
+	if (!initDevice(dev, numBlocks))
+	{
+		printf("Could not create a Vulkan device\n");
+		return 1;
+	}
+
+	std::vector<vh::vhMemoryBlock *> blocklist;
+	vh::vhMemBlockListInit(dev.device, dev.allocator, dev.descriptorPool, dev.descriptorLayout, BLOCK_ENTRIES,
+		ENTRY_SIZE, NUM_BUFFERS, blocklist);
+
+	std::vector<vh::vhMemoryHandle> handles(numEntities); //must not move, the blocks point to the handles
+	for (auto &handle : handles)
+		vh::vhMemBlockListAdd(blocklist, nullptr, &handle);
+
+	printf("%u entities of %u bytes in %u blocks, %u frames\n", numEntities, ENTRY_SIZE, (uint32_t)blocklist.size(),
+		numFrames);
+
+	std::vector<benchCase_t> cases = {
+		{ "static", 0, false },
+		{ "1% clustered", numEntities / 100, false },
+		{ "1% scattered", numEntities / 100, true },
+		{ "10% scattered", numEntities / 10, true },
+		{ "all moving", numEntities, false } };
+
+	printf("%-16s %14s %14s %14s %14s %8s\n", "case", "whole ms", "whole KB", "ranged ms", "ranged KB", "speedup");
+	for (auto &c : cases)
+	{
+		double timeWhole, bytesWhole, timeRanged, bytesRanged;
+		runCase(blocklist, handles, c, true, numFrames, timeWhole, bytesWhole);
+		runCase(blocklist, handles, c, false, numFrames, timeRanged, bytesRanged);
+		printf("%-16s %14.4f %14.1f %14.4f %14.1f %7.1fx\n", c.name, timeWhole * 1000.0, bytesWhole / 1024.0,
+			timeRanged * 1000.0, bytesRanged / 1024.0, timeWhole / std::max(timeRanged, 1.0e-9));
+	}
+
+	vh::vhMemBlockListClear(blocklist);
+	destroyDevice(dev);
+	return 0;
+}
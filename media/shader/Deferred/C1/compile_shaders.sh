@@ -4,3 +4,4 @@ SCRIPT=$(realpath $0)
 SCRIPTPATH=`dirname $SCRIPT`
 glslangValidator -V $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert.spv
 glslangValidator -V $SCRIPTPATH/shader.frag -o $SCRIPTPATH/frag.spv
+glslangValidator -V -DVE_PACKED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_packed.spv
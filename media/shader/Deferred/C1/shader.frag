@@ -7,16 +7,14 @@
 layout(location = 0) in vec4 fragColor;
 layout(location = 1) in vec4 fragPosition;
 
-layout (location = 0) out vec4 outPosition;
-layout (location = 1) out vec4 outNormal;
-layout (location = 2) out vec4 outAlbedo;
+layout (location = 0) out vec2 outNormal;
+layout (location = 1) out vec4 outAlbedo;
 
 
 layout(set = 2, binding = 0) uniform sampler2D shadowMap;
 
 
 void main() {
-    outPosition = fragPosition;
-    outNormal = vec4(0.0);
-    outAlbedo = fragColor;
+    outNormal = vec2(0.0);
+    outAlbedo = vec4(fragColor.rgb, 0.0);
 }
@@ -12,7 +12,11 @@ layout(set = 1, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
 
+#ifdef VE_PACKED
+layout(location = 0) in vec3 inPositionQ;
+#else
 layout(location = 0) in vec3 inPositionL;
+#endif
 
 
 layout(location = 0) out vec4 fragColor;
@@ -24,6 +28,9 @@ out gl_PerVertex {
 
 
 void main() {
+#ifdef VE_PACKED
+    vec3 inPositionL = decodePosition(inPositionQ, objectUBO.data.dequantize);
+#endif
     gl_Position  = cameraUBO.data.camProj  * cameraUBO.data.camView * objectUBO.data.model * vec4(inPositionL, 1.0);
     fragWorldPos = objectUBO.data.model * vec4(inPositionL, 1.0);
     fragColor  = objectUBO.data.color;
@@ -20,7 +20,7 @@ layout(set = 1, binding = 0) uniform lightUBO_t {
 
 layout(set = 2, binding = 0) uniform sampler2D shadowMap[NUM_SHADOW_CASCADE];
 
-layout (set = 3, binding = 0) uniform sampler2D samplerPosition;
+layout (set = 3, binding = 0) uniform sampler2D samplerDepth;
 layout (set = 3, binding = 1) uniform sampler2D samplerNormal;
 layout (set = 3, binding = 2) uniform sampler2D samplerAlbedo;
 
@@ -28,10 +28,13 @@ void main()
 {
 
 
-    // Read G-Buffer values from previous sub pass
-    vec3 position = texture(samplerPosition, inUV).rgb;
-    vec3 normal = texture(samplerNormal, inUV).rgb;
-    vec3 albedo = texture(samplerAlbedo, inUV).rgb;
+    // Read G-Buffer values from previous sub pass, unlit pixels have no normal
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 albedoLit = texelFetch(samplerAlbedo, texel, 0);
+    vec3 albedo = albedoLit.rgb;
+    vec3 normal = albedoLit.a > 0.0 ? decodeOctahedral(texelFetch(samplerNormal, texel, 0).rg) : vec3(0.0);
+    vec3 position = positionFromDepth(inUV, texelFetch(samplerDepth, texel, 0).r,
+    cameraUBO.data.camProjInv, cameraUBO.data.camViewInv);
 
     //parameters
     int  lightType  = lightUBO.data.itype[0];
@@ -13,9 +13,8 @@ layout(location = 0) in vec3 fragPosW;
 layout(location = 1) in vec3 fragNormalW;
 layout(location = 2) in vec2 fragTexCoord;
 
-layout(location = 0) out vec4 outPosition;
-layout(location = 1) out vec4 outNormal;
-layout(location = 2) out vec4 outAlbedo;
+layout(location = 0) out vec2 outNormal;
+layout(location = 1) out vec4 outAlbedo;
 
 layout(set = 0, binding = 0) uniform cameraUBO_t {
     cameraData_t data;
@@ -25,16 +24,15 @@ layout(set = 1, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
 
-layout(set = 2, binding = 0) uniform sampler2D texSamplerArray[RESOURCEARRAYLENGTH];
+layout(set = 2, binding = 0) uniform sampler2D texSamplerArray[MAXMATERIALS];
 
 void main() {
     vec4 texParam   = objectUBO.data.param;
     vec2 texCoord   = (fragTexCoord + texParam.zw)*texParam.xy;
     ivec4 iparam    = objectUBO.data.iparam;
-    uint resIdx     = iparam.x % RESOURCEARRAYLENGTH;
-    vec3 fragColor = texture(texSamplerArray[resIdx], texCoord).xyz;
+    uint resIdx     = iparam.x;
+    vec3 fragColor = texture(texSamplerArray[nonuniformEXT(resIdx)], texCoord).xyz;
 
     outAlbedo = vec4(fragColor, 1.0);
-    outNormal = vec4(fragNormalW, 1.0);
-    outPosition = vec4(fragPosW, 1.0);
+    outNormal = encodeOctahedral(fragNormalW);
 }
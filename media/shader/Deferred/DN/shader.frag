@@ -15,9 +15,8 @@ layout(location = 2) in vec3 fragTangentW;
 layout(location = 3) in vec2 fragTexCoord;
 
 
-layout(location = 0) out vec4 outPosition;
-layout(location = 1) out vec4 outNormal;
-layout(location = 2) out vec4 outAlbedo;
+layout(location = 0) out vec2 outNormal;
+layout(location = 1) out vec4 outAlbedo;
 
 layout(set = 0, binding = 0) uniform cameraUBO_t {
     cameraData_t data;
@@ -27,15 +26,15 @@ layout(set = 1, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
 
-layout(set = 2, binding = 0) uniform sampler2D texSamplerArray[RESOURCEARRAYLENGTH];
-layout(set = 2, binding = 1) uniform sampler2D normalSamplerArray[RESOURCEARRAYLENGTH];
+layout(set = 2, binding = 0) uniform sampler2D texSamplerArray[MAXMATERIALS];
+layout(set = 2, binding = 1) uniform sampler2D normalSamplerArray[MAXMATERIALS];
 
 
 void main() {
     vec4 texParam   = objectUBO.data.param;
     vec2 texCoord   = (fragTexCoord + texParam.zw)*texParam.xy;
     ivec4 iparam    = objectUBO.data.iparam;
-    uint resIdx     = iparam.x % RESOURCEARRAYLENGTH;
+    uint resIdx     = iparam.x;
 
     //TBN matrix
     vec3 N        = normalize(fragNormalW);
@@ -43,12 +42,11 @@ void main() {
     T             = normalize(T - dot(T, N)*N);
     vec3 B        = normalize(cross(T, N));
     mat3 TBN      = mat3(T, B, N);
-    vec3 mapnorm  = normalize(texture(normalSamplerArray[resIdx], texCoord).xyz*2.0 - 1.0);
+    vec3 mapnorm  = normalize(texture(normalSamplerArray[nonuniformEXT(resIdx)], texCoord).xyz*2.0 - 1.0);
     vec3 normalW  = normalize(TBN * mapnorm);
 
-    vec3 fragColor = texture(texSamplerArray[resIdx], texCoord).xyz;
+    vec3 fragColor = texture(texSamplerArray[nonuniformEXT(resIdx)], texCoord).xyz;
 
-    outPosition = vec4(fragPosW, 1.0);
-    outNormal = vec4(normalW, 1.0);
+    outNormal = encodeOctahedral(normalW);
     outAlbedo = vec4(fragColor, 1.0);
 }
@@ -1,2 +1,3 @@
 glslangValidator.exe -V shader.vert
+glslangValidator.exe -DVE_PACKED -o vert_packed.spv -V shader.vert
 pause
@@ -3,3 +3,4 @@ SCRIPT=$(realpath $0)
 # Absolute path this script is in. /home/user/bin
 SCRIPTPATH=`dirname $SCRIPT`
 glslangValidator -V $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert.spv
+glslangValidator -V -DVE_PACKED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_packed.spv
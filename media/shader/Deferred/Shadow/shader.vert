@@ -13,12 +13,19 @@ layout(set = 3, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
 
+#ifdef VE_PACKED
+layout(location = 0) in vec3 inPositionQ;
+#else
 layout(location = 0) in vec3 inPositionL;
+#endif
 
 out gl_PerVertex {
     vec4 gl_Position;
 };
 
 void main() {
+#ifdef VE_PACKED
+    vec3 inPositionL = decodePosition(inPositionQ, objectUBO.data.dequantize);
+#endif
     gl_Position    = cameraUBO.data.camProj * cameraUBO.data.camView * objectUBO.data.model * vec4(inPositionL, 1.0);
 }
\ No newline at end of file
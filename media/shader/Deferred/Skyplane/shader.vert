@@ -12,10 +12,17 @@ layout(set = 1, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
 
+#ifdef VE_PACKED
+layout(location = 0) in vec3 inPositionQ;
+layout(location = 1) in vec2 inNormalO;
+layout(location = 2) in vec2 inTangentO;
+layout(location = 3) in vec2 inTexCoord;
+#else
 layout(location = 0) in vec3 inPositionL;
 layout(location = 1) in vec3 inNormalL;
 layout(location = 2) in vec3 inTangentL;
 layout(location = 3) in vec2 inTexCoord;
+#endif
 
 
 layout(location = 0) out vec2 fragTexCoord;
@@ -26,6 +33,11 @@ out gl_PerVertex {
 };
 
 void main() {
+#ifdef VE_PACKED
+    vec3 inPositionL = decodePosition(inPositionQ, objectUBO.data.dequantize);
+    vec3 inNormalL   = decodeOctahedral(inNormalO);
+    vec3 inTangentL  = decodeOctahedral(inTangentO);
+#endif
     vec4 glp = cameraUBO.data.camProj        * cameraUBO.data.camView * objectUBO.data.model * vec4(inPositionL, 1.0);
     gl_Position = vec4(glp.x, glp.y, glp.z, glp.z*1.000001);
     fragPosW = objectUBO.data.model * vec4(inPositionL, 1.0);
@@ -0,0 +1,3 @@
+glslangValidator.exe -V shader.comp -o comp.spv
+glslangValidator.exe -V shader.frag -o frag.spv
+pause
@@ -0,0 +1,6 @@
+# Absolute path to this script. /home/user/bin/foo.sh
+SCRIPT=$(realpath $0)
+# Absolute path this script is in. /home/user/bin
+SCRIPTPATH=`dirname $SCRIPT`
+glslangValidator -V $SCRIPTPATH/shader.comp -o $SCRIPTPATH/comp.spv
+glslangValidator -V $SCRIPTPATH/shader.frag -o $SCRIPTPATH/frag.spv
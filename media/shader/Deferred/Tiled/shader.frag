@@ -0,0 +1,15 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//copies the lighting of the tiled compute pass into the first onscreen pass
+
+layout(location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outColor;
+
+layout (set = 0, binding = 0) uniform sampler2D samplerLighting;
+
+void main()
+{
+    outColor = vec4(texture(samplerLighting, inUV).rgb, 1.0);
+}
@@ -1,3 +1,8 @@
 glslangValidator.exe -V shader.vert
 glslangValidator.exe -V shader.frag
+glslangValidator.exe -DVE_INDIRECT -o vert_indirect.spv -V shader.vert
+glslangValidator.exe -DVE_INSTANCED -o vert_instanced.spv -V shader.vert
+glslangValidator.exe -DVE_PACKED -o vert_packed.spv -V shader.vert
+glslangValidator.exe -DVE_INDIRECT -DVE_PACKED -o vert_indirect_packed.spv -V shader.vert
+glslangValidator.exe -DVE_INSTANCED -DVE_PACKED -o vert_instanced_packed.spv -V shader.vert
 pause
@@ -4,3 +4,8 @@ SCRIPT=$(realpath $0)
 SCRIPTPATH=`dirname $SCRIPT`
 glslangValidator -V $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert.spv
 glslangValidator -V $SCRIPTPATH/shader.frag -o $SCRIPTPATH/frag.spv
+glslangValidator -V -DVE_INDIRECT $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_indirect.spv
+glslangValidator -V -DVE_INSTANCED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_instanced.spv
+glslangValidator -V -DVE_PACKED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_packed.spv
+glslangValidator -V -DVE_INDIRECT -DVE_PACKED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_indirect_packed.spv
+glslangValidator -V -DVE_INSTANCED -DVE_PACKED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_instanced_packed.spv
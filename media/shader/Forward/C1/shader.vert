@@ -8,11 +8,33 @@ layout(set = 0, binding = 0) uniform cameraUBO_t {
     cameraData_t data;
 } cameraUBO;
 
+#if defined(VE_INDIRECT) || defined(VE_INSTANCED)
+layout(set = 3, binding = 0) readonly buffer objectSSBO_t {
+    objectData_t data[];
+} objectSSBO;
+#ifdef VE_INSTANCED
+//instanced drawing: gl_InstanceIndex selects the index of the entity UBO in the memory block
+layout(set = 4, binding = 0) readonly buffer instanceSSBO_t {
+    uint data[];
+} instanceSSBO;
+#define OBJECTIDX instanceSSBO.data[gl_InstanceIndex]
+#else
+//indirect drawing: firstInstance of the draw command is the index of the entity UBO in the memory block
+#define OBJECTIDX gl_InstanceIndex
+#endif
+#define OBJECTDATA objectSSBO.data[OBJECTIDX]
+#else
 layout(set = 3, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
+#define OBJECTDATA objectUBO.data
+#endif
 
+#ifdef VE_PACKED
+layout(location = 0) in vec3 inPositionQ;
+#else
 layout(location = 0) in vec3 inPositionL;
+#endif
 
 layout(location = 0) out vec4 fragColor;
 
@@ -22,6 +44,9 @@ out gl_PerVertex {
 
 
 void main() {
-    gl_Position = cameraUBO.data.camProj  * cameraUBO.data.camView * objectUBO.data.model * vec4(inPositionL, 1.0);
-    fragColor   = objectUBO.data.color;
+#ifdef VE_PACKED
+    vec3 inPositionL = decodePosition(inPositionQ, OBJECTDATA.dequantize);
+#endif
+    gl_Position = cameraUBO.data.camProj  * cameraUBO.data.camView * OBJECTDATA.model * vec4(inPositionL, 1.0);
+    fragColor   = OBJECTDATA.color;
 }
@@ -1,4 +1,5 @@
 glslangValidator.exe -DALL -DSPOT -DDIR -DPOINT -DAMB -V shader.frag
+glslangValidator.exe -DALL -DSPOT -DDIR -DPOINT -DAMB -DVE_CLUSTERED -o frag_clustered.spv -V shader.frag
 rem glslangValidator.exe -DSPOT  -o frag_SPOT.spv -V shader.frag
 rem glslangValidator.exe -DDIR   -o frag_DIR.spv -V shader.frag
 rem glslangValidator.exe -DPOINT -o frag_POINT.spv -V shader.frag
@@ -3,3 +3,4 @@ SCRIPT=$(realpath $0)
 # Absolute path this script is in. /home/user/bin
 SCRIPTPATH=`dirname $SCRIPT`
 glslangValidator -V $SCRIPTPATH/shader.frag -o $SCRIPTPATH/frag.spv
+glslangValidator -V -DVE_CLUSTERED $SCRIPTPATH/shader.frag -o $SCRIPTPATH/frag_clustered.spv
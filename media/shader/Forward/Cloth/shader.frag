@@ -28,18 +28,25 @@ layout(set = 1, binding = 0) uniform lightUBO_t {
     lightData_t data;
 } lightUBO;
 
-layout(set = 2, binding = 0) uniform sampler2D shadowMap[NUM_SHADOW_CASCADE];
+layout(set = 2, binding = 0) uniform sampler2D shadowAtlas;
 
 layout(set = 3, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
 
-layout(set = 4, binding = 0) uniform sampler2D texSamplerArray[RESOURCEARRAYLENGTH];
+layout(set = 4, binding = 0) uniform sampler2D texSamplerArray[MAXMATERIALS];
+
+#ifdef VE_CLUSTERED
+#include "../../cluster.glsl"
+#endif
 
 
 void main() {
     //parameters
     int  lightType  = lightUBO.data.itype[0];
+#ifdef VE_CLUSTERED
+    if (clusterLights.counts.z == 0) lightType = -1;   //the light UBO is only bound, all lights are in the clusters
+#endif
     vec3 camPosW    = cameraUBO.data.camModel[3].xyz;
     vec3 lightPosW  = lightUBO.data.lightModel[3].xyz;
     vec3 lightDirW  = normalize(lightUBO.data.lightModel[2].xyz);
@@ -47,7 +54,7 @@ void main() {
     vec4 texParam   = objectUBO.data.param;
     vec2 texCoord   = (fragTexCoord + texParam.zw)*texParam.xy;
     ivec4 iparam    = objectUBO.data.iparam;
-    uint resIdx     = iparam.x % RESOURCEARRAYLENGTH;
+    uint resIdx     = iparam.x;
     vec3 normalW    = fragNormalW;                                                                  //to be consistent with DN
 
     bool drawShadow = true;                                                                         // Soft Body Stuff
@@ -63,7 +70,7 @@ void main() {
     vec3 ambcol  = lightUBO.data.col_ambient.xyz;
     vec3 diffcol = lightUBO.data.col_diffuse.xyz;
     vec3 speccol = lightUBO.data.col_specular.xyz;
-    vec3 fragColor = texture(texSamplerArray[resIdx], texCoord).xyz;
+    vec3 fragColor = texture(texSamplerArray[nonuniformEXT(resIdx)], texCoord).xyz;
 
     vec3 result = vec3(0, 0, 0);
     int sIdx = 0;
@@ -77,7 +84,7 @@ void main() {
                 lightUBO.data.shadowCameras[1].param[3],
                 lightUBO.data.shadowCameras[2].param[3]);
             s = lightUBO.data.shadowCameras[sIdx];
-            shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+            shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
         }
         
         result += dirlight(lightType, camPosW, lightDirW, lightParam, shadowFactor,
@@ -88,7 +95,7 @@ void main() {
         if (drawShadow) {
             sIdx = shadowIdxPoint(lightPosW, fragPosW);
             s = lightUBO.data.shadowCameras[sIdx];
-            shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+            shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
         }
 
         result += pointlight(lightType, camPosW, lightPosW, lightParam, shadowFactor,
@@ -97,7 +104,7 @@ void main() {
 
     if (lightType == LIGHT_SPOT) {
         if (drawShadow) {
-            shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+            shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
         }
 
         result += spotlight(lightType, camPosW, lightPosW, lightDirW, lightParam, shadowFactor,
@@ -107,5 +114,9 @@ void main() {
     if (lightType == LIGHT_AMBIENT)
         result += fragColor * ambcol;
 
+#ifdef VE_CLUSTERED
+    result += clusterLighting(cameraUBO.data.camView, camPosW, fragPosW, normalW, fragColor);
+#endif
+
     outColor = vec4(result, 1.0);
 }
@@ -0,0 +1,2 @@
+glslangValidator.exe -V shader.comp -o comp.spv
+pause
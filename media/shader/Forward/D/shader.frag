@@ -23,34 +23,51 @@ layout(set = 1, binding = 0) uniform lightUBO_t {
     lightData_t data;
 } lightUBO;
 
-layout(set = 2, binding = 0) uniform sampler2D shadowMap[NUM_SHADOW_CASCADE];
+layout(set = 2, binding = 0) uniform sampler2D shadowAtlas;
 
+#if defined(VE_INDIRECT) || defined(VE_INSTANCED)
+layout(location = 3) flat in int fragObjectIdx;
+
+layout(set = 3, binding = 0) readonly buffer objectSSBO_t {
+    objectData_t data[];
+} objectSSBO;
+#define OBJECTDATA objectSSBO.data[fragObjectIdx]
+#else
 layout(set = 3, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
+#define OBJECTDATA objectUBO.data
+#endif
+
+layout(set = 4, binding = 0) uniform sampler2D texSamplerArray[MAXMATERIALS];
 
-layout(set = 4, binding = 0) uniform sampler2D texSamplerArray[RESOURCEARRAYLENGTH];
+#ifdef VE_CLUSTERED
+#include "../../cluster.glsl"
+#endif
 
 
 void main() {
 
     //parameters
     int  lightType  = lightUBO.data.itype[0];
+#ifdef VE_CLUSTERED
+    if (clusterLights.counts.z == 0) lightType = -1;   //the light UBO is only bound, all lights are in the clusters
+#endif
     vec3 camPosW    = cameraUBO.data.camModel[3].xyz;
     vec3 lightPosW  = lightUBO.data.lightModel[3].xyz;
     vec3 lightDirW  = normalize(lightUBO.data.lightModel[2].xyz);
     vec4 lightParam = lightUBO.data.param;
-    vec4 texParam   = objectUBO.data.param;
+    vec4 texParam   = OBJECTDATA.param;
     vec2 texCoord   = (fragTexCoord + texParam.zw)*texParam.xy;
-    ivec4 iparam    = objectUBO.data.iparam;
-    uint resIdx     = iparam.x % RESOURCEARRAYLENGTH;
+    ivec4 iparam    = OBJECTDATA.iparam;
+    uint resIdx     = iparam.x;
     vec3 normalW    = fragNormalW;//to be consistent with DN
 
     //colors
     vec3 ambcol  = lightUBO.data.col_ambient.xyz;
     vec3 diffcol = lightUBO.data.col_diffuse.xyz;
     vec3 speccol = lightUBO.data.col_specular.xyz;
-    vec3 fragColor = texture(texSamplerArray[resIdx], texCoord).xyz;
+    vec3 fragColor = texture(texSamplerArray[nonuniformEXT(resIdx)], texCoord).xyz;
 
     vec3 result = vec3(0, 0, 0);
     int sIdx = 0;
@@ -65,7 +82,7 @@ void main() {
         lightUBO.data.shadowCameras[2].param[3]);
 
         s = lightUBO.data.shadowCameras[sIdx];
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+        shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
 
         result +=   dirlight(lightType, camPosW,
         lightDirW, lightParam, shadowFactor,
@@ -78,7 +95,7 @@ void main() {
 
         sIdx = shadowIdxPoint(lightPosW, fragPosW);
         s = lightUBO.data.shadowCameras[sIdx];
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+        shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
 
         result +=   pointlight(lightType, camPosW,
         lightPosW, lightParam, shadowFactor,
@@ -88,7 +105,7 @@ void main() {
 
     if (lightType == LIGHT_SPOT) {
 
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+        shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
 
         result +=  spotlight(lightType, camPosW,
         lightPosW, lightDirW, lightParam, shadowFactor,
@@ -100,5 +117,9 @@ void main() {
         result += fragColor * ambcol;
     }
 
+#ifdef VE_CLUSTERED
+    result += clusterLighting(cameraUBO.data.camView, camPosW, fragPosW, normalW, fragColor);
+#endif
+
     outColor = vec4(result, 1.0);
 }
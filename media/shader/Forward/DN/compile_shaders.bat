@@ -1,5 +1,14 @@
 glslangValidator.exe -V shader.vert
 glslangValidator.exe -DALL -DSPOT -DDIR -DPOINT -DAMB -V shader.frag
+glslangValidator.exe -DVE_INDIRECT -o vert_indirect.spv -V shader.vert
+glslangValidator.exe -DALL -DSPOT -DDIR -DPOINT -DAMB -DVE_INDIRECT -o frag_indirect.spv -V shader.frag
+glslangValidator.exe -DVE_INSTANCED -o vert_instanced.spv -V shader.vert
+glslangValidator.exe -DALL -DSPOT -DDIR -DPOINT -DAMB -DVE_INSTANCED -o frag_instanced.spv -V shader.frag
+glslangValidator.exe -DALL -DSPOT -DDIR -DPOINT -DAMB -DVE_INDIRECT -DVE_CLUSTERED -o frag_indirect_clustered.spv -V shader.frag
+glslangValidator.exe -DALL -DSPOT -DDIR -DPOINT -DAMB -DVE_INSTANCED -DVE_CLUSTERED -o frag_instanced_clustered.spv -V shader.frag
+glslangValidator.exe -DVE_PACKED -o vert_packed.spv -V shader.vert
+glslangValidator.exe -DVE_INDIRECT -DVE_PACKED -o vert_indirect_packed.spv -V shader.vert
+glslangValidator.exe -DVE_INSTANCED -DVE_PACKED -o vert_instanced_packed.spv -V shader.vert
 rem glslangValidator.exe -DSPOT  -o frag_SPOT.spv -V shader.frag
 rem glslangValidator.exe -DDIR   -o frag_DIR.spv -V shader.frag
 rem glslangValidator.exe -DPOINT -o frag_POINT.spv -V shader.frag
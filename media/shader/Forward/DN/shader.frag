@@ -24,29 +24,46 @@ layout(set = 1, binding = 0) uniform lightUBO_t {
     lightData_t data;
 } lightUBO;
 
-layout(set = 2, binding = 0) uniform sampler2D shadowMap[NUM_SHADOW_CASCADE];
+layout(set = 2, binding = 0) uniform sampler2D shadowAtlas;
 
+#if defined(VE_INDIRECT) || defined(VE_INSTANCED)
+layout(location = 4) flat in int fragObjectIdx;
+
+layout(set = 3, binding = 0) readonly buffer objectSSBO_t {
+    objectData_t data[];
+} objectSSBO;
+#define OBJECTDATA objectSSBO.data[fragObjectIdx]
+#else
 layout(set = 3, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
+#define OBJECTDATA objectUBO.data
+#endif
+
+layout(set = 4, binding = 0) uniform sampler2D texSamplerArray[MAXMATERIALS];
+layout(set = 4, binding = 1) uniform sampler2D normalSamplerArray[MAXMATERIALS];
 
-layout(set = 4, binding = 0) uniform sampler2D texSamplerArray[RESOURCEARRAYLENGTH];
-layout(set = 4, binding = 1) uniform sampler2D normalSamplerArray[RESOURCEARRAYLENGTH];
+#ifdef VE_CLUSTERED
+#include "../../cluster.glsl"
+#endif
 
 
 void main() {
 
     //parameters
     int  lightType  = lightUBO.data.itype[0];
+#ifdef VE_CLUSTERED
+    if (clusterLights.counts.z == 0) lightType = -1;   //the light UBO is only bound, all lights are in the clusters
+#endif
     vec3 camPosW   = cameraUBO.data.camModel[3].xyz;
     vec3 lightPosW = lightUBO.data.lightModel[3].xyz;
     vec3 lightDirW = normalize(lightUBO.data.lightModel[2].xyz);
     float nfac = dot(fragNormalW, -lightDirW)<0? 0.5:1;
     vec4 lightParam = lightUBO.data.param;
-    vec4 texParam   = objectUBO.data.param;
+    vec4 texParam   = OBJECTDATA.param;
     vec2 texCoord   = (fragTexCoord + texParam.zw)*texParam.xy;
-    ivec4 iparam    = objectUBO.data.iparam;
-    uint resIdx     = iparam.x % RESOURCEARRAYLENGTH;
+    ivec4 iparam    = OBJECTDATA.iparam;
+    uint resIdx     = iparam.x;
 
     //TBN matrix
     vec3 N        = normalize(fragNormalW);
@@ -54,14 +71,14 @@ void main() {
     T             = normalize(T - dot(T, N)*N);
     vec3 B        = normalize(cross(T, N));
     mat3 TBN      = mat3(T, B, N);
-    vec3 mapnorm  = normalize(texture(normalSamplerArray[resIdx], texCoord).xyz*2.0 - 1.0);
+    vec3 mapnorm  = normalize(texture(normalSamplerArray[nonuniformEXT(resIdx)], texCoord).xyz*2.0 - 1.0);
     vec3 normalW  = normalize(TBN * mapnorm);
 
     //colors
     vec3 ambcol  = lightUBO.data.col_ambient.xyz;
     vec3 diffcol = lightUBO.data.col_diffuse.xyz;
     vec3 speccol = lightUBO.data.col_specular.xyz;
-    vec3 fragColor = texture(texSamplerArray[resIdx], texCoord).xyz;
+    vec3 fragColor = texture(texSamplerArray[nonuniformEXT(resIdx)], texCoord).xyz;
 
     vec3 result = vec3(0, 0, 0);
     int sIdx = 0;
@@ -78,7 +95,7 @@ void main() {
         lightUBO.data.shadowCameras[2].param[3]);
 
         s = lightUBO.data.shadowCameras[sIdx];
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+        shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
 
         result +=   dirlight(lightType, camPosW,
         lightDirW, lightParam, shadowFactor,
@@ -91,7 +108,7 @@ void main() {
 
         sIdx = shadowIdxPoint(lightPosW, fragPosW);
         s = lightUBO.data.shadowCameras[sIdx];
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+        shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
 
         result +=   pointlight(lightType, camPosW,
         lightPosW, lightParam, shadowFactor,
@@ -103,7 +120,7 @@ void main() {
         if (dot(lightDirW, N) >= 0) normalW = N;
 
         sIdx = shadowIdxPoint(lightPosW, fragPosW);
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx]);
+        shadowFactor = shadowFuncAtlas(fragPosW, s.camView, s.camProj, s.tile, shadowAtlas);
 
         result +=  spotlight(lightType, camPosW,
         lightPosW, lightDirW, lightParam, shadowFactor,
@@ -115,5 +132,9 @@ void main() {
         result += fragColor * ambcol;
     }
 
+#ifdef VE_CLUSTERED
+    result += clusterLighting(cameraUBO.data.camView, camPosW, fragPosW, normalW, fragColor);
+#endif
+
     outColor = vec4(result, 1.0);
 }
@@ -8,19 +8,47 @@ layout(set = 0, binding = 0) uniform cameraUBO_t {
     cameraData_t data;
 } cameraUBO;
 
+#if defined(VE_INDIRECT) || defined(VE_INSTANCED)
+layout(set = 3, binding = 0) readonly buffer objectSSBO_t {
+    objectData_t data[];
+} objectSSBO;
+#ifdef VE_INSTANCED
+//instanced drawing: gl_InstanceIndex selects the index of the entity UBO in the memory block
+layout(set = 5, binding = 0) readonly buffer instanceSSBO_t {
+    uint data[];
+} instanceSSBO;
+#define OBJECTIDX instanceSSBO.data[gl_InstanceIndex]
+#else
+//indirect drawing: firstInstance of the draw command is the index of the entity UBO in the memory block
+#define OBJECTIDX gl_InstanceIndex
+#endif
+#define OBJECTDATA objectSSBO.data[OBJECTIDX]
+#else
 layout(set = 3, binding = 0) uniform objectUBO_t {
     objectData_t data;
 } objectUBO;
+#define OBJECTDATA objectUBO.data
+#endif
 
+#ifdef VE_PACKED
+layout(location = 0) in vec3 inPositionQ;
+layout(location = 1) in vec2 inNormalO;
+layout(location = 2) in vec2 inTangentO;
+layout(location = 3) in vec2 inTexCoord;
+#else
 layout(location = 0) in vec3 inPositionL;
 layout(location = 1) in vec3 inNormalL;
 layout(location = 2) in vec3 inTangentL;
 layout(location = 3) in vec2 inTexCoord;
+#endif
 
 layout(location = 0) out vec3 fragPosW;
 layout(location = 1) out vec3 fragNormalW;
 layout(location = 2) out vec3 fragTangentW;
 layout(location = 3) out vec2 fragTexCoord;
+#if defined(VE_INDIRECT) || defined(VE_INSTANCED)
+layout(location = 4) flat out int fragObjectIdx;
+#endif
 
 out gl_PerVertex {
     vec4 gl_Position;
@@ -28,9 +56,17 @@ out gl_PerVertex {
 
 
 void main() {
-    gl_Position    = cameraUBO.data.camProj        * cameraUBO.data.camView * objectUBO.data.model * vec4(inPositionL, 1.0);
-    fragPosW       = (objectUBO.data.model         * vec4(inPositionL, 1.0)).xyz;
-    fragNormalW    = (objectUBO.data.modelInvTrans * vec4(inNormalL, 1.0)).xyz;
-    fragTangentW   = (objectUBO.data.modelInvTrans * vec4(inTangentL, 0.0)).xyz;
+#ifdef VE_PACKED
+    vec3 inPositionL = decodePosition(inPositionQ, OBJECTDATA.dequantize);
+    vec3 inNormalL   = decodeOctahedral(inNormalO);
+    vec3 inTangentL  = decodeOctahedral(inTangentO);
+#endif
+    gl_Position    = cameraUBO.data.camProj        * cameraUBO.data.camView * OBJECTDATA.model * vec4(inPositionL, 1.0);
+    fragPosW       = (OBJECTDATA.model         * vec4(inPositionL, 1.0)).xyz;
+    fragNormalW    = (OBJECTDATA.modelInvTrans * vec4(inNormalL, 1.0)).xyz;
+    fragTangentW   = (OBJECTDATA.modelInvTrans * vec4(inTangentL, 0.0)).xyz;
     fragTexCoord   = inTexCoord;
+#if defined(VE_INDIRECT) || defined(VE_INSTANCED)
+    fragObjectIdx  = int(OBJECTIDX);
+#endif
 }
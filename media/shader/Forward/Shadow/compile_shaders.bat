@@ -1,2 +1,6 @@
 glslangValidator.exe -V shader.vert
+glslangValidator.exe -DVE_PACKED -o vert_packed.spv -V shader.vert
+glslangValidator.exe -DVE_CUBE -o vert_cube.spv -V shader.vert
+glslangValidator.exe -DVE_CUBE -DVE_PACKED -o vert_cube_packed.spv -V shader.vert
+glslangValidator.exe -V shader.geom
 pause
@@ -3,3 +3,7 @@ SCRIPT=$(realpath $0)
 # Absolute path this script is in. /home/user/bin
 SCRIPTPATH=`dirname $SCRIPT`
 glslangValidator -V $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert.spv
+glslangValidator -V -DVE_PACKED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_packed.spv
+glslangValidator -V -DVE_CUBE $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_cube.spv
+glslangValidator -V -DVE_CUBE -DVE_PACKED $SCRIPTPATH/shader.vert -o $SCRIPTPATH/vert_cube_packed.spv
+glslangValidator -V $SCRIPTPATH/shader.geom -o $SCRIPTPATH/geom.spv
@@ -1,3 +1,4 @@
 glslangValidator.exe -V shader.vert
 glslangValidator.exe -V shader.frag
+glslangValidator.exe -DVE_PACKED -o vert_packed.spv -V shader.vert
 pause
@@ -0,0 +1,93 @@
+/*
+* Lights of the clustered forward renderer
+*
+* The view frustum is split into a grid of clusters, tiles on the screen and exponential depth slices.
+* A compute shader lists the lights reaching each cluster. Directional and ambient lights reach
+* all clusters, they are stored first and are not listed.
+* Needs common_defines.glsl and light.glsl.
+*/
+
+//the cluster set follows the material table, and the instance indices if drawn instanced
+#if defined(VE_INSTANCED)
+#define CLUSTERSET 6
+#else
+#define CLUSTERSET 5
+#endif
+
+layout(set = CLUSTERSET, binding = 0) readonly buffer clusterLightSSBO_t {
+    uvec4 grid;     //number of clusters in x, y, z, tile size in pixels
+    uvec4 counts;   //x...number of global lights, y...number of all lights, z...1 if the light UBO is shaded too
+    vec4  depth;    //x...near plane, y...far plane, z...slices / log(far / near)
+    vec4  extent;   //xy...framebuffer size in pixels
+    clusterLight_t data[];
+} clusterLights;
+
+layout(set = CLUSTERSET, binding = 1) readonly buffer clusterCountSSBO_t {
+    uint data[];
+} clusterCounts;
+
+layout(set = CLUSTERSET, binding = 2) readonly buffer clusterIndexSSBO_t {
+    uint data[];
+} clusterIndices;
+
+
+/*
+* Given a frag coordinate and the depth of the frag in view space,
+* find the index of the cluster that the frag belongs to
+*/
+uint clusterIndex(vec4 fragCoord, float viewZ) {
+    uvec3 grid = clusterLights.grid.xyz;
+    uvec2 tile = min(uvec2(fragCoord.xy) / clusterLights.grid.w, grid.xy - 1);
+    float z = log(max(viewZ, clusterLights.depth.x) / clusterLights.depth.x) * clusterLights.depth.z;
+    uint slice = uint(clamp(z, 0.0, float(grid.z - 1)));
+    return tile.x + grid.x * (tile.y + grid.y * slice);
+}
+
+
+vec3 clusterLight(uint idx, vec3 camposW, vec3 fragposW, vec3 fragnormalW, vec3 fragcolor) {
+    clusterLight_t l = clusterLights.data[idx];
+    int lightType = l.itype.x;
+    vec3 lightdirW = normalize(l.direction.xyz);
+
+    if (lightType == LIGHT_DIR) {
+        return dirlight(lightType, camposW, lightdirW, l.param, 1.0,
+        l.col_ambient.xyz, l.col_diffuse.xyz, l.col_specular.xyz,
+        fragposW, fragnormalW, fragcolor);
+    }
+
+    if (lightType == LIGHT_POINT) {
+        return pointlight(lightType, camposW, l.position.xyz, l.param, 1.0,
+        l.col_ambient.xyz, l.col_diffuse.xyz, l.col_specular.xyz,
+        fragposW, fragnormalW, fragcolor);
+    }
+
+    if (lightType == LIGHT_SPOT) {
+        return spotlight(lightType, camposW, l.position.xyz, lightdirW, l.param, 1.0,
+        l.col_ambient.xyz, l.col_diffuse.xyz, l.col_specular.xyz,
+        fragposW, fragnormalW, fragcolor);
+    }
+
+    return fragcolor * l.col_ambient.xyz;
+}
+
+
+/*
+* Shade a frag with all global lights and the lights of its cluster, without shadows
+*/
+vec3 clusterLighting(mat4 camView, vec3 camposW, vec3 fragposW, vec3 fragnormalW, vec3 fragcolor) {
+    vec3 result = vec3(0, 0, 0);
+
+    for (uint i = 0; i < clusterLights.counts.x; i++) {
+        result += clusterLight(i, camposW, fragposW, fragnormalW, fragcolor);
+    }
+
+    float viewZ = (camView * vec4(fragposW, 1.0)).z;
+    uint cluster = clusterIndex(gl_FragCoord, viewZ);
+    uint first = cluster * MAXCLUSTERLIGHTS;
+    uint count = clusterCounts.data[cluster];
+    for (uint i = 0; i < count; i++) {
+        result += clusterLight(clusterIndices.data[first + i], camposW, fragposW, fragnormalW, fragcolor);
+    }
+
+    return result;
+}
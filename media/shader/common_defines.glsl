@@ -6,7 +6,11 @@
 
 #define NUM_SHADOW_CASCADE 6
 
-#define RESOURCEARRAYLENGTH 16
+//number of slots in the material table, must match VE_MAX_MATERIALS
+#define MAXMATERIALS 4096
+
+//max number of lights in one cluster of the clustered forward renderer, must match VE_CLUSTER_MAX_LIGHTS
+#define MAXCLUSTERLIGHTS 128
 
 #define LIGHT_DIR 0
 #define LIGHT_POINT 1
@@ -21,7 +25,8 @@ struct cameraData_t {
     mat4 camViewInv;
     mat4 camProjInv;
     vec4 param;
-    vec4 a, b, c, d, e, f, g;
+    vec4 tile;      //shadow cameras of a light: offset and size of the shadow map in the shadow atlas
+    vec4 b, c, d, e, f, g;
 };
 
 struct lightData_t {
@@ -35,6 +40,17 @@ struct lightData_t {
     cameraData_t shadowCameras[NUM_SHADOW_CASCADE];
 };
 
+//light shaded in the clusters or tiles, position.w is the reach of the light
+struct clusterLight_t {
+    ivec4 itype;
+    vec4  position;
+    vec4  direction;
+    vec4  col_ambient;
+    vec4  col_diffuse;
+    vec4  col_specular;
+    vec4  param;
+};
+
 struct objectData_t {
     mat4  model;
     mat4  modelTrans;
@@ -42,9 +58,40 @@ struct objectData_t {
     vec4  color;
     vec4  param;
     ivec4 iparam;
-    vec4  a;
+    vec4  dequantize;
 };
 
+//packed vertices: the position is stored as unorm16 relative to the mesh bounds,
+//normal and tangent are octahedral encoded as snorm16
+
+vec3 decodePosition(vec3 pos, vec4 dequantize) {
+    return dequantize.xyz + dequantize.w * pos;
+}
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 v = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+//compact G-buffer of the deferred renderer: normals are octahedral encoded as snorm16,
+//positions are reconstructed from the depth map, albedo alpha is 0 for unlit pixels
+
+vec2 encodeOctahedral(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return n.xy;
+}
+
+vec3 positionFromDepth(vec2 uv, float depth, mat4 camProjInv, mat4 camViewInv) {
+    vec4 posV = camProjInv * vec4(uv * 2.0 - 1.0, depth, 1.0);
+    return (camViewInv * vec4(posV.xyz / posV.w, 1.0)).xyz;
+}
+
 struct Vertex
 {
     vec3 pos;
@@ -91,6 +91,42 @@ float shadowFunc(vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2D shad
 }
 
 
+/*
+* Like shadowFunc(), but the shadow map is a tile of the shadow atlas.
+* tile.xy is the offset and tile.zw the size of the tile in texture coordinates,
+* the filter does not read texels of neighbouring tiles. Lights without a tile cast no shadows.
+*/
+float shadowFuncAtlas(vec3 fragposW, mat4 shadowView, mat4 shadowProj, vec4 tile, sampler2D shadowAtlas) {
+
+    if (tile.z <= 0.0) {
+        return 1.0;
+    }
+
+    vec4 fragposH = shadowProj * shadowView * vec4(fragposW, 1);
+    fragposH /= fragposH.w;//homogeneous coords are in [-1,1]
+    vec2 uv = clamp(fragposH.xy / 2.0 + 0.5, 0.0, 1.0);//translate to [0,1]
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    vec2 lo = tile.xy + 0.5 * texel;
+    vec2 hi = tile.xy + tile.zw - 0.5 * texel;
+    float scale = 1.2;
+    float bias = 0.0001;
+
+    float factor = 0.0;
+    float sum = 0;
+    int range = 1;
+
+    for (int x = -range; x <= range; x++) {
+        for (int y = -range; y <= range; y++) {
+            vec2 coord = clamp(tile.xy + uv * tile.zw + scale * texel * vec2(x, y), lo, hi);
+            factor += texture(shadowAtlas, coord).r < fragposH.z + bias ? 0.2 : 1.0;
+            sum += 1.0;
+        }
+    }
+    return factor / sum;
+}
+
+
 
 vec3 dirlight(int lightType, vec3 camposW,
 vec3 lightdirW, vec4 lightparam, float shadowFac,